@@ -32,20 +32,31 @@
 #include "gnc-ui-util.h"
 
 
+/* The children of a node are kept in an array sorted by key, which
+ * costs far less memory per node than a hash table and is searched
+ * just as quickly for the handful of children most nodes have. */
+typedef struct
+{
+    guint key;           /* upper-cased character of the child  */
+    QuickFill *qf;
+} QuickFillChild;
+
 struct _QuickFill
 {
     char *text;          /* the first matching text string     */
     int len;             /* number of chars in text string     */
-    GHashTable *matches; /* array of children in the tree      */
+    guint n_matches;     /* number of children in the tree     */
+    QuickFillChild *matches; /* children, sorted by key        */
 };
 
 
 /** PROTOTYPES ******************************************************/
-static void quickfill_insert_recursive (QuickFill *qf, const char *text,
-                                        int depth, QuickFillSort sort);
+static QuickFill * quickfill_insert_node (QuickFill *qf, guint key,
+        const char *text, int len,
+        QuickFillSort sort);
 
 static void gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text,
-        gint depth, QuickFillSort sort);
+        const gchar *key_char, QuickFillSort sort);
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_REGISTER;
@@ -69,7 +80,8 @@ gnc_quickfill_new (void)
     qf->text = NULL;
     qf->len = 0;
 
-    qf->matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+    qf->n_matches = 0;
+    qf->matches = NULL;
 
     return qf;
 }
@@ -77,11 +89,69 @@ gnc_quickfill_new (void)
 /********************************************************************\
 \********************************************************************/
 
-static gboolean
-destroy_helper (gpointer key, gpointer value, gpointer data)
+/* Return the position of key among the children of qf, or the
+ * position at which it would be inserted. */
+static guint
+quickfill_find_child (QuickFill *qf, guint key)
+{
+    guint lo = 0;
+    guint hi = qf->n_matches;
+
+    while (lo < hi)
+    {
+        guint mid = (lo + hi) / 2;
+
+        if (qf->matches[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static QuickFill *
+quickfill_add_child (QuickFill *qf, guint pos, guint key)
 {
-    gnc_quickfill_destroy (value);
-    return TRUE;
+    QuickFill *child = gnc_quickfill_new ();
+
+    qf->matches = g_renew (QuickFillChild, qf->matches, qf->n_matches + 1);
+    memmove (qf->matches + pos + 1, qf->matches + pos,
+             (qf->n_matches - pos) * sizeof (QuickFillChild));
+    qf->matches[pos].key = key;
+    qf->matches[pos].qf = child;
+    qf->n_matches++;
+
+    return child;
+}
+
+static void
+quickfill_remove_child (QuickFill *qf, guint pos)
+{
+    gnc_quickfill_destroy (qf->matches[pos].qf);
+
+    qf->n_matches--;
+    memmove (qf->matches + pos, qf->matches + pos + 1,
+             (qf->n_matches - pos) * sizeof (QuickFillChild));
+
+    if (qf->n_matches == 0)
+    {
+        g_free (qf->matches);
+        qf->matches = NULL;
+    }
+}
+
+static void
+quickfill_destroy_children (QuickFill *qf)
+{
+    guint i;
+
+    for (i = 0; i < qf->n_matches; i++)
+        gnc_quickfill_destroy (qf->matches[i].qf);
+
+    g_free (qf->matches);
+    qf->matches = NULL;
+    qf->n_matches = 0;
 }
 
 void
@@ -90,9 +160,7 @@ gnc_quickfill_destroy (QuickFill *qf)
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach (qf->matches, (GHFunc)destroy_helper, NULL);
-    g_hash_table_destroy (qf->matches);
-    qf->matches = NULL;
+    quickfill_destroy_children (qf);
 
     if (qf->text)
         CACHE_REMOVE(qf->text);
@@ -108,7 +176,7 @@ gnc_quickfill_purge (QuickFill *qf)
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach_remove (qf->matches, destroy_helper, NULL);
+    quickfill_destroy_children (qf);
 
     if (qf->text)
         CACHE_REMOVE (qf->text);
@@ -135,12 +203,17 @@ QuickFill *
 gnc_quickfill_get_char_match (QuickFill *qf, gunichar uc)
 {
     guint key = g_unichar_toupper (uc);
+    guint pos;
 
     if (NULL == qf) return NULL;
 
     DEBUG ("xaccGetQuickFill(): index = %u\n", key);
 
-    return g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
+    pos = quickfill_find_child (qf, key);
+    if (pos < qf->n_matches && qf->matches[pos].key == key)
+        return qf->matches[pos].qf;
+
+    return NULL;
 }
 
 /********************************************************************\
@@ -187,14 +260,6 @@ gnc_quickfill_get_string_match (QuickFill *qf, const char *str)
 /********************************************************************\
 \********************************************************************/
 
-static void
-unique_len_helper (gpointer key, gpointer value, gpointer data)
-{
-    QuickFill **qf_p = data;
-
-    *qf_p = value;
-}
-
 QuickFill *
 gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
 {
@@ -204,16 +269,9 @@ gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
     if (qf == NULL)
         return NULL;
 
-    while (1)
+    while (qf->n_matches == 1)
     {
-        guint count;
-
-        count = g_hash_table_size (qf->matches);
-
-        if (count != 1)
-            break;
-
-        g_hash_table_foreach (qf->matches, unique_len_helper, &qf);
+        qf = qf->matches[0].qf;
 
         if (length != NULL)
             (*length)++;
@@ -229,47 +287,43 @@ void
 gnc_quickfill_insert (QuickFill *qf, const char *text, QuickFillSort sort)
 {
     gchar *normalized_str;
+    const char *c;
+    int len;
 
     if (NULL == qf) return;
     if (NULL == text) return;
 
 
     normalized_str = g_utf8_normalize (text, -1, G_NORMALIZE_NFC);
-    quickfill_insert_recursive (qf, normalized_str, 0, sort);
+    len = g_utf8_strlen (normalized_str, -1);
+
+    /* Walk down the tree one character at a time rather than
+     * re-scanning the string for every level. */
+    for (c = normalized_str; qf && *c; c = g_utf8_next_char (c))
+        qf = quickfill_insert_node (qf, g_unichar_toupper (g_utf8_get_char (c)),
+                                    normalized_str, len, sort);
+
     g_free (normalized_str);
 }
 
 /********************************************************************\
 \********************************************************************/
 
-static void
-quickfill_insert_recursive (QuickFill *qf, const char *text, int depth,
-                            QuickFillSort sort)
+/* Record text in the child of qf for key, creating it if needed, and
+ * return the child. */
+static QuickFill *
+quickfill_insert_node (QuickFill *qf, guint key, const char *text, int len,
+                       QuickFillSort sort)
 {
-    guint key;
     char *old_text;
     QuickFill *match_qf;
-    int len;
-    char *key_char;
-    gunichar key_char_uc;
-
-    if (qf == NULL)
-        return;
-
-    if ((text == NULL) || (g_utf8_strlen (text, -1) <= depth))
-        return;
-
-    key_char = g_utf8_offset_to_pointer (text, depth);
+    guint pos;
 
-    key_char_uc = g_utf8_get_char (key_char);
-    key = g_unichar_toupper (key_char_uc);
-
-    match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
-    if (match_qf == NULL)
-    {
-        match_qf = gnc_quickfill_new ();
-        g_hash_table_insert (qf->matches, GUINT_TO_POINTER (key), match_qf);
-    }
+    pos = quickfill_find_child (qf, key);
+    if (pos < qf->n_matches && qf->matches[pos].key == key)
+        match_qf = qf->matches[pos].qf;
+    else
+        match_qf = quickfill_add_child (qf, pos, key);
 
     old_text = match_qf->text;
 
@@ -282,8 +336,6 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int depth,
 
     case QUICKFILL_LIFO:
     default:
-        len = g_utf8_strlen (text, -1);
-
         /* If there's no string there already, just put the new one in. */
         if (old_text == NULL)
         {
@@ -303,7 +355,7 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int depth,
         break;
     }
 
-    quickfill_insert_recursive (match_qf, text, ++depth, sort);
+    return match_qf;
 }
 
 /********************************************************************\
@@ -318,49 +370,35 @@ gnc_quickfill_remove (QuickFill *qf, const gchar *text, QuickFillSort sort)
     if (text == NULL) return;
 
     normalized_str = g_utf8_normalize (text, -1, G_NORMALIZE_NFC);
-    gnc_quickfill_remove_recursive (qf, normalized_str, 0, sort);
+    gnc_quickfill_remove_recursive (qf, normalized_str, normalized_str, sort);
     g_free (normalized_str);
 }
 
 /********************************************************************\
 \********************************************************************/
 
-struct _BestText
+/* Return the best remaining text among the children of qf. */
+static gchar *
+best_child_text (QuickFill *qf)
 {
-    gchar *text;
-    QuickFillSort sort;
-};
+    gchar *best = NULL;
+    guint i;
 
-static void
-best_text_helper (gpointer key, gpointer value, gpointer user_data)
-{
-    QuickFill *qf = value;
-    struct _BestText *best = user_data;
-
-    if (best->text == NULL)
+    for (i = 0; i < qf->n_matches; i++)
     {
-        /* start with the first text */
-        best->text = qf->text;
+        gchar *text = qf->matches[i].qf->text;
 
+        if (best == NULL || g_utf8_collate (text, best) < 0)
+            best = text;
     }
-    else if (best->text == QUICKFILL_LIFO)
-    {
-        /* we do not track history, so ignore it */
-        return;
 
-    }
-    else if (g_utf8_collate (qf->text, best->text) < 0)
-    {
-        /* even better text */
-        best->text = qf->text;
-    }
+    return best;
 }
 
 
-
 static void
-gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
-                                QuickFillSort sort)
+gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text,
+                                const gchar *key_char, QuickFillSort sort)
 {
     QuickFill *match_qf;
     gchar *child_text;
@@ -369,29 +407,30 @@ gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
     child_text = NULL;
     child_len = 0;
 
-    if (depth < g_utf8_strlen (text, -1))
+    if (*key_char)
     {
         /* process next letter */
 
-        gchar *key_char;
         gunichar key_char_uc;
         guint key;
+        guint pos;
 
-        key_char = g_utf8_offset_to_pointer (text, depth);
         key_char_uc = g_utf8_get_char (key_char);
         key = g_unichar_toupper (key_char_uc);
 
-        match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
-        if (match_qf)
+        pos = quickfill_find_child (qf, key);
+        if (pos < qf->n_matches && qf->matches[pos].key == key)
         {
+            match_qf = qf->matches[pos].qf;
+
             /* remove text from child qf */
-            gnc_quickfill_remove_recursive (match_qf, text, depth + 1, sort);
+            gnc_quickfill_remove_recursive (match_qf, text,
+                                            g_utf8_next_char (key_char), sort);
 
             if (match_qf->text == NULL)
             {
                 /* text was the only word with a prefix up to match_qf */
-                g_hash_table_remove (qf->matches, GUINT_TO_POINTER (key));
-                gnc_quickfill_destroy (match_qf);
+                quickfill_remove_child (qf, pos);
 
             }
             else
@@ -422,17 +461,9 @@ gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
         }
         else
         {
-            if (g_hash_table_size (qf->matches) != 0)
-            {
-                /* otherwise search for another good text */
-                struct _BestText bts;
-                bts.text = NULL;
-                bts.sort = sort;
-
-                g_hash_table_foreach (qf->matches, (GHFunc) best_text_helper, &bts);
-                best_text = bts.text;
-                best_len = (best_text == NULL) ? 0 : g_utf8_strlen (best_text, -1);
-            }
+            /* otherwise search for another good text */
+            best_text = best_child_text (qf);
+            best_len = (best_text == NULL) ? 0 : g_utf8_strlen (best_text, -1);
         }
 
         /* now replace or clear text */
@@ -40,8 +40,6 @@ typedef struct
 {
     GHashTable * event_masks;
     GHashTable * entity_events;
-
-    gboolean match;
 } ComponentEventInfo;
 
 typedef struct
@@ -64,8 +62,15 @@ static guint  suspend_counter = 0;
 static gint   next_component_id = 1;
 static GList *components = NULL;
 
-static ComponentEventInfo changes = { NULL, NULL, FALSE };
-static ComponentEventInfo changes_backup = { NULL, NULL, FALSE };
+static ComponentEventInfo changes = { NULL, NULL };
+static ComponentEventInfo changes_backup = { NULL, NULL };
+
+/* Reverse indexes from a watched entity (GncGUID --> GList of
+ * ComponentInfo) and from a watched entity type (QofIdType --> GList of
+ * ComponentInfo) to the components watching it, so that a refresh only
+ * looks at the components watching something that changed. */
+static GHashTable *watch_entity_index = NULL;
+static GHashTable *watch_type_index = NULL;
 
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -252,6 +257,126 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
         *mask = event_mask;
 }
 
+static void
+watch_index_add_entity (ComponentInfo *ci, const GncGUID *entity)
+{
+    gpointer key;
+    gpointer value;
+
+    if (!watch_entity_index)
+        watch_entity_index = guid_hash_table_new ();
+
+    if (g_hash_table_lookup_extended (watch_entity_index, entity, &key, &value))
+    {
+        if (g_list_find (value, ci))
+            return;
+        g_hash_table_insert (watch_entity_index, key, g_list_prepend (value, ci));
+    }
+    else
+    {
+        GncGUID *guid = guid_malloc ();
+
+        *guid = *entity;
+        g_hash_table_insert (watch_entity_index, guid, g_list_prepend (NULL, ci));
+    }
+}
+
+static void
+watch_index_remove_entity (ComponentInfo *ci, const GncGUID *entity)
+{
+    gpointer key;
+    gpointer value;
+    GList *list;
+
+    if (!watch_entity_index ||
+            !g_hash_table_lookup_extended (watch_entity_index, entity, &key, &value))
+        return;
+
+    list = g_list_remove (value, ci);
+    if (list)
+    {
+        g_hash_table_insert (watch_entity_index, key, list);
+        return;
+    }
+
+    g_hash_table_remove (watch_entity_index, key);
+    guid_free (key);
+}
+
+static void
+watch_index_add_type (ComponentInfo *ci, QofIdTypeConst entity_type)
+{
+    gpointer key;
+    gpointer value;
+
+    if (!watch_type_index)
+        watch_type_index = g_hash_table_new (g_str_hash, g_str_equal);
+
+    if (g_hash_table_lookup_extended (watch_type_index, entity_type, &key, &value))
+    {
+        if (g_list_find (value, ci))
+            return;
+        g_hash_table_insert (watch_type_index, key, g_list_prepend (value, ci));
+    }
+    else
+    {
+        key = qof_string_cache_insert ((gpointer) entity_type);
+        g_hash_table_insert (watch_type_index, key, g_list_prepend (NULL, ci));
+    }
+}
+
+static void
+watch_index_remove_type (ComponentInfo *ci, QofIdTypeConst entity_type)
+{
+    gpointer key;
+    gpointer value;
+    GList *list;
+
+    if (!watch_type_index ||
+            !g_hash_table_lookup_extended (watch_type_index, entity_type, &key, &value))
+        return;
+
+    list = g_list_remove (value, ci);
+    if (list)
+    {
+        g_hash_table_insert (watch_type_index, key, list);
+        return;
+    }
+
+    g_hash_table_remove (watch_type_index, key);
+    qof_string_cache_remove (key);
+}
+
+static void
+unindex_entity_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    watch_index_remove_entity (user_data, key);
+}
+
+static void
+unindex_type_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    watch_index_remove_type (user_data, key);
+}
+
+static gboolean
+destroy_entity_index_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    guid_free (key);
+    g_list_free (value);
+
+    return TRUE;
+}
+
+static gboolean
+destroy_type_index_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    qof_string_cache_remove (key);
+    g_list_free (value);
+
+    return TRUE;
+}
+
 static void
 gnc_cm_event_handler (QofInstance *entity,
                       QofEventId event_type,
@@ -322,6 +447,22 @@ gnc_component_manager_shutdown (void)
     destroy_event_hash (changes_backup.entity_events);
     changes_backup.entity_events = NULL;
 
+    if (watch_entity_index)
+    {
+        g_hash_table_foreach_remove (watch_entity_index,
+                                     destroy_entity_index_helper, NULL);
+        g_hash_table_destroy (watch_entity_index);
+        watch_entity_index = NULL;
+    }
+
+    if (watch_type_index)
+    {
+        g_hash_table_foreach_remove (watch_type_index,
+                                     destroy_type_index_helper, NULL);
+        g_hash_table_destroy (watch_type_index);
+        watch_type_index = NULL;
+    }
+
     qof_event_unregister_handler (handler_id);
 }
 
@@ -464,6 +605,11 @@ gnc_gui_component_watch_entity (gint component_id,
     }
 
     add_event (&ci->watch_info, entity, event_mask, FALSE);
+
+    if (event_mask)
+        watch_index_add_entity (ci, entity);
+    else
+        watch_index_remove_entity (ci, entity);
 }
 
 void
@@ -481,6 +627,8 @@ gnc_gui_component_watch_entity_type (gint component_id,
     }
 
     add_event_type (&ci->watch_info, entity_type, event_mask, FALSE);
+
+    watch_index_add_type (ci, entity_type);
 }
 
 const EventInfo *
@@ -504,6 +652,11 @@ gnc_gui_component_clear_watches (gint component_id)
         return;
     }
 
+    /* Cleared type watches keep a zero mask, so they stay indexed
+     * until the component is unregistered. */
+    g_hash_table_foreach (ci->watch_info.entity_events,
+                          unindex_entity_helper, ci);
+
     clear_event_info (&ci->watch_info);
 }
 
@@ -529,6 +682,9 @@ gnc_unregister_gui_component (gint component_id)
 
     components = g_list_remove (components, ci);
 
+    g_hash_table_foreach (ci->watch_info.event_masks,
+                          unindex_type_helper, ci);
+
     destroy_mask_hash (ci->watch_info.event_masks);
     ci->watch_info.event_masks = NULL;
 
@@ -597,72 +753,63 @@ gnc_resume_gui_refresh (void)
 static void
 match_type_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    ComponentEventInfo *cei = user_data;
-    QofIdType id_type = key;
+    GHashTable *matched = user_data;
     QofEventId * et = value;
-    QofEventId * et_2;
+    GList *node;
 
-    et_2 = g_hash_table_lookup (cei->event_masks, id_type);
-    if (!et_2)
-        return;
+    for (node = g_hash_table_lookup (watch_type_index, key); node; node = node->next)
+    {
+        ComponentInfo *ci = node->data;
+        QofEventId * et_2;
 
-    if (*et & *et_2)
-        cei->match = TRUE;
+        et_2 = g_hash_table_lookup (ci->watch_info.event_masks, key);
+        if (et_2 && (*et & *et_2))
+            g_hash_table_replace (matched, GINT_TO_POINTER (ci->component_id),
+                                  GINT_TO_POINTER (ci->component_id));
+    }
 }
 
 static void
 match_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    GncGUID *guid = key;
+    GHashTable *matched = user_data;
     EventInfo *ei_1 = value;
-    EventInfo *ei_2;
-    ComponentEventInfo *cei = user_data;
+    GList *node;
 
-    ei_2 = g_hash_table_lookup (cei->entity_events, guid);
-    if (!ei_2)
-        return;
+    for (node = g_hash_table_lookup (watch_entity_index, key); node; node = node->next)
+    {
+        ComponentInfo *ci = node->data;
+        EventInfo *ei_2;
 
-    if (ei_1->event_mask & ei_2->event_mask)
-        cei->match = TRUE;
+        ei_2 = g_hash_table_lookup (ci->watch_info.entity_events, key);
+        if (ei_2 && (ei_1->event_mask & ei_2->event_mask))
+            g_hash_table_replace (matched, GINT_TO_POINTER (ci->component_id),
+                                  GINT_TO_POINTER (ci->component_id));
+    }
 }
 
-static gboolean
-changes_match (ComponentEventInfo *cei, ComponentEventInfo *changes)
+/* Return the set of ids of the components watching one of the changes.
+ * The changes are looked up in the watch indexes, so the cost depends
+ * on the number of changed entities rather than on the number of
+ * components and the entities they watch. */
+static GHashTable *
+find_matching_components (ComponentEventInfo *changes)
 {
-    ComponentEventInfo *big_cei;
-    GHashTable *smalltable;
+    GHashTable *matched = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-    if (cei == NULL)
-        return FALSE;
+    if (watch_type_index)
+        g_hash_table_foreach (changes->event_masks, match_type_helper, matched);
 
-    /* check types first, for efficiency */
-    cei->match = FALSE;
-    g_hash_table_foreach (changes->event_masks, match_type_helper, cei);
-    if (cei->match)
-        return TRUE;
+    if (watch_entity_index)
+        g_hash_table_foreach (changes->entity_events, match_helper, matched);
 
-    if (g_hash_table_size (cei->entity_events) <=
-            g_hash_table_size (changes->entity_events))
-    {
-        smalltable = cei->entity_events;
-        big_cei = changes;
-    }
-    else
-    {
-        smalltable = changes->entity_events;
-        big_cei = cei;
-    }
-
-    big_cei->match = FALSE;
-
-    g_hash_table_foreach (smalltable, match_helper, big_cei);
-
-    return big_cei->match;
+    return matched;
 }
 
 static void
 gnc_gui_refresh_internal (gboolean force)
 {
+    GHashTable *matched = NULL;
     GList *list;
     GList *node;
 
@@ -689,6 +836,9 @@ gnc_gui_refresh_internal (gboolean force)
 
     list = find_component_ids_by_class (NULL);
 
+    if (!force)
+        matched = find_matching_components (&changes_backup);
+
     for (node = list; node; node = node->next)
     {
         ComponentInfo *ci = find_component (GPOINTER_TO_INT (node->data));
@@ -714,7 +864,7 @@ gnc_gui_refresh_internal (gboolean force)
                 ci->refresh_handler (NULL, ci->user_data);
             }
         }
-        else if (changes_match (&ci->watch_info, &changes_backup))
+        else if (g_hash_table_lookup_extended (matched, node->data, NULL, NULL))
         {
             if (ci->refresh_handler)
             {
@@ -735,6 +885,8 @@ gnc_gui_refresh_internal (gboolean force)
     clear_event_info (&changes_backup);
     got_events = FALSE;
 
+    if (matched)
+        g_hash_table_destroy (matched);
     g_list_free (list);
 
     gnc_resume_gui_refresh ();
@@ -0,0 +1,275 @@
+/********************************************************************\
+ * gnc-trans-quickfill.c -- Create transaction text quick-fills     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+#include "gnc-trans-quickfill.h"
+#include "engine/gnc-event.h"
+#include "engine/gnc-engine.h"
+#include "engine/Account.h"
+#include "engine/Transaction.h"
+
+/* This static indicates the debugging module that this .o belongs to. */
+static QofLogModule log_module = GNC_MOD_REGISTER;
+
+/* Number of transactions added to the quickfills per idle call. */
+#define TRANS_QF_CHUNK 500
+
+typedef struct
+{
+    QuickFill *qf_desc;
+    QuickFill *qf_notes;
+    QuickFill *qf_memo;
+    QuickFillSort qf_sort;
+    QofBook *book;
+    GncGUID account;    /* whose transactions are offered */
+    gint  listener;
+    GArray *pending;    /* GUIDs of transactions not yet added */
+    guint pending_pos;
+    GHashTable *handled; /* GUIDs the event handler requeued */
+    guint idle_id;
+} TransQF;
+
+static gboolean
+trans_qf_has_account (TransQF *qfb, Transaction *trans)
+{
+    Account *account = xaccAccountLookup (&qfb->account, qfb->book);
+    GList *node;
+
+    if (!account)
+        return FALSE;
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        if (xaccSplitGetAccount (node->data) == account)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+trans_qf_add (TransQF *qfb, Transaction *trans)
+{
+    const char *str;
+    GList *node;
+
+    str = xaccTransGetDescription (trans);
+    if (str && *str)
+        gnc_quickfill_insert (qfb->qf_desc, str, qfb->qf_sort);
+
+    str = xaccTransGetNotes (trans);
+    if (str && *str)
+        gnc_quickfill_insert (qfb->qf_notes, str, qfb->qf_sort);
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        str = xaccSplitGetMemo (node->data);
+        if (str && *str)
+            gnc_quickfill_insert (qfb->qf_memo, str, qfb->qf_sort);
+    }
+}
+
+static void
+listen_for_trans_events (QofInstance *entity,  QofEventId event_type,
+                         gpointer user_data, gpointer event_data)
+{
+    TransQF *qfb = user_data;
+
+    /* We only listen for Transaction events */
+    if (!GNC_IS_TRANS (entity))
+        return;
+
+    /* A committed transaction sends MODIFY; add its strings so that
+     * they are offered first. */
+    if (0 == (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_ADD)))
+        return;
+
+    if (qof_instance_get_book (entity) != qfb->book)
+        return;
+    if (!trans_qf_has_account (qfb, GNC_TRANS (entity)))
+        return;
+
+    trans_qf_add (qfb, GNC_TRANS (entity));
+
+    /* The idle build would add older strings after these and so
+     * offer them first.  Add this transaction again once it is done,
+     * and skip it where it was in the list. */
+    if (qfb->pending)
+    {
+        const GncGUID *guid = qof_instance_get_guid (entity);
+
+        g_array_append_val (qfb->pending, *guid);
+        g_hash_table_insert (qfb->handled, guid_copy (guid),
+                             GUINT_TO_POINTER (qfb->pending->len - 1));
+    }
+}
+
+static gboolean
+trans_qf_load_idle (gpointer user_data)
+{
+    TransQF *qfb = user_data;
+    QofCollection *col;
+    guint end;
+
+    col = qof_book_get_collection (qfb->book, GNC_ID_TRANS);
+    end = MIN (qfb->pending_pos + TRANS_QF_CHUNK, qfb->pending->len);
+
+    /* Transactions deleted since the list was taken are skipped, and
+     * so are those the event handler queued again further on. */
+    for (; qfb->pending_pos < end; qfb->pending_pos++)
+    {
+        GncGUID *guid = &g_array_index (qfb->pending, GncGUID, qfb->pending_pos);
+        gpointer last;
+        QofInstance *inst;
+
+        if (g_hash_table_lookup_extended (qfb->handled, guid, NULL, &last) &&
+                GPOINTER_TO_UINT (last) != qfb->pending_pos)
+            continue;
+        inst = qof_collection_lookup_entity (col, guid);
+        if (inst)
+            trans_qf_add (qfb, GNC_TRANS (inst));
+    }
+
+    if (qfb->pending_pos < qfb->pending->len)
+        return TRUE;
+
+    DEBUG ("added %u transactions to the quickfills", qfb->pending->len);
+    g_array_free (qfb->pending, TRUE);
+    qfb->pending = NULL;
+    g_hash_table_destroy (qfb->handled);
+    qfb->handled = NULL;
+    qfb->idle_id = 0;
+    return FALSE;
+}
+
+static void
+trans_qf_destroy (gpointer data)
+{
+    TransQF *qfb = data;
+
+    if (qfb->idle_id)
+        g_source_remove (qfb->idle_id);
+    if (qfb->pending)
+        g_array_free (qfb->pending, TRUE);
+    if (qfb->handled)
+        g_hash_table_destroy (qfb->handled);
+    gnc_quickfill_destroy (qfb->qf_desc);
+    gnc_quickfill_destroy (qfb->qf_notes);
+    gnc_quickfill_destroy (qfb->qf_memo);
+    qof_event_unregister_handler (qfb->listener);
+    g_free (qfb);
+}
+
+static void
+shared_quickfill_destroy (QofBook *book, gpointer key, gpointer user_data)
+{
+    g_hash_table_destroy ((GHashTable *) user_data);
+}
+
+static TransQF* build_shared_quickfill (QofBook *book, Account *account)
+{
+    TransQF *result;
+    GHashTable *seen;
+    GList *node;
+
+    result = g_new0(TransQF, 1);
+
+    result->qf_desc = gnc_quickfill_new();
+    result->qf_notes = gnc_quickfill_new();
+    result->qf_memo = gnc_quickfill_new();
+    result->qf_sort = QUICKFILL_LIFO;
+    result->book = book;
+    result->account = *qof_entity_get_guid (QOF_INSTANCE (account));
+
+    /* Remember the transactions in the account's order, oldest first,
+     * so that the newest use of a string wins, and fill the quickfills
+     * from the idle loop. */
+    result->pending = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+    result->handled = g_hash_table_new_full (guid_hash_to_guint,
+                      guid_g_hash_table_equal,
+                      (GDestroyNotify) guid_free, NULL);
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        if (!trans || g_hash_table_lookup (seen, trans))
+            continue;
+        g_hash_table_insert (seen, trans, trans);
+        g_array_append_val (result->pending,
+                            *qof_instance_get_guid (QOF_INSTANCE (trans)));
+    }
+    g_hash_table_destroy (seen);
+
+    result->idle_id = g_idle_add (trans_qf_load_idle, result);
+
+    result->listener =
+        qof_event_register_handler (listen_for_trans_events,
+                                    result);
+
+    return result;
+}
+
+static TransQF *
+get_shared_quickfill (Account *account, const char * key)
+{
+    QofBook *book;
+    GHashTable *quickfills;
+    TransQF *qfb;
+
+    g_assert(account);
+    g_assert(key);
+
+    book = gnc_account_get_book (account);
+    quickfills = qof_book_get_data (book, key);
+    if (!quickfills)
+    {
+        quickfills = g_hash_table_new_full (guid_hash_to_guint,
+                                            guid_g_hash_table_equal,
+                                            (GDestroyNotify) guid_free,
+                                            trans_qf_destroy);
+        qof_book_set_data_fin (book, key, quickfills, shared_quickfill_destroy);
+    }
+
+    qfb = g_hash_table_lookup (quickfills,
+                               qof_entity_get_guid (QOF_INSTANCE (account)));
+    if (!qfb)
+    {
+        qfb = build_shared_quickfill (book, account);
+        g_hash_table_insert (quickfills, guid_copy (&qfb->account), qfb);
+    }
+
+    return qfb;
+}
+
+QuickFill * gnc_get_shared_trans_desc_quickfill (Account *account, const char * key)
+{
+    return get_shared_quickfill (account, key)->qf_desc;
+}
+
+QuickFill * gnc_get_shared_trans_notes_quickfill (Account *account, const char * key)
+{
+    return get_shared_quickfill (account, key)->qf_notes;
+}
+
+QuickFill * gnc_get_shared_split_memo_quickfill (Account *account, const char * key)
+{
+    return get_shared_quickfill (account, key)->qf_memo;
+}
@@ -0,0 +1,86 @@
+/********************************************************************\
+ * gnc-trans-quickfill.h -- Create transaction text quick-fills     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @addtogroup QuickFill Auto-complete typed user input.
+   @{
+*/
+/** Similar to the @ref Account_QuickFill account name quickfill, we
+ * create cached quickfills with the descriptions, notes and split
+ * memos of the transactions of an account, so that opening its
+ * register does not have to rebuild them every time.  They only
+ * offer strings of transactions with a split in that account, the
+ * same ones description auto-fill searches, so scheduled transaction
+ * templates and other accounts' transactions are never offered.
+*/
+
+#ifndef GNC_TRANS_QUICKFILL_H
+#define GNC_TRANS_QUICKFILL_H
+
+#include "qof.h"
+#include "engine/Account.h"
+#include "app-utils/QuickFill.h"
+
+/** Create/fetch a quickfill of Transaction description strings.
+ *
+ *  Each account has its own quickfill, and multiple, distinct
+ *  quickfills, for different uses, are allowed.  Each use is
+ *  identified with the 'key'.  Be sure to use distinct,
+ *  unique keys that don't conflict with other users of QofBook.
+ *
+ *  The quickfill is returned at once but filled from the idle loop,
+ *  a block of transactions at a time and in the order of the
+ *  account's splits, so that the most recent use of a string is the
+ *  one offered.  Meanwhile and after that this code listens to
+ *  commit events of the account's transactions and adds their
+ *  strings to the quickfill list.  Strings of deleted
+ *  transactions are not removed.
+ *
+ * \param account The account whose transactions are offered
+ * \param key The identifier to look up the shared object in the book
+ *
+ * \return The shared QuickFill object which is created on first
+ * calling of this function and subsequently looked up in the book by
+ * using the key and the account.
+ */
+QuickFill * gnc_get_shared_trans_desc_quickfill (Account *account,
+        const char * key);
+
+/** Create/fetch a quickfill of Transaction notes strings.
+ *
+ * Identical to gnc_get_shared_trans_desc_quickfill(). You should
+ * also use the same key as for the other function because the
+ * internal quickfills are updated simultaneously.
+ */
+QuickFill * gnc_get_shared_trans_notes_quickfill (Account *account,
+        const char * key);
+
+/** Create/fetch a quickfill of Split memo strings.
+ *
+ * Identical to gnc_get_shared_trans_desc_quickfill(). You should
+ * also use the same key as for the other function because the
+ * internal quickfills are updated simultaneously.
+ */
+QuickFill * gnc_get_shared_split_memo_quickfill (Account *account,
+        const char * key);
+
+#endif
+
+/** @} */
@@ -95,6 +95,11 @@ static provider_functions_t provider_sqlite3 =
     conn_drop_index_sqlite3
 };
 #define SQLITE3_TIMESPEC_STR_FORMAT "%04d%02d%02d%02d%02d%02d"
+/* LIKE only folds ASCII case */
+static const GncSqlQueryDialect sqlite3_query_dialect =
+{
+    FALSE, "LIKE"
+};
 
 static /*@ null @*/ gchar* conn_create_table_ddl_mysql( GncSqlConnection* conn,
         const gchar* table_name,
@@ -111,6 +116,11 @@ static provider_functions_t provider_mysql =
     conn_drop_index_mysql
 };
 #define MYSQL_TIMESPEC_STR_FORMAT "%04d%02d%02d%02d%02d%02d"
+/* The database is created with a case-insensitive collation */
+static const GncSqlQueryDialect mysql_query_dialect =
+{
+    FALSE, "LIKE"
+};
 
 static /*@ null @*/ gchar* conn_create_table_ddl_pgsql( GncSqlConnection* conn,
         const gchar* table_name,
@@ -129,6 +139,10 @@ static provider_functions_t provider_pgsql =
     conn_drop_index_pgsql
 };
 #define PGSQL_TIMESPEC_STR_FORMAT "%04d%02d%02d %02d%02d%02d"
+static const GncSqlQueryDialect pgsql_query_dialect =
+{
+    TRUE, "ILIKE"
+};
 
 static gboolean gnc_dbi_lock_database( QofBackend *qbe, gboolean ignore_lock );
 static void gnc_dbi_unlock( QofBackend *qbe );
@@ -150,6 +164,10 @@ static GncDbiTestResult conn_test_dbi_library( dbi_conn conn );
 
 #define DBI_MAX_CONN_ATTEMPTS 5
 
+/* Largest GNC_SQL_LOAD_MONTHS; a window reaching back past year 1 can't
+ * be computed and isn't a window anyway. */
+#define DBI_MAX_LOAD_MONTHS (12 * 1000)
+
 /* ================================================================= */
 
 /* Free the contents of a GSList, then free the list. Don't use this
@@ -363,6 +381,7 @@ gnc_dbi_sqlite3_session_begin( QofBackend *qbe, QofSession *session,
     }
     be->sql_be.conn = create_dbi_connection( GNC_DBI_PROVIDER_SQLITE, qbe, be->conn );
     be->sql_be.timespec_format = SQLITE3_TIMESPEC_STR_FORMAT;
+    be->sql_be.query_dialect = &sqlite3_query_dialect;
 
     /* We should now have a proper session set up.
      * Let's start logging */
@@ -940,6 +959,7 @@ gnc_dbi_mysql_session_begin( QofBackend* qbe, QofSession *session,
         be->sql_be.conn = create_dbi_connection( GNC_DBI_PROVIDER_MYSQL, qbe, be->conn );
     }
     be->sql_be.timespec_format = MYSQL_TIMESPEC_STR_FORMAT;
+    be->sql_be.query_dialect = &mysql_query_dialect;
 
     /* We should now have a proper session set up.
      * Let's start logging */
@@ -1265,6 +1285,7 @@ gnc_dbi_postgres_session_begin( QofBackend *qbe, QofSession *session,
         be->sql_be.conn = create_dbi_connection( GNC_DBI_PROVIDER_PGSQL, qbe, be->conn );
     }
     be->sql_be.timespec_format = PGSQL_TIMESPEC_STR_FORMAT;
+    be->sql_be.query_dialect = &pgsql_query_dialect;
 
     /* We should now have a proper session set up.
      * Let's start logging */
@@ -1330,6 +1351,13 @@ gnc_dbi_session_end( QofBackend *be_start )
 
     ENTER (" ");
 
+    /* Write anything still waiting in the write-behind queue, if the
+       database is still there, and stop its timer in any case */
+    if ( be->sql_be.write_behind != NULL )
+    {
+        gnc_sql_set_write_behind( &be->sql_be, FALSE );
+    }
+
     if ( be->conn != NULL )
     {
         gnc_dbi_unlock( be_start );
@@ -1342,6 +1370,7 @@ gnc_dbi_session_end( QofBackend *be_start )
         be->sql_be.conn = NULL;
     }
     gnc_sql_finalize_version_info( &be->sql_be );
+    gnc_sql_clear_dirty_sets( &be->sql_be );
 
     LEAVE (" ");
 }
@@ -1599,12 +1628,40 @@ gnc_dbi_sync_all( QofBackend* qbe, /*@ dependent @*/ QofBook *book )
 }
 #endif
 
+/**
+ * Checks whether the database already holds this book in the current
+ * schema, so that only the objects which are not yet written need to be
+ * saved.  A book coming from another backend (Save As) or a database
+ * which needs to be upgraded has to be rewritten completely.
+ *
+ * @param be: DBI backend for the session.
+ * @param book: QofBook to be saved in the database.
+ * @return TRUE if an incremental save is enough
+ */
+static gboolean
+can_sync_incrementally( GncDbiBackend *be, QofBook *book )
+{
+    if ( be->sql_be.book != book || be->primary_book != book ) return FALSE;
+    if ( be->sql_be.is_pristine_db ) return FALSE;
+    if ( GNUCASH_RESAVE_VERSION > gnc_sql_get_table_version( &be->sql_be,
+            "Gnucash" ) )
+        return FALSE;
+    if ( GNUCASH_RESAVE_VERSION < gnc_sql_get_table_version( &be->sql_be,
+            "Gnucash-Resave" ) )
+        return FALSE;
+    return TRUE;
+}
+
 /**
  * Safely resave a database by renaming all of its tables, recreating
  * everything, and then dropping the backup tables only if there were
  * no errors. If there are errors, drop the new tables and restore the
  * originals.
  *
+ * If the database already holds this book in the current schema, only
+ * the objects which have not been written yet are saved, in a single
+ * database transaction, and the tables are left alone.
+ *
  * @param qbe: QofBackend for the session.
  * @param book: QofBook to be saved in the database.
  */
@@ -1620,6 +1677,21 @@ gnc_dbi_safe_sync_all( QofBackend *qbe, QofBook *book )
     g_return_if_fail( book != NULL );
 
     ENTER( "book=%p, primary=%p", book, be->primary_book );
+
+    if ( can_sync_incrementally( be, book ) )
+    {
+        (void)gnc_sql_sync_dirty( &be->sql_be, book );
+        LEAVE( "book=%p, incremental", book );
+        return;
+    }
+
+    /* Everything is about to be rewritten from memory, so anything that
+     * was left out of a windowed load has to be brought in first. */
+    if ( be->sql_be.load_window_months > 0 && be->sql_be.book == book )
+    {
+        gnc_sql_load( &be->sql_be, book, LOAD_TYPE_LOAD_ALL );
+    }
+
     dbname = dbi_conn_get_option( be->conn, "dbname" );
     table_list = conn->provider->get_table_list( conn->conn, dbname );
     if ( !conn_table_operation( (GncSqlConnection*)conn, table_list,
@@ -1706,6 +1778,7 @@ static void
 init_sql_backend( GncDbiBackend* dbi_be )
 {
     QofBackend* be;
+    const gchar* months_str;
 
     be = (QofBackend*)dbi_be;
 
@@ -1740,6 +1813,31 @@ init_sql_backend( GncDbiBackend* dbi_be )
 
     dbi_be->sql_be.conn = NULL;
     dbi_be->sql_be.book = NULL;
+
+    /* Queue commits and write them in batches instead of one database
+     * transaction per commit.  Useful with high-latency servers. */
+    if ( g_getenv( "GNC_SQL_WRITE_BEHIND" ) != NULL )
+        gnc_sql_set_write_behind( &dbi_be->sql_be, TRUE );
+
+    /* Only load the transactions of the last N months at startup; older
+     * ones are loaded when a query needs them. */
+    months_str = g_getenv( "GNC_SQL_LOAD_MONTHS" );
+    if ( months_str != NULL )
+    {
+        gchar* end;
+        gint64 months = g_ascii_strtoll( months_str, &end, 10 );
+
+        if ( end == months_str || *end != '\0'
+                || months < 0 || months > DBI_MAX_LOAD_MONTHS )
+        {
+            PWARN( "Ignoring GNC_SQL_LOAD_MONTHS=\"%s\", which is not a number of months from 0 to %d; loading all transactions",
+                   months_str, DBI_MAX_LOAD_MONTHS );
+        }
+        else
+        {
+            gnc_sql_set_load_window( &dbi_be->sql_be, (gint)months );
+        }
+    }
 }
 
 static QofBackend*
@@ -2856,6 +2954,31 @@ conn_create_table( GncSqlConnection* conn, const gchar* table_name,
     return TRUE;
 }
 
+/* Whether the database has an index called index_name on table_name.
+ * MySQL index names are only unique per table, so its list holds
+ * "<index> <table>". */
+static gboolean
+conn_index_exists( GncDbiSqlConnection* dbi_conn, const gchar* index_name,
+                   const gchar* table_name )
+{
+    GSList* index_list;
+    GSList* iter;
+    gchar* qualified_name;
+    gboolean found = FALSE;
+
+    index_list = dbi_conn->provider->get_index_list( dbi_conn->conn );
+    qualified_name = g_strjoin( " ", index_name, table_name, NULL );
+    for ( iter = index_list; iter != NULL && !found; iter = g_slist_next( iter ) )
+    {
+        found = ( g_strcmp0( iter->data, index_name ) == 0
+                  || g_strcmp0( iter->data, qualified_name ) == 0 );
+    }
+    g_free( qualified_name );
+    gnc_table_slist_free( index_list );
+
+    return found;
+}
+
 static gboolean
 conn_create_index( /*@ unused @*/ GncSqlConnection* conn, /*@ unused @*/ const gchar* index_name,
                                   /*@ unused @*/ const gchar* table_name, /*@ unused @*/ const GncSqlColumnTableEntry* col_table )
@@ -2869,6 +2992,12 @@ conn_create_index( /*@ unused @*/ GncSqlConnection* conn, /*@ unused @*/ const g
     g_return_val_if_fail( table_name != NULL, FALSE );
     g_return_val_if_fail( col_table != NULL, FALSE );
 
+    /* Not every database knows CREATE INDEX IF NOT EXISTS */
+    if ( conn_index_exists( dbi_conn, index_name, table_name ) )
+    {
+        return TRUE;
+    }
+
     ddl = create_index_ddl( conn, index_name, table_name, col_table );
     if ( ddl != NULL )
     {
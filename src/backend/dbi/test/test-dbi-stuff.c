@@ -34,6 +34,7 @@
 #include "Account.h"
 #include "Split.h"
 #include "Transaction.h"
+#include "Query.h"
 #include "gnc-commodity.h"
 #include <SX-book.h>
 #include <gnc-lot.h>
@@ -214,7 +215,7 @@ test_conn_index_functions( QofBackend *qbe )
     index_list = conn->provider->get_index_list( be->conn );
     g_test_message ( "Returned from index list\n");
     g_assert (index_list != NULL);
-    g_assert_cmpint (g_slist_length( index_list ), ==, 4);
+    g_assert_cmpint (g_slist_length( index_list ), ==, 6);
     for ( iter = index_list; iter != NULL; iter = g_slist_next( iter) )
     {
         const char *errmsg;
@@ -300,6 +301,384 @@ test_dbi_store_and_reload( const gchar* driver, QofSession* session_1, const gch
     g_log_set_default_handler (dhdlr, NULL);
 }
 
+#define WINDOW_TEST_MONTHS 36
+#define WINDOW_TEST_LOAD_MONTHS "12"
+
+static Account*
+make_usd_account( QofBook* book, const gchar* name, GNCAccountType type )
+{
+    gnc_commodity* usd;
+    Account* acct = xaccMallocAccount( book );
+
+    usd = gnc_commodity_table_lookup( gnc_commodity_table_get_table( book ),
+                                      GNC_COMMODITY_NS_CURRENCY, "USD" );
+    xaccAccountBeginEdit( acct );
+    xaccAccountSetName( acct, name );
+    xaccAccountSetType( acct, type );
+    xaccAccountSetCommodity( acct, usd );
+    gnc_account_append_child( gnc_book_get_root_account( book ), acct );
+    xaccAccountCommitEdit( acct );
+    return acct;
+}
+
+/* Monthly transactions between two accounts over the last three years,
+ * half a month off the month boundaries, some cleared or reconciled. */
+static void
+fill_window_book( QofBook* book )
+{
+    gnc_commodity* usd;
+    Account* bank;
+    Account* income;
+    gint i;
+
+    usd = gnc_commodity_table_lookup( gnc_commodity_table_get_table( book ),
+                                      GNC_COMMODITY_NS_CURRENCY, "USD" );
+    bank = make_usd_account( book, "Bank", ACCT_TYPE_BANK );
+    income = make_usd_account( book, "Income", ACCT_TYPE_INCOME );
+
+    for ( i = 0; i < WINDOW_TEST_MONTHS; i++ )
+    {
+        Transaction* tx = xaccMallocTransaction( book );
+        Split* to_bank = xaccMallocSplit( book );
+        Split* from_income = xaccMallocSplit( book );
+        gnc_numeric amount = gnc_numeric_create( 10000 + i, 100 );
+        gchar* description = g_strdup_printf( "Month %d", i );
+        GDate date;
+
+        g_date_clear( &date, 1 );
+        g_date_set_time_t( &date, time( NULL ) );
+        g_date_subtract_months( &date, (guint)i );
+        g_date_subtract_days( &date, 15 );
+
+        xaccTransBeginEdit( tx );
+        xaccTransSetCurrency( tx, usd );
+        xaccTransSetDatePostedGDate( tx, date );
+        xaccTransSetDateEnteredSecs( tx, time( NULL ) );
+        xaccTransSetDescription( tx, description );
+
+        xaccSplitSetParent( to_bank, tx );
+        xaccSplitSetAccount( to_bank, bank );
+        xaccSplitSetValue( to_bank, amount );
+        xaccSplitSetAmount( to_bank, amount );
+        xaccSplitSetReconcile( to_bank, i % 3 == 0 ? YREC : i % 3 == 1 ? CREC : NREC );
+
+        xaccSplitSetParent( from_income, tx );
+        xaccSplitSetAccount( from_income, income );
+        xaccSplitSetValue( from_income, gnc_numeric_neg( amount ) );
+        xaccSplitSetAmount( from_income, gnc_numeric_neg( amount ) );
+
+        xaccTransCommitEdit( tx );
+        g_free( description );
+    }
+}
+
+static void
+compare_account_balances( QofInstance* inst, gpointer user_data )
+{
+    CompareInfoStruct* info = (CompareInfoStruct*)user_data;
+    Account* acct_1 = GNC_ACCOUNT(inst);
+    Account* acct_2 = xaccAccountLookup( qof_instance_get_guid( inst ),
+                                         info->book_2 );
+
+    g_assert (acct_2 != NULL);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct_1),
+                                 xaccAccountGetBalance (acct_2)));
+    g_assert (gnc_numeric_equal (xaccAccountGetClearedBalance (acct_1),
+                                 xaccAccountGetClearedBalance (acct_2)));
+    g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct_1),
+                                 xaccAccountGetReconciledBalance (acct_2)));
+}
+
+typedef struct
+{
+    QofBook* book;
+    Timespec since;
+} window_check_t;
+
+/* A transaction of the fully loaded book must be in the windowed one
+ * exactly when it was posted since the watermark. */
+static void
+check_window_tx( QofInstance* inst, gpointer user_data )
+{
+    window_check_t* check = (window_check_t*)user_data;
+    Timespec posted = xaccTransRetDatePostedTS( GNC_TRANS(inst) );
+    Transaction* tx = xaccTransLookup( qof_instance_get_guid( inst ),
+                                       check->book );
+
+    if ( timespec_cmp( &posted, &check->since ) >= 0 )
+        g_assert (tx != NULL);
+}
+
+static void
+check_window( QofBook* full, QofSession* windowed, gboolean exact )
+{
+    QofBook* book = qof_session_get_book( windowed );
+    GncSqlBackend* sql_be = (GncSqlBackend*)qof_session_get_backend( windowed );
+    window_check_t check;
+    CompareInfoStruct info;
+    QofCollection* coll;
+
+    check.book = book;
+    check.since = sql_be->tx_loaded_since;
+    g_assert (check.since.tv_sec != G_MAXINT64);
+    g_assert (check.since.tv_sec != G_MININT64);
+    coll = qof_book_get_collection( full, GNC_ID_TRANS );
+    qof_collection_foreach( coll, check_window_tx, &check );
+
+    /* Nothing older than the watermark until a query needs it */
+    if ( exact )
+    {
+        check.book = full;
+        coll = qof_book_get_collection( book, GNC_ID_TRANS );
+        qof_collection_foreach( coll, check_window_tx, &check );
+        g_assert_cmpint (qof_collection_count( coll ), <,
+                         qof_collection_count( qof_book_get_collection( full,
+                                               GNC_ID_TRANS ) ));
+    }
+
+    info.book_1 = full;
+    info.book_2 = book;
+    info.result = TRUE;
+    coll = qof_book_get_collection( full, GNC_ID_ACCOUNT );
+    qof_collection_foreach( coll, compare_account_balances, &info );
+}
+
+/* Only the transactions the window asks for are loaded, and account
+ * balances are those of a full load.  A query for an old transaction
+ * loads everything since, so that the watermark still holds.  A bad
+ * GNC_SQL_LOAD_MONTHS is ignored. */
+void
+test_dbi_load_window( const gchar* driver, const gchar* url )
+{
+    QofSession* session_1;
+    QofSession* session_2;
+    QofSession* full;
+    QofSession* windowed;
+    QofQuery* query;
+    GList* found;
+    Timespec since;
+    GDate date;
+
+    gchar *msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    gchar *env_msg = "[init_sql_backend()] Ignoring GNC_SQL_LOAD_MONTHS=\"12x\", which is not a number of months from 0 to 12000; loading all transactions";
+    gchar *log_domain = "gnc.backend.dbi";
+    guint loglevel = G_LOG_LEVEL_WARNING | G_LOG_FLAG_FATAL, hdlr;
+    TestErrorStruct check = { loglevel, log_domain, msg, 0 };
+    TestErrorStruct env_check = { loglevel, log_domain, env_msg, 0 };
+    GLogFunc dhdlr = g_log_set_default_handler ((GLogFunc)test_null_handler,
+                                                &check);
+    g_test_log_set_fatal_handler ((GTestLogFatalFunc)test_checked_handler,
+                                  &check);
+
+    g_test_message ( "Testing load window %s\n", driver );
+
+    session_1 = qof_session_new();
+    fill_window_book( qof_session_get_book( session_1 ) );
+    session_2 = qof_session_new();
+    hdlr = g_log_set_handler (log_domain, loglevel,
+                              (GLogFunc)test_checked_handler, &check);
+    qof_session_begin( session_2, url, FALSE, TRUE, TRUE );
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_swap_data( session_1, session_2 );
+    qof_session_save( session_2, NULL );
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_end( session_2 );
+    qof_session_destroy( session_2 );
+    qof_session_destroy( session_1 );
+
+    full = qof_session_new();
+    qof_session_begin( full, url, TRUE, FALSE, FALSE );
+    qof_session_load( full, NULL );
+    g_assert_cmpint (qof_session_get_error (full), ==, ERR_BACKEND_NO_ERR);
+
+    g_setenv( "GNC_SQL_LOAD_MONTHS", WINDOW_TEST_LOAD_MONTHS, TRUE );
+    windowed = qof_session_new();
+    qof_session_begin( windowed, url, TRUE, FALSE, FALSE );
+    qof_session_load( windowed, NULL );
+    g_unsetenv( "GNC_SQL_LOAD_MONTHS" );
+    g_assert_cmpint (qof_session_get_error (windowed), ==, ERR_BACKEND_NO_ERR);
+
+    g_date_clear( &date, 1 );
+    g_date_set_time_t( &date, time( NULL ) );
+    g_date_subtract_months( &date, 12 );
+    since = gdate_to_timespec( date );
+    g_assert (timespec_equal (&((GncSqlBackend*)qof_session_get_backend( windowed ))->tx_loaded_since,
+                              &since));
+    check_window( qof_session_get_book( full ), windowed, TRUE );
+
+    query = qof_query_create_for( GNC_ID_SPLIT );
+    qof_query_set_book( query, qof_session_get_book( windowed ) );
+    xaccQueryAddDescriptionMatch( query, "Month 30", TRUE, FALSE, QOF_QUERY_AND );
+    found = qof_query_run( query );
+    g_assert_cmpint (g_list_length( found ), ==, 2);
+    since = xaccTransRetDatePostedTS( xaccSplitGetParent( found->data ) );
+    qof_query_destroy( query );
+    g_assert (timespec_equal (&((GncSqlBackend*)qof_session_get_backend( windowed ))->tx_loaded_since,
+                              &since));
+    check_window( qof_session_get_book( full ), windowed, FALSE );
+
+    qof_session_end( windowed );
+    qof_session_destroy( windowed );
+
+    g_setenv( "GNC_SQL_LOAD_MONTHS", "12x", TRUE );
+    g_log_remove_handler (log_domain, hdlr);
+    hdlr = g_log_set_handler (log_domain, loglevel,
+                              (GLogFunc)test_checked_handler, &env_check);
+    windowed = qof_session_new();
+    qof_session_begin( windowed, url, TRUE, FALSE, FALSE );
+    g_unsetenv( "GNC_SQL_LOAD_MONTHS" );
+    g_assert_cmpint (env_check.hits, ==, 1);
+    g_log_remove_handler (log_domain, hdlr);
+    hdlr = g_log_set_handler (log_domain, loglevel,
+                              (GLogFunc)test_checked_handler, &check);
+    g_assert_cmpint (((GncSqlBackend*)qof_session_get_backend( windowed ))->load_window_months, ==, 0);
+    qof_session_end( windowed );
+    qof_session_destroy( windowed );
+
+    qof_session_end( full );
+    qof_session_destroy( full );
+    g_log_remove_handler (log_domain, hdlr);
+    g_log_set_default_handler (dhdlr, NULL);
+}
+
+/* One more transaction than the backend loads in one query, so that the
+ * splits with their slots come in two batches, and so do the slots of
+ * the transactions, which hold their notes. */
+#define BATCH_TEST_TXS (GNC_SQL_MAX_GUIDS_PER_QUERY + 1)
+#define BATCH_TEST_SLOT "batch-test/index"
+
+/* Transactions numbered in their notes, each with two splits numbered
+ * in a slot. */
+static void
+fill_batch_book( QofBook* book )
+{
+    gnc_commodity* usd;
+    Account* bank;
+    Account* income;
+    gint i;
+
+    usd = gnc_commodity_table_lookup( gnc_commodity_table_get_table( book ),
+                                      GNC_COMMODITY_NS_CURRENCY, "USD" );
+    bank = make_usd_account( book, "Bank", ACCT_TYPE_BANK );
+    income = make_usd_account( book, "Income", ACCT_TYPE_INCOME );
+
+    for ( i = 0; i < BATCH_TEST_TXS; i++ )
+    {
+        Transaction* tx = xaccMallocTransaction( book );
+        Split* to_bank = xaccMallocSplit( book );
+        Split* from_income = xaccMallocSplit( book );
+        gnc_numeric amount = gnc_numeric_create( 100 + i, 100 );
+        gchar* notes = g_strdup_printf( "%d", i );
+
+        xaccTransBeginEdit( tx );
+        xaccTransSetCurrency( tx, usd );
+        xaccTransSetDatePostedSecs( tx, time( NULL ) - i * 3600 );
+        xaccTransSetDateEnteredSecs( tx, time( NULL ) );
+        xaccTransSetDescription( tx, "Batch" );
+        xaccTransSetNotes( tx, notes );
+
+        xaccSplitSetParent( to_bank, tx );
+        xaccSplitSetAccount( to_bank, bank );
+        xaccSplitSetValue( to_bank, amount );
+        xaccSplitSetAmount( to_bank, amount );
+        kvp_frame_set_gint64( xaccSplitGetSlots( to_bank ), BATCH_TEST_SLOT,
+                              2 * i );
+
+        xaccSplitSetParent( from_income, tx );
+        xaccSplitSetAccount( from_income, income );
+        xaccSplitSetValue( from_income, gnc_numeric_neg( amount ) );
+        xaccSplitSetAmount( from_income, gnc_numeric_neg( amount ) );
+        kvp_frame_set_gint64( xaccSplitGetSlots( from_income ), BATCH_TEST_SLOT,
+                              2 * i + 1 );
+
+        xaccTransCommitEdit( tx );
+        g_free( notes );
+    }
+}
+
+/* Tick off the transaction and its splits in seen, indexed by the
+ * numbers fill_batch_book gave them. */
+static void
+check_batch_tx( QofInstance* inst, gpointer user_data )
+{
+    gboolean* seen = (gboolean*)user_data;
+    Transaction* tx = GNC_TRANS(inst);
+    const gchar* notes = xaccTransGetNotes( tx );
+    GList* node;
+    gint i;
+
+    g_assert (notes != NULL);
+    i = (gint)g_ascii_strtoll( notes, NULL, 10 );
+    g_assert_cmpint (i, >=, 0);
+    g_assert_cmpint (i, <, BATCH_TEST_TXS);
+    g_assert_cmpint (xaccTransCountSplits( tx ), ==, 2);
+    for ( node = xaccTransGetSplitList( tx ); node; node = node->next )
+    {
+        gint64 index = kvp_frame_get_gint64( xaccSplitGetSlots( node->data ),
+                                             BATCH_TEST_SLOT );
+
+        g_assert (index == 2 * i || index == 2 * i + 1);
+        g_assert (!seen[index]);
+        seen[index] = TRUE;
+    }
+}
+
+/* Splits and slots are loaded a batch of GUIDs at a time; every split
+ * and every slot must arrive, on both sides of each batch boundary. */
+void
+test_dbi_batch_load( const gchar* driver, const gchar* url )
+{
+    QofSession* session_1;
+    QofSession* session_2;
+    QofCollection* coll;
+    gboolean* seen;
+    gint i;
+
+    gchar *msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    gchar *log_domain = "gnc.backend.dbi";
+    guint loglevel = G_LOG_LEVEL_WARNING | G_LOG_FLAG_FATAL, hdlr;
+    TestErrorStruct check = { loglevel, log_domain, msg, 0 };
+    GLogFunc dhdlr = g_log_set_default_handler ((GLogFunc)test_null_handler,
+                                                &check);
+    g_test_log_set_fatal_handler ((GTestLogFatalFunc)test_checked_handler,
+                                  &check);
+
+    g_test_message ( "Testing batched loading %s\n", driver );
+
+    session_1 = qof_session_new();
+    fill_batch_book( qof_session_get_book( session_1 ) );
+    session_2 = qof_session_new();
+    hdlr = g_log_set_handler (log_domain, loglevel,
+                              (GLogFunc)test_checked_handler, &check);
+    qof_session_begin( session_2, url, FALSE, TRUE, TRUE );
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_swap_data( session_1, session_2 );
+    qof_session_save( session_2, NULL );
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_end( session_2 );
+    qof_session_destroy( session_2 );
+    qof_session_destroy( session_1 );
+
+    session_2 = qof_session_new();
+    qof_session_begin( session_2, url, TRUE, FALSE, FALSE );
+    qof_session_load( session_2, NULL );
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+
+    coll = qof_book_get_collection( qof_session_get_book( session_2 ),
+                                    GNC_ID_TRANS );
+    g_assert_cmpint (qof_collection_count( coll ), ==, BATCH_TEST_TXS);
+    seen = g_new0( gboolean, 2 * BATCH_TEST_TXS );
+    qof_collection_foreach( coll, check_batch_tx, seen );
+    for ( i = 0; i < 2 * BATCH_TEST_TXS; i++ )
+        g_assert (seen[i]);
+    g_free( seen );
+
+    qof_session_end( session_2 );
+    qof_session_destroy( session_2 );
+    g_log_remove_handler (log_domain, hdlr);
+    g_log_set_default_handler (dhdlr, NULL);
+}
+
 /* Given an already-created url (yeah, bad testing practice: Should
  * start fresh from a synthetic session) load and safe-save it, then
  * load it again into a new session and compare the two. Since
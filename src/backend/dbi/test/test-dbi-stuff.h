@@ -46,6 +46,26 @@ void do_compare( QofBook* book_1, QofBook* book_2, const gchar* id, QofInstanceF
  */
 void test_dbi_store_and_reload( const gchar* driver, QofSession* session_1, const gchar* url );
 
+/**
+ * Test loading only the recent transactions of a database: account
+ * balances must match a full load, and the transactions loaded must be
+ * all of those since the load window watermark, also after a query
+ * loaded an older one.
+ *
+ * @param driver Driver name
+ * @param url Database URL
+ */
+void test_dbi_load_window( const gchar* driver, const gchar* url );
+
+/**
+ * Test that loading more transactions than fit in one batch of splits
+ * brings back every split and every split slot.
+ *
+ * @param driver Driver name
+ * @param url Database URL
+ */
+void test_dbi_batch_load( const gchar* driver, const gchar* url );
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
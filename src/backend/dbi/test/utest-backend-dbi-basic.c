@@ -60,6 +60,18 @@ test_sqlite_store_and_reload (Fixture *fixture, gconstpointer pData)
     test_dbi_store_and_reload( "sqlite3", fixture->session, fixture->filename );
 }
 
+static void
+test_sqlite_load_window (Fixture *fixture, gconstpointer pData)
+{
+    test_dbi_load_window( "sqlite3", fixture->filename );
+}
+
+static void
+test_sqlite_batch_load (Fixture *fixture, gconstpointer pData)
+{
+    test_dbi_batch_load( "sqlite3", fixture->filename );
+}
+
 static void
 test_mysql_store_and_reload (Fixture *fixture, gconstpointer pData)
 {
@@ -80,6 +92,8 @@ void
 test_suite_gnc_backend_dbi_basic(void)
 {
      GNC_TEST_ADD (suitename, "store_and_reload/sqlite", Fixture, NULL, setup, test_sqlite_store_and_reload, teardown);
+     GNC_TEST_ADD (suitename, "load_window/sqlite", Fixture, NULL, setup, test_sqlite_load_window, teardown);
+     GNC_TEST_ADD (suitename, "batch_load/sqlite", Fixture, NULL, setup, test_sqlite_batch_load, teardown);
      if (strlen (TEST_MYSQL_URL) > 0)
          GNC_TEST_ADD (suitename, "store_and_reload/mysql", Fixture, NULL, setup, test_mysql_store_and_reload, teardown);
      if (strlen (TEST_PGSQL_URL) > 0)
@@ -288,22 +288,30 @@ load_all_accounts( GncSqlBackend* be )
             }
         }
 
-        /* Load starting balances */
-        bal_slist = gnc_sql_get_account_balances_slist( be );
-        for ( bal = bal_slist; bal != NULL; bal = bal->next )
+        /* When only some of the transactions are loaded, the starting
+           balances are the totals of all splits in the database.  The
+           transaction loader takes loaded splits back out of them. */
+        if ( be->load_window_months > 0 )
         {
-            acct_balances_t* balances = (acct_balances_t*)bal->data;
-
-            g_object_set( balances->acct,
-                          "start-balance", &balances->balance,
-                          "start-cleared-balance", &balances->cleared_balance,
-                          "start-reconciled-balance", &balances->reconciled_balance,
-                          NULL);
+            bal_slist = gnc_sql_get_account_balances_slist( be );
+            for ( bal = bal_slist; bal != NULL; bal = bal->next )
+            {
+                acct_balances_t* balances = (acct_balances_t*)bal->data;
 
-        }
-        if ( bal_slist != NULL )
-        {
-            g_slist_free( bal_slist );
+                if ( balances->acct != NULL )
+                {
+                    g_object_set( balances->acct,
+                                  "start-balance", &balances->balance,
+                                  "start-cleared-balance", &balances->cleared_balance,
+                                  "start-reconciled-balance", &balances->reconciled_balance,
+                                  NULL);
+                }
+                g_free( balances );
+            }
+            if ( bal_slist != NULL )
+            {
+                g_slist_free( bal_slist );
+            }
         }
     }
 
@@ -342,7 +350,7 @@ gnc_sql_save_account( GncSqlBackend* be, QofInstance* inst )
 
     ENTER( "inst=%p", inst );
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
 
     // If there is no commodity yet, this might be because a new account name
     // has been entered directly into the register and an account window will
@@ -86,6 +86,8 @@ static void update_progress( GncSqlBackend* be );
 static void finish_progress( GncSqlBackend* be );
 static void register_standard_col_type_handlers( void );
 static gboolean reset_version_info( GncSqlBackend* be );
+static void write_behind_clear( GncSqlWriteBehind* wb );
+static gboolean dirty_set_remove( GncSqlBackend* be, QofInstance* inst );
 /*@ null @*/
 static GncSqlStatement* build_insert_statement( GncSqlBackend* be,
         const gchar* table_name,
@@ -180,6 +182,20 @@ gnc_sql_set_load_order( const gchar** load_order )
     other_load_order = load_order;
 }
 
+/* Run the initial load of one type of object, reporting how many were
+ * loaded and how long it took. */
+static void
+initial_load_profiled( GncSqlBackend* be, const gchar* type, GncSqlObjectBackend* pData )
+{
+    QofCollection* col = qof_book_get_collection( be->book, type );
+    guint before = qof_collection_count( col );
+    gint64 start = qof_profile_now();
+
+    (pData->initial_load)( be );
+    qof_profile_add_objects( type, qof_collection_count( col ) - before,
+                             qof_profile_now() - start );
+}
+
 static void
 initial_load_cb( const gchar* type, gpointer data_p, gpointer be_p )
 {
@@ -207,16 +223,30 @@ initial_load_cb( const gchar* type, gpointer data_p, gpointer be_p )
 
     if ( pData->initial_load != NULL )
     {
-        (pData->initial_load)( be );
+        initial_load_profiled( be, type, pData );
     }
 }
 
+void
+gnc_sql_set_load_window( GncSqlBackend* be, gint months )
+{
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( months >= 0 );
+
+    be->load_window_months = months;
+
+    /* Nothing is loaded yet */
+    be->tx_loaded_since.tv_sec = G_MAXINT64;
+    be->tx_loaded_since.tv_nsec = 0;
+}
+
 void
 gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoadType loadType )
 {
     GncSqlObjectBackend* pData;
     gint i;
     Account* root;
+    gint64 start;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( book != NULL );
@@ -237,7 +267,7 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
             if ( pData->initial_load != NULL )
             {
                 update_progress( be );
-                (pData->initial_load)( be );
+                initial_load_profiled( be, fixed_load_order[i], pData );
             }
         }
         if ( other_load_order != NULL )
@@ -248,7 +278,7 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
                 if ( pData->initial_load != NULL )
                 {
                     update_progress( be );
-                    (pData->initial_load)( be );
+                    initial_load_profiled( be, other_load_order[i], pData );
                 }
             }
         }
@@ -258,7 +288,11 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
 
         qof_object_foreach_backend( GNC_SQL_BACKEND, initial_load_cb, be );
 
+        /* Committing the accounts sorts their splits and computes the
+         * balances. */
+        start = qof_profile_now();
         gnc_account_foreach_descendant( root, (AccountCb)xaccAccountCommitEdit, NULL );
+        qof_profile_end_phase( "sort and balance accounts", start );
     }
     else if ( loadType == LOAD_TYPE_LOAD_ALL )
     {
@@ -454,6 +488,19 @@ write_schedXactions( GncSqlBackend* be )
     return is_ok;
 }
 
+typedef gboolean (*write_fn)( GncSqlBackend* be );
+
+/* Write one kind of object, reporting how long it took per object. */
+static gboolean
+write_profiled( GncSqlBackend* be, write_fn write, const gchar* type, gint64 count )
+{
+    gint64 start = qof_profile_now();
+    gboolean is_ok = write( be );
+
+    qof_profile_add_objects( type, count, qof_profile_now() - start );
+    return is_ok;
+}
+
 static void
 write_cb( const gchar* type, gpointer data_p, gpointer be_p )
 {
@@ -465,7 +512,8 @@ write_cb( const gchar* type, gpointer data_p, gpointer be_p )
 
     if ( pData->write != NULL )
     {
-        (void)(pData->write)( be );
+        (void)write_profiled( be, pData->write, type,
+                              qof_collection_count( qof_book_get_collection( be->book, type ) ) );
         update_progress( be );
     }
 }
@@ -488,6 +536,7 @@ void
 gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
 {
     gboolean is_ok;
+    gint64 start;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( book != NULL );
@@ -500,7 +549,9 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
 
     /* Create new tables */
     be->is_pristine_db = TRUE;
+    start = qof_profile_now();
     qof_object_foreach_backend( GNC_SQL_BACKEND, create_tables_cb, be );
+    qof_profile_end_phase( "create tables", start );
 
     /* Save all contents */
     be->book = book;
@@ -515,23 +566,29 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     //write_commodities( be, book );
     if ( is_ok )
     {
+        start = qof_profile_now();
         is_ok = gnc_sql_save_book( be, QOF_INSTANCE(book) );
+        qof_profile_add_objects( GNC_ID_BOOK, 1, qof_profile_now() - start );
     }
     if ( is_ok )
     {
-        is_ok = write_accounts( be );
+        is_ok = write_profiled( be, write_accounts, GNC_ID_ACCOUNT,
+                                1 + gnc_account_n_descendants( gnc_book_get_root_account( book ) ) );
     }
     if ( is_ok )
     {
-        is_ok = write_transactions( be );
+        is_ok = write_profiled( be, write_transactions, GNC_ID_TRANS,
+                                gnc_book_count_transactions( book ) );
     }
     if ( is_ok )
     {
-        is_ok = write_template_transactions( be );
+        is_ok = write_profiled( be, write_template_transactions, "template account",
+                                gnc_account_n_descendants( gnc_book_get_template_root( book ) ) );
     }
     if ( is_ok )
     {
-        is_ok = write_schedXactions( be );
+        is_ok = write_profiled( be, write_schedXactions, GNC_ID_SCHEDXACTION,
+                                g_list_length( gnc_book_get_schedxactions( book )->sx_list ) );
     }
     if ( is_ok )
     {
@@ -539,12 +596,22 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     }
     if ( is_ok )
     {
+        start = qof_profile_now();
         is_ok = gnc_sql_connection_commit_transaction( be->conn );
+        qof_profile_end_phase( "commit", start );
     }
     if ( is_ok )
     {
         be->is_pristine_db = FALSE;
 
+        /* Everything which was waiting in the write-behind queue has
+         * just been written */
+        if ( be->write_behind != NULL )
+        {
+            write_behind_clear( be->write_behind );
+        }
+        gnc_sql_clear_dirty_sets( be );
+
         /* Mark the session as clean -- though it shouldn't ever get
 	 * marked dirty with this backend
 	 */
@@ -602,16 +669,557 @@ commit_cb( const gchar* type, gpointer data_p, gpointer be_data_p )
     }
 }
 
+/* An object which has been committed by the engine but not yet written
+ * to the database.  The infant flag is captured when the entry is made,
+ * because the engine clears it as soon as gnc_sql_commit_edit() returns.
+ */
+typedef struct
+{
+    /*@ owned @*/
+    QofInstance* inst;
+    gboolean is_infant;
+} pending_entry_t;
+
+static gboolean
+commit_instance( GncSqlBackend* be, QofInstance* inst, gboolean* is_known )
+{
+    sql_backend be_data;
+
+    be_data.is_known = FALSE;
+    be_data.be = be;
+    be_data.inst = inst;
+    be_data.is_ok = TRUE;
+
+    qof_object_foreach_backend( GNC_SQL_BACKEND, commit_cb, &be_data );
+
+    *is_known = be_data.is_known;
+    return be_data.is_ok;
+}
+
+static void
+pending_entry_free( gpointer data )
+{
+    pending_entry_t* entry = (pending_entry_t*)data;
+
+    g_object_unref( entry->inst );
+    g_free( entry );
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* Write-behind commit queue.  Instead of running one database transaction
+ * per engine commit, changed objects are remembered and written in one
+ * database transaction per batch.  The queue keeps a reference to each
+ * object, and an object which is committed several times before the queue
+ * is flushed is only written once, with its latest contents.
+ *
+ * The commit handlers read the engine objects themselves, so the queue is
+ * flushed on the thread which owns the engine (from a main loop timeout)
+ * rather than from a separate thread.
+ */
+#define WRITE_BEHIND_BATCH_SIZE 256
+#define WRITE_BEHIND_DELAY_SECS 2
+
+struct GncSqlWriteBehind
+{
+    gboolean enabled;
+    /*@ owned @*/
+    GQueue* pending;		/* pending_entry_t*, in commit order */
+    /*@ owned @*/
+    GHashTable* entries;	/* QofInstance* -> pending_entry_t* */
+    guint timeout_id;
+    GncSqlWriteBehindStats stats;
+};
+
+static void
+write_behind_clear( GncSqlWriteBehind* wb )
+{
+    g_queue_clear( wb->pending );
+    g_hash_table_remove_all( wb->entries );
+    wb->stats.queue_depth = 0;
+}
+
+static gboolean
+write_behind_timeout_cb( gpointer data )
+{
+    GncSqlBackend* be = (GncSqlBackend*)data;
+
+    be->write_behind->timeout_id = 0;
+    (void)gnc_sql_write_behind_flush( be );
+
+    return FALSE;
+}
+
+static void
+write_behind_schedule( GncSqlBackend* be )
+{
+    GncSqlWriteBehind* wb = be->write_behind;
+
+    if ( wb->timeout_id == 0 )
+    {
+        wb->timeout_id = g_timeout_add_seconds( WRITE_BEHIND_DELAY_SECS,
+                                                write_behind_timeout_cb, be );
+    }
+}
+
+static void
+write_behind_enqueue( GncSqlBackend* be, QofInstance* inst )
+{
+    GncSqlWriteBehind* wb = be->write_behind;
+    pending_entry_t* entry;
+
+    entry = g_hash_table_lookup( wb->entries, inst );
+    if ( entry != NULL )
+    {
+        /* Already queued; it will be written with its latest contents.
+           A failed flush leaves no flush pending, so arrange one. */
+        entry->is_infant = entry->is_infant || qof_instance_get_infant( inst );
+        write_behind_schedule( be );
+        return;
+    }
+
+    entry = g_new0( pending_entry_t, 1 );
+    entry->inst = g_object_ref( inst );
+    /* The queue takes over an object whose earlier commit failed */
+    entry->is_infant = dirty_set_remove( be, inst );
+    entry->is_infant = entry->is_infant || qof_instance_get_infant( inst );
+    g_hash_table_insert( wb->entries, inst, entry );
+    g_queue_push_tail( wb->pending, entry );
+
+    wb->stats.queue_depth = g_queue_get_length( wb->pending );
+    if ( wb->stats.queue_depth > wb->stats.max_queue_depth )
+    {
+        wb->stats.max_queue_depth = wb->stats.queue_depth;
+    }
+
+    if ( wb->stats.queue_depth < WRITE_BEHIND_BATCH_SIZE
+            || !gnc_sql_write_behind_flush( be ) )
+    {
+        write_behind_schedule( be );
+    }
+}
+
+/* An object which is destroyed while it is queued as an infant never
+ * reached the database, so it is dropped from the queue and there is
+ * nothing to delete.  Returns TRUE if it was. */
+static gboolean
+write_behind_drop_infant( GncSqlBackend* be, QofInstance* inst )
+{
+    GncSqlWriteBehind* wb = be->write_behind;
+    pending_entry_t* entry;
+
+    entry = g_hash_table_lookup( wb->entries, inst );
+    if ( entry == NULL || !entry->is_infant ) return FALSE;
+
+    (void)g_queue_remove( wb->pending, entry );
+    (void)g_hash_table_remove( wb->entries, inst );
+    wb->stats.queue_depth = g_queue_get_length( wb->pending );
+    if ( wb->stats.queue_depth == 0 && wb->timeout_id != 0 )
+    {
+        (void)g_source_remove( wb->timeout_id );
+        wb->timeout_id = 0;
+    }
+    return TRUE;
+}
+
+gboolean
+gnc_sql_write_behind_flush( GncSqlBackend* be )
+{
+    GncSqlWriteBehind* wb;
+    GList* node;
+    GTimer* timer;
+    gboolean is_ok;
+    gboolean is_known;
+    guint count;
+
+    g_return_val_if_fail( be != NULL, FALSE );
+
+    wb = be->write_behind;
+    if ( wb == NULL || g_queue_is_empty( wb->pending ) ) return TRUE;
+
+    ENTER( "be=%p, depth=%u", be, wb->stats.queue_depth );
+
+    if ( wb->timeout_id != 0 )
+    {
+        (void)g_source_remove( wb->timeout_id );
+        wb->timeout_id = 0;
+    }
+    if ( be->conn == NULL )
+    {
+        qof_backend_set_error( (QofBackend*)be, ERR_BACKEND_CONN_LOST );
+        wb->stats.failed_flushes++;
+        LEAVE( "No database connection" );
+        return FALSE;
+    }
+
+    timer = g_timer_new();
+    count = 0;
+    is_ok = gnc_sql_connection_begin_transaction( be->conn );
+    for ( node = wb->pending->head; node != NULL && is_ok; node = node->next )
+    {
+        pending_entry_t* entry = (pending_entry_t*)node->data;
+
+        is_ok = commit_instance( be, entry->inst, &is_known );
+        if ( !is_known )
+        {
+            PERR( "gnc_sql_write_behind_flush(): Unknown object type '%s'\n",
+                  entry->inst->e_type );
+            is_ok = TRUE;
+        }
+        count++;
+    }
+    if ( is_ok )
+    {
+        is_ok = gnc_sql_connection_commit_transaction( be->conn );
+    }
+    g_timer_stop( timer );
+
+    wb->stats.last_flush_secs = g_timer_elapsed( timer, NULL );
+    wb->stats.total_flush_secs += wb->stats.last_flush_secs;
+    g_timer_destroy( timer );
+
+    if ( !is_ok )
+    {
+        /* Keep everything queued so that the next flush retries it */
+        (void)gnc_sql_connection_rollback_transaction( be->conn );
+        qof_backend_set_error( (QofBackend*)be, ERR_BACKEND_SERVER_ERR );
+        wb->stats.failed_flushes++;
+        LEAVE( "Rolled back - database error" );
+        return FALSE;
+    }
+
+    for ( node = wb->pending->head; node != NULL; node = node->next )
+    {
+        pending_entry_t* entry = (pending_entry_t*)node->data;
+        qof_instance_mark_clean( entry->inst );
+    }
+    write_behind_clear( wb );
+    qof_book_mark_session_saved( be->book );
+
+    wb->stats.flushes++;
+    wb->stats.objects_flushed += count;
+
+    LEAVE( "%u objects in %f secs", count, wb->stats.last_flush_secs );
+    return TRUE;
+}
+
+void
+gnc_sql_set_write_behind( GncSqlBackend* be, gboolean enabled )
+{
+    GncSqlWriteBehind* wb;
+
+    g_return_if_fail( be != NULL );
+
+    wb = be->write_behind;
+    if ( enabled )
+    {
+        if ( wb == NULL )
+        {
+            wb = g_new0( GncSqlWriteBehind, 1 );
+            wb->pending = g_queue_new();
+            wb->entries = g_hash_table_new_full( g_direct_hash, g_direct_equal,
+                                                 NULL, pending_entry_free );
+            be->write_behind = wb;
+        }
+        wb->enabled = TRUE;
+        return;
+    }
+
+    if ( wb == NULL ) return;
+
+    if ( !gnc_sql_write_behind_flush( be ) )
+    {
+        PERR( "%u queued objects could not be written\n", wb->stats.queue_depth );
+    }
+    if ( wb->timeout_id != 0 )
+    {
+        (void)g_source_remove( wb->timeout_id );
+    }
+    write_behind_clear( wb );
+    g_queue_free( wb->pending );
+    g_hash_table_destroy( wb->entries );
+    g_free( wb );
+    be->write_behind = NULL;
+}
+
+void
+gnc_sql_get_write_behind_stats( const GncSqlBackend* be,
+                                GncSqlWriteBehindStats* stats )
+{
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( stats != NULL );
+
+    if ( be->write_behind == NULL )
+    {
+        memset( stats, 0, sizeof( GncSqlWriteBehindStats ) );
+        return;
+    }
+    *stats = be->write_behind->stats;
+    stats->flush_scheduled = ( be->write_behind->timeout_id != 0 );
+}
+
+/* ---------------------------------------------------------------------- */
+
+/* Dirty sets.  When an object cannot be written by gnc_sql_commit_edit(),
+ * the engine leaves it dirty in memory and the database keeps the old
+ * row.  Such objects are remembered in a set per collection type so that
+ * gnc_sql_sync_dirty() can write just them instead of the whole book.
+ * Deletions are always written by gnc_sql_commit_edit() itself; if one
+ * fails, a backend error makes the engine keep the object, but it is
+ * not put in a dirty set.  See commit_failed().
+ */
+static GHashTable*
+dirty_set_for_type( GncSqlBackend* be, QofIdTypeConst type )
+{
+    GHashTable* set;
+
+    if ( be->dirty_sets == NULL )
+    {
+        be->dirty_sets = g_hash_table_new_full( g_str_hash, g_str_equal,
+                                                g_free,
+                                                (GDestroyNotify)g_hash_table_destroy );
+    }
+
+    set = g_hash_table_lookup( be->dirty_sets, type );
+    if ( set == NULL )
+    {
+        set = g_hash_table_new_full( g_direct_hash, g_direct_equal,
+                                     NULL, pending_entry_free );
+        g_hash_table_insert( be->dirty_sets, g_strdup( type ), set );
+    }
+    return set;
+}
+
+static void
+dirty_set_add( GncSqlBackend* be, QofInstance* inst, gboolean is_infant )
+{
+    GHashTable* set = dirty_set_for_type( be, inst->e_type );
+    pending_entry_t* entry;
+
+    entry = g_hash_table_lookup( set, inst );
+    if ( entry != NULL )
+    {
+        entry->is_infant = entry->is_infant || is_infant;
+        return;
+    }
+
+    entry = g_new0( pending_entry_t, 1 );
+    entry->inst = g_object_ref( inst );
+    entry->is_infant = is_infant;
+    g_hash_table_insert( set, inst, entry );
+}
+
+static /*@ null @*/ pending_entry_t*
+dirty_set_lookup( const GncSqlBackend* be, QofInstance* inst )
+{
+    GHashTable* set;
+
+    if ( be->dirty_sets == NULL ) return NULL;
+    set = g_hash_table_lookup( be->dirty_sets, inst->e_type );
+    if ( set == NULL ) return NULL;
+    return g_hash_table_lookup( set, inst );
+}
+
+/* Removes an object from its dirty set.  Returns TRUE if it was there
+ * and was never written, so that it still has to be inserted. */
+static gboolean
+dirty_set_remove( GncSqlBackend* be, QofInstance* inst )
+{
+    GHashTable* set;
+    pending_entry_t* entry;
+    gboolean is_infant;
+
+    if ( be->dirty_sets == NULL ) return FALSE;
+    set = g_hash_table_lookup( be->dirty_sets, inst->e_type );
+    if ( set == NULL ) return FALSE;
+    entry = g_hash_table_lookup( set, inst );
+    if ( entry == NULL ) return FALSE;
+
+    is_infant = entry->is_infant;
+    (void)g_hash_table_remove( set, inst );
+    return is_infant;
+}
+
+guint
+gnc_sql_get_dirty_count( const GncSqlBackend* be )
+{
+    GHashTableIter iter;
+    gpointer set;
+    guint count = 0;
+
+    g_return_val_if_fail( be != NULL, 0 );
+
+    if ( be->dirty_sets == NULL ) return 0;
+    g_hash_table_iter_init( &iter, be->dirty_sets );
+    while ( g_hash_table_iter_next( &iter, NULL, &set ) )
+    {
+        count += g_hash_table_size( (GHashTable*)set );
+    }
+    return count;
+}
+
+void
+gnc_sql_clear_dirty_sets( GncSqlBackend* be )
+{
+    g_return_if_fail( be != NULL );
+
+    if ( be->dirty_sets == NULL ) return;
+    g_hash_table_destroy( be->dirty_sets );
+    be->dirty_sets = NULL;
+}
+
+gboolean
+gnc_sql_sync_dirty( GncSqlBackend* be, /*@ dependent @*/ QofBook* book )
+{
+    GHashTableIter type_iter;
+    GHashTableIter iter;
+    gpointer set;
+    gpointer entry_p;
+    GList* node;
+    gboolean is_ok;
+    gboolean is_known;
+    guint count = 0;
+
+    g_return_val_if_fail( be != NULL, FALSE );
+    g_return_val_if_fail( book != NULL, FALSE );
+    g_return_val_if_fail( be->book == book, FALSE );
+
+    ENTER( "book=%p, dirty=%u", book, gnc_sql_get_dirty_count( be ) );
+
+    if ( be->write_behind != NULL && be->write_behind->timeout_id != 0 )
+    {
+        (void)g_source_remove( be->write_behind->timeout_id );
+        be->write_behind->timeout_id = 0;
+    }
+
+    is_ok = gnc_sql_connection_begin_transaction( be->conn );
+
+    /* Objects queued by write-behind mode */
+    if ( be->write_behind != NULL )
+    {
+        for ( node = be->write_behind->pending->head; node != NULL && is_ok;
+                node = node->next )
+        {
+            pending_entry_t* entry = (pending_entry_t*)node->data;
+
+            is_ok = commit_instance( be, entry->inst, &is_known );
+            if ( !is_known ) is_ok = TRUE;
+            count++;
+        }
+    }
+
+    /* Objects whose earlier commit failed */
+    if ( be->dirty_sets != NULL )
+    {
+        g_hash_table_iter_init( &type_iter, be->dirty_sets );
+        while ( is_ok && g_hash_table_iter_next( &type_iter, NULL, &set ) )
+        {
+            g_hash_table_iter_init( &iter, (GHashTable*)set );
+            while ( is_ok && g_hash_table_iter_next( &iter, NULL, &entry_p ) )
+            {
+                pending_entry_t* entry = (pending_entry_t*)entry_p;
+
+                is_ok = commit_instance( be, entry->inst, &is_known );
+                if ( !is_known ) is_ok = TRUE;
+                count++;
+            }
+        }
+    }
+
+    if ( is_ok )
+    {
+        is_ok = gnc_sql_connection_commit_transaction( be->conn );
+    }
+    if ( !is_ok )
+    {
+        /* Everything stays pending, so a later sync retries it */
+        (void)gnc_sql_connection_rollback_transaction( be->conn );
+        qof_backend_set_error( (QofBackend*)be, ERR_BACKEND_SERVER_ERR );
+        LEAVE( "Rolled back - database error" );
+        return FALSE;
+    }
+
+    if ( be->write_behind != NULL )
+    {
+        for ( node = be->write_behind->pending->head; node != NULL;
+                node = node->next )
+        {
+            qof_instance_mark_clean( ((pending_entry_t*)node->data)->inst );
+        }
+        write_behind_clear( be->write_behind );
+    }
+    if ( be->dirty_sets != NULL )
+    {
+        g_hash_table_iter_init( &type_iter, be->dirty_sets );
+        while ( g_hash_table_iter_next( &type_iter, NULL, &set ) )
+        {
+            g_hash_table_iter_init( &iter, (GHashTable*)set );
+            while ( g_hash_table_iter_next( &iter, NULL, &entry_p ) )
+            {
+                qof_instance_mark_clean( ((pending_entry_t*)entry_p)->inst );
+            }
+        }
+        gnc_sql_clear_dirty_sets( be );
+    }
+    qof_book_mark_session_saved( book );
+
+    LEAVE( "%u objects written", count );
+    return TRUE;
+}
+
+gboolean
+gnc_sql_instance_is_infant( const GncSqlBackend* be, QofInstance* inst )
+{
+    pending_entry_t* entry;
+
+    g_return_val_if_fail( be != NULL, FALSE );
+    g_return_val_if_fail( inst != NULL, FALSE );
+
+    if ( qof_instance_get_infant( inst ) ) return TRUE;
+
+    entry = dirty_set_lookup( be, inst );
+    if ( entry != NULL && entry->is_infant ) return TRUE;
+    if ( be->write_behind == NULL ) return FALSE;
+
+    entry = g_hash_table_lookup( be->write_behind->entries, inst );
+    return entry != NULL && entry->is_infant;
+}
+
+/* Deals with an object which gnc_sql_commit_edit() could not write.
+ *
+ * A backend error makes the engine undo the edit: transactions are
+ * rolled back, and an object being destroyed is kept.  That is wanted
+ * for a failed delete, so the object is not freed while its row is
+ * still there.  A failed change raises no error, so the engine keeps
+ * the edit; the object goes into the dirty set and the next sync
+ * writes what the user entered.
+ */
+static void
+commit_failed( GncSqlBackend* be, QofInstance* inst, gboolean is_destroying,
+               gboolean is_infant )
+{
+    if ( is_destroying )
+    {
+        (void)dirty_set_remove( be, inst );
+        qof_backend_set_error( (QofBackend*)be, ERR_BACKEND_SERVER_ERR );
+    }
+    else
+    {
+        dirty_set_add( be, inst, is_infant );
+    }
+}
+
 /* Commit_edit handler - find the correct backend handler for this object
  * type and call its commit handler
  */
 void
 gnc_sql_commit_edit( GncSqlBackend *be, QofInstance *inst )
 {
-    sql_backend be_data;
     gboolean is_dirty;
     gboolean is_destroying;
     gboolean is_infant;
+    gboolean is_known;
+    gboolean is_ok;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( inst != NULL );
@@ -654,21 +1262,39 @@ gnc_sql_commit_edit( GncSqlBackend *be, QofInstance *inst )
         return;
     }
 
+    if ( be->write_behind != NULL && be->write_behind->enabled )
+    {
+        if ( !is_destroying )
+        {
+            write_behind_enqueue( be, inst );
+            LEAVE( "Queued" );
+            return;
+        }
+        if ( write_behind_drop_infant( be, inst ) )
+        {
+            LEAVE( "Never written - dropped from the queue" );
+            return;
+        }
+        /* The object is freed once this returns, so the delete is written
+           now, after everything which was queued before it. */
+        if ( !gnc_sql_write_behind_flush( be ) )
+        {
+            LEAVE( "Rolled back - write-behind flush error" );
+            return;
+        }
+    }
+
     if ( !gnc_sql_connection_begin_transaction( be->conn ) )
     {
         PERR( "gnc_sql_commit_edit(): begin_transaction failed\n" );
+        commit_failed( be, inst, is_destroying, is_infant );
         LEAVE( "Rolled back - database transaction begin error" );
         return;
     }
 
-    be_data.is_known = FALSE;
-    be_data.be = be;
-    be_data.inst = inst;
-    be_data.is_ok = TRUE;
-
-    qof_object_foreach_backend( GNC_SQL_BACKEND, commit_cb, &be_data );
+    is_ok = commit_instance( be, inst, &is_known );
 
-    if ( !be_data.is_known )
+    if ( !is_known )
     {
         PERR( "gnc_sql_commit_edit(): Unknown object type '%s'\n", inst->e_type );
         (void)gnc_sql_connection_rollback_transaction( be->conn );
@@ -679,18 +1305,18 @@ gnc_sql_commit_edit( GncSqlBackend *be, QofInstance *inst )
         LEAVE( "Rolled back - unknown object type" );
         return;
     }
-    if ( !be_data.is_ok )
+    if ( !is_ok )
     {
         // Error - roll it back
         (void)gnc_sql_connection_rollback_transaction( be->conn );
-
-        // This *should* leave things marked dirty
+        commit_failed( be, inst, is_destroying, is_infant );
         LEAVE( "Rolled back - database error" );
         return;
     }
 
     (void)gnc_sql_connection_commit_transaction( be->conn );
 
+    (void)dirty_set_remove( be, inst );
     qof_book_mark_session_saved( be->book );
     qof_instance_mark_clean(inst);
 
@@ -996,17 +1622,11 @@ gnc_sql_free_query( QofBackend* pBEnd, gpointer pQuery )
     // Try various objects first
     be_data.is_ok = FALSE;
     be_data.be = be;
-    be_data.pCompiledQuery = pQuery;
+    be_data.pCompiledQuery = pQueryInfo->pCompiledQuery;
     be_data.pQueryInfo = pQueryInfo;
 
     qof_object_foreach_backend( GNC_SQL_BACKEND, free_query_cb, &be_data );
-    if ( be_data.is_ok )
-    {
-        LEAVE( "" );
-        return;
-    }
-
-    if ( pQueryInfo->pCompiledQuery != NULL )
+    if ( !be_data.is_ok && pQueryInfo->pCompiledQuery != NULL )
     {
         DEBUG( "%s\n", (gchar*)pQueryInfo->pCompiledQuery );
         g_free( pQueryInfo->pCompiledQuery );
@@ -3026,7 +3646,7 @@ gnc_sql_commit_standard_item( GncSqlBackend* be, QofInstance* inst, const gchar*
     gint op;
     gboolean is_ok;
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
@@ -44,6 +44,19 @@
 #include <gmodule.h>
 
 typedef struct GncSqlConnection GncSqlConnection;
+typedef struct GncSqlWriteBehind GncSqlWriteBehind;
+
+/**
+ * @struct GncSqlQueryDialect
+ *
+ * Database specific operators used when queries are translated to SQL.
+ */
+typedef struct
+{
+    gboolean like_is_case_sensitive;	/**< TRUE if LIKE compares case-sensitively */
+    /*@ null @*/
+    const gchar* like_nocase_op;	/**< Case-insensitive LIKE, or NULL if none */
+} GncSqlQueryDialect;
 
 /**
  * @struct GncSqlBackend
@@ -63,6 +76,11 @@ struct GncSqlBackend
     gint operations_done;			/**< Number of operations (save/load) done */
     GHashTable* versions;			/**< Version number for each table */
     const gchar* timespec_format;	/**< Format string for SQL for timespec values */
+    GncSqlWriteBehind* write_behind;	/**< Deferred commit queue, or NULL if commits are synchronous */
+    gint load_window_months;		/**< # of months of transactions loaded initially, 0 for all */
+    Timespec tx_loaded_since;		/**< All transactions posted on or after this date are loaded */
+    const GncSqlQueryDialect* query_dialect;	/**< Query operators for the database, or NULL */
+    GHashTable* dirty_sets;		/**< Objects not yet written, per collection type, or NULL */
 };
 typedef struct GncSqlBackend GncSqlBackend;
 
@@ -81,6 +99,20 @@ void gnc_sql_init( GncSqlBackend* be );
  */
 void gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoadType loadType );
 
+/**
+ * Restricts the initial load to recent transactions.  When months is
+ * greater than 0, gnc_sql_load() loads only the transactions posted in the
+ * last months months.  Account starting balances are set from the totals
+ * in the database, so account balances are correct without the older
+ * transactions.  Older transactions are loaded when a split query needs
+ * dates before the loaded range; whenever one is, so are all of those
+ * posted after it.  Must be called before gnc_sql_load().
+ *
+ * @param be SQL backend
+ * @param months Number of months to load, or 0 to load all transactions
+ */
+void gnc_sql_set_load_window( GncSqlBackend* be, gint months );
+
 /**
  * Save the contents of a book to an SQL database.
  *
@@ -89,6 +121,36 @@ void gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBacken
  */
 void gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book );
 
+/**
+ * Writes only the objects which are not yet in the database, in one
+ * database transaction.  These are the objects waiting in the
+ * write-behind queue and the objects whose commit failed earlier.  If
+ * the transaction fails, it is rolled back, everything stays pending and
+ * ERR_BACKEND_SERVER_ERR is set on the backend.  The book must be the one
+ * which was loaded from or saved to this database.
+ *
+ * @param be SQL backend
+ * @param book Book to be saved
+ * @return TRUE if successful, FALSE if error
+ */
+gboolean gnc_sql_sync_dirty( GncSqlBackend* be, /*@ dependent @*/ QofBook *book );
+
+/**
+ * Returns the number of objects waiting in the dirty sets, i.e. whose
+ * commit failed and which have not been written since.
+ *
+ * @param be SQL backend
+ * @return Number of objects
+ */
+guint gnc_sql_get_dirty_count( const GncSqlBackend* be );
+
+/**
+ * Forgets all objects in the dirty sets without writing them.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_clear_dirty_sets( GncSqlBackend* be );
+
 /**
  * An object is about to be edited.
  *
@@ -113,6 +175,68 @@ void gnc_sql_rollback_edit( GncSqlBackend* qbe, QofInstance *inst );
  */
 void gnc_sql_commit_edit( GncSqlBackend* qbe, QofInstance *inst );
 
+/**
+ * @struct GncSqlWriteBehindStats
+ *
+ * Counters describing the state of the write-behind commit queue.
+ */
+typedef struct
+{
+    guint queue_depth;			/**< # of objects waiting to be written */
+    guint max_queue_depth;		/**< Largest queue depth seen */
+    guint flushes;				/**< # of successful flushes */
+    guint failed_flushes;		/**< # of flushes which were rolled back */
+    guint objects_flushed;		/**< Total # of objects written by flushes */
+    gdouble last_flush_secs;	/**< Duration of the last flush */
+    gdouble total_flush_secs;	/**< Total duration of all flushes */
+    gboolean flush_scheduled;	/**< TRUE if a timed flush is pending */
+} GncSqlWriteBehindStats;
+
+/**
+ * Enables or disables write-behind mode.  In write-behind mode,
+ * gnc_sql_commit_edit() queues changed objects instead of writing them
+ * immediately.  The queue is written in a single database transaction
+ * when it grows past a batch size, when the main loop has been idle for
+ * a short time, when an object is deleted and when
+ * gnc_sql_write_behind_flush() is called.  Disabling write-behind mode
+ * flushes the queue if there is a connection, and always frees it.
+ *
+ * @param be SQL backend
+ * @param enabled TRUE to queue commits, FALSE to write them immediately
+ */
+void gnc_sql_set_write_behind( GncSqlBackend* be, gboolean enabled );
+
+/**
+ * Writes all queued objects to the database in one transaction.  If
+ * the transaction fails, it is rolled back, the objects stay queued and
+ * ERR_BACKEND_SERVER_ERR is set on the backend.
+ *
+ * @param be SQL backend
+ * @return TRUE if the queue is empty afterwards, FALSE if error
+ */
+gboolean gnc_sql_write_behind_flush( GncSqlBackend* be );
+
+/**
+ * Returns the write-behind queue counters.  All counters are zero if
+ * write-behind mode has never been enabled.
+ *
+ * @param be SQL backend
+ * @param stats Structure to be filled in
+ */
+void gnc_sql_get_write_behind_stats( const GncSqlBackend* be,
+                                     GncSqlWriteBehindStats* stats );
+
+/**
+ * Returns whether an object must be inserted rather than updated.  This
+ * is the instance's infant flag, which is remembered for objects which
+ * were still infants when they were queued by write-behind mode.
+ *
+ * @param be SQL backend
+ * @param inst Object being committed
+ * @return TRUE if the object is not yet in the database
+ */
+gboolean gnc_sql_instance_is_infant( const GncSqlBackend* be, QofInstance* inst );
+
 /**
  */
 typedef struct GncSqlColumnTableEntry GncSqlColumnTableEntry;
@@ -157,7 +281,7 @@ struct GncSqlConnection
     gboolean (*rollbackTransaction)( GncSqlConnection* ); /**< Returns TRUE if successful, FALSE if error */
     gboolean (*commitTransaction)( GncSqlConnection* ); /**< Returns TRUE if successful, FALSE if error */
     gboolean (*createTable)( GncSqlConnection*, const gchar*, GList* ); /**< Returns TRUE if successful, FALSE if error */
-    gboolean (*createIndex)( GncSqlConnection*, const gchar*, const gchar*, const GncSqlColumnTableEntry* ); /**< Returns TRUE if successful, FALSE if error */
+    gboolean (*createIndex)( GncSqlConnection*, const gchar*, const gchar*, const GncSqlColumnTableEntry* ); /**< Does nothing if the index exists.  Returns TRUE if successful, FALSE if error */
     gboolean (*addColumnsToTable)( GncSqlConnection*, const gchar* table, GList* ); /**< Returns TRUE if successful, FALSE if error */
     gchar* (*quoteString)( const GncSqlConnection*, gchar* );
 };
@@ -554,7 +678,7 @@ gboolean gnc_sql_create_temp_table( const GncSqlBackend* be,
                                     const GncSqlColumnTableEntry* col_table );
 
 /**
- * Creates an index in the database
+ * Creates an index in the database, unless it already exists
  *
  * @param be SQL backend struct
  * @param index_name Index name
@@ -630,6 +754,12 @@ void gnc_sql_add_gvalue_objectref_guid_to_slist( const GncSqlBackend* be,
 void gnc_sql_add_objectref_guid_col_info_to_list( const GncSqlBackend* be,
         const GncSqlColumnTableEntry* table_row, GList** pList );
 
+/**
+ * Largest number of GUIDs put in one IN list.  Longer lists of objects are
+ * loaded in batches so that statements and their results stay small.
+ */
+#define GNC_SQL_MAX_GUIDS_PER_QUERY 500
+
 /**
  * Appends the ascii strings for a list of GUIDs to the end of an SQL string.
  *
@@ -190,7 +190,7 @@ do_commit_commodity( GncSqlBackend* be, QofInstance* inst, gboolean force_insert
     gint op;
     gboolean is_ok;
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
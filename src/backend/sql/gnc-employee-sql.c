@@ -168,7 +168,7 @@ save_employee( GncSqlBackend* be, QofInstance* inst )
 
     emp = GNC_EMPLOYEE(inst);
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
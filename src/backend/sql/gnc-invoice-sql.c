@@ -191,7 +191,7 @@ save_invoice( GncSqlBackend* be, QofInstance* inst )
 
     invoice = GNC_INVOICE(inst);
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
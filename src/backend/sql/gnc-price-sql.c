@@ -166,7 +166,7 @@ save_price( GncSqlBackend* be, QofInstance* inst )
     g_return_val_if_fail( inst != NULL, FALSE );
     g_return_val_if_fail( GNC_IS_PRICE(inst), FALSE );
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
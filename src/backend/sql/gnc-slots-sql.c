@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <string.h>
 
 #include "qof.h"
 #include "gnc-engine.h"
@@ -881,19 +882,13 @@ load_obj_guid( const GncSqlBackend* be, GncSqlRow* row )
 }
 
 static void
-load_slot_for_list_item( GncSqlBackend* be, GncSqlRow* row, QofCollection* coll )
+load_slot_for_instance( GncSqlBackend* be, GncSqlRow* row, QofInstance* inst )
 {
     slot_info_t slot_info = { NULL, NULL, TRUE, NULL, 0, NULL, FRAME, NULL, NULL };
-    const GncGUID* guid;
-    QofInstance* inst;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( row != NULL );
-    g_return_if_fail( coll != NULL );
-
-    guid = load_obj_guid( be, row );
-    g_assert( guid != NULL );
-    inst = qof_collection_lookup_entity( coll, guid );
+    g_return_if_fail( inst != NULL );
 
     slot_info.be = be;
     slot_info.pKvpFrame = qof_instance_get_slots( inst );
@@ -907,14 +902,33 @@ load_slot_for_list_item( GncSqlBackend* be, GncSqlRow* row, QofCollection* coll
     }
 }
 
+/* Copies the guid string in a column of a row into buf.  Returns FALSE if
+ * the column is NULL, e.g. the slot columns of an outer join for an object
+ * without slots. */
+static gboolean
+get_row_guid_string( GncSqlRow* row, const gchar* col_name,
+                     gchar buf[GUID_ENCODING_LENGTH+1] )
+{
+    const GValue* val;
+
+    val = gnc_sql_row_get_value_at_col_name( row, col_name );
+    if ( val == NULL || !G_VALUE_HOLDS_STRING( val ) ||
+            g_value_get_string( val ) == NULL )
+    {
+        return FALSE;
+    }
+    (void)g_strlcpy( buf, g_value_get_string( val ), GUID_ENCODING_LENGTH + 1 );
+    return TRUE;
+}
+
 void
 gnc_sql_slots_load_for_list( GncSqlBackend* be, GList* list )
 {
     QofCollection* coll;
-    GncSqlStatement* stmt;
     GString* sql;
-    GncSqlResult* result;
-    gboolean single_item;
+    gchar guid_buf[GUID_ENCODING_LENGTH+1];
+    gchar last_guid_buf[GUID_ENCODING_LENGTH+1];
+    guint count;
 
     g_return_if_fail( be != NULL );
 
@@ -923,43 +937,113 @@ gnc_sql_slots_load_for_list( GncSqlBackend* be, GList* list )
 
     coll = qof_instance_get_collection( QOF_INSTANCE(list->data) );
 
-    // Create the query for all slots for all items on the list
-    sql = g_string_sized_new( 40 + (GUID_ENCODING_LENGTH + 3) * g_list_length( list ) );
-    g_string_append_printf( sql, "SELECT * FROM %s WHERE %s ", TABLE_NAME, obj_guid_col_table[0].col_name );
-    if ( g_list_length( list ) != 1 )
+    /* Query the slots a batch of objects at a time so that neither the
+       statement nor the result grows with the size of the list.  Rows are
+       ordered by object so that each object is looked up only once. */
+    sql = g_string_sized_new( 80 + (GUID_ENCODING_LENGTH + 3) * GNC_SQL_MAX_GUIDS_PER_QUERY );
+    while ( list != NULL )
     {
-        (void)g_string_append( sql, "IN (" );
-        single_item = FALSE;
-    }
-    else
-    {
-        (void)g_string_append( sql, "= " );
-        single_item = TRUE;
-    }
-    (void)gnc_sql_append_guid_list_to_sql( sql, list, G_MAXUINT );
-    if ( !single_item )
-    {
-        (void)g_string_append( sql, ")" );
+        GncSqlStatement* stmt;
+        GncSqlResult* result;
+
+        g_string_printf( sql, "SELECT * FROM %s WHERE %s IN (",
+                         TABLE_NAME, obj_guid_col_table[0].col_name );
+        count = gnc_sql_append_guid_list_to_sql( sql, list, GNC_SQL_MAX_GUIDS_PER_QUERY );
+        g_string_append_printf( sql, ") ORDER BY %s,%s",
+                                obj_guid_col_table[0].col_name, col_table[id_col].col_name );
+        list = g_list_nth( list, count );
+
+        // Execute the query and load the slots
+        stmt = gnc_sql_create_statement_from_sql( be, sql->str );
+        if ( stmt == NULL )
+        {
+            PERR( "stmt == NULL, SQL = '%s'\n", sql->str );
+            break;
+        }
+        result = gnc_sql_execute_select_statement( be, stmt );
+        gnc_sql_statement_dispose( stmt );
+        if ( result != NULL )
+        {
+            GncSqlRow* row = gnc_sql_result_get_first_row( result );
+            QofInstance* inst = NULL;
+
+            last_guid_buf[0] = '\0';
+            while ( row != NULL )
+            {
+                if ( get_row_guid_string( row, obj_guid_col_table[0].col_name, guid_buf ) )
+                {
+                    if ( strcmp( guid_buf, last_guid_buf ) != 0 )
+                    {
+                        GncGUID guid;
+
+                        (void)string_to_guid( guid_buf, &guid );
+                        inst = qof_collection_lookup_entity( coll, &guid );
+                        (void)g_strlcpy( last_guid_buf, guid_buf, sizeof( last_guid_buf ) );
+                    }
+                    if ( inst != NULL )
+                    {
+                        load_slot_for_instance( be, row, inst );
+                    }
+                }
+                row = gnc_sql_result_get_next_row( result );
+            }
+            gnc_sql_result_dispose( result );
+        }
     }
+    (void)g_string_free( sql, TRUE );
+}
 
-    // Execute the query and load the slots
-    stmt = gnc_sql_create_statement_from_sql( be, sql->str );
+void
+gnc_sql_slots_load_with_objects( GncSqlBackend* be, const gchar* table_name,
+                                 const gchar* where, GncSqlObjectRowFn load_fn,
+                                 gpointer data )
+{
+    gchar* sql;
+    GncSqlStatement* stmt;
+    GncSqlResult* result;
+    gchar guid_buf[GUID_ENCODING_LENGTH+1];
+    gchar last_guid_buf[GUID_ENCODING_LENGTH+1];
+
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( table_name != NULL );
+    g_return_if_fail( load_fn != NULL );
+
+    sql = g_strdup_printf( "SELECT %s.*,%s.* FROM %s LEFT OUTER JOIN %s ON %s.%s=%s.guid%s%s ORDER BY %s.guid,%s.%s",
+                           table_name, TABLE_NAME, table_name, TABLE_NAME,
+                           TABLE_NAME, obj_guid_col_table[0].col_name, table_name,
+                           where != NULL ? " WHERE " : "", where != NULL ? where : "",
+                           table_name, TABLE_NAME, col_table[id_col].col_name );
+    stmt = gnc_sql_create_statement_from_sql( be, sql );
     if ( stmt == NULL )
     {
-        PERR( "stmt == NULL, SQL = '%s'\n", sql->str );
-        (void)g_string_free( sql, TRUE );
+        PERR( "stmt == NULL, SQL = '%s'\n", sql );
+        g_free( sql );
         return;
     }
-    (void)g_string_free( sql, TRUE );
+    g_free( sql );
     result = gnc_sql_execute_select_statement( be, stmt );
     gnc_sql_statement_dispose( stmt );
     if ( result != NULL )
     {
         GncSqlRow* row = gnc_sql_result_get_first_row( result );
+        QofInstance* inst = NULL;
 
+        /* Each object comes first with its first slot, then once more for
+           each further slot, so it is loaded when its guid changes. */
+        last_guid_buf[0] = '\0';
         while ( row != NULL )
         {
-            load_slot_for_list_item( be, row, coll );
+            if ( get_row_guid_string( row, "guid", guid_buf ) &&
+                    strcmp( guid_buf, last_guid_buf ) != 0 )
+            {
+                inst = (load_fn)( be, row, data );
+                (void)g_strlcpy( last_guid_buf, guid_buf, sizeof( last_guid_buf ) );
+            }
+            if ( inst != NULL &&
+                    get_row_guid_string( row, obj_guid_col_table[0].col_name, guid_buf ) )
+            {
+                load_slot_for_instance( be, row, inst );
+            }
             row = gnc_sql_result_get_next_row( result );
         }
         gnc_sql_result_dispose( result );
@@ -65,13 +65,43 @@ void gnc_sql_slots_load( GncSqlBackend* be, QofInstance* inst );
 /**
  * gnc_sql_slots_load_for_list - Loads slots for a list of objects from the db.
  * Loading slots for a list of objects can be faster than loading for one object
- * at a time because fewer SQL queries are used.
+ * at a time because fewer SQL queries are used.  Long lists are queried
+ * GNC_SQL_MAX_GUIDS_PER_QUERY objects at a time.
  *
  * @param be SQL backend
  * @param list List of objects
  */
 void gnc_sql_slots_load_for_list( GncSqlBackend* be, GList* list );
 
+/**
+ * Loads one object from a row of gnc_sql_slots_load_with_objects().
+ *
+ * @param be SQL backend
+ * @param row Row holding the object's columns
+ * @param data User data
+ * @return Object to which the slots in the row belong, or NULL to skip them
+ */
+typedef QofInstance* (*GncSqlObjectRowFn)( GncSqlBackend* be, GncSqlRow* row, gpointer data );
+
+/**
+ * gnc_sql_slots_load_with_objects - Loads objects from a table together with
+ * their slots.  The table is joined with the slots table in the database and
+ * the rows are ordered by object, so each object is loaded when it first
+ * appears and its slots are added to it as the following rows arrive.  The
+ * table's guid column must be called "guid", and no other column may share a
+ * name with a slots column.
+ *
+ * @param be SQL backend
+ * @param table_name Object table
+ * @param where SQL condition selecting the objects, or NULL for all of them.
+ * Columns must be qualified with the table name.
+ * @param load_fn Function which loads an object from a row
+ * @param data User data passed to load_fn
+ */
+void gnc_sql_slots_load_with_objects( GncSqlBackend* be, const gchar* table_name,
+                                      const gchar* where, GncSqlObjectRowFn load_fn,
+                                      gpointer data );
+
 typedef QofInstance* (*BookLookupFn)( const GncGUID* guid, const QofBook* book );
 
 /**
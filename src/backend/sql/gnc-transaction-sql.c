@@ -47,15 +47,10 @@
 
 #include "gnc-engine.h"
 
-#include "escape.h"
-
 #ifdef S_SPLINT_S
 #include "splint-defs.h"
 #endif
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
-
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 #define TRANSACTION_TABLE "transactions"
@@ -125,6 +120,23 @@ static const GncSqlColumnTableEntry post_date_col_table[] =
     /*@ +full_init_block @*/
 };
 
+static const GncSqlColumnTableEntry enter_date_col_table[] =
+{
+    /*@ -full_init_block @*/
+    { "enter_date", CT_TIMESPEC, 0, 0, "enter-date" },
+    { NULL }
+    /*@ +full_init_block @*/
+};
+
+static const GncSqlColumnTableEntry account_reconcile_col_table[] =
+{
+    /*@ -full_init_block @*/
+    { "account_guid",    CT_ACCOUNTREF, 0, COL_NNUL, "account" },
+    { "reconcile_state", CT_STRING,     1, COL_NNUL, NULL },
+    { NULL }
+    /*@ +full_init_block @*/
+};
+
 static const GncSqlColumnTableEntry account_guid_col_table[] =
 {
     /*@ -full_init_block @*/
@@ -227,49 +239,44 @@ load_single_split( GncSqlBackend* be, GncSqlRow* row )
     return pSplit;
 }
 
+static /*@ null @*/ QofInstance*
+load_split_row( GncSqlBackend* be, GncSqlRow* row, /*@ unused @*/ gpointer data )
+{
+    Split* s = load_single_split( be, row );
+
+    return s != NULL ? QOF_INSTANCE(s) : NULL;
+}
+
+/**
+ * Loads the splits of a list of transactions with their slots.  The
+ * transactions are handled in batches, and each batch is loaded by one
+ * query which joins the splits with their slots.
+ *
+ * @param be SQL backend
+ * @param list List of transactions
+ */
 static void
 load_splits_for_tx_list( GncSqlBackend* be, GList* list )
 {
-    GString* sql;
-    GncSqlResult* result;
+    GString* where;
+    guint count;
 
     g_return_if_fail( be != NULL );
 
     if ( list == NULL ) return;
 
-    sql = g_string_sized_new( 40 + (GUID_ENCODING_LENGTH + 3) * g_list_length( list ) );
-    g_string_append_printf( sql, "SELECT * FROM %s WHERE %s IN (", SPLIT_TABLE, tx_guid_col_table[0].col_name );
-    (void)gnc_sql_append_guid_list_to_sql( sql, list, G_MAXUINT );
-    (void)g_string_append( sql, ")" );
-
-    // Execute the query and load the splits
-    result = gnc_sql_execute_select_sql( be, sql->str );
-    if ( result != NULL )
+    where = g_string_sized_new( 40 + (GUID_ENCODING_LENGTH + 3) * GNC_SQL_MAX_GUIDS_PER_QUERY );
+    while ( list != NULL )
     {
-        GList* split_list = NULL;
-        GncSqlRow* row;
+        g_string_printf( where, "%s.%s IN (", SPLIT_TABLE, tx_guid_col_table[0].col_name );
+        count = gnc_sql_append_guid_list_to_sql( where, list, GNC_SQL_MAX_GUIDS_PER_QUERY );
+        (void)g_string_append( where, ")" );
+        list = g_list_nth( list, count );
 
-        row = gnc_sql_result_get_first_row( result );
-        while ( row != NULL )
-        {
-            Split* s;
-            s = load_single_split( be, row );
-            if ( s != NULL )
-            {
-                split_list = g_list_prepend( split_list, s );
-            }
-            row = gnc_sql_result_get_next_row( result );
-        }
-
-        if ( split_list != NULL )
-        {
-            gnc_sql_slots_load_for_list( be, split_list );
-            g_list_free( split_list );
-        }
-
-        gnc_sql_result_dispose( result );
+        gnc_sql_slots_load_with_objects( be, SPLIT_TABLE, where->str,
+                                         load_split_row, NULL );
     }
-    (void)g_string_free( sql, TRUE );
+    (void)g_string_free( where, TRUE );
 }
 
 static /*@ null @*/ Transaction*
@@ -303,78 +310,128 @@ load_single_tx( GncSqlBackend* be, GncSqlRow* row )
 }
 
 /**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
+ * Adds the amount of a split to the balance deltas for its account.
+ *
+ * @param deltas Hash table of acct_balances_t structures, keyed by account
+ * @param split Split
  */
-typedef struct
+static void
+add_split_to_balance_deltas( GHashTable* deltas, Split* split )
 {
-    /*@ dependent @*/ Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
+    Account* acc;
+    acct_balances_t* delta;
+    gnc_numeric amount;
+    char state;
+
+    acc = xaccSplitGetAccount( split );
+    if ( acc == NULL ) return;
+
+    delta = g_hash_table_lookup( deltas, acc );
+    if ( delta == NULL )
+    {
+        delta = g_malloc( (gsize)sizeof( acct_balances_t ) );
+        g_assert( delta != NULL );
+
+        delta->acct = acc;
+        delta->balance = gnc_numeric_zero();
+        delta->cleared_balance = gnc_numeric_zero();
+        delta->reconciled_balance = gnc_numeric_zero();
+        g_hash_table_insert( deltas, acc, delta );
+    }
+
+    amount = xaccSplitGetAmount( split );
+    state = xaccSplitGetReconcile( split );
+    delta->balance = gnc_numeric_add( delta->balance, amount,
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+    if ( state != NREC )
+    {
+        delta->cleared_balance = gnc_numeric_add( delta->cleared_balance, amount,
+                                 GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+    }
+    if ( state == YREC || state == FREC )
+    {
+        delta->reconciled_balance = gnc_numeric_add( delta->reconciled_balance, amount,
+                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+    }
+}
 
-#if 0 /* Not Used */
 /**
- * Saves the start/end balances for an account.
+ * Takes the splits of newly loaded transactions out of the account starting
+ * balances.  When only some transactions are loaded, the starting balances
+ * were set from the totals of all splits in the database, so this keeps the
+ * ending balances unchanged as older transactions are loaded.
  *
- * @param acc Account
- * @param pData Pointer to balances info list
+ * @param tx_list List of newly loaded transactions
  */
 static void
-save_account_balances( Account* acc, gpointer pData )
-{
-    GSList** pBal_list = (GSList**)pData;
-    full_acct_balances_t* newbal;
-    gnc_numeric* pstart;
-    gnc_numeric* pend;
-    gnc_numeric* pstart_c;
-    gnc_numeric* pend_c;
-    gnc_numeric* pstart_r;
-    gnc_numeric* pend_r;
-
-    newbal = g_malloc( (gsize)sizeof( full_acct_balances_t ) );
-    g_assert( newbal != NULL );
-
-    newbal->acc = acc;
-    g_object_get( acc,
-                  "start-balance", &pstart,
-                  "end-balance", &pend,
-                  "start-cleared-balance", &pstart_c,
-                  "end-cleared-balance", &pend_c,
-                  "start-reconciled-balance", &pstart_r,
-                  "end-reconciled-balance", &pend_r,
-                  NULL );
-    newbal->start_bal = *pstart;
-    newbal->end_bal = *pend;
-    newbal->start_cleared_bal = *pstart_c;
-    newbal->end_cleared_bal = *pend_c;
-    newbal->start_reconciled_bal = *pstart_r;
-    newbal->end_reconciled_bal = *pend_r;
-    *pBal_list = g_slist_append( *pBal_list, newbal );
-
-    g_free( pstart );
-    g_free( pend );
-    g_free( pstart_c );
-    g_free( pend_c );
-    g_free( pstart_r );
-    g_free( pend_r );
+adjust_start_balances_for_tx_list( GList* tx_list )
+{
+    GHashTable* deltas;
+    GHashTableIter iter;
+    gpointer value;
+    GList* node;
+    GList* split_node;
+
+    deltas = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, g_free );
+    for ( node = tx_list; node != NULL; node = node->next )
+    {
+        Transaction* pTx = GNC_TRANSACTION(node->data);
+
+        for ( split_node = xaccTransGetSplitList( pTx ); split_node != NULL;
+                split_node = split_node->next )
+        {
+            add_split_to_balance_deltas( deltas, GNC_SPLIT(split_node->data) );
+        }
+    }
+
+    g_hash_table_iter_init( &iter, deltas );
+    while ( g_hash_table_iter_next( &iter, NULL, &value ) )
+    {
+        acct_balances_t* delta = (acct_balances_t*)value;
+        gnc_numeric* pstart;
+        gnc_numeric* pstart_c;
+        gnc_numeric* pstart_r;
+        gnc_numeric start;
+        gnc_numeric start_c;
+        gnc_numeric start_r;
+
+        g_object_get( delta->acct,
+                      "start-balance", &pstart,
+                      "start-cleared-balance", &pstart_c,
+                      "start-reconciled-balance", &pstart_r,
+                      NULL );
+        start = gnc_numeric_sub( *pstart, delta->balance,
+                                 GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+        start_c = gnc_numeric_sub( *pstart_c, delta->cleared_balance,
+                                   GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+        start_r = gnc_numeric_sub( *pstart_r, delta->reconciled_balance,
+                                   GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+        g_object_set( delta->acct,
+                      "start-balance", &start,
+                      "start-cleared-balance", &start_c,
+                      "start-reconciled-balance", &start_r,
+                      NULL );
+        xaccAccountRecomputeBalance( delta->acct );
+
+        g_free( pstart );
+        g_free( pstart_c );
+        g_free( pstart_r );
+    }
+    g_hash_table_destroy( deltas );
 }
-#endif
+
 /**
  * Executes a transaction query statement and loads the transactions and all
  * of the splits.
  *
  * @param be SQL backend
  * @param stmt SQL statement
+ * @param oldest If not NULL, lowered to the earliest post date of the newly
+ * loaded transactions, or to G_MININT64 seconds if one has no post date
  */
 static void
-query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
+query_transactions( GncSqlBackend* be, GncSqlStatement* stmt,
+                    /*@ null @*/ Timespec* oldest )
 {
     GncSqlResult* result;
 
@@ -388,20 +445,6 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
         GList* node;
         GncSqlRow* row;
         Transaction* tx;
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        GSList* bal_list = NULL;
-        GSList* nextbal;
-        Account* root = gnc_book_get_root_account( be->book );
-
-        qof_event_suspend();
-        xaccAccountBeginEdit( root );
-
-        // Save the start/ending balances (balance, cleared and reconciled) for
-        // every account.
-        gnc_account_foreach_descendant( gnc_book_get_root_account( be->primary_book ),
-                                        save_account_balances,
-                                        &bal_list );
-#endif
 
         // Load the transactions
         row = gnc_sql_result_get_first_row( result );
@@ -428,69 +471,172 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
         {
             Transaction* pTx = GNC_TRANSACTION(node->data);
             xaccTransCommitEdit( pTx );
-        }
-        g_list_free( tx_list );
 
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        // Update the account balances based on the loaded splits.  If the end
-        // balance has changed, update the start balance so that the end
-        // balance is the same as it was before the splits were loaded.
-        // Repeat for cleared and reconciled balances.
-        for ( nextbal = bal_list; nextbal != NULL; nextbal = nextbal->next )
-        {
-            full_acct_balances_t* balns = (full_acct_balances_t*)nextbal->data;
-            gnc_numeric* pnew_end_bal;
-            gnc_numeric* pnew_end_c_bal;
-            gnc_numeric* pnew_end_r_bal;
-            gnc_numeric adj;
-
-            g_object_get( balns->acc,
-                          "end-balance", &pnew_end_bal,
-                          "end-cleared-balance", &pnew_end_c_bal,
-                          "end-reconciled-balance", &pnew_end_r_bal,
-                          NULL );
-
-            if ( !gnc_numeric_eq( *pnew_end_bal, balns->end_bal ) )
-            {
-                adj = gnc_numeric_sub( balns->end_bal, *pnew_end_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_bal = gnc_numeric_add( balns->start_bal, adj,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-balance", &balns->start_bal, NULL );
-            }
-            if ( !gnc_numeric_eq( *pnew_end_c_bal, balns->end_cleared_bal ) )
+            if ( oldest != NULL )
             {
-                adj = gnc_numeric_sub( balns->end_cleared_bal, *pnew_end_c_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_cleared_bal = gnc_numeric_add( balns->start_cleared_bal, adj,
-                                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-cleared-balance", &balns->start_cleared_bal, NULL );
-            }
-            if ( !gnc_numeric_eq( *pnew_end_r_bal, balns->end_reconciled_bal ) )
-            {
-                adj = gnc_numeric_sub( balns->end_reconciled_bal, *pnew_end_r_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_reconciled_bal = gnc_numeric_add( balns->start_reconciled_bal, adj,
-                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-reconciled-balance", &balns->start_reconciled_bal, NULL );
+                Timespec posted = xaccTransRetDatePostedTS( pTx );
+
+                if ( posted.tv_sec == 0 && posted.tv_nsec == 0 )
+                {
+                    oldest->tv_sec = G_MININT64;
+                    oldest->tv_nsec = 0;
+                }
+                else if ( timespec_cmp( &posted, oldest ) < 0 )
+                {
+                    *oldest = posted;
+                }
             }
-            xaccAccountRecomputeBalance( balns->acc );
-            g_free( pnew_end_bal );
-            g_free( pnew_end_c_bal );
-            g_free( pnew_end_r_bal );
-            g_free( balns );
         }
-        if ( bal_list != NULL )
+
+        if ( be->load_window_months > 0 && tx_list != NULL )
         {
-            g_slist_free( bal_list );
+            adjust_start_balances_for_tx_list( tx_list );
         }
+        g_list_free( tx_list );
+    }
+}
 
-        xaccAccountCommitEdit( root );
-        qof_event_resume();
-#endif
+/**
+ * Loads the transactions posted in a date range.  Transactions without a
+ * post date are loaded with the range which has no start date.
+ *
+ * @param be SQL backend
+ * @param from Earliest post date to load, or NULL for no limit
+ * @param to Post date before which to stop, or NULL for no limit
+ */
+static void
+load_tx_posted_between( GncSqlBackend* be, const Timespec* from, const Timespec* to )
+{
+    GString* sql;
+    GncSqlStatement* stmt;
+    gchar* datebuf;
+
+    sql = g_string_new( "" );
+    g_string_printf( sql, "SELECT * FROM %s", TRANSACTION_TABLE );
+    if ( from != NULL )
+    {
+        datebuf = gnc_sql_convert_timespec_to_string( be, *from );
+        g_string_append_printf( sql, " WHERE post_date>='%s'", datebuf );
+        g_free( datebuf );
+    }
+    if ( to != NULL )
+    {
+        datebuf = gnc_sql_convert_timespec_to_string( be, *to );
+        g_string_append_printf( sql, "%s (post_date<'%s' OR post_date IS NULL)",
+                                from != NULL ? " AND" : " WHERE", datebuf );
+        g_free( datebuf );
+    }
+
+    stmt = gnc_sql_create_statement_from_sql( be, sql->str );
+    (void)g_string_free( sql, TRUE );
+    if ( stmt != NULL )
+    {
+        query_transactions( be, stmt, NULL );
+        gnc_sql_statement_dispose( stmt );
+    }
+
+    if ( from == NULL )
+    {
+        be->tx_loaded_since.tv_sec = G_MININT64;
+        be->tx_loaded_since.tv_nsec = 0;
+    }
+    else if ( timespec_cmp( from, &be->tx_loaded_since ) < 0 )
+    {
+        be->tx_loaded_since = *from;
+    }
+}
+
+/**
+ * Executes a query which loads single transactions, and keeps every
+ * transaction posted since the load window watermark in memory: if the
+ * query found older ones, the ones between them and the watermark are
+ * loaded as well and the watermark moves back.  The account starting
+ * balances then stay the balances at the watermark.
+ *
+ * @param be SQL backend
+ * @param stmt SQL statement
+ */
+static void
+query_some_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
+{
+    Timespec oldest;
+    Timespec to;
+
+    oldest.tv_sec = G_MAXINT64;
+    oldest.tv_nsec = 0;
+    query_transactions( be, stmt, &oldest );
+
+    /* Before the initial load, load_initial_tx() takes care of them */
+    to = be->tx_loaded_since;
+    if ( be->load_window_months <= 0 || to.tv_sec == G_MAXINT64
+            || to.tv_sec == G_MININT64 || timespec_cmp( &oldest, &to ) >= 0 )
+    {
+        return;
+    }
+
+    DEBUG( "Loading transactions posted before %" G_GINT64_FORMAT "\n", to.tv_sec );
+    load_tx_posted_between( be, oldest.tv_sec == G_MININT64 ? NULL : &oldest, &to );
+}
+
+/**
+ * Lowers a date to the post date of a transaction.  Transactions without
+ * a post date lower it to G_MININT64 seconds.
+ *
+ * @param inst Transaction
+ * @param user_data Timespec to lower
+ */
+static void
+lower_to_post_date( QofInstance* inst, gpointer user_data )
+{
+    Timespec* since = (Timespec*)user_data;
+    Timespec posted = xaccTransRetDatePostedTS( GNC_TRANSACTION(inst) );
+
+    if ( posted.tv_sec == 0 && posted.tv_nsec == 0 )
+    {
+        since->tv_sec = G_MININT64;
+        since->tv_nsec = 0;
+    }
+    else if ( timespec_cmp( &posted, since ) < 0 )
+    {
+        *since = posted;
     }
 }
 
+/**
+ * Initial transaction load.  Loads all transactions, or only the ones in
+ * the load window if one has been set.
+ *
+ * @param be SQL backend
+ */
+static void
+load_initial_tx( GncSqlBackend* be )
+{
+    GDate date;
+    Timespec since;
+
+    g_return_if_fail( be != NULL );
+
+    if ( be->load_window_months <= 0 )
+    {
+        gnc_sql_transaction_load_all_tx( be );
+        return;
+    }
+
+    g_date_clear( &date, 1 );
+    g_date_set_time_t( &date, time( NULL ) );
+    g_date_subtract_months( &date, (guint)be->load_window_months );
+    since = gdate_to_timespec( date );
+
+    /* Objects loaded earlier, such as posted invoices, may have loaded
+       older transactions.  Everything since the oldest of them is loaded
+       too, so that the starting balances are those at the watermark. */
+    qof_collection_foreach( qof_book_get_collection( be->book, GNC_ID_TRANS ),
+                            lower_to_post_date, &since );
+
+    load_tx_posted_between( be, since.tv_sec == G_MININT64 ? NULL : &since, NULL );
+    PINFO( "Loaded transactions posted in the last %d months\n", be->load_window_months );
+}
+
 /* ================================================================= */
 /**
  * Creates the transaction and split tables.
@@ -561,6 +707,19 @@ create_transaction_tables( GncSqlBackend* be )
         (void)gnc_sql_set_table_version( be, SPLIT_TABLE, SPLIT_TABLE_VERSION );
         PINFO("Splits table upgraded from version %d to version %d\n", version, SPLIT_TABLE_VERSION);
     }
+
+    /* Indexes for split queries.  They don't change the tables, so they
+       are added to existing databases without a version bump. */
+    ok = gnc_sql_create_index( be, "tx_enter_date_index", TRANSACTION_TABLE, enter_date_col_table );
+    if ( !ok )
+    {
+        PERR( "Unable to create index\n" );
+    }
+    ok = gnc_sql_create_index( be, "splits_account_reconcile_index", SPLIT_TABLE, account_reconcile_col_table );
+    if ( !ok )
+    {
+        PERR( "Unable to create index\n" );
+    }
 }
 /* ================================================================= */
 /**
@@ -631,7 +790,7 @@ commit_split( GncSqlBackend* be, QofInstance* inst )
     g_return_val_if_fail( inst != NULL, FALSE );
     g_return_val_if_fail( be != NULL, FALSE );
 
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
@@ -703,7 +862,7 @@ save_transaction( GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits )
     g_return_val_if_fail( pTx != NULL, FALSE );
 
     inst = QOF_INSTANCE(pTx);
-    is_infant = qof_instance_get_infant( inst );
+    is_infant = gnc_sql_instance_is_infant( be, inst );
     if ( qof_instance_get_destroying( inst ) )
     {
         op = OP_DB_DELETE;
@@ -877,7 +1036,7 @@ void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* accoun
     g_free( query_sql );
     if ( stmt != NULL )
     {
-        query_transactions( be, stmt );
+        query_some_transactions( be, stmt );
         gnc_sql_statement_dispose( stmt );
     }
 }
@@ -890,429 +1049,855 @@ void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* accoun
  */
 void gnc_sql_transaction_load_all_tx( GncSqlBackend* be )
 {
-    gchar* query_sql;
-    GncSqlStatement* stmt;
-
     g_return_if_fail( be != NULL );
 
-    query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-    stmt = gnc_sql_create_statement_from_sql( be, query_sql );
-    g_free( query_sql );
-    if ( stmt != NULL )
+    if ( be->load_window_months > 0 && be->tx_loaded_since.tv_sec != G_MAXINT64 )
     {
-        query_transactions( be, stmt );
-        gnc_sql_statement_dispose( stmt );
+        // Only the transactions older than the ones already loaded are needed
+        if ( be->tx_loaded_since.tv_sec != G_MININT64 )
+        {
+            Timespec to = be->tx_loaded_since;
+            load_tx_posted_between( be, NULL, &to );
+        }
+    }
+    else
+    {
+        load_tx_posted_between( be, NULL, NULL );
     }
 }
 
-static void
-convert_query_comparison_to_sql( QofQueryPredData* pPredData, gboolean isInverted, GString* sql )
+/* ----------------------------------------------------------------- */
+/*
+ * Split query translation.  The engine runs every query against the
+ * objects in memory, so the backend only has to make sure that the
+ * transactions a query can match are loaded.  The SQL generated here may
+ * select more rows than the query matches, but never fewer.
+ */
+
+/* How closely the SQL for a query term follows the term */
+typedef enum
+{
+    SQL_MATCH_NONE,         /* The term can't be expressed in SQL */
+    SQL_MATCH_SUPERSET,     /* The SQL matches at least the rows the term matches */
+    SQL_MATCH_EXACT         /* The SQL matches exactly the rows the term matches */
+} sql_match_t;
+
+typedef struct
 {
-    if ( pPredData->how == QOF_COMPARE_LT
-            || ( isInverted && pPredData->how == QOF_COMPARE_GTE ) )
+    const gchar* param;
+    /*@ null @*/ const gchar* sub_param;
+    const gchar* type_name;
+    const gchar* column;
+    /*@ null @*/ const gchar* denom_column;     /* For numerics */
+} split_query_field_t;
+
+static const split_query_field_t split_query_fields[] =
+{
+    { SPLIT_ACCOUNT,         QOF_PARAM_GUID,     QOF_TYPE_GUID,    "s.account_guid",    NULL },
+    { SPLIT_TRANS,           QOF_PARAM_GUID,     QOF_TYPE_GUID,    "t.guid",            NULL },
+    { SPLIT_TRANS,           TRANS_DATE_POSTED,  QOF_TYPE_DATE,    "t.post_date",       NULL },
+    { SPLIT_TRANS,           TRANS_DATE_ENTERED, QOF_TYPE_DATE,    "t.enter_date",      NULL },
+    { SPLIT_TRANS,           TRANS_DESCRIPTION,  QOF_TYPE_STRING,  "t.description",     NULL },
+    { SPLIT_TRANS,           TRANS_NUM,          QOF_TYPE_STRING,  "t.num",             NULL },
+    { QOF_PARAM_GUID,        NULL,               QOF_TYPE_GUID,    "s.guid",            NULL },
+    { SPLIT_MEMO,            NULL,               QOF_TYPE_STRING,  "s.memo",            NULL },
+    { SPLIT_ACTION,          NULL,               QOF_TYPE_STRING,  "s.action",          NULL },
+    { SPLIT_RECONCILE,       NULL,               QOF_TYPE_CHAR,    "s.reconcile_state", NULL },
+    { SPLIT_DATE_RECONCILED, NULL,               QOF_TYPE_DATE,    "s.reconcile_date",  NULL },
+    { SPLIT_VALUE,           NULL,               QOF_TYPE_NUMERIC, "s.value_num",       "s.value_denom" },
+    { SPLIT_AMOUNT,          NULL,               QOF_TYPE_NUMERIC, "s.quantity_num",    "s.quantity_denom" },
+    { NULL }
+};
+
+#define SECS_PER_DAY (24 * 60 * 60)
+
+static /*@ null @*/ const split_query_field_t*
+lookup_split_query_field( /*@ null @*/ const GSList* paramPath )
+{
+    const split_query_field_t* field;
+
+    if ( paramPath == NULL ) return NULL;
+
+    for ( field = split_query_fields; field->param != NULL; field++ )
     {
-        g_string_append( sql, "<" );
+        if ( strcmp( paramPath->data, field->param ) != 0 ) continue;
+        if ( field->sub_param == NULL )
+        {
+            if ( paramPath->next == NULL ) return field;
+        }
+        else if ( paramPath->next != NULL && paramPath->next->next == NULL
+                  && strcmp( paramPath->next->data, field->sub_param ) == 0 )
+        {
+            return field;
+        }
     }
-    else if ( pPredData->how == QOF_COMPARE_LTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_GT ) )
+
+    return NULL;
+}
+
+static gboolean
+is_post_date_path( /*@ null @*/ const GSList* paramPath )
+{
+    return paramPath != NULL && paramPath->next != NULL
+           && strcmp( paramPath->data, SPLIT_TRANS ) == 0
+           && strcmp( paramPath->next->data, TRANS_DATE_POSTED ) == 0;
+}
+
+static sql_match_t
+convert_guid_term_to_sql( const gchar* column, QofQueryPredData* pPredData, GString* sql )
+{
+    query_guid_t guid_data = (query_guid_t)pPredData;
+    GList* guid_entry;
+
+    if ( guid_data->options != QOF_GUID_MATCH_ANY && guid_data->options != QOF_GUID_MATCH_NONE )
     {
-        g_string_append( sql, "<=" );
+        return SQL_MATCH_NONE;
     }
-    else if ( pPredData->how == QOF_COMPARE_EQUAL
-              || ( isInverted && pPredData->how == QOF_COMPARE_NEQ ) )
+
+    // Nothing is in an empty list
+    if ( guid_data->guids == NULL )
     {
-        g_string_append( sql, "=" );
+        g_string_append( sql, guid_data->options == QOF_GUID_MATCH_ANY ? "(1=0)" : "(1=1)" );
+        return SQL_MATCH_EXACT;
     }
-    else if ( pPredData->how == QOF_COMPARE_GT
-              || ( isInverted && pPredData->how == QOF_COMPARE_LTE ) )
+
+    g_string_append_printf( sql, "(%s%s IN (", column,
+                            guid_data->options == QOF_GUID_MATCH_NONE ? " NOT" : "" );
+    for ( guid_entry = guid_data->guids; guid_entry != NULL; guid_entry = guid_entry->next )
     {
-        g_string_append( sql, ">" );
+        gchar guid_buf[GUID_ENCODING_LENGTH+1];
+
+        if ( guid_entry != guid_data->guids ) g_string_append( sql, "," );
+        (void)guid_to_string_buff( guid_entry->data, guid_buf );
+        g_string_append_printf( sql, "'%s'", guid_buf );
     }
-    else if ( pPredData->how == QOF_COMPARE_GTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_LT ) )
+    g_string_append( sql, "))" );
+
+    return SQL_MATCH_EXACT;
+}
+
+static sql_match_t
+convert_char_term_to_sql( const gchar* column, QofQueryPredData* pPredData, GString* sql )
+{
+    query_char_t char_data = (query_char_t)pPredData;
+    int i;
+
+    if ( char_data->char_list == NULL || char_data->char_list[0] == '\0' )
     {
-        g_string_append( sql, ">=" );
+        g_string_append( sql, char_data->options == QOF_CHAR_MATCH_ANY ? "(1=0)" : "(1=1)" );
+        return SQL_MATCH_EXACT;
     }
-    else if ( pPredData->how == QOF_COMPARE_NEQ
-              || ( isInverted && pPredData->how == QOF_COMPARE_EQUAL ) )
+
+    g_string_append_printf( sql, "(%s%s IN (", column,
+                            char_data->options == QOF_CHAR_MATCH_NONE ? " NOT" : "" );
+    for ( i = 0; char_data->char_list[i] != '\0'; i++ )
     {
-        g_string_append( sql, "~=" );
+        // Reconcile flags are letters; don't try to quote anything else
+        if ( !g_ascii_isalnum( char_data->char_list[i] ) ) return SQL_MATCH_NONE;
+
+        if ( i != 0 ) g_string_append( sql, "," );
+        g_string_append_printf( sql, "'%c'", char_data->char_list[i] );
     }
-    else
+    g_string_append( sql, "))" );
+
+    return SQL_MATCH_EXACT;
+}
+
+static gboolean
+is_ascii_string( const gchar* str )
+{
+    const gchar* p;
+
+    for ( p = str; *p != '\0'; p++ )
     {
-        PERR( "Unknown comparison type\n" );
-        g_string_append( sql, "??" );
+        if ( (guchar)*p >= 0x80 ) return FALSE;
     }
+    return TRUE;
 }
 
-static void
-convert_query_term_to_sql( const GncSqlBackend* be, const gchar* fieldName, QofQueryTerm* pTerm, GString* sql )
+static sql_match_t
+convert_string_term_to_sql( const GncSqlBackend* be, const gchar* column,
+                            QofQueryPredData* pPredData, GString* sql )
 {
-    QofQueryPredData* pPredData;
-    gboolean isInverted;
+    query_string_t string_data = (query_string_t)pPredData;
+    const GncSqlQueryDialect* dialect = be->query_dialect;
+    gboolean nocase = ( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE );
+    /*@ null @*/ const gchar* op;
+    sql_match_t match;
+    GString* pattern;
+    gchar* quoted;
+    const gchar* p;
+
+    if ( pPredData->how != QOF_COMPARE_EQUAL && pPredData->how != QOF_COMPARE_NEQ )
+    {
+        return SQL_MATCH_NONE;
+    }
 
-    g_return_if_fail( pTerm != NULL );
-    g_return_if_fail( sql != NULL );
+    // Database regular expressions differ from POSIX in ways that can
+    // reject rows the engine would match, so leave them to the engine
+    if ( string_data->is_regex )
+    {
+        return SQL_MATCH_NONE;
+    }
 
-    pPredData = qof_query_term_get_pred_data( pTerm );
-    isInverted = qof_query_term_is_inverted( pTerm );
+    if ( nocase )
+    {
+        // Only ASCII case folding works the same everywhere
+        op = ( dialect == NULL || !is_ascii_string( string_data->matchstring ) )
+             ? NULL : dialect->like_nocase_op;
+        match = SQL_MATCH_SUPERSET;
+    }
+    else
+    {
+        op = "LIKE";
+        match = ( dialect != NULL && dialect->like_is_case_sensitive )
+                ? SQL_MATCH_EXACT : SQL_MATCH_SUPERSET;
+    }
+
+    // Substring match, with the LIKE wildcards escaped
+    pattern = g_string_new( "%" );
+    for ( p = string_data->matchstring; *p != '\0'; p++ )
+    {
+        if ( *p == '!' || *p == '%' || *p == '_' ) g_string_append_c( pattern, '!' );
+        g_string_append_c( pattern, *p );
+    }
+    g_string_append_c( pattern, '%' );
 
-    if ( g_strcmp0( pPredData->type_name, QOF_TYPE_GUID ) == 0 )
+    // A negated superset would be a subset
+    if ( op == NULL || ( pPredData->how == QOF_COMPARE_NEQ && match != SQL_MATCH_EXACT ) )
     {
-        query_guid_t guid_data = (query_guid_t)pPredData;
-        GList* guid_entry;
+        (void)g_string_free( pattern, TRUE );
+        return SQL_MATCH_NONE;
+    }
 
-        g_string_append( sql, "(" );
-        g_string_append( sql, fieldName );
+    quoted = gnc_sql_connection_quote_string( be->conn, pattern->str );
+    (void)g_string_free( pattern, TRUE );
+    if ( quoted == NULL ) return SQL_MATCH_NONE;
 
-        switch ( guid_data->options )
-        {
-        case QOF_GUID_MATCH_ANY:
-            if ( isInverted ) g_string_append( sql, " NOT IN (" );
-            else g_string_append( sql, " IN (" );
-            break;
-
-        case QOF_GUID_MATCH_NONE:
-            if ( isInverted ) g_string_append( sql, " IN (" );
-            else g_string_append( sql, " NOT IN (" );
-            break;
-
-        default:
-            PERR( "Unexpected GncGUID match type: %d\n", guid_data->options );
-        }
+    // The engine treats a NULL string as empty
+    g_string_append_printf( sql, "(%sCOALESCE(%s,'') %s %s ESCAPE '!')",
+                            pPredData->how == QOF_COMPARE_NEQ ? "NOT " : "",
+                            column, op, quoted );
+    g_free( quoted );
 
-        for ( guid_entry = guid_data->guids; guid_entry != NULL; guid_entry = guid_entry->next )
-        {
-            gchar guid_buf[GUID_ENCODING_LENGTH+1];
+    return match;
+}
 
-            if ( guid_entry != guid_data->guids ) g_string_append( sql, "," );
-            (void)guid_to_string_buff( guid_entry->data, guid_buf );
-            g_string_append_printf( sql, "'%s'", guid_buf );
-        }
-        g_string_append( sql, "))" );
+static gboolean
+compare_secs( QofQueryCompare how, gint64 a, gint64 b )
+{
+    switch ( how )
+    {
+    case QOF_COMPARE_LT:
+        return a < b;
+    case QOF_COMPARE_LTE:
+        return a <= b;
+    case QOF_COMPARE_EQUAL:
+        return a == b;
+    case QOF_COMPARE_GT:
+        return a > b;
+    case QOF_COMPARE_GTE:
+        return a >= b;
+    case QOF_COMPARE_NEQ:
+        return a != b;
+    default:
+        return FALSE;
+    }
+}
+
+static void
+append_date_comparison( const GncSqlBackend* be, const gchar* column, const gchar* op,
+                        Timespec ts, GString* sql )
+{
+    gchar* datebuf;
 
+    datebuf = gnc_sql_convert_timespec_to_string( be, ts );
+    g_string_append_printf( sql, "%s%s'%s'", column, op, datebuf );
+    g_free( datebuf );
+}
+
+static sql_match_t
+convert_date_term_to_sql( const GncSqlBackend* be, const gchar* column,
+                          QofQueryPredData* pPredData, GString* sql )
+{
+    query_date_t date_data = (query_date_t)pPredData;
+    QofQueryCompare how = pPredData->how;
+    gboolean null_matches;
+    sql_match_t match;
+
+    g_string_append( sql, "(" );
+    if ( date_data->options != QOF_DATE_MATCH_DAY && date_data->date.tv_nsec == 0 )
+    {
+        static const gchar* ops[] = { NULL, "<", "<=", "=", ">", ">=", "<>" };
+
+        if ( how < QOF_COMPARE_LT || how > QOF_COMPARE_NEQ ) return SQL_MATCH_NONE;
+        append_date_comparison( be, column, ops[how], date_data->date, sql );
+        null_matches = compare_secs( how, 0, date_data->date.tv_sec );
+        match = SQL_MATCH_EXACT;
     }
-    else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_CHAR ) == 0 )
+    else
     {
-        query_char_t char_data = (query_char_t)pPredData;
-        int i;
+        /* Dates are stored to the second, and day matches compare the
+           times rounded to the middle of the day, so widen the range */
+        gint64 slack = ( date_data->options == QOF_DATE_MATCH_DAY ) ? 2 * SECS_PER_DAY : 1;
+        Timespec lo = { date_data->date.tv_sec - slack, 0 };
+        Timespec hi = { date_data->date.tv_sec + slack, 0 };
 
-        if ( isInverted )
+        if ( how == QOF_COMPARE_LT || how == QOF_COMPARE_LTE )
         {
-            g_string_append( sql, "NOT(" );
+            append_date_comparison( be, column, "<=", hi, sql );
+            null_matches = ( 0 <= hi.tv_sec );
         }
-        if ( char_data->options == QOF_CHAR_MATCH_NONE )
+        else if ( how == QOF_COMPARE_GT || how == QOF_COMPARE_GTE )
         {
-            g_string_append( sql, "NOT " );
+            append_date_comparison( be, column, ">=", lo, sql );
+            null_matches = ( 0 >= lo.tv_sec );
         }
-        g_string_append( sql, "(" );
-        for ( i = 0; char_data->char_list[i] != '\0'; i++ )
+        else if ( how == QOF_COMPARE_EQUAL )
         {
-            if ( i != 0 )
-            {
-                g_string_append( sql, " OR " );
-            }
-            g_string_append( sql, fieldName );
-            g_string_append( sql, " = '" );
-            g_string_append_c( sql, char_data->char_list[i] );
-            g_string_append( sql, "'" );
+            append_date_comparison( be, column, ">=", lo, sql );
+            g_string_append( sql, " AND " );
+            append_date_comparison( be, column, "<=", hi, sql );
+            null_matches = ( lo.tv_sec <= 0 && 0 <= hi.tv_sec );
         }
-        g_string_append( sql, ") " );
-        if ( isInverted )
+        else
         {
-            g_string_append( sql, ") " );
+            return SQL_MATCH_NONE;
         }
+        match = SQL_MATCH_SUPERSET;
+    }
 
+    // The engine sees a missing date as the epoch
+    if ( null_matches )
+    {
+        g_string_append_printf( sql, " OR %s IS NULL", column );
     }
-    else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_STRING ) == 0 )
+    g_string_append( sql, ")" );
+
+    return match;
+}
+
+static sql_match_t
+convert_numeric_term_to_sql( const gchar* num_column, const gchar* denom_column,
+                             QofQueryPredData* pPredData, GString* sql )
+{
+    query_numeric_t numeric_data = (query_numeric_t)pPredData;
+    gdouble amount = gnc_numeric_to_double( numeric_data->amount );
+    gdouble slack;
+    gchar lo_buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar hi_buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    /* The engine compares absolute values, and amounts within 1/10000 are
+       equal.  Doubles can't hold every amount, so widen the range a bit. */
+    if ( pPredData->how == QOF_COMPARE_EQUAL )
+    {
+        amount = ABS( amount );
+        slack = 0.0002;
+    }
+    else
     {
-        query_string_t string_data = (query_string_t)pPredData;
-        sqlEscape* escape = sqlEscape_new();
+        slack = ABS( amount ) * 1e-9 + 1e-6;
+    }
+    (void)g_ascii_dtostr( lo_buf, sizeof(lo_buf), amount - slack );
+    (void)g_ascii_dtostr( hi_buf, sizeof(hi_buf), amount + slack );
 
-        if ( isInverted )
-        {
-            g_string_append( sql, "NOT(" );
-        }
-        if ( pPredData->how == QOF_COMPARE_NEQ )
-        {
-            g_string_append( sql, "NOT(" );
-        }
-        g_string_append( sql, fieldName );
-        if ( string_data->is_regex || string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE )
-        {
-            PWARN( "String is_regex || option = QOF_STRING_MATCH_INSENSITIVE\n" );
-        }
-//			g_string_append( sql, " ~" );
-//		} else {
-        g_string_append( sql, " =" );
-//		}
-//		if( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE ) {
-//			g_string_append( sql, "*" );
-//		}
-        g_string_append( sql, "'" );
-        g_string_append( sql, sqlEscapeString( escape, string_data->matchstring ) );
-        g_string_append( sql, "'" );
-        if ( pPredData->how == QOF_COMPARE_NEQ )
+    switch ( pPredData->how )
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+        g_string_append_printf( sql, "(ABS(1.0*%s/%s)<=%s", num_column, denom_column, hi_buf );
+        break;
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        g_string_append_printf( sql, "(ABS(1.0*%s/%s)>=%s", num_column, denom_column, lo_buf );
+        break;
+    case QOF_COMPARE_EQUAL:
+        g_string_append_printf( sql, "(ABS(1.0*%s/%s)>=%s AND ABS(1.0*%s/%s)<=%s",
+                                num_column, denom_column, lo_buf,
+                                num_column, denom_column, hi_buf );
+        break;
+    default:
+        return SQL_MATCH_NONE;
+    }
+
+    if ( numeric_data->options == QOF_NUMERIC_MATCH_DEBIT )
+    {
+        g_string_append_printf( sql, " AND %s>=0", num_column );
+    }
+    else if ( numeric_data->options == QOF_NUMERIC_MATCH_CREDIT )
+    {
+        g_string_append_printf( sql, " AND %s<=0", num_column );
+    }
+    g_string_append( sql, ")" );
+
+    return SQL_MATCH_SUPERSET;
+}
+
+/**
+ * Translates one split query term into an SQL condition on the splits (s)
+ * and transactions (t) tables.  Nothing is appended if the term can't be
+ * translated.
+ *
+ * @param be SQL backend
+ * @param pTerm Query term
+ * @param sql String to append the condition to
+ * @return How closely the condition follows the term
+ */
+static sql_match_t
+convert_query_term_to_sql( const GncSqlBackend* be, QofQueryTerm* pTerm, GString* sql )
+{
+    const split_query_field_t* field;
+    QofQueryPredData* pPredData;
+    GString* term_sql;
+    sql_match_t match;
+
+    g_return_val_if_fail( pTerm != NULL, SQL_MATCH_NONE );
+    g_return_val_if_fail( sql != NULL, SQL_MATCH_NONE );
+
+    field = lookup_split_query_field( qof_query_term_get_param_path( pTerm ) );
+    pPredData = qof_query_term_get_pred_data( pTerm );
+    if ( field == NULL || g_strcmp0( pPredData->type_name, field->type_name ) != 0 )
+    {
+        return SQL_MATCH_NONE;
+    }
+
+    term_sql = g_string_new( "" );
+    if ( strcmp( field->type_name, QOF_TYPE_GUID ) == 0 )
+    {
+        match = convert_guid_term_to_sql( field->column, pPredData, term_sql );
+    }
+    else if ( strcmp( field->type_name, QOF_TYPE_CHAR ) == 0 )
+    {
+        match = convert_char_term_to_sql( field->column, pPredData, term_sql );
+    }
+    else if ( strcmp( field->type_name, QOF_TYPE_STRING ) == 0 )
+    {
+        match = convert_string_term_to_sql( be, field->column, pPredData, term_sql );
+    }
+    else if ( strcmp( field->type_name, QOF_TYPE_DATE ) == 0 )
+    {
+        match = convert_date_term_to_sql( be, field->column, pPredData, term_sql );
+    }
+    else
+    {
+        match = convert_numeric_term_to_sql( field->column, field->denom_column,
+                                             pPredData, term_sql );
+    }
+
+    if ( match != SQL_MATCH_NONE && qof_query_term_is_inverted( pTerm ) )
+    {
+        // A negated superset would be a subset.  NOT(NULL) is still NULL, so use CASE.
+        if ( match == SQL_MATCH_EXACT )
         {
-            g_string_append( sql, ")" );
+            g_string_append_printf( sql, "(CASE WHEN %s THEN 0 ELSE 1 END=1)", term_sql->str );
         }
-        if ( isInverted )
+        else
         {
-            g_string_append( sql, ")" );
+            match = SQL_MATCH_NONE;
         }
-        sqlEscape_destroy( escape );
-
     }
-    else
+    else if ( match != SQL_MATCH_NONE )
     {
-        g_string_append( sql, "(" );
-        g_string_append( sql, fieldName );
-        convert_query_comparison_to_sql( pPredData, isInverted, sql );
+        g_string_append( sql, term_sql->str );
+    }
+    (void)g_string_free( term_sql, TRUE );
 
-        if ( strcmp( pPredData->type_name, QOF_TYPE_NUMERIC ) == 0 )
-        {
-            query_numeric_t pData = (query_numeric_t)pPredData;
-            double d = gnc_numeric_to_double( pData->amount );
+    return match;
+}
 
-            g_string_append_printf( sql, "%f", d );
+/**
+ * Translates the terms of a split query, an OR of ANDs, into an SQL
+ * condition.  Terms which can't be translated are left out of their AND,
+ * which only widens it.  An AND with nothing left matches everything.
+ *
+ * @param be SQL backend
+ * @param query Split query
+ * @param sql String to append the condition to
+ * @return How closely the condition follows the query, SQL_MATCH_NONE if
+ * it can't restrict anything
+ */
+static sql_match_t
+convert_split_query_terms_to_sql( const GncSqlBackend* be, QofQuery* query, GString* sql )
+{
+    GList* orTerm;
+    sql_match_t match = SQL_MATCH_EXACT;
+    gsize start = sql->len;
 
-        }
-        else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_DATE ) == 0 )
-        {
-            query_date_t date_data = (query_date_t)pPredData;
-            gchar* datebuf;
+    if ( !qof_query_has_terms( query ) ) return SQL_MATCH_NONE;
 
-            datebuf = gnc_sql_convert_timespec_to_string( be, date_data->date );
-            g_string_append_printf( sql, "'%s'", datebuf );
+    for ( orTerm = qof_query_get_terms( query ); orTerm != NULL; orTerm = orTerm->next )
+    {
+        GList* andTerm;
+        GString* branch = g_string_new( "" );
+        gint num_terms = 0;
 
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_INT32 ) == 0 )
+        for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
         {
-            query_int32_t pData = (query_int32_t)pPredData;
+            QofQueryTerm* term = (QofQueryTerm*)andTerm->data;
+            GSList* paramPath = qof_query_term_get_param_path( term );
+            gsize len = branch->len;
+            sql_match_t term_match;
 
-            g_string_append_printf( sql, "%d", pData->val );
+            // The backend only holds one book
+            if ( paramPath != NULL && strcmp( paramPath->data, QOF_PARAM_BOOK ) == 0 ) continue;
 
+            if ( num_terms != 0 ) g_string_append( branch, " AND " );
+            term_match = convert_query_term_to_sql( be, term, branch );
+            if ( term_match == SQL_MATCH_NONE )
+            {
+                g_string_truncate( branch, len );
+                match = SQL_MATCH_SUPERSET;
+                continue;
+            }
+            if ( term_match == SQL_MATCH_SUPERSET ) match = SQL_MATCH_SUPERSET;
+            num_terms++;
         }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_INT64 ) == 0 )
+
+        if ( num_terms == 0 )
         {
-            query_int64_t pData = (query_int64_t)pPredData;
+            (void)g_string_free( branch, TRUE );
+            g_string_truncate( sql, start );
+            return SQL_MATCH_NONE;
+        }
 
-            g_string_append_printf( sql, "%" G_GINT64_FORMAT, pData->val );
+        if ( orTerm != qof_query_get_terms( query ) ) g_string_append( sql, " OR " );
+        g_string_append_printf( sql, "(%s)", branch->str );
+        (void)g_string_free( branch, TRUE );
+    }
 
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_DOUBLE ) == 0 )
-        {
-            query_double_t pData = (query_double_t)pPredData;
+    return match;
+}
+
+/**
+ * Translates the sort order of a split query into an ORDER BY clause.  The
+ * engine sorts and then keeps the last max_results objects, so the SQL
+ * sorts the other way around and keeps the first ones.  Only numeric and
+ * date sorts are translated since string collation differs between the
+ * engine and the databases.
+ *
+ * @param be SQL backend
+ * @param query Split query
+ * @param sql String to append the clause to
+ * @return TRUE if the whole sort order was translated
+ */
+static gboolean
+convert_split_query_sort_to_sql( const GncSqlBackend* be, QofQuery* query, GString* sql )
+{
+    QofQuerySort* sorts[3];
+    GString* order;
+    gint i;
+    gboolean ok = TRUE;
+
+    qof_query_get_sorts( query, &sorts[0], &sorts[1], &sorts[2] );
+    if ( sorts[0] == NULL || qof_query_sort_get_param_path( sorts[0] ) == NULL ) return FALSE;
+
+    order = g_string_new( "" );
+    for ( i = 0; i < 3 && ok; i++ )
+    {
+        const split_query_field_t* field;
+        const gchar* dir;
+
+        if ( sorts[i] == NULL || qof_query_sort_get_param_path( sorts[i] ) == NULL ) continue;
 
-            g_string_append_printf( sql, "%f", pData->val );
+        field = lookup_split_query_field( qof_query_sort_get_param_path( sorts[i] ) );
+        dir = qof_query_sort_get_increasing( sorts[i] ) ? "DESC" : "ASC";
+        g_string_append( order, order->len == 0 ? " ORDER BY " : ", " );
 
+        if ( field != NULL && field->denom_column != NULL )
+        {
+            g_string_append_printf( order, "1.0*%s/%s %s", field->column, field->denom_column, dir );
         }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_BOOLEAN ) == 0 )
+        else if ( field != NULL && strcmp( field->type_name, QOF_TYPE_DATE ) == 0
+                  && qof_query_sort_get_sort_options( sorts[i] ) != QOF_DATE_MATCH_DAY )
         {
-            query_boolean_t pData = (query_boolean_t)pPredData;
-
-            g_string_append_printf( sql, "%d", pData->val );
+            static const Timespec epoch = { 0, 0 };
+            gchar* datebuf = gnc_sql_convert_timespec_to_string( be, epoch );
 
+            // Databases disagree on where NULLs sort; the engine sees the epoch
+            g_string_append_printf( order, "COALESCE(%s,'%s') %s", field->column, datebuf, dir );
+            g_free( datebuf );
         }
         else
         {
-            PERR( "Unknown query predicate type: %s\n", pPredData->type_name );
+            ok = FALSE;
         }
-
-        g_string_append( sql, ")" );
     }
-}
 
-typedef struct
-{
-    GncSqlStatement* stmt;
-    gboolean has_been_run;
-} split_query_info_t;
+    if ( ok ) g_string_append( sql, order->str );
+    (void)g_string_free( order, TRUE );
 
-#define TX_GUID_CHECK 0
+    return ok;
+}
 
-G_GNUC_UNUSED static /*@ null @*/ gpointer
-compile_split_query( GncSqlBackend* be, QofQuery* query )
+/*@ null @*/ gchar*
+gnc_sql_split_query_to_sql( const GncSqlBackend* be, QofQuery* query, gboolean* is_exact )
 {
-    split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    GString* where;
+    GString* order;
+    gchar* loaded = NULL;
+    gchar* query_sql = NULL;
+    gint max_results;
+    sql_match_t match;
 
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( query != NULL, NULL );
 
-    query_info = g_malloc( (gsize)sizeof(split_query_info_t) );
-    g_assert( query_info != NULL );
-    query_info->has_been_run = FALSE;
-
-    if ( qof_query_has_terms( query ) )
+    where = g_string_new( "" );
+    match = convert_split_query_terms_to_sql( be, query, where );
+    if ( is_exact != NULL ) *is_exact = ( match == SQL_MATCH_EXACT );
+    if ( match == SQL_MATCH_NONE )
     {
-        GList* orterms = qof_query_get_terms( query );
-        GList* orTerm;
-        GString* sql = g_string_new( "" );
-        gboolean need_OR = FALSE;
-
-        for ( orTerm = orterms; orTerm != NULL; orTerm = orTerm->next )
-        {
-            GList* andterms = (GList*)orTerm->data;
-            GList* andTerm;
-            gboolean need_AND = FALSE;
-#if TX_GUID_CHECK
-            gboolean has_tx_guid_check = FALSE;
-#endif
-            if ( need_OR )
-            {
-                g_string_append( sql, " OR " );
-            }
-            g_string_append( sql, "(" );
-            for ( andTerm = andterms; andTerm != NULL; andTerm = andTerm->next )
-            {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path( term );
+        (void)g_string_free( where, TRUE );
+        return NULL;
+    }
 
-                if ( strcmp( paramPath->data, QOF_PARAM_BOOK ) == 0 ) continue;
+    // Transactions on or after the watermark are already in memory
+    if ( be->load_window_months > 0 && be->tx_loaded_since.tv_sec != G_MAXINT64
+            && be->tx_loaded_since.tv_sec != G_MININT64 )
+    {
+        gchar* datebuf = gnc_sql_convert_timespec_to_string( be, be->tx_loaded_since );
+        loaded = g_strdup_printf( "(t.post_date<'%s' OR t.post_date IS NULL) AND ", datebuf );
+        g_free( datebuf );
+    }
 
-#if SIMPLE_QUERY_COMPILATION
-                if ( strcmp( paramPath->data, SPLIT_ACCOUNT ) != 0
-                        || strcmp( paramPath->next->data, QOF_PARAM_GUID ) != 0 ) continue;
-#endif
+    /* A limit can only be pushed down if the SQL matches exactly the same
+       splits in the same order.  Whatever is already loaded is merged in
+       by the engine, which keeps the overall top max_results. */
+    max_results = qof_query_get_max_results( query );
+    order = g_string_new( "" );
+    if ( match == SQL_MATCH_EXACT && max_results >= 0
+            && convert_split_query_sort_to_sql( be, query, order ) )
+    {
+        query_sql = g_strdup_printf(
+                        "SELECT DISTINCT t.* FROM %s AS t, (SELECT s.tx_guid FROM %s AS s, %s AS t WHERE s.tx_guid=t.guid AND %s(%s)%s LIMIT %d) AS lim WHERE t.guid=lim.tx_guid",
+                        TRANSACTION_TABLE, SPLIT_TABLE, TRANSACTION_TABLE,
+                        loaded != NULL ? loaded : "", where->str, order->str, max_results );
+    }
+    else
+    {
+        query_sql = g_strdup_printf(
+                        "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s(%s)",
+                        TRANSACTION_TABLE, SPLIT_TABLE,
+                        loaded != NULL ? loaded : "", where->str );
+    }
 
-                if ( need_AND ) g_string_append( sql, " AND " );
+    (void)g_string_free( order, TRUE );
+    (void)g_string_free( where, TRUE );
+    g_free( loaded );
 
-                if ( strcmp( paramPath->data, SPLIT_ACCOUNT ) == 0
-                        && strcmp( paramPath->next->data, QOF_PARAM_GUID ) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.account_guid", term, sql );
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
+    return query_sql;
+}
 
-                }
-                else if ( strcmp( paramPath->data, SPLIT_RECONCILE ) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.reconcile_state", term, sql );
+typedef struct
+{
+    /*@ null @*/
+    GncSqlStatement* stmt;  /* Pushed down query, or NULL to load by date */
+    gboolean has_been_run;
+    gboolean needs_load;    /* Older transactions must be loaded */
+    gboolean load_all;      /* The query has no lower date bound */
+    Timespec since;         /* Earliest post date the query can match */
+} split_query_info_t;
 
-                }
-                else if ( strcmp( paramPath->data, SPLIT_TRANS ) == 0 )
-                {
-#if TX_GUID_CHECK
-                    if ( !has_tx_guid_check )
-                    {
-                        g_string_append( sql, "(splits.tx_guid = transactions.guid) AND " );
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if ( strcmp( paramPath->next->data, TRANS_DATE_POSTED ) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.post_date", term, sql );
-                    }
-                    else if ( strcmp( paramPath->next->data, TRANS_DESCRIPTION ) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.description", term, sql );
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
+/**
+ * Finds the earliest post date which a split query can match.  The query is
+ * an OR of ANDs; each AND branch needs a lower bound on the transaction post
+ * date, and the earliest of those is returned.
+ *
+ * @param query Split query
+ * @param since Set to the earliest post date the query can match
+ * @return TRUE if the query has a lower bound, FALSE if it can match any date
+ */
+static gboolean
+get_split_query_posted_since( QofQuery* query, Timespec* since )
+{
+    GList* orterms;
+    GList* orTerm;
+    gboolean have_since = FALSE;
 
-                }
-                else if ( strcmp( paramPath->data, SPLIT_VALUE ) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.value_num/s.value_denom", term, sql );
+    if ( !qof_query_has_terms( query ) ) return FALSE;
 
-                }
-                else
-                {
-                    unknownPath = TRUE;
-                }
+    orterms = qof_query_get_terms( query );
+    for ( orTerm = orterms; orTerm != NULL; orTerm = orTerm->next )
+    {
+        GList* andTerm;
+        gboolean branch_has_since = FALSE;
+        Timespec branch_since = { 0, 0 };
 
-                if ( unknownPath )
-                {
-                    GString* name = g_string_new( (gchar*)paramPath->data );
-                    while ( paramPath->next != NULL )
-                    {
-                        g_string_append( name, "." );
-                        g_string_append( name, paramPath->next->data );
-                        paramPath = paramPath->next;
-                    }
-                    PERR( "Unknown SPLIT query field: %s\n", name->str );
-                    g_string_free( name, TRUE );
-                }
-                need_AND = TRUE;
+        for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
+        {
+            QofQueryTerm* term = (QofQueryTerm*)andTerm->data;
+            GSList* paramPath = qof_query_term_get_param_path( term );
+            QofQueryPredData* pPredData = qof_query_term_get_pred_data( term );
+            gboolean isInverted = qof_query_term_is_inverted( term );
+            query_date_t date_data;
+            Timespec ts;
+
+            if ( !is_post_date_path( paramPath ) ) continue;
+            if ( strcmp( pPredData->type_name, QOF_TYPE_DATE ) != 0 ) continue;
+
+            /* Only comparisons which exclude earlier dates give a bound */
+            if ( isInverted )
+            {
+                if ( pPredData->how != QOF_COMPARE_LT && pPredData->how != QOF_COMPARE_LTE ) continue;
+            }
+            else
+            {
+                if ( pPredData->how != QOF_COMPARE_GT && pPredData->how != QOF_COMPARE_GTE
+                        && pPredData->how != QOF_COMPARE_EQUAL ) continue;
             }
 
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-            if ( sql->str[sql->len-1] == '(' )
+            date_data = (query_date_t)pPredData;
+            ts = date_data->date;
+            if ( date_data->options == QOF_DATE_MATCH_DAY )
             {
-                g_string_truncate( sql, sql->len - 1 );
-                need_OR = FALSE;
+                /* Day matches compare rounded times; back off a full day */
+                ts.tv_sec -= 24 * 60 * 60;
             }
-            else
+            if ( !branch_has_since || timespec_cmp( &ts, &branch_since ) > 0 )
             {
-                g_string_append( sql, ")" );
-                need_OR = TRUE;
+                branch_since = ts;
+                branch_has_since = TRUE;
             }
         }
 
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-        if ( sql->len != 0 )
+        if ( !branch_has_since ) return FALSE;
+        if ( !have_since || timespec_cmp( &branch_since, since ) < 0 )
         {
-#if SIMPLE_QUERY_COMPILATION
-            g_string_append( sql, ")" );
-#endif
-            query_sql = g_strdup_printf(
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
-                            TRANSACTION_TABLE, SPLIT_TABLE, sql->str );
+            *since = branch_since;
+            have_since = TRUE;
         }
-        else
+    }
+
+    return have_since;
+}
+
+/**
+ * Checks whether a split query restricts nothing but the transaction post
+ * date.  Such queries are better served by loading the whole date range.
+ *
+ * @param query Split query
+ * @return TRUE if all terms are on the post date
+ */
+static gboolean
+is_split_query_date_only( QofQuery* query )
+{
+    GList* orTerm;
+    GList* andTerm;
+
+    for ( orTerm = qof_query_get_terms( query ); orTerm != NULL; orTerm = orTerm->next )
+    {
+        for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
         {
-            query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
+            GSList* paramPath = qof_query_term_get_param_path( (QofQueryTerm*)andTerm->data );
+
+            if ( paramPath != NULL && strcmp( paramPath->data, QOF_PARAM_BOOK ) == 0 ) continue;
+            if ( !is_post_date_path( paramPath ) ) return FALSE;
         }
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
+    }
 
-        g_string_free( sql, TRUE );
-        g_free( query_sql );
+    return TRUE;
+}
 
+/**
+ * Compiles a split query.  All transactions are in memory unless a load
+ * window was set.  If one was, the query is pushed down to the database
+ * so that only the transactions it can match are loaded, along with those
+ * posted between the oldest of them and the watermark.  Queries which
+ * can't be translated, or which only restrict the post date, load all of
+ * the older transactions they could match by date instead.  The engine
+ * then runs the query against the objects in memory.
+ *
+ * @param be SQL backend
+ * @param query Split query
+ * @return Compiled query
+ */
+static /*@ null @*/ gpointer
+compile_split_query( GncSqlBackend* be, QofQuery* query )
+{
+    split_query_info_t* query_info = NULL;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( query != NULL, NULL );
+
+    query_info = g_malloc( (gsize)sizeof(split_query_info_t) );
+    g_assert( query_info != NULL );
+    query_info->stmt = NULL;
+    query_info->has_been_run = FALSE;
+    query_info->needs_load = FALSE;
+    query_info->load_all = FALSE;
+    query_info->since = be->tx_loaded_since;
+
+    // Everything is already in memory
+    if ( be->load_window_months <= 0 || be->tx_loaded_since.tv_sec == G_MININT64 )
+    {
+        return query_info;
     }
-    else
+
+    if ( !is_split_query_date_only( query ) )
     {
-        query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
-        g_free( query_sql );
+        gchar* query_sql = gnc_sql_split_query_to_sql( be, query, NULL );
+
+        if ( query_sql != NULL )
+        {
+            DEBUG( "%s\n", query_sql );
+            query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
+            g_free( query_sql );
+            if ( query_info->stmt != NULL ) return query_info;
+        }
     }
 
+    query_info->load_all = !get_split_query_posted_since( query, &query_info->since );
+    query_info->needs_load = query_info->load_all
+                             || timespec_cmp( &query_info->since, &be->tx_loaded_since ) < 0;
+
     return query_info;
 }
 
-G_GNUC_UNUSED static void
+static void
 run_split_query( GncSqlBackend* be, gpointer pQuery )
 {
     split_query_info_t* query_info = (split_query_info_t*)pQuery;
+    Timespec to;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( pQuery != NULL );
 
-    if ( !query_info->has_been_run )
+    if ( query_info->stmt != NULL )
     {
-        query_transactions( be, query_info->stmt );
-        query_info->has_been_run = TRUE;
-        gnc_sql_statement_dispose( query_info->stmt );
-        query_info->stmt = NULL;
+        if ( !query_info->has_been_run )
+        {
+            query_some_transactions( be, query_info->stmt );
+            query_info->has_been_run = TRUE;
+            gnc_sql_statement_dispose( query_info->stmt );
+            query_info->stmt = NULL;
+        }
+        return;
     }
+
+    if ( !query_info->needs_load ) return;
+
+    // An earlier query may have loaded these already
+    to = be->tx_loaded_since;
+    if ( to.tv_sec == G_MININT64 ) return;
+    if ( !query_info->load_all && timespec_cmp( &query_info->since, &to ) >= 0 ) return;
+
+    DEBUG( "Loading transactions posted before %" G_GINT64_FORMAT "\n", to.tv_sec );
+    load_tx_posted_between( be, query_info->load_all ? NULL : &query_info->since, &to );
 }
 
-G_GNUC_UNUSED static void
+static void
 free_split_query( GncSqlBackend* be, gpointer pQuery )
 {
+    split_query_info_t* query_info = (split_query_info_t*)pQuery;
+
     g_return_if_fail( be != NULL );
     g_return_if_fail( pQuery != NULL );
 
+    if ( query_info->stmt != NULL )
+    {
+        gnc_sql_statement_dispose( query_info->stmt );
+        query_info->stmt = NULL;
+    }
     g_free( pQuery );
 }
 
@@ -1370,7 +1955,7 @@ static const GncSqlColumnTableEntry acct_balances_col_table[] =
     /*@ +full_init_block @*/
 };
 
-G_GNUC_UNUSED static /*@ null @*/ single_acct_balance_t*
+static /*@ null @*/ single_acct_balance_t*
 load_single_acct_balances( const GncSqlBackend* be, GncSqlRow* row )
 {
     single_acct_balance_t* bal = NULL;
@@ -1390,7 +1975,6 @@ load_single_acct_balances( const GncSqlBackend* be, GncSqlRow* row )
 /*@ null @*/ GSList*
 gnc_sql_get_account_balances_slist( GncSqlBackend* be )
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     GncSqlResult* result;
     GncSqlStatement* stmt;
     gchar* buf;
@@ -1417,15 +2001,11 @@ gnc_sql_get_account_balances_slist( GncSqlBackend* be )
 
             // Get the next reconcile state balance and merge with other balances
             single_bal = load_single_acct_balances( be, row );
-            if ( single_bal != NULL )
+            if ( single_bal != NULL && single_bal->acct != NULL )
             {
                 if ( bal != NULL && bal->acct != single_bal->acct )
                 {
-                    bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, bal->reconciled_balance,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                    bal->balance = gnc_numeric_add( bal->balance, bal->cleared_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                    bal_slist = g_slist_append( bal_slist, bal );
+                    bal_slist = g_slist_prepend( bal_slist, bal );
                     bal = NULL;
                 }
                 if ( bal == NULL )
@@ -1438,42 +2018,34 @@ gnc_sql_get_account_balances_slist( GncSqlBackend* be )
                     bal->cleared_balance = gnc_numeric_zero();
                     bal->reconciled_balance = gnc_numeric_zero();
                 }
-                if ( single_bal->reconcile_state == 'n' )
-                {
-                    bal->balance = gnc_numeric_add( bal->balance, single_bal->balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                }
-                else if ( single_bal->reconcile_state == 'c' )
+
+                /* Same rules as xaccAccountRecomputeBalance() */
+                bal->balance = gnc_numeric_add( bal->balance, single_bal->balance,
+                                                GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+                if ( single_bal->reconcile_state != NREC )
                 {
                     bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, single_bal->balance,
                                                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
                 }
-                else if ( single_bal->reconcile_state == 'y' )
+                if ( single_bal->reconcile_state == YREC || single_bal->reconcile_state == FREC )
                 {
                     bal->reconciled_balance = gnc_numeric_add( bal->reconciled_balance, single_bal->balance,
                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
                 }
-                g_free( single_bal );
             }
+            g_free( single_bal );
             row = gnc_sql_result_get_next_row( result );
         }
 
         // Add the final balance
         if ( bal != NULL )
         {
-            bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, bal->reconciled_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-            bal->balance = gnc_numeric_add( bal->balance, bal->cleared_balance,
-                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-            bal_slist = g_slist_append( bal_slist, bal );
+            bal_slist = g_slist_prepend( bal_slist, bal );
         }
         gnc_sql_result_dispose( result );
     }
 
-    return bal_slist;
-#else
-    return NULL;
-#endif
+    return g_slist_reverse( bal_slist );
 }
 
 /* ----------------------------------------------------------------- */
@@ -1510,7 +2082,7 @@ load_tx_guid( const GncSqlBackend* be, GncSqlRow* row,
                                    TRANSACTION_TABLE, guid_str );
             stmt = gnc_sql_create_statement_from_sql( (GncSqlBackend*)be, buf );
             g_free( buf );
-            query_transactions( (GncSqlBackend*)be, stmt );
+            query_some_transactions( (GncSqlBackend*)be, stmt );
             tx = xaccTransLookup( &guid, be->book );
         }
 
@@ -1544,11 +2116,7 @@ gnc_sql_init_transaction_handler( void )
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_TRANS,
         commit_transaction,          /* commit */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        NULL,                        /* initial load */
-#else
-        gnc_sql_transaction_load_all_tx,
-#endif
+        load_initial_tx,             /* initial load */
         create_transaction_tables,   /* create tables */
         NULL,                        /* compile_query */
         NULL,                        /* run_query */
@@ -1562,15 +2130,9 @@ gnc_sql_init_transaction_handler( void )
         commit_split,                /* commit */
         NULL,                        /* initial_load */
         NULL,                        /* create tables */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        compile_split_query,
-        run_split_query,
-        free_split_query,
-#else
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
-#endif
+        compile_split_query,         /* compile_query */
+        run_split_query,             /* run_query */
+        free_split_query,            /* free_query */
         NULL                         /* write */
     };
 
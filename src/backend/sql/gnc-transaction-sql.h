@@ -68,6 +68,21 @@ void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* accoun
  */
 void gnc_sql_transaction_load_all_tx( GncSqlBackend* be );
 
+/**
+ * Translates a split query into SQL which selects the transactions that the
+ * query can match.  The SQL may select more transactions than the query
+ * matches, but never fewer.  Transactions which are already loaded are left
+ * out when a load window is in use.
+ *
+ * @param be SQL backend
+ * @param query Split query
+ * @param is_exact If not NULL, set to TRUE if the SQL matches exactly the
+ * splits the query matches
+ * @return SQL, or NULL if the query can't be narrowed down in SQL
+ */
+/*@ null @*/
+gchar* gnc_sql_split_query_to_sql( const GncSqlBackend* be, QofQuery* query, gboolean* is_exact );
+
 typedef struct
 {
     Account* acct;
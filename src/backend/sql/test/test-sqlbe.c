@@ -26,6 +26,7 @@
 #include "qof.h"
 
 extern void test_suite_gnc_backend_sql ();
+extern void test_suite_gnc_transaction_sql ();
 
 int
 main (int   argc,
@@ -37,6 +38,7 @@ main (int   argc,
     g_test_bug_base("https://bugzilla.gnome.org/show_bug.cgi?id="); /* init the bugzilla URL */
 
     test_suite_gnc_backend_sql ();
+    test_suite_gnc_transaction_sql ();
 
     return g_test_run( );
 }
@@ -218,6 +218,8 @@ test_gnc_sql_commit_edit (void)
     inst  = g_object_new (QOF_TYPE_INSTANCE, NULL);
     qof_instance_init_data (inst, QOF_ID_NULL, be.book);
     be.loading = FALSE;
+    be.write_behind = NULL;
+    be.dirty_sets = NULL;
     qof_book_set_dirty_cb (be.book, test_dirty_cb, &dirty_called);
     qof_instance_set_dirty_flag (inst, TRUE);
     qof_book_mark_session_dirty (be.book);
@@ -260,6 +262,383 @@ test_gnc_sql_commit_edit (void)
     g_object_unref (inst);
     g_object_unref (be.book);
 }
+
+/* gnc_sql_write_behind_flush
+gboolean
+gnc_sql_write_behind_flush (GncSqlBackend* be)// C: 1 */
+static guint fake_commits = 0;
+static gboolean fake_commit_ok = TRUE;
+
+static gboolean
+fake_commit (GncSqlBackend* be, QofInstance* inst)
+{
+    g_assert (gnc_sql_instance_is_infant (be, inst));
+    if (!fake_commit_ok)
+        return FALSE;
+    ++fake_commits;
+    return TRUE;
+}
+
+static void
+test_gnc_sql_write_behind (void)
+{
+    GncSqlBackend be;
+    GncSqlConnection conn;
+    GncSqlWriteBehindStats stats;
+    QofInstance *inst;
+    gchar *msg = "[gnc_sql_set_write_behind()] 1 queued objects could not be written\n";
+    guint loglevel = G_LOG_LEVEL_CRITICAL | G_LOG_FLAG_FATAL;
+    gchar *logdomain = "gnc.backend.sql";
+    TestErrorStruct check = { loglevel, logdomain, msg, 0 };
+    guint hdlr;
+    static GncSqlObjectBackend be_data =
+    {
+        GNC_SQL_BACKEND_VERSION,
+        "WriteBehindTest",
+        fake_commit,     /* commit */
+        NULL,            /* initial_load */
+        NULL,            /* create_tables */
+        NULL, NULL, NULL, NULL
+    };
+
+    qof_object_initialize ();
+    qof_object_register_backend ("WriteBehindTest", GNC_SQL_BACKEND, &be_data);
+    memset (&be, 0, sizeof (be));
+    be.book = qof_book_new ();
+    be.conn = &conn;
+    conn.beginTransaction = fake_connection_function;
+    conn.rollbackTransaction = fake_connection_function;
+    conn.commitTransaction = fake_connection_function;
+    inst  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (inst, "WriteBehindTest", be.book);
+    gnc_sql_set_write_behind (&be, TRUE);
+
+    /* Two commits of the same object are queued once and not written */
+    qof_book_mark_session_dirty (be.book);
+    qof_instance_set_dirty_flag (inst, TRUE);
+    gnc_sql_commit_edit (&be, inst);
+    qof_instance_set_dirty_flag (inst, TRUE);
+    gnc_sql_commit_edit (&be, inst);
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 1);
+    g_assert_cmpint (fake_commits, ==, 0);
+    g_assert (qof_book_session_not_saved (be.book));
+
+    /* A failed flush keeps the queue and reports the error */
+    fake_commit_ok = FALSE;
+    g_assert (!gnc_sql_write_behind_flush (&be));
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 1);
+    g_assert_cmpint (stats.failed_flushes, ==, 1);
+    g_assert_cmpint (qof_backend_get_error (&be.be), ==, ERR_BACKEND_SERVER_ERR);
+    g_assert (qof_book_session_not_saved (be.book));
+    g_assert (!stats.flush_scheduled);
+
+    /* Committing the queued object again arranges for a new flush */
+    qof_instance_set_dirty_flag (inst, TRUE);
+    gnc_sql_commit_edit (&be, inst);
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 1);
+    g_assert (stats.flush_scheduled);
+
+    fake_commit_ok = TRUE;
+    g_assert (gnc_sql_write_behind_flush (&be));
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (fake_commits, ==, 1);
+    g_assert_cmpint (stats.queue_depth, ==, 0);
+    g_assert_cmpint (stats.max_queue_depth, ==, 1);
+    g_assert_cmpint (stats.flushes, ==, 1);
+    g_assert_cmpint (stats.objects_flushed, ==, 1);
+    g_assert (!qof_instance_get_dirty_flag (inst));
+    g_assert (!qof_book_session_not_saved (be.book));
+
+    gnc_sql_set_write_behind (&be, FALSE);
+    g_assert (be.write_behind == NULL);
+
+    /* Without a connection the queue is freed, not written */
+    test_add_error (&check);
+    hdlr = g_log_set_handler (logdomain, loglevel,
+                              (GLogFunc)test_list_handler, NULL);
+    gnc_sql_set_write_behind (&be, TRUE);
+    qof_instance_set_dirty_flag (inst, TRUE);
+    gnc_sql_commit_edit (&be, inst);
+    be.conn = NULL;
+    g_assert (!gnc_sql_write_behind_flush (&be));
+    g_assert_cmpint (qof_backend_get_error (&be.be), ==, ERR_BACKEND_CONN_LOST);
+    gnc_sql_set_write_behind (&be, FALSE);
+    g_assert (be.write_behind == NULL);
+    g_assert_cmpint (check.hits, ==, 1);
+    g_assert_cmpint (fake_commits, ==, 1);
+    g_assert (qof_instance_get_dirty_flag (inst));
+    g_log_remove_handler (logdomain, hdlr);
+    test_clear_error_list ();
+
+    g_object_unref (inst);
+    g_object_unref (be.book);
+}
+
+static guint infant_inserts = 0;
+static guint infant_deletes = 0;
+
+static gboolean
+fake_commit_infant (GncSqlBackend* be, QofInstance* inst)
+{
+    if (qof_instance_get_destroying (inst))
+    {
+        g_assert (!gnc_sql_instance_is_infant (be, inst));
+        ++infant_deletes;
+    }
+    else
+    {
+        g_assert (gnc_sql_instance_is_infant (be, inst));
+        ++infant_inserts;
+    }
+    return TRUE;
+}
+
+static void
+fake_backend_commit (QofBackend* qbe, QofInstance* inst)
+{
+    gnc_sql_commit_edit ((GncSqlBackend*)qbe, inst);
+}
+
+/* The engine clears the infant flag of a new object once its commit
+   returns, so the queue must remember that it is to be inserted.  An
+   object destroyed while it is still queued as an infant never reached
+   the database: it is dropped and nothing is written.  One destroyed
+   after the flush is deleted. */
+static void
+test_gnc_sql_write_behind_infant (void)
+{
+    GncSqlBackend be;
+    GncSqlConnection conn;
+    GncSqlWriteBehindStats stats;
+    QofInstance *inst, *kept;
+    static GncSqlObjectBackend be_data =
+    {
+        GNC_SQL_BACKEND_VERSION,
+        "WriteBehindInfantTest",
+        fake_commit_infant, /* commit */
+        NULL,            /* initial_load */
+        NULL,            /* create_tables */
+        NULL, NULL, NULL, NULL
+    };
+
+    qof_object_initialize ();
+    qof_object_register_backend ("WriteBehindInfantTest", GNC_SQL_BACKEND,
+                                 &be_data);
+    memset (&be, 0, sizeof (be));
+    be.be.commit = fake_backend_commit;
+    be.book = qof_book_new ();
+    qof_book_set_backend (be.book, &be.be);
+    be.conn = &conn;
+    conn.beginTransaction = fake_connection_function;
+    conn.rollbackTransaction = fake_connection_function;
+    conn.commitTransaction = fake_connection_function;
+    inst  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (inst, "WriteBehindInfantTest", be.book);
+    kept  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (kept, "WriteBehindInfantTest", be.book);
+    gnc_sql_set_write_behind (&be, TRUE);
+
+    qof_instance_set_dirty_flag (inst, TRUE);
+    g_assert (qof_commit_edit_part2 (inst, NULL, NULL, NULL));
+    qof_instance_set_dirty_flag (kept, TRUE);
+    g_assert (qof_commit_edit_part2 (kept, NULL, NULL, NULL));
+    g_assert (!qof_instance_get_infant (inst));
+    g_assert (gnc_sql_instance_is_infant (&be, inst));
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 2);
+
+    /* Destroyed before the flush */
+    qof_instance_set_destroying (inst, TRUE);
+    g_assert (qof_commit_edit_part2 (inst, NULL, NULL, NULL));
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 1);
+    g_assert (stats.flush_scheduled);
+    g_assert_cmpint (infant_inserts, ==, 0);
+    g_assert_cmpint (infant_deletes, ==, 0);
+
+    /* Destroyed after the flush */
+    g_assert (gnc_sql_write_behind_flush (&be));
+    g_assert_cmpint (infant_inserts, ==, 1);
+    g_assert (!gnc_sql_instance_is_infant (&be, kept));
+    qof_instance_set_destroying (kept, TRUE);
+    g_assert (qof_commit_edit_part2 (kept, NULL, NULL, NULL));
+    g_assert_cmpint (infant_inserts, ==, 1);
+    g_assert_cmpint (infant_deletes, ==, 1);
+    gnc_sql_get_write_behind_stats (&be, &stats);
+    g_assert_cmpint (stats.queue_depth, ==, 0);
+    g_assert (!stats.flush_scheduled);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 0);
+
+    gnc_sql_set_write_behind (&be, FALSE);
+    qof_book_set_backend (be.book, NULL);
+    g_object_unref (kept);
+    g_object_unref (inst);
+    g_object_unref (be.book);
+}
+/* gnc_sql_sync_dirty
+gboolean
+gnc_sql_sync_dirty (GncSqlBackend* be, QofBook* book)// C: 1 */
+static void
+test_gnc_sql_sync_dirty (void)
+{
+    GncSqlBackend be;
+    GncSqlConnection conn;
+    QofInstance *inst, *doomed;
+    static GncSqlObjectBackend be_data =
+    {
+        GNC_SQL_BACKEND_VERSION,
+        "DirtySetTest",
+        fake_commit,     /* commit */
+        NULL,            /* initial_load */
+        NULL,            /* create_tables */
+        NULL, NULL, NULL, NULL
+    };
+
+    qof_object_initialize ();
+    qof_object_register_backend ("DirtySetTest", GNC_SQL_BACKEND, &be_data);
+    memset (&be, 0, sizeof (be));
+    be.book = qof_book_new ();
+    be.conn = &conn;
+    conn.beginTransaction = fake_connection_function;
+    conn.rollbackTransaction = fake_connection_function;
+    conn.commitTransaction = fake_connection_function;
+    inst  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (inst, "DirtySetTest", be.book);
+    doomed  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (doomed, "DirtySetTest", be.book);
+    fake_commits = 0;
+
+    /* A failed commit remembers the object without raising an error,
+       which would make the engine undo the edit */
+    fake_commit_ok = FALSE;
+    qof_book_mark_session_dirty (be.book);
+    qof_instance_set_dirty_flag (inst, TRUE);
+    gnc_sql_commit_edit (&be, inst);
+    g_assert (qof_instance_get_dirty_flag (inst));
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 1);
+    g_assert_cmpint (qof_backend_get_error (&be.be), ==, ERR_BACKEND_NO_ERR);
+
+    /* A failed delete reports the error but is not remembered */
+    qof_instance_set_destroying (doomed, TRUE);
+    gnc_sql_commit_edit (&be, doomed);
+    g_assert_cmpint (qof_backend_get_error (&be.be), ==, ERR_BACKEND_SERVER_ERR);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 1);
+
+    /* Nothing is lost if the sync fails too */
+    g_assert (!gnc_sql_sync_dirty (&be, be.book));
+    g_assert_cmpint (qof_backend_get_error (&be.be), ==, ERR_BACKEND_SERVER_ERR);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 1);
+    g_assert (qof_book_session_not_saved (be.book));
+
+    fake_commit_ok = TRUE;
+    g_assert (gnc_sql_sync_dirty (&be, be.book));
+    g_assert_cmpint (fake_commits, ==, 1);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 0);
+    g_assert (!qof_instance_get_dirty_flag (inst));
+    g_assert (!qof_book_session_not_saved (be.book));
+
+    /* With nothing pending a sync writes nothing */
+    g_assert (gnc_sql_sync_dirty (&be, be.book));
+    g_assert_cmpint (fake_commits, ==, 1);
+
+    /* Nor is an object once it is being destroyed */
+    fake_commit_ok = FALSE;
+    qof_instance_set_destroying (doomed, FALSE);
+    qof_instance_set_dirty_flag (doomed, TRUE);
+    gnc_sql_commit_edit (&be, doomed);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 1);
+    qof_instance_set_destroying (doomed, TRUE);
+    gnc_sql_commit_edit (&be, doomed);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 0);
+    (void)qof_backend_get_error (&be.be);
+
+    fake_commit_ok = TRUE;
+    g_assert (gnc_sql_sync_dirty (&be, be.book));
+    g_assert_cmpint (fake_commits, ==, 1);
+
+    gnc_sql_clear_dirty_sets (&be);
+    g_object_unref (doomed);
+    g_object_unref (inst);
+    g_object_unref (be.book);
+}
+/* What the next sync writes after a failed commit must be the edit
+   the user made.  on_error stands in for trans_on_error(), which rolls
+   a transaction back when the backend reports an error. */
+static gchar *retry_written = NULL;
+static gboolean retry_infant = FALSE;
+
+static gboolean
+fake_commit_retry (GncSqlBackend* be, QofInstance* inst)
+{
+    if (!fake_commit_ok)
+        return FALSE;
+    g_free (retry_written);
+    retry_written = g_strdup (kvp_frame_get_string (qof_instance_get_slots (inst),
+                              "memo"));
+    retry_infant = gnc_sql_instance_is_infant (be, inst);
+    return TRUE;
+}
+
+static void
+fake_rollback (QofInstance* inst, QofBackendError errcode)
+{
+    kvp_frame_set_string (qof_instance_get_slots (inst), "memo", "rolled back");
+}
+
+static void
+test_gnc_sql_commit_failure_retry (void)
+{
+    GncSqlBackend be;
+    GncSqlConnection conn;
+    QofInstance *inst;
+    static GncSqlObjectBackend be_data =
+    {
+        GNC_SQL_BACKEND_VERSION,
+        "RetryTest",
+        fake_commit_retry, /* commit */
+        NULL,            /* initial_load */
+        NULL,            /* create_tables */
+        NULL, NULL, NULL, NULL
+    };
+
+    qof_object_initialize ();
+    qof_object_register_backend ("RetryTest", GNC_SQL_BACKEND, &be_data);
+    memset (&be, 0, sizeof (be));
+    be.be.commit = fake_backend_commit;
+    be.book = qof_book_new ();
+    qof_book_set_backend (be.book, &be.be);
+    be.conn = &conn;
+    conn.beginTransaction = fake_connection_function;
+    conn.rollbackTransaction = fake_connection_function;
+    conn.commitTransaction = fake_connection_function;
+    inst  = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (inst, "RetryTest", be.book);
+
+    fake_commit_ok = FALSE;
+    kvp_frame_set_string (qof_instance_get_slots (inst), "memo", "entered");
+    qof_instance_set_dirty_flag (inst, TRUE);
+    g_assert (qof_commit_edit_part2 (inst, fake_rollback, NULL, NULL));
+    g_assert_cmpstr (kvp_frame_get_string (qof_instance_get_slots (inst), "memo"),
+                     ==, "entered");
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 1);
+    g_assert (retry_written == NULL);
+
+    /* The engine has cleared the infant flag, but the row is inserted */
+    fake_commit_ok = TRUE;
+    g_assert (gnc_sql_sync_dirty (&be, be.book));
+    g_assert_cmpstr (retry_written, ==, "entered");
+    g_assert (retry_infant);
+    g_assert_cmpint (gnc_sql_get_dirty_count (&be), ==, 0);
+
+    g_free (retry_written);
+    retry_written = NULL;
+    qof_book_set_backend (be.book, NULL);
+    g_object_unref (inst);
+    g_object_unref (be.book);
+}
 /* handle_and_term
 static void
 handle_and_term (QofQueryTerm* pTerm, GString* sql)// 2
@@ -993,6 +1372,10 @@ test_suite_gnc_backend_sql (void)
 // GNC_TEST_ADD (suitename, "gnc sql rollback edit", Fixture, NULL, test_gnc_sql_rollback_edit,  teardown);
 // GNC_TEST_ADD (suitename, "commit cb", Fixture, NULL, test_commit_cb,  teardown);
     GNC_TEST_ADD_FUNC (suitename, "gnc sql commit edit", test_gnc_sql_commit_edit);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql write behind", test_gnc_sql_write_behind);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql write behind infant", test_gnc_sql_write_behind_infant);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql sync dirty", test_gnc_sql_sync_dirty);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql commit failure retry", test_gnc_sql_commit_failure_retry);
 // GNC_TEST_ADD (suitename, "handle and term", Fixture, NULL, test_handle_and_term,  teardown);
 // GNC_TEST_ADD (suitename, "compile query cb", Fixture, NULL, test_compile_query_cb,  teardown);
 // GNC_TEST_ADD (suitename, "gnc sql compile query", Fixture, NULL, test_gnc_sql_compile_query,  teardown);
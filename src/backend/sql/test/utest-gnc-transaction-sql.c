@@ -0,0 +1,283 @@
+/********************************************************************
+ * utest-gnc-transaction-sql.c:                                     *
+ *             GLib g_test test suite for gnc-transaction-sql.c.    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#include "config.h"
+#include <string.h>
+#include <glib.h>
+#include <unittest-support.h>
+/* Add specific headers for this class */
+#include "../gnc-backend-sql.h"
+#include "../gnc-transaction-sql.h"
+#include "Split.h"
+
+static const gchar *suitename = "/backend/sql/gnc-transaction-sql";
+void test_suite_gnc_transaction_sql (void);
+
+typedef struct
+{
+    GncSqlConnection conn;
+    GncSqlBackend be;
+    QofQuery *query;
+    GncGUID guid1;
+    GncGUID guid2;
+} Fixture;
+
+static gchar*
+fake_quote_string (const GncSqlConnection* conn, gchar* str)
+{
+    gchar **parts = g_strsplit (str, "'", -1);
+    gchar *joined = g_strjoinv ("''", parts);
+    gchar *quoted = g_strdup_printf ("'%s'", joined);
+
+    g_strfreev (parts);
+    g_free (joined);
+    return quoted;
+}
+
+static const GncSqlQueryDialect pgsql_dialect = { TRUE, "ILIKE" };
+static const GncSqlQueryDialect sqlite3_dialect = { FALSE, "LIKE" };
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    memset (&fixture->conn, 0, sizeof (fixture->conn));
+    fixture->conn.quoteString = fake_quote_string;
+    memset (&fixture->be, 0, sizeof (fixture->be));
+    fixture->be.conn = &fixture->conn;
+    fixture->be.timespec_format = "%04d%02d%02d%02d%02d%02d";
+    fixture->be.query_dialect = &pgsql_dialect;
+    fixture->query = qof_query_create_for (GNC_ID_SPLIT);
+    guid_new (&fixture->guid1);
+    guid_new (&fixture->guid2);
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    qof_query_destroy (fixture->query);
+}
+
+static void
+add_account_match (Fixture *fixture, QofQuery *q)
+{
+    GList *guids = NULL;
+
+    guids = g_list_prepend (guids, &fixture->guid2);
+    guids = g_list_prepend (guids, &fixture->guid1);
+    qof_query_add_guid_list_match (q,
+                                   qof_query_build_param_list (SPLIT_ACCOUNT, QOF_PARAM_GUID, NULL),
+                                   guids, QOF_GUID_MATCH_ANY, QOF_QUERY_AND);
+    g_list_free (guids);
+}
+
+static void
+add_reconcile_match (QofQuery *q, const gchar *states)
+{
+    qof_query_add_term (q, qof_query_build_param_list (SPLIT_RECONCILE, NULL),
+                        qof_query_char_predicate (QOF_CHAR_MATCH_ANY, states),
+                        QOF_QUERY_AND);
+}
+
+static void
+add_string_match (QofQuery *q, QofQueryParamList *param_list, const gchar *str,
+                  QofStringMatch options, gboolean is_regex)
+{
+    qof_query_add_term (q, param_list,
+                        qof_query_string_predicate (QOF_COMPARE_EQUAL, str,
+                                                    options, is_regex),
+                        QOF_QUERY_AND);
+}
+
+static void
+assert_contains (const gchar *sql, const gchar *expected)
+{
+    if (strstr (sql, expected) == NULL)
+        g_error ("\"%s\" not found in \"%s\"", expected, sql);
+}
+
+/* gnc_sql_split_query_to_sql
+gchar*
+gnc_sql_split_query_to_sql (const GncSqlBackend* be, QofQuery* query, gboolean* is_exact)// C: 1 */
+static void
+test_split_query_accounts (Fixture *fixture, gconstpointer pData)
+{
+    gchar guid1[GUID_ENCODING_LENGTH+1], guid2[GUID_ENCODING_LENGTH+1];
+    gchar *expected, *sql;
+    gboolean is_exact = FALSE;
+
+    add_account_match (fixture, fixture->query);
+    add_reconcile_match (fixture->query, "cy");
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    g_assert (is_exact);
+
+    (void)guid_to_string_buff (&fixture->guid1, guid1);
+    (void)guid_to_string_buff (&fixture->guid2, guid2);
+    expected = g_strdup_printf ("(s.account_guid IN ('%s','%s'))", guid1, guid2);
+    assert_contains (sql, expected);
+    assert_contains (sql, "(s.reconcile_state IN ('c','y'))");
+    assert_contains (sql, " AND ");
+    g_free (expected);
+    g_free (sql);
+}
+
+static void
+test_split_query_strings (Fixture *fixture, gconstpointer pData)
+{
+    gchar *sql;
+    gboolean is_exact = TRUE;
+
+    add_string_match (fixture->query,
+                      qof_query_build_param_list (SPLIT_TRANS, TRANS_DESCRIPTION, NULL),
+                      "50%_off", QOF_STRING_MATCH_CASEINSENSITIVE, FALSE);
+    add_string_match (fixture->query, qof_query_build_param_list (SPLIT_MEMO, NULL),
+                      "^Rent", QOF_STRING_MATCH_NORMAL, TRUE);
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    assert_contains (sql, "(COALESCE(t.description,'') ILIKE '%50!%!_off%' ESCAPE '!')");
+    /* Regular expressions are left to the engine; the memo term is
+       dropped from the AND */
+    g_assert (strstr (sql, "s.memo") == NULL);
+    g_assert (!is_exact);
+    g_free (sql);
+
+    fixture->be.query_dialect = &sqlite3_dialect;
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    assert_contains (sql, "(COALESCE(t.description,'') LIKE '%50!%!_off%' ESCAPE '!')");
+    g_assert (strstr (sql, "s.memo") == NULL);
+    g_free (sql);
+}
+
+static void
+test_split_query_amounts (Fixture *fixture, gconstpointer pData)
+{
+    gchar *sql;
+    gboolean is_exact = TRUE;
+
+    qof_query_add_term (fixture->query, qof_query_build_param_list (SPLIT_AMOUNT, NULL),
+                        qof_query_numeric_predicate (QOF_COMPARE_GTE, QOF_NUMERIC_MATCH_DEBIT,
+                                                     gnc_numeric_create (1000, 100)),
+                        QOF_QUERY_AND);
+    qof_query_add_term (fixture->query, qof_query_build_param_list (SPLIT_VALUE, NULL),
+                        qof_query_numeric_predicate (QOF_COMPARE_LT, QOF_NUMERIC_MATCH_ANY,
+                                                     gnc_numeric_create (50, 1)),
+                        QOF_QUERY_AND);
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    assert_contains (sql, "ABS(1.0*s.quantity_num/s.quantity_denom)>=9.99");
+    assert_contains (sql, "s.quantity_num>=0");
+    assert_contains (sql, "ABS(1.0*s.value_num/s.value_denom)<=50.0");
+    g_assert (!is_exact);
+    g_free (sql);
+}
+
+static void
+test_split_query_or_not (Fixture *fixture, gconstpointer pData)
+{
+    QofQuery *q1 = qof_query_create_for (GNC_ID_SPLIT);
+    QofQuery *q2 = qof_query_create_for (GNC_ID_SPLIT);
+    QofQuery *inverted, *merged;
+    gchar *sql;
+    gboolean is_exact = FALSE;
+
+    add_account_match (fixture, q1);
+    add_reconcile_match (q2, "n");
+    inverted = qof_query_invert (q2);
+    merged = qof_query_merge (q1, inverted, QOF_QUERY_OR);
+
+    sql = gnc_sql_split_query_to_sql (&fixture->be, merged, &is_exact);
+    g_assert (sql != NULL);
+    assert_contains (sql, ") OR (");
+    assert_contains (sql, "(CASE WHEN (s.reconcile_state IN ('n')) THEN 0 ELSE 1 END=1)");
+    g_assert (is_exact);
+    g_free (sql);
+
+    /* A negated superset can't be pushed down, and then neither can the OR */
+    qof_query_destroy (q2);
+    q2 = qof_query_create_for (GNC_ID_SPLIT);
+    add_string_match (q2, qof_query_build_param_list (SPLIT_MEMO, NULL),
+                      "x", QOF_STRING_MATCH_CASEINSENSITIVE, FALSE);
+    qof_query_destroy (inverted);
+    inverted = qof_query_invert (q2);
+    qof_query_destroy (merged);
+    merged = qof_query_merge (q1, inverted, QOF_QUERY_OR);
+    g_assert (gnc_sql_split_query_to_sql (&fixture->be, merged, &is_exact) == NULL);
+
+    qof_query_destroy (merged);
+    qof_query_destroy (inverted);
+    qof_query_destroy (q2);
+    qof_query_destroy (q1);
+}
+
+static void
+test_split_query_sort_limit (Fixture *fixture, gconstpointer pData)
+{
+    gchar *sql;
+    gboolean is_exact = FALSE;
+
+    add_account_match (fixture, fixture->query);
+    qof_query_set_sort_order (fixture->query,
+                              qof_query_build_param_list (SPLIT_TRANS, TRANS_DATE_POSTED, NULL),
+                              qof_query_build_param_list (SPLIT_VALUE, NULL),
+                              NULL);
+    qof_query_set_sort_increasing (fixture->query, TRUE, FALSE, TRUE);
+    qof_query_set_max_results (fixture->query, 10);
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    assert_contains (sql, " ORDER BY COALESCE(t.post_date,'19700101000000') DESC, 1.0*s.value_num/s.value_denom ASC LIMIT 10");
+    g_free (sql);
+
+    /* String collation differs from the engine's, so no limit */
+    qof_query_set_sort_order (fixture->query,
+                              qof_query_build_param_list (SPLIT_MEMO, NULL), NULL, NULL);
+    sql = gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact);
+    g_assert (sql != NULL);
+    g_assert (strstr (sql, "LIMIT") == NULL);
+    g_free (sql);
+}
+
+static void
+test_split_query_not_pushed (Fixture *fixture, gconstpointer pData)
+{
+    gboolean is_exact = TRUE;
+
+    /* No terms */
+    g_assert (gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact) == NULL);
+
+    /* Nothing translatable */
+    add_string_match (fixture->query,
+                      qof_query_build_param_list (SPLIT_CORR_ACCT_NAME, NULL),
+                      "Expenses", QOF_STRING_MATCH_NORMAL, FALSE);
+    g_assert (gnc_sql_split_query_to_sql (&fixture->be, fixture->query, &is_exact) == NULL);
+    g_assert (!is_exact);
+}
+
+void
+test_suite_gnc_transaction_sql (void)
+{
+    GNC_TEST_ADD (suitename, "split query accounts", Fixture, NULL, setup, test_split_query_accounts, teardown);
+    GNC_TEST_ADD (suitename, "split query strings", Fixture, NULL, setup, test_split_query_strings, teardown);
+    GNC_TEST_ADD (suitename, "split query amounts", Fixture, NULL, setup, test_split_query_amounts, teardown);
+    GNC_TEST_ADD (suitename, "split query or not", Fixture, NULL, setup, test_split_query_or_not, teardown);
+    GNC_TEST_ADD (suitename, "split query sort limit", Fixture, NULL, setup, test_split_query_sort_limit, teardown);
+    GNC_TEST_ADD (suitename, "split query not pushed", Fixture, NULL, setup, test_split_query_not_pushed, teardown);
+}
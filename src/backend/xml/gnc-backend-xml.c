@@ -53,6 +53,10 @@ typedef int ssize_t;
 # include <dirent.h>
 #endif
 #include <time.h>
+#ifdef HAVE_LINUX_FS_H
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
 #ifdef G_OS_WIN32
 # include <io.h>
 # define close _close
@@ -69,11 +73,14 @@ typedef int ssize_t;
 #include "qof.h"
 #include "TransLog.h"
 #include "gnc-engine.h"
+#include "Transaction.h"
+#include "Scrub.h"
 
 #include "gnc-uri-utils.h"
 
 #include "io-gncxml.h"
 #include "io-gncxml-v2.h"
+#include "io-gncxml-snapshot.h"
 #include "gnc-backend-xml.h"
 #include "gnc-core-prefs.h"
 
@@ -234,6 +241,14 @@ gnc_xml_be_get_file_lock (FileBackend *be)
 /* ================================================================= */
 #define XML_URI_PREFIX "xml://"
 #define FILE_URI_PREFIX "file://"
+#define XML_JOURNAL_EXT ".journal"
+#define XML_SNAPSHOT_EXT ".snapshot"
+
+static gboolean gnc_xml_be_write_to_file(FileBackend *fbe, QofBook *book,
+                                         const gchar *datafile,
+                                         gboolean make_backup);
+static void gnc_xml_be_journal_reset(FileBackend *fbe);
+static void gnc_xml_be_snapshot_save(FileBackend *fbe, QofBook *book);
 
 static void
 xml_session_begin(QofBackend *be_start, QofSession *session,
@@ -328,6 +343,12 @@ xml_session_begin(QofBackend *be_start, QofSession *session,
     }
 
 
+    be->journalfile = g_strconcat(be->fullpath, XML_JOURNAL_EXT, NULL);
+    be->journal = (g_getenv("GNC_XML_JOURNAL") != NULL);
+    if (g_getenv("GNC_XML_SNAPSHOT"))
+        be->snapshotfile = g_strconcat(be->fullpath, XML_SNAPSHOT_EXT, NULL);
+    be->deferred_scrub = (g_getenv("GNC_XML_DEFERRED_SCRUB") != NULL);
+
     /* ---------------------------------------------------- */
     /* We should now have a fully resolved path name.
      * Let's start logging */
@@ -383,6 +404,17 @@ xml_session_end(QofBackend *be_start)
         return;
     }
 
+    /* Fold the journal back into the data file, provided the book holds
+     * nothing that the user chose not to save. */
+    if (be->book && be->journalfile && be->journal_base_digest
+            && !qof_book_session_not_saved(be->book)
+            && g_file_test(be->journalfile, G_FILE_TEST_EXISTS)
+            && gnc_xml_be_write_to_file(be, be->book, be->fullpath, TRUE))
+    {
+        gnc_xml_be_journal_reset(be);
+        gnc_xml_be_snapshot_save(be, be->book);
+    }
+
     if (be->linkfile)
         g_unlink (be->linkfile);
 
@@ -416,6 +448,20 @@ xml_session_end(QofBackend *be_start)
 
     g_free (be->linkfile);
     be->linkfile = NULL;
+
+    g_free (be->journalfile);
+    be->journalfile = NULL;
+
+    g_free (be->journal_base_digest);
+    be->journal_base_digest = NULL;
+
+    g_free (be->snapshotfile);
+    be->snapshotfile = NULL;
+
+    if (be->old_files)
+        g_hash_table_destroy (be->old_files);
+    be->old_files = NULL;
+    be->old_files_mtime = 0;
     LEAVE (" ");
 }
 
@@ -425,6 +471,8 @@ xml_destroy_backend(QofBackend *be)
     /* Stop transaction logging */
     xaccLogSetBaseName (NULL);
 
+    g_hash_table_destroy(((FileBackend*)be)->journal_trans);
+
     qof_backend_destroy(be);
     g_free(be);
 }
@@ -440,18 +488,79 @@ xml_destroy_backend(QofBackend *be)
    "file.YYYYMMDDHHMMSS.gnucash" where YYYYMMDDHHMMSS is replaced with the
    current year/month/day/hour/minute/second. */
 
-/* The variable buf_size must be a compile-time constant */
-#define buf_size 1024
+/* Copies that can't be cloned go through a buffer of this size. */
+#define COPY_BUFFER_SIZE (1024 * 1024)
+
+static gboolean
+write_all(int fd, const char *buf, ssize_t count)
+{
+    while (count > 0)
+    {
+        ssize_t count_write = write(fd, buf, count);
+        if (count_write == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        buf += count_write;
+        count -= count_write;
+    }
+    return TRUE;
+}
+
+/* Copy the contents of orig_fd to bkup_fd.  Where the file system can
+ * share the blocks of the two files this takes no time at all; where
+ * the kernel can copy them itself, the data at least never passes
+ * through this process. */
+static gboolean
+copy_file_contents(int orig_fd, int bkup_fd)
+{
+    char *buf;
+    ssize_t count_read;
+    gboolean success = TRUE;
+
+#ifdef FICLONE
+    if (ioctl(bkup_fd, FICLONE, orig_fd) == 0)
+        return TRUE;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+    /* Both file offsets advance, so if the kernel gives up part way the
+     * copy below carries on where it stopped. */
+    while (TRUE)
+    {
+        ssize_t count_copied = copy_file_range(orig_fd, NULL, bkup_fd, NULL,
+                                               COPY_BUFFER_SIZE, 0);
+        if (count_copied == 0)
+            return TRUE;
+        if (count_copied == -1 && errno != EINTR)
+            break;
+    }
+#endif
+
+    buf = g_malloc(COPY_BUFFER_SIZE);
+    do
+    {
+        count_read = read(orig_fd, buf, COPY_BUFFER_SIZE);
+        if (count_read == -1 && errno != EINTR)
+            success = FALSE;
+        else if (count_read > 0)
+            success = write_all(bkup_fd, buf, count_read);
+    }
+    while (success && count_read != 0);
+    g_free(buf);
+
+    return success;
+}
 
 static gboolean
 copy_file(const char *orig, const char *bkup)
 {
-    char buf[buf_size];
     int orig_fd;
     int bkup_fd;
     int flags = 0;
-    ssize_t count_write;
-    ssize_t count_read;
+    gboolean success;
 
 #ifdef G_OS_WIN32
     flags = O_BINARY;
@@ -469,41 +578,23 @@ copy_file(const char *orig, const char *bkup)
         return FALSE;
     }
 
-    do
-    {
-        count_read = read(orig_fd, buf, buf_size);
-        if (count_read == -1 && errno != EINTR)
-        {
-            close(orig_fd);
-            close(bkup_fd);
-            return FALSE;
-        }
-
-        if (count_read > 0)
-        {
-            count_write = write(bkup_fd, buf, count_read);
-            if (count_write == -1)
-            {
-                close(orig_fd);
-                close(bkup_fd);
-                return FALSE;
-            }
-        }
-    }
-    while (count_read > 0);
+    success = copy_file_contents(orig_fd, bkup_fd);
 
     close(orig_fd);
-    close(bkup_fd);
+    if (close(bkup_fd) != 0)
+        success = FALSE;
 
-    return TRUE;
+    return success;
 }
 
 /* ================================================================= */
 
+/* Try to hard link orig to bkup.  If that fails, *can_copy says whether
+ * the file system just doesn't do links, so that a copy is worth a
+ * try. */
 static gboolean
-gnc_int_link_or_make_backup(FileBackend *be, const char *orig, const char *bkup)
+link_file(const char *orig, const char *bkup, gboolean *can_copy)
 {
-    gboolean copy_success = FALSE;
     int err_ret =
 #ifdef HAVE_LINK
         link (orig, bkup)
@@ -511,37 +602,128 @@ gnc_int_link_or_make_backup(FileBackend *be, const char *orig, const char *bkup)
         - 1
 #endif
         ;
-    if (err_ret != 0)
-    {
+    *can_copy = FALSE;
+    if (err_ret == 0)
+        return TRUE;
+
 #ifdef HAVE_LINK
-        if (errno == EPERM || errno == ENOSYS
+    if (errno == EPERM || errno == ENOSYS
 # ifdef EOPNOTSUPP
-                || errno == EOPNOTSUPP
+            || errno == EOPNOTSUPP
 # endif
 # ifdef ENOTSUP
-                || errno == ENOTSUP
+            || errno == ENOTSUP
 # endif
 # ifdef ENOSYS
-                || errno == ENOSYS
+            || errno == ENOSYS
 # endif
-           )
+       )
 #endif
-        {
-            copy_success = copy_file(orig, bkup);
-        }
+    {
+        *can_copy = TRUE;
+    }
+    return FALSE;
+}
 
-        if (!copy_success)
-        {
-            qof_backend_set_error((QofBackend*)be, ERR_FILEIO_BACKUP_ERROR);
-            PWARN ("unable to make file backup from %s to %s: %s",
-                   orig, bkup, g_strerror(errno) ? g_strerror(errno) : "");
-            return FALSE;
-        }
+static void
+backup_failed(FileBackend *be, const char *orig, const char *bkup, int error)
+{
+    qof_backend_set_error((QofBackend*)be, ERR_FILEIO_BACKUP_ERROR);
+    PWARN ("unable to make file backup from %s to %s: %s",
+           orig, bkup, g_strerror(error) ? g_strerror(error) : "");
+}
+
+static gboolean
+gnc_int_link_or_make_backup(FileBackend *be, const char *orig, const char *bkup)
+{
+    gboolean can_copy;
+
+    if (link_file(orig, bkup, &can_copy))
+        return TRUE;
+    if (!can_copy || !copy_file(orig, bkup))
+    {
+        backup_failed(be, orig, bkup, errno);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* A backup that has to be copied is copied on a thread of its own
+ * while the new file is written, since the data file it copies is
+ * only replaced once the new one is complete. */
+typedef struct
+{
+    gchar *orig;
+    gchar *bkup;
+    GThread *thread;
+    gboolean success;
+    int error;
+} BackupCopy;
+
+static gpointer
+backup_copy_thread(BackupCopy *copy)
+{
+    copy->success = copy_file(copy->orig, copy->bkup);
+    copy->error = copy->success ? 0 : errno;
+    return NULL;
+}
+
+static gboolean
+gnc_int_link_or_start_backup(FileBackend *be, const char *orig,
+                             const char *bkup, BackupCopy **pending)
+{
+    BackupCopy *copy;
+    gboolean can_copy;
+#ifndef HAVE_GLIB_2_32
+    GError *error = NULL;
+#endif
+
+    if (link_file(orig, bkup, &can_copy))
+        return TRUE;
+    if (!can_copy)
+    {
+        backup_failed(be, orig, bkup, errno);
+        return FALSE;
     }
 
+    copy = g_new0(BackupCopy, 1);
+    copy->orig = g_strdup(orig);
+    copy->bkup = g_strdup(bkup);
+#ifndef HAVE_GLIB_2_32
+    copy->thread = g_thread_create((GThreadFunc) backup_copy_thread, copy,
+                                   TRUE, &error);
+    if (!copy->thread)
+        g_error_free(error);
+#else
+    copy->thread = g_thread_new("backup_thread",
+                                (GThreadFunc) backup_copy_thread, copy);
+#endif
+    if (!copy->thread)
+        backup_copy_thread(copy);
+    *pending = copy;
     return TRUE;
 }
 
+/* Wait for a backup started by gnc_int_link_or_start_backup and return
+ * whether it succeeded. */
+static gboolean
+gnc_int_finish_backup(FileBackend *be, BackupCopy *copy)
+{
+    gboolean success;
+
+    if (!copy)
+        return TRUE;
+    if (copy->thread)
+        g_thread_join(copy->thread);
+    success = copy->success;
+    if (!success)
+        backup_failed(be, copy->orig, copy->bkup, copy->error);
+    g_free(copy->orig);
+    g_free(copy->bkup);
+    g_free(copy);
+    return success;
+}
+
 /* ================================================================= */
 
 static QofBookFileType
@@ -630,8 +812,24 @@ det_exit:
     return result;
 }
 
+/* Remember a backup or log file for gnc_xml_be_remove_old_files.  Until
+ * the directory has been scanned once there's nothing to add to. */
+static void
+gnc_xml_be_index_file(FileBackend *be, const gchar *name)
+{
+    gchar *key;
+
+    if (!be->old_files || !name)
+        return;
+    key = g_strdup(name);
+    g_hash_table_replace(be->old_files, key, key);
+}
+
+/* Back up the data file before it is replaced.  The backup may still
+ * be copying when this returns; pass *pending to gnc_int_finish_backup
+ * before touching the data file. */
 static gboolean
-gnc_xml_be_backup_file(FileBackend *be)
+gnc_xml_be_backup_file(FileBackend *be, BackupCopy **pending)
 {
     gboolean bkup_ret;
     char *timestamp;
@@ -665,7 +863,9 @@ gnc_xml_be_backup_file(FileBackend *be)
     backup = g_strconcat( datafile, ".", timestamp, GNC_DATAFILE_EXT, NULL );
     g_free (timestamp);
 
-    bkup_ret = gnc_int_link_or_make_backup(be, datafile, backup);
+    bkup_ret = gnc_int_link_or_start_backup(be, datafile, backup, pending);
+    if (bkup_ret)
+        gnc_xml_be_index_file(be, backup);
     g_free(backup);
 
     return bkup_ret;
@@ -673,6 +873,18 @@ gnc_xml_be_backup_file(FileBackend *be)
 
 /* ================================================================= */
 
+static gboolean
+write_book_profiled(QofBook *book, const gchar *filename)
+{
+    gint64 start = qof_profile_now();
+    gboolean success;
+
+    success = gnc_book_write_to_xml_file_v2(book, filename,
+                                            gnc_core_prefs_get_file_save_compressed());
+    qof_profile_end_phase("write", start);
+    return success;
+}
+
 static gboolean
 gnc_xml_be_write_to_file(FileBackend *fbe,
                          QofBook *book,
@@ -684,6 +896,9 @@ gnc_xml_be_write_to_file(FileBackend *fbe,
     struct stat statbuf;
     int rc;
     QofBackendError be_err;
+    gboolean success;
+    BackupCopy *backup = NULL;
+    gint64 backup_start = 0;
 
     ENTER (" book=%p file=%s", book, datafile);
 
@@ -713,14 +928,35 @@ gnc_xml_be_write_to_file(FileBackend *fbe,
 
     if (make_backup)
     {
-        if (!gnc_xml_be_backup_file(fbe))
+        gboolean backed_up;
+
+        backup_start = qof_profile_now();
+        backed_up = gnc_xml_be_backup_file(fbe, &backup);
+        if (!backup)
+            qof_profile_end_phase("backup", backup_start);
+        if (!backed_up)
         {
+            g_free(tmp_name);
             LEAVE("");
             return FALSE;
         }
     }
 
-    if (gnc_book_write_to_xml_file_v2(book, tmp_name, gnc_core_prefs_get_file_save_compressed()))
+    success = write_book_profiled(book, tmp_name);
+    if (backup)
+    {
+        /* The copy ran alongside the write; time it to its end. */
+        if (!gnc_int_finish_backup(fbe, backup))
+        {
+            g_unlink(tmp_name);
+            g_free(tmp_name);
+            LEAVE("");
+            return FALSE;
+        }
+        qof_profile_end_phase("backup", backup_start);
+    }
+
+    if (success)
     {
         /* Record the file's permissions before g_unlinking it */
         rc = g_stat(datafile, &statbuf);
@@ -846,24 +1082,39 @@ gnc_xml_be_write_to_file(FileBackend *fbe,
 /*
  * Clean up any lock files from prior crashes, and clean up old
  * backup and log files.
+ *
+ * The first time round the directory is scanned for them, and the
+ * backup and log files found are kept in be->old_files.  After that
+ * only the files in the index, to which new backups and logs are
+ * added as they are made, are looked at, unless the directory has
+ * changed between two saves: then it is scanned again, to find lock
+ * files left by a crash and backups made by another process.
  */
 
+/* Whether name, already known to start with the data file's name, is
+ * one of its backup or log files: the data file's name followed by a
+ * dot, 14 digits and one of the extensions. */
+static gboolean
+gnc_xml_be_is_old_file(FileBackend *be, const gchar *name, regex_t *pattern)
+{
+    return regexec(pattern, name + strlen(be->fullpath), 0, NULL, 0) == 0;
+}
+
 static void
-gnc_xml_be_remove_old_files(FileBackend *be)
+gnc_xml_be_scan_old_files(FileBackend *be, struct stat *lockstatbuf,
+                          regex_t *pattern)
 {
     const gchar *dent;
     GDir *dir;
-    struct stat lockstatbuf, statbuf;
-    time64 now;
+    struct stat statbuf;
 
-    if (g_stat (be->lockfile, &lockstatbuf) != 0)
-        return;
+    be->old_files = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          g_free, NULL);
 
     dir = g_dir_open (be->dirname, 0, NULL);
     if (!dir)
         return;
 
-    now = gnc_time(NULL);
     while ((dent = g_dir_read_name(dir)) != NULL)
     {
         gchar *name;
@@ -898,7 +1149,7 @@ gnc_xml_be_remove_old_files(FileBackend *be)
             if ((g_strcmp0(name, be->linkfile) != 0) &&
                     /* Only delete lock files older than the active one */
                     (g_stat(name, &statbuf) == 0) &&
-                    (statbuf.st_mtime < lockstatbuf.st_mtime))
+                    (statbuf.st_mtime < lockstatbuf->st_mtime))
             {
                 PINFO ("remove stale lock file: %s", name);
                 g_unlink(name);
@@ -914,71 +1165,331 @@ gnc_xml_be_remove_old_files(FileBackend *be)
          * <fullpath/to/datafile><anything>.log
          *
          * To be a file generated by GnuCash, the <anything> part should consist
-         * of 1 dot followed by 14 digits (0 to 9). Let's test this with a
-         * regular expression.
+         * of 1 dot followed by 14 digits (0 to 9).
          */
-        {
-            /* Find the start of the date stamp. This takes some pointer
-             * juggling, but considering the above tests, this should always
-             * be safe */
-            regex_t pattern;
-            gchar *stamp_start = name + strlen(be->fullpath);
-            gchar *expression = g_strdup_printf ("^\\.[[:digit:]]{14}(\\%s|\\%s|\\.xac)$",
-                                                 GNC_DATAFILE_EXT, GNC_LOGFILE_EXT);
-            gboolean got_date_stamp = FALSE;
-
-            if (regcomp(&pattern, expression, REG_EXTENDED | REG_ICASE) != 0)
-                PWARN("Cannot compile regex for date stamp");
-            else if (regexec(&pattern, stamp_start, 0, NULL, 0) == 0)
-                got_date_stamp = TRUE;
-
-            regfree(&pattern);
-            g_free(expression);
-
-            if (!got_date_stamp) /* Not a gnucash created file after all... */
-            {
-                g_free(name);
-                continue;
-            }
-        }
+        if (gnc_xml_be_is_old_file(be, name, pattern))
+            g_hash_table_replace(be->old_files, name, name);
+        else
+            g_free(name);
+    }
+    g_dir_close (dir);
+}
 
-        /* The file is a backup or log file. Check the user's retention preference
-         * to determine if we should keep it or not
-         */
-        if (gnc_core_prefs_get_file_retention_policy() == XML_RETAIN_NONE)
+/* Remove name if the user's retention preference says so.  Returns
+ * TRUE if the file is gone. */
+static gboolean
+gnc_xml_be_expire_old_file(gpointer key, gpointer value, gpointer data)
+{
+    const gchar *name = key;
+    time64 now = *(time64 *)data;
+    struct stat statbuf;
+
+    if (gnc_core_prefs_get_file_retention_policy() == XML_RETAIN_NONE)
+    {
+        PINFO ("remove stale file: %s  - reason: preference XML_RETAIN_NONE", name);
+        g_unlink(name);
+        return TRUE;
+    }
+    else if ((gnc_core_prefs_get_file_retention_policy() == XML_RETAIN_DAYS) &&
+             (gnc_core_prefs_get_file_retention_days() > 0))
+    {
+        int days;
+
+        /* Is the backup file old enough to delete */
+        if (g_stat(name, &statbuf) != 0)
+            return (errno == ENOENT);
+        days = (int)(difftime(now, statbuf.st_mtime) / 86400);
+
+        PINFO ("file retention = %d days", gnc_core_prefs_get_file_retention_days());
+        if (days >= gnc_core_prefs_get_file_retention_days())
         {
-            PINFO ("remove stale file: %s  - reason: preference XML_RETAIN_NONE", name);
+            PINFO ("remove stale file: %s  - reason: more than %d days old", name, days);
             g_unlink(name);
+            return TRUE;
         }
-        else if ((gnc_core_prefs_get_file_retention_policy() == XML_RETAIN_DAYS) &&
-                 (gnc_core_prefs_get_file_retention_days() > 0))
-        {
-            int days;
+    }
+    return FALSE;
+}
 
-            /* Is the backup file old enough to delete */
-            if (g_stat(name, &statbuf) != 0)
-            {
-                g_free(name);
-                continue;
-            }
-            days = (int)(difftime(now, statbuf.st_mtime) / 86400);
+/* Drop the index if something other than the last save changed the
+ * directory since, so that the save about to start rescans it.  Call
+ * this before the save makes changes of its own. */
+static void
+gnc_xml_be_check_old_files(FileBackend *be)
+{
+    struct stat dirstatbuf;
 
-            PINFO ("file retention = %d days", gnc_core_prefs_get_file_retention_days());
-            if (days >= gnc_core_prefs_get_file_retention_days())
-            {
-                PINFO ("remove stale file: %s  - reason: more than %d days old", name, days);
-                g_unlink(name);
-            }
+    if (!be->old_files)
+        return;
+    if (g_stat (be->dirname, &dirstatbuf) == 0 &&
+            dirstatbuf.st_mtime == be->old_files_mtime)
+        return;
+
+    PINFO ("%s changed, rescanning it for old files", be->dirname);
+    g_hash_table_destroy (be->old_files);
+    be->old_files = NULL;
+}
+
+static void
+gnc_xml_be_remove_old_files(FileBackend *be)
+{
+    struct stat lockstatbuf, dirstatbuf;
+    regex_t pattern;
+    gchar *expression;
+    const gchar *log_name;
+    time64 now;
+
+    if (g_stat (be->lockfile, &lockstatbuf) != 0)
+        return;
+
+    expression = g_strdup_printf ("^\\.[[:digit:]]{14}(\\%s|\\%s|\\.xac)$",
+                                  GNC_DATAFILE_EXT, GNC_LOGFILE_EXT);
+    if (regcomp(&pattern, expression, REG_EXTENDED | REG_ICASE) != 0)
+    {
+        PWARN("Cannot compile regex for date stamp");
+        g_free(expression);
+        return;
+    }
+    g_free(expression);
+
+    if (!be->old_files)
+    {
+        gnc_xml_be_scan_old_files(be, &lockstatbuf, &pattern);
+    }
+    else
+    {
+        /* A log file is started after each save. */
+        log_name = xaccLogGetCurrentName();
+        if (log_name)
+        {
+            gchar *name = g_build_filename(be->dirname, log_name, (gchar*)NULL);
+
+            if (g_str_has_prefix(name, be->fullpath) &&
+                    gnc_xml_be_is_old_file(be, name, &pattern))
+                gnc_xml_be_index_file(be, name);
+            g_free(name);
         }
-        g_free(name);
     }
-    g_dir_close (dir);
+    regfree(&pattern);
+
+    now = gnc_time(NULL);
+    g_hash_table_foreach_remove(be->old_files, gnc_xml_be_expire_old_file, &now);
+
+    /* Whatever was removed above changed the directory too. */
+    if (g_stat (be->dirname, &dirstatbuf) == 0)
+        be->old_files_mtime = dirstatbuf.st_mtime;
+}
+
+/* ================================================================= */
+/* Journaled saves.  With GNC_XML_JOURNAL set, a save in which only
+ * transactions changed appends them to a journal next to the data file
+ * instead of rewriting the whole file, and loading replays the journal
+ * over the data file.  A full save folds the journal back in; that
+ * happens when anything else changed, when the journal has grown past
+ * XML_JOURNAL_MAX_RATIO times the size of the data file, and when the
+ * session ends. */
+
+#define XML_JOURNAL_MAX_RATIO 1
+
+/* Remember which transaction a committed instance belongs to. */
+static void
+gnc_xml_be_journal_note(FileBackend *fbe, QofInstance *inst)
+{
+    Transaction *trn;
+
+    if (GNC_IS_TRANSACTION(inst))
+        trn = GNC_TRANSACTION(inst);
+    else if (GNC_IS_SPLIT(inst))
+        trn = xaccSplitGetParent(GNC_SPLIT(inst));
+    else
+    {
+        fbe->journal_full_save = TRUE;
+        return;
+    }
+
+    if (trn)
+        g_hash_table_insert(fbe->journal_trans,
+                            guid_copy(qof_instance_get_guid(trn)), NULL);
+}
+
+/* Remember the data file as we wrote or read it; journaling is only
+ * safe as long as nobody else replaced it. */
+static void
+gnc_xml_be_journal_set_base(FileBackend *fbe)
+{
+    g_free(fbe->journal_base_digest);
+    fbe->journal_base_digest = fbe->journal
+                               ? gnc_xml_file_digest(fbe->fullpath) : NULL;
+}
+
+/* Called after a full save: the data file holds everything now. */
+static void
+gnc_xml_be_journal_reset(FileBackend *fbe)
+{
+    g_hash_table_remove_all(fbe->journal_trans);
+    fbe->journal_full_save = FALSE;
+
+    if (fbe->journalfile && g_unlink(fbe->journalfile) != 0 && errno != ENOENT)
+        PWARN("unable to unlink journal %s: %s", fbe->journalfile,
+              g_strerror(errno) ? g_strerror(errno) : "");
+
+    gnc_xml_be_journal_set_base(fbe);
+}
+
+/* A journal which cannot be replayed may still hold the only copy of
+ * some changes, so move it out of the way of the next full save, which
+ * would delete it, and tell the user.  If it cannot be moved, leave it
+ * alone and stop journaling for this session. */
+static void
+gnc_xml_be_journal_orphan(FileBackend *fbe)
+{
+    gchar *timestamp, *orphan;
+
+    timestamp = gnc_date_timestamp();
+    orphan = g_strconcat(fbe->journalfile, ".orphan-", timestamp, NULL);
+    g_free(timestamp);
+
+    if (g_rename(fbe->journalfile, orphan) == 0)
+    {
+        PERR("journal %s does not apply to %s, moved it to %s",
+             fbe->journalfile, fbe->fullpath, orphan);
+    }
+    else
+    {
+        PERR("journal %s does not apply to %s and could not be moved to %s: %s",
+             fbe->journalfile, fbe->fullpath, orphan,
+             g_strerror(errno) ? g_strerror(errno) : "");
+        g_free(fbe->journalfile);
+        fbe->journalfile = NULL;
+        fbe->journal = FALSE;
+    }
+    g_free(orphan);
+
+    qof_backend_set_error(&fbe->be, ERR_FILEIO_FILE_BAD_READ);
+}
+
+/* Replay the journal, if there is one, over the freshly loaded book.
+ * Returns FALSE if it has to be folded away by a full save. */
+static gboolean
+gnc_xml_be_journal_load(FileBackend *fbe, QofBook *book)
+{
+    gboolean has_journal;
+
+    has_journal = (fbe->journalfile
+                   && g_file_test(fbe->journalfile, G_FILE_TEST_EXISTS));
+
+    g_free(fbe->journal_base_digest);
+    fbe->journal_base_digest = NULL;
+    if (!has_journal && !fbe->journal)
+        return TRUE;
+
+    fbe->journal_base_digest = gnc_xml_file_digest(fbe->fullpath);
+    if (has_journal
+            && (!fbe->journal_base_digest
+                || !gnc_xml_journal_replay(book, fbe->journalfile,
+                                           fbe->journal_base_digest)))
+    {
+        gnc_xml_be_journal_orphan(fbe);
+        return FALSE;
+    }
+
+    /* The replayed transactions came after the load's scrub, so scrub
+     * again, and mark the book again for what it holds now. */
+    if (has_journal)
+    {
+        xaccBookScrubAfterLoad(book, NULL);
+        if (fbe->deferred_scrub)
+            xaccBookMarkScrubbed(book);
+    }
+
+    return fbe->journal_base_digest != NULL;
+}
+
+/* Append the transactions changed since the last save to the journal.
+ * Returns FALSE if the whole file has to be written instead. */
+static gboolean
+gnc_xml_be_journal_sync(FileBackend *fbe, QofBook *book)
+{
+    struct stat base_stat, journal_stat;
+    GList *guids;
+    FILE *out;
+    gchar *digest;
+    gboolean success;
+
+    if (!fbe->journal || fbe->journal_full_save || !fbe->journal_base_digest)
+        return FALSE;
+
+    /* Only journal against the very file we loaded or last wrote.  That
+     * takes reading it once more, which costs far less than writing it. */
+    digest = gnc_xml_file_digest(fbe->fullpath);
+    success = (g_strcmp0(digest, fbe->journal_base_digest) == 0);
+    g_free(digest);
+    if (!success || g_stat(fbe->fullpath, &base_stat) != 0)
+        return FALSE;
+
+    if (g_hash_table_size(fbe->journal_trans) == 0)
+        return TRUE;
+
+    if (g_stat(fbe->journalfile, &journal_stat) == 0)
+    {
+        if (journal_stat.st_size > XML_JOURNAL_MAX_RATIO * base_stat.st_size)
+            return FALSE;
+
+        out = g_fopen(fbe->journalfile, "ab");
+        success = (out != NULL);
+    }
+    else
+    {
+        out = g_fopen(fbe->journalfile, "wb");
+        success = (out != NULL
+                   && gnc_xml_journal_write_header(out,
+                                                   fbe->journal_base_digest));
+    }
+
+    guids = g_hash_table_get_keys(fbe->journal_trans);
+    success = success && gnc_xml_journal_write_record(out, book, guids);
+    g_list_free(guids);
+
+    if (out && fclose(out) != 0)
+        success = FALSE;
+
+    if (!success)
+    {
+        PWARN("unable to append to journal %s, writing the whole file",
+              fbe->journalfile);
+        return FALSE;
+    }
+
+    g_hash_table_remove_all(fbe->journal_trans);
+    return TRUE;
+}
+
+/* ================================================================= */
+/* With GNC_XML_SNAPSHOT set, the transactions are also written to a
+ * binary snapshot next to the data file whenever the whole file has
+ * been written or read, and later loads take them from there as long as
+ * the data file has not changed; see io-gncxml-snapshot.h.  Journaled
+ * saves leave both the data file and the snapshot alone. */
+
+static void
+gnc_xml_be_snapshot_save(FileBackend *fbe, QofBook *book)
+{
+    gint64 start;
+
+    if (!fbe->snapshotfile)
+        return;
+
+    start = qof_profile_now();
+    gnc_xml_snapshot_write(book, fbe->snapshotfile, fbe->fullpath);
+    qof_profile_end_phase("snapshot write", start);
 }
 
 static void
 xml_sync_all(QofBackend* be, QofBook *book)
 {
     FileBackend *fbe = (FileBackend *) be;
+    gboolean journaled;
+    gint64 start;
     ENTER ("book=%p, fbe->book=%p", book, fbe->book);
 
     /* We make an important assumption here, that we might want to change
@@ -997,8 +1508,26 @@ xml_sync_all(QofBackend* be, QofBook *book)
         return;
     }
 
-    gnc_xml_be_write_to_file (fbe, book, fbe->fullpath, TRUE);
+    gnc_xml_be_check_old_files (fbe);
+    start = qof_profile_now();
+    journaled = gnc_xml_be_journal_sync (fbe, book);
+    if (fbe->journal)
+        qof_profile_end_phase("journal", start);
+    if (journaled)
+    {
+        qof_book_mark_session_saved (book);
+        LEAVE ("book=%p, journaled", book);
+        return;
+    }
+
+    if (gnc_xml_be_write_to_file (fbe, book, fbe->fullpath, TRUE))
+    {
+        gnc_xml_be_journal_reset (fbe);
+        gnc_xml_be_snapshot_save (fbe, book);
+    }
+    start = qof_profile_now();
     gnc_xml_be_remove_old_files (fbe);
+    qof_profile_end_phase("remove old files", start);
     LEAVE ("book=%p", book);
 }
 
@@ -1077,12 +1606,20 @@ xml_rollback_edit (QofBackend *be, QofInstance *inst)
 static void
 xml_commit_edit (QofBackend *be, QofInstance *inst)
 {
+    FileBackend *fbe = (FileBackend *) be;
+
     if (qof_instance_get_dirty(inst) && qof_get_alt_dirty_mode() &&
             !(qof_instance_get_infant(inst) && qof_instance_get_destroying(inst)))
     {
         qof_collection_mark_dirty(qof_instance_get_collection(inst));
         qof_book_mark_session_dirty(qof_instance_get_book(inst));
     }
+    /* Deleting a transaction does not necessarily dirty it.  What the
+     * scrub changes, the next load's scrub changes again. */
+    if (fbe->journal && !gnc_get_ongoing_scrub()
+            && (qof_instance_get_dirty(inst) || qof_instance_get_destroying(inst))
+            && !(qof_instance_get_infant(inst) && qof_instance_get_destroying(inst)))
+        gnc_xml_be_journal_note(fbe, inst);
 #if BORKEN_FOR_NOW
     FileBackend *fbe = (FileBackend *) be;
     QofBook *book = gp;
@@ -1115,6 +1652,7 @@ gnc_xml_be_load_from_file (QofBackend *bend, QofBook *book, QofBackendLoadType l
 {
     QofBackendError error;
     gboolean rc;
+    gboolean journal_ok = TRUE;
     FileBackend *be = (FileBackend *) bend;
 
     if (loadType != LOAD_TYPE_INITIAL_LOAD) return;
@@ -1131,6 +1669,12 @@ gnc_xml_be_load_from_file (QofBackend *bend, QofBook *book, QofBackendLoadType l
             PWARN( "Syntax error in Xml File %s", be->fullpath );
             error = ERR_FILEIO_PARSE_ERROR;
         }
+        else
+        {
+            gint64 start = qof_profile_now();
+            journal_ok = gnc_xml_be_journal_load (be, book);
+            qof_profile_end_phase("journal replay", start);
+        }
         break;
 
     case GNC_BOOK_XML2_FILE_NO_ENCODING:
@@ -1178,6 +1722,10 @@ gnc_xml_be_load_from_file (QofBackend *bend, QofBook *book, QofBackendLoadType l
 
     /* We just got done loading, it can't possibly be dirty !! */
     qof_book_mark_session_saved (book);
+
+    /* Nor is there anything to journal yet. */
+    g_hash_table_remove_all (be->journal_trans);
+    be->journal_full_save = !journal_ok;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -1266,6 +1814,11 @@ gnc_backend_new(void)
 
     gnc_be->book = NULL;
 
+    gnc_be->journal_base_digest = NULL;
+    gnc_be->journal_trans = g_hash_table_new_full(guid_hash_to_guint,
+                            guid_g_hash_table_equal,
+                            (GDestroyNotify) guid_free, NULL);
+
     return be;
 }
 
@@ -64,6 +64,30 @@ struct FileBackend_struct
     int lockfd;
 
     QofBook *book;  /* The primary, main open book */
+
+    /* Journaled saves, enabled by GNC_XML_JOURNAL */
+    gboolean journal;
+    char *journalfile;
+    GHashTable *journal_trans;   /* GncGUIDs of transactions changed since
+                                  * the last save */
+    gboolean journal_full_save;  /* something else changed as well */
+    gchar *journal_base_digest;  /* digest of the data file the journal
+                                  * applies to; NULL if unknown */
+
+    /* Transaction snapshot, enabled by GNC_XML_SNAPSHOT; NULL otherwise */
+    char *snapshotfile;
+
+    /* Mark books clean once scrubbed and don't scrub them when loading them
+     * back, enabled by GNC_XML_DEFERRED_SCRUB */
+    gboolean deferred_scrub;
+
+    /* Full names of the backup and log files of the data file, so that
+     * removing old ones needn't scan the directory after each save.
+     * NULL until the first scan.  The directory is scanned again when
+     * its modification time, as of the end of the last save, has
+     * changed by the next one. */
+    GHashTable *old_files;
+    time_t old_files_mtime;
 };
 
 typedef struct FileBackend_struct FileBackend;
@@ -25,6 +25,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "gnc-xml-helper.h"
@@ -47,6 +48,8 @@
 #include "gnc-lot.h"
 #include "gnc-lot-p.h"
 
+static QofLogModule log_module = GNC_MOD_IO;
+
 const gchar *transaction_version_string = "2.0.0";
 
 static void
@@ -193,6 +196,220 @@ gnc_transaction_dom_tree_create(Transaction *trn)
     return ret;
 }
 
+/***********************************************************************/
+/* Streaming writer.
+ *
+ * gnc_transaction_write_xml writes the same bytes that xmlElemDump
+ * writes for the tree from gnc_transaction_dom_tree_create, but without
+ * building the tree.  The tags, including their indentation, are fixed
+ * strings; only the kvp slots are still built as a DOM subtree and
+ * dumped in place. */
+
+#define XML_WRITE(out, str) xmlOutputBufferWrite(out, sizeof(str) - 1, str)
+
+static void
+xml_write_text(xmlOutputBufferPtr out, const char *text)
+{
+    if (text && *text)
+        xmlOutputBufferWriteEscape(out, BAD_CAST text, NULL);
+}
+
+static void
+xml_write_guid(xmlOutputBufferPtr out, const GncGUID *guid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    guid_to_string_buff(guid, guid_str);
+    xmlOutputBufferWrite(out, GUID_ENCODING_LENGTH, guid_str);
+}
+
+static void
+xml_write_numeric(xmlOutputBufferPtr out, gnc_numeric num)
+{
+    gchar *numstr = gnc_numeric_to_string(num);
+
+    xmlOutputBufferWriteString(out, numstr);
+    g_free(numstr);
+}
+
+/* 'open' and 'close' are the element tags with their indentation;
+   'inner' is the indentation of the ts:date and ts:ns children. */
+static void
+xml_write_timespec(xmlOutputBufferPtr out, const char *open,
+                   const char *inner, const char *close, Timespec ts)
+{
+    gchar *date_str = timespec_sec_to_string(&ts);
+
+    if (!date_str)
+        return;
+
+    xmlOutputBufferWriteString(out, open);
+    xmlOutputBufferWriteString(out, inner);
+    XML_WRITE(out, "<ts:date>");
+    xml_write_text(out, date_str);
+    XML_WRITE(out, "</ts:date>\n");
+    if (ts.tv_nsec > 0)
+    {
+        gchar *ns_str = timespec_nsec_to_string(&ts);
+
+        xmlOutputBufferWriteString(out, inner);
+        XML_WRITE(out, "<ts:ns>");
+        xml_write_text(out, ns_str);
+        XML_WRITE(out, "</ts:ns>\n");
+        g_free(ns_str);
+    }
+    xmlOutputBufferWriteString(out, close);
+    g_free(date_str);
+}
+
+static void
+xml_write_slots(xmlOutputBufferPtr out, const char *tag, const char *indent,
+                int level, KvpFrame *frame)
+{
+    xmlNodePtr kvpnode = kvp_frame_to_dom_tree(tag, frame);
+
+    if (!kvpnode)
+        return;
+
+    xmlOutputBufferWriteString(out, indent);
+    xmlNodeDumpOutput(out, NULL, kvpnode, level, 1, NULL);
+    XML_WRITE(out, "\n");
+    xmlFreeNode(kvpnode);
+}
+
+static void
+split_write_xml(xmlOutputBufferPtr out, Split *spl)
+{
+    const char *memo = xaccSplitGetMemo(spl);
+    const char *action = xaccSplitGetAction(spl);
+    Timespec ts = xaccSplitRetDateReconciledTS(spl);
+    GNCLot *lot = xaccSplitGetLot(spl);
+    char state[2];
+
+    XML_WRITE(out, "    <trn:split>\n");
+
+    XML_WRITE(out, "      <split:id type=\"guid\">");
+    xml_write_guid(out, xaccSplitGetGUID(spl));
+    XML_WRITE(out, "</split:id>\n");
+
+    if (memo && g_strcmp0(memo, "") != 0)
+    {
+        XML_WRITE(out, "      <split:memo>");
+        xml_write_text(out, memo);
+        XML_WRITE(out, "</split:memo>\n");
+    }
+
+    if (action && g_strcmp0(action, "") != 0)
+    {
+        XML_WRITE(out, "      <split:action>");
+        xml_write_text(out, action);
+        XML_WRITE(out, "</split:action>\n");
+    }
+
+    state[0] = xaccSplitGetReconcile(spl);
+    state[1] = '\0';
+    XML_WRITE(out, "      <split:reconciled-state>");
+    xml_write_text(out, state);
+    XML_WRITE(out, "</split:reconciled-state>\n");
+
+    if (ts.tv_sec != 0 || ts.tv_nsec != 0)
+        xml_write_timespec(out, "      <split:reconcile-date>\n", "        ",
+                           "      </split:reconcile-date>\n", ts);
+
+    XML_WRITE(out, "      <split:value>");
+    xml_write_numeric(out, xaccSplitGetValue(spl));
+    XML_WRITE(out, "</split:value>\n");
+
+    XML_WRITE(out, "      <split:quantity>");
+    xml_write_numeric(out, xaccSplitGetAmount(spl));
+    XML_WRITE(out, "</split:quantity>\n");
+
+    XML_WRITE(out, "      <split:account type=\"guid\">");
+    xml_write_guid(out, xaccAccountGetGUID(xaccSplitGetAccount(spl)));
+    XML_WRITE(out, "</split:account>\n");
+
+    if (lot)
+    {
+        XML_WRITE(out, "      <split:lot type=\"guid\">");
+        xml_write_guid(out, gnc_lot_get_guid(lot));
+        XML_WRITE(out, "</split:lot>\n");
+    }
+
+    xml_write_slots(out, "split:slots", "      ", 3, xaccSplitGetSlots(spl));
+
+    XML_WRITE(out, "    </trn:split>\n");
+}
+
+gboolean
+gnc_transaction_write_xml(xmlOutputBufferPtr out, Transaction *trn)
+{
+    gnc_commodity *currency = xaccTransGetCurrency(trn);
+    const char *num = xaccTransGetNum(trn);
+    const char *description = xaccTransGetDescription(trn);
+    GList *n;
+
+    g_return_val_if_fail(out && trn, FALSE);
+
+    XML_WRITE(out, "<gnc:transaction version=\"");
+    xmlOutputBufferWriteString(out, transaction_version_string);
+    XML_WRITE(out, "\">\n");
+
+    XML_WRITE(out, "  <trn:id type=\"guid\">");
+    xml_write_guid(out, xaccTransGetGUID(trn));
+    XML_WRITE(out, "</trn:id>\n");
+
+    /* commodity_ref_to_dom_tree drops incomplete commodities */
+    if (currency && gnc_commodity_get_namespace(currency) &&
+            gnc_commodity_get_mnemonic(currency))
+    {
+        XML_WRITE(out, "  <trn:currency>\n    <cmdty:space>");
+        xml_write_text(out, gnc_commodity_get_namespace_compat(currency));
+        XML_WRITE(out, "</cmdty:space>\n    <cmdty:id>");
+        xml_write_text(out, gnc_commodity_get_mnemonic(currency));
+        XML_WRITE(out, "</cmdty:id>\n  </trn:currency>\n");
+    }
+
+    if (num && g_strcmp0(num, "") != 0)
+    {
+        XML_WRITE(out, "  <trn:num>");
+        xml_write_text(out, num);
+        XML_WRITE(out, "</trn:num>\n");
+    }
+
+    xml_write_timespec(out, "  <trn:date-posted>\n", "    ",
+                       "  </trn:date-posted>\n",
+                       xaccTransRetDatePostedTS(trn));
+    xml_write_timespec(out, "  <trn:date-entered>\n", "    ",
+                       "  </trn:date-entered>\n",
+                       xaccTransRetDateEnteredTS(trn));
+
+    if (description)
+    {
+        XML_WRITE(out, "  <trn:description>");
+        xml_write_text(out, description);
+        XML_WRITE(out, "</trn:description>\n");
+    }
+
+    xml_write_slots(out, "trn:slots", "  ", 1, xaccTransGetSlots(trn));
+
+    n = xaccTransGetSplitList(trn);
+    if (n)
+    {
+        XML_WRITE(out, "  <trn:splits>\n");
+        for (; n; n = n->next)
+            split_write_xml(out, n->data);
+        XML_WRITE(out, "  </trn:splits>\n");
+    }
+    else
+    {
+        XML_WRITE(out, "  <trn:splits/>\n");
+    }
+
+    XML_WRITE(out, "</gnc:transaction>");
+
+    return out->error == 0;
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -300,26 +517,50 @@ spl_quantity_handler(xmlNodePtr node, gpointer data)
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
 
-static gboolean
-spl_account_handler(xmlNodePtr node, gpointer data)
+/* Shared by the DOM and the SAX split parsers. */
+static void
+split_set_account_by_guid(Split *split, QofBook *book, const GncGUID *id)
 {
-    struct split_pdata *pdata = data;
-    GncGUID *id = dom_tree_to_guid(node);
     Account *account;
 
-    g_return_val_if_fail(id, FALSE);
-
-    account = xaccAccountLookup (id, pdata->book);
+    account = xaccAccountLookup (id, book);
     if (!account && gnc_transaction_xml_v2_testing &&
             !guid_equal (id, guid_null ()))
     {
-        account = xaccMallocAccount (pdata->book);
+        account = xaccMallocAccount (book);
         xaccAccountSetGUID (account, id);
         xaccAccountSetCommoditySCU (account,
-                                    xaccSplitGetAmount (pdata->split).denom);
+                                    xaccSplitGetAmount (split).denom);
+    }
+
+    xaccAccountInsertSplit (account, split);
+}
+
+static void
+split_set_lot_by_guid(Split *split, QofBook *book, const GncGUID *id)
+{
+    GNCLot *lot;
+
+    lot = gnc_lot_lookup (id, book);
+    if (!lot && gnc_transaction_xml_v2_testing &&
+            !guid_equal (id, guid_null ()))
+    {
+        lot = gnc_lot_new (book);
+        gnc_lot_set_guid (lot, *id);
     }
 
-    xaccAccountInsertSplit (account, pdata->split);
+    gnc_lot_add_split (lot, split);
+}
+
+static gboolean
+spl_account_handler(xmlNodePtr node, gpointer data)
+{
+    struct split_pdata *pdata = data;
+    GncGUID *id = dom_tree_to_guid(node);
+
+    g_return_val_if_fail(id, FALSE);
+
+    split_set_account_by_guid(pdata->split, pdata->book, id);
 
     g_free(id);
 
@@ -331,19 +572,10 @@ spl_lot_handler(xmlNodePtr node, gpointer data)
 {
     struct split_pdata *pdata = data;
     GncGUID *id = dom_tree_to_guid(node);
-    GNCLot *lot;
 
     g_return_val_if_fail(id, FALSE);
 
-    lot = gnc_lot_lookup (id, pdata->book);
-    if (!lot && gnc_transaction_xml_v2_testing &&
-            !guid_equal (id, guid_null ()))
-    {
-        lot = gnc_lot_new (pdata->book);
-        gnc_lot_set_guid (lot, *id);
-    }
-
-    gnc_lot_add_split (lot, pdata->split);
+    split_set_lot_by_guid(pdata->split, pdata->book, id);
 
     g_free(id);
 
@@ -596,6 +828,12 @@ gnc_transaction_end_handler(gpointer data_for_children,
 
     g_return_val_if_fail(tree, FALSE);
 
+    if (gdata->skip_transactions)
+    {
+        xmlFreeNode(tree);
+        return TRUE;
+    }
+
     trn = dom_tree_to_transaction(tree, gdata->bookdata);
     if (trn != NULL)
     {
@@ -640,8 +878,1144 @@ dom_tree_to_transaction( xmlNodePtr node, QofBook *book )
     return trn;
 }
 
-sixtp*
-gnc_transaction_sixtp_parser_create(void)
+/***********************************************************************/
+/* Streaming transaction parser.
+ *
+ * The DOM parser above builds a complete xmlNode tree for every
+ * <gnc:transaction> and only then converts it.  The parser below works
+ * from the SAX events instead, in three steps:
+ *
+ *   record:  the raw text of each field is collected into a txn_stage.
+ *            The parser is a single sixtp which catches all of its own
+ *            children; what an element means is decided from the
+ *            element enclosing it, which is kept on a small stack.
+ *   convert: GUIDs, numbers and dates are parsed.  This touches
+ *            nothing but the stage, so it may run on a worker thread.
+ *   apply:   the Transaction and its Splits are created in the book.
+ *
+ * Without a pipeline the three steps run back to back when the
+ * transaction ends.  With one (see gnc_txn_pipeline_new) the converts
+ * run on a thread pool and the applies are done in document order by
+ * the parsing thread, so the resulting book is the same.
+ *
+ * The kvp slots, which are rare and arbitrarily nested, are still
+ * collected into a DOM subtree and converted in the apply step, as the
+ * kvp code shares a string cache which is not thread safe.
+ *
+ * Errors are treated exactly as the DOM parser treats them: an unknown
+ * child or a missing required child rejects the transaction, a bad
+ * split ends the split list, and an unparseable value is skipped. */
+
+typedef enum
+{
+    TXN_SAX_TRANSACTION,
+    TXN_SAX_TRN_ID,
+    TXN_SAX_TRN_CURRENCY,
+    TXN_SAX_TRN_NUM,
+    TXN_SAX_TRN_DATE_POSTED,
+    TXN_SAX_TRN_DATE_ENTERED,
+    TXN_SAX_TRN_DESCRIPTION,
+    TXN_SAX_TRN_SLOTS,
+    TXN_SAX_TRN_SPLITS,
+    TXN_SAX_SPLIT,
+    TXN_SAX_SPL_ID,
+    TXN_SAX_SPL_MEMO,
+    TXN_SAX_SPL_ACTION,
+    TXN_SAX_SPL_RECONCILED_STATE,
+    TXN_SAX_SPL_RECONCILE_DATE,
+    TXN_SAX_SPL_VALUE,
+    TXN_SAX_SPL_QUANTITY,
+    TXN_SAX_SPL_ACCOUNT,
+    TXN_SAX_SPL_LOT,
+    TXN_SAX_SPL_SLOTS,
+    TXN_SAX_TS_DATE,
+    TXN_SAX_TS_NS,
+    TXN_SAX_CMDTY_SPACE,
+    TXN_SAX_CMDTY_ID,
+} txn_sax_elem;
+
+struct txn_sax_child
+{
+    const gchar *tag;
+    txn_sax_elem elem;
+    gboolean required;
+};
+
+static const struct txn_sax_child txn_sax_trn_children[] =
+{
+    { "trn:id", TXN_SAX_TRN_ID, TRUE },
+    { "trn:currency", TXN_SAX_TRN_CURRENCY, FALSE },
+    { "trn:num", TXN_SAX_TRN_NUM, FALSE },
+    { "trn:date-posted", TXN_SAX_TRN_DATE_POSTED, TRUE },
+    { "trn:date-entered", TXN_SAX_TRN_DATE_ENTERED, TRUE },
+    { "trn:description", TXN_SAX_TRN_DESCRIPTION, FALSE },
+    { "trn:slots", TXN_SAX_TRN_SLOTS, FALSE },
+    { "trn:splits", TXN_SAX_TRN_SPLITS, TRUE },
+    { NULL, 0, FALSE },
+};
+
+static const struct txn_sax_child txn_sax_split_children[] =
+{
+    { "split:id", TXN_SAX_SPL_ID, TRUE },
+    { "split:memo", TXN_SAX_SPL_MEMO, FALSE },
+    { "split:action", TXN_SAX_SPL_ACTION, FALSE },
+    { "split:reconciled-state", TXN_SAX_SPL_RECONCILED_STATE, TRUE },
+    { "split:reconcile-date", TXN_SAX_SPL_RECONCILE_DATE, FALSE },
+    { "split:value", TXN_SAX_SPL_VALUE, TRUE },
+    { "split:quantity", TXN_SAX_SPL_QUANTITY, TRUE },
+    { "split:account", TXN_SAX_SPL_ACCOUNT, TRUE },
+    { "split:lot", TXN_SAX_SPL_LOT, FALSE },
+    { "split:slots", TXN_SAX_SPL_SLOTS, FALSE },
+    { NULL, 0, FALSE },
+};
+
+/* A guid, number or date as read, and its converted value. */
+typedef struct
+{
+    gchar *text;
+    gboolean attrs_ok;
+    gboolean valid;
+    GncGUID guid;
+} txn_stage_guid;
+
+typedef struct
+{
+    gchar *text;
+    gboolean valid;
+    gnc_numeric num;
+} txn_stage_num;
+
+typedef struct
+{
+    gboolean present;
+    gboolean ok;
+    gchar *secs;
+    gchar *nsecs;
+    gboolean valid;
+    Timespec ts;
+} txn_stage_ts;
+
+typedef struct
+{
+    txn_stage_guid id;
+    gchar *memo;
+    gchar *action;
+    gchar *reconciled;
+    txn_stage_ts reconcile_date;
+    txn_stage_num value;
+    txn_stage_num quantity;
+    txn_stage_guid account;
+    txn_stage_guid lot;
+    xmlNodePtr slots;
+} txn_split_stage;
+
+typedef struct
+{
+    const gchar *tag;
+    gboolean ok;
+    txn_stage_guid id;
+    gboolean has_currency;
+    gboolean cmdty_ok;
+    gchar *cmdty_space;
+    gchar *cmdty_id;
+    gchar *num;
+    txn_stage_ts date_posted;
+    txn_stage_ts date_entered;
+    gchar *description;
+    xmlNodePtr slots;
+    GPtrArray *splits;
+} txn_stage;
+
+static void
+txn_stage_ts_clear(txn_stage_ts *ts)
+{
+    g_free(ts->secs);
+    g_free(ts->nsecs);
+    memset(ts, 0, sizeof(*ts));
+}
+
+static void
+txn_split_stage_free(txn_split_stage *split)
+{
+    g_free(split->id.text);
+    g_free(split->memo);
+    g_free(split->action);
+    g_free(split->reconciled);
+    txn_stage_ts_clear(&split->reconcile_date);
+    g_free(split->value.text);
+    g_free(split->quantity.text);
+    g_free(split->account.text);
+    g_free(split->lot.text);
+    if (split->slots) xmlFreeNode(split->slots);
+    g_free(split);
+}
+
+static txn_stage *
+txn_stage_new(const gchar *tag)
+{
+    txn_stage *stage = g_new0(txn_stage, 1);
+
+    stage->tag = g_intern_string(tag);
+    stage->ok = TRUE;
+    stage->splits = g_ptr_array_new_with_free_func(
+                        (GDestroyNotify)txn_split_stage_free);
+    return stage;
+}
+
+static void
+txn_stage_free(txn_stage *stage)
+{
+    g_free(stage->id.text);
+    g_free(stage->cmdty_space);
+    g_free(stage->cmdty_id);
+    g_free(stage->num);
+    txn_stage_ts_clear(&stage->date_posted);
+    txn_stage_ts_clear(&stage->date_entered);
+    g_free(stage->description);
+    if (stage->slots) xmlFreeNode(stage->slots);
+    g_ptr_array_free(stage->splits, TRUE);
+    g_free(stage);
+}
+
+/* Conversion.  Nothing here may touch the book or the engine. */
+
+static void
+txn_stage_convert_guid(txn_stage_guid *id)
+{
+    if (!id->text)
+        return;
+
+    if (!id->attrs_ok)
+    {
+        PERR("guid element without a valid type attribute");
+        return;
+    }
+    id->valid = xml_string_to_guid(id->text, &id->guid);
+}
+
+static void
+txn_stage_convert_num(txn_stage_num *num)
+{
+    num->valid = num->text && xml_string_to_gnc_numeric(num->text, &num->num);
+}
+
+static void
+txn_stage_convert_ts(txn_stage_ts *ts, const gchar *tag)
+{
+    if (!ts->present)
+        return;
+
+    if (!ts->secs)
+    {
+        PERR("no ts:date node found.");
+        ts->ok = FALSE;
+    }
+    if (ts->ok && !string_to_timespec_secs(ts->secs, &ts->ts))
+        ts->ok = FALSE;
+    if (ts->ok && ts->nsecs && !string_to_timespec_nsecs(ts->nsecs, &ts->ts))
+        ts->ok = FALSE;
+    if (!ts->ok)
+    {
+        ts->ts.tv_sec = 0;
+        ts->ts.tv_nsec = 0;
+    }
+
+    ts->valid = dom_tree_valid_timespec(&ts->ts, BAD_CAST tag);
+}
+
+static void
+txn_stage_convert(txn_stage *stage)
+{
+    guint i;
+
+    if (!stage->ok)
+        return;
+
+    txn_stage_convert_guid(&stage->id);
+    txn_stage_convert_ts(&stage->date_posted, "trn:date-posted");
+    txn_stage_convert_ts(&stage->date_entered, "trn:date-entered");
+
+    for (i = 0; i < stage->splits->len; i++)
+    {
+        txn_split_stage *split = g_ptr_array_index(stage->splits, i);
+
+        txn_stage_convert_guid(&split->id);
+        txn_stage_convert_ts(&split->reconcile_date, "split:reconcile-date");
+        txn_stage_convert_num(&split->value);
+        txn_stage_convert_num(&split->quantity);
+        txn_stage_convert_guid(&split->account);
+        txn_stage_convert_guid(&split->lot);
+    }
+}
+
+/* Application.  Runs on the parsing thread only. */
+
+static Split *
+txn_split_stage_apply(txn_split_stage *stage, QofBook *book)
+{
+    Split *split = xaccMallocSplit(book);
+
+    if (stage->id.valid)
+        xaccSplitSetGUID(split, &stage->id.guid);
+    if (stage->memo)
+        xaccSplitSetMemo(split, stage->memo);
+    if (stage->action)
+        xaccSplitSetAction(split, stage->action);
+    if (stage->reconciled)
+        xaccSplitSetReconcile(split, stage->reconciled[0]);
+    if (stage->reconcile_date.valid)
+        xaccSplitSetDateReconciledTS(split, &stage->reconcile_date.ts);
+    if (stage->value.valid)
+        xaccSplitSetValue(split, stage->value.num);
+    if (stage->quantity.valid)
+        xaccSplitSetAmount(split, stage->quantity.num);
+    if (stage->account.valid)
+        split_set_account_by_guid(split, book, &stage->account.guid);
+    if (stage->lot.valid)
+        split_set_lot_by_guid(split, book, &stage->lot.guid);
+    if (stage->slots)
+        dom_tree_to_kvp_frame_given(stage->slots, xaccSplitGetSlots(split));
+
+    return split;
+}
+
+static Transaction *
+txn_stage_apply(txn_stage *stage, QofBook *book)
+{
+    Transaction *trn;
+    guint i;
+
+    if (!stage->ok)
+        return NULL;
+
+    trn = xaccMallocTransaction(book);
+    xaccTransBeginEdit(trn);
+
+    if (stage->id.valid)
+        xaccTransSetGUID(trn, &stage->id.guid);
+
+    if (stage->has_currency)
+    {
+        gnc_commodity_table *table = gnc_commodity_table_get_table(book);
+        gnc_commodity *ref = NULL;
+
+        if (stage->cmdty_ok && stage->cmdty_space && stage->cmdty_id && table)
+        {
+            ref = gnc_commodity_table_lookup(table,
+                                             g_strstrip(stage->cmdty_space),
+                                             g_strstrip(stage->cmdty_id));
+        }
+        if (!ref)
+            PERR("transaction currency not found");
+
+        xaccTransSetCurrency(trn, ref);
+    }
+
+    if (stage->num)
+        xaccTransSetNum(trn, stage->num);
+    if (stage->date_posted.valid)
+        xaccTransSetDatePostedTS(trn, &stage->date_posted.ts);
+    if (stage->date_entered.valid)
+        xaccTransSetDateEnteredTS(trn, &stage->date_entered.ts);
+    if (stage->description)
+        xaccTransSetDescription(trn, stage->description);
+    if (stage->slots)
+        dom_tree_to_kvp_frame_given(stage->slots, xaccTransGetSlots(trn));
+
+    for (i = 0; i < stage->splits->len; i++)
+    {
+        txn_split_stage *split = g_ptr_array_index(stage->splits, i);
+        xaccTransAppendSplit(trn, txn_split_stage_apply(split, book));
+    }
+
+    xaccTransCommitEdit(trn);
+
+    return trn;
+}
+
+static void
+txn_stage_deliver(txn_stage *stage, gxpf_data *gdata)
+{
+    Transaction *trn = txn_stage_apply(stage, gdata->bookdata);
+
+    if (trn)
+        gdata->cb(stage->tag, gdata->parsedata, trn);
+}
+
+/***********************************************************************/
+/* Pipelined loading */
+
+/* Transactions handed to a worker at a time. */
+#define TXN_PIPELINE_BATCH 256
+
+typedef struct
+{
+    guint seq;
+    GPtrArray *stages;
+} txn_batch;
+
+struct gnc_txn_pipeline_struct
+{
+    GThreadPool *pool;
+    GAsyncQueue *done;
+    /* completed batches which arrived before their predecessors */
+    GHashTable *ready;
+    txn_batch *filling;
+    guint next_seq;
+    guint merge_seq;
+    guint in_flight;
+    guint max_in_flight;
+};
+
+static txn_batch *
+txn_batch_new(void)
+{
+    txn_batch *batch = g_new0(txn_batch, 1);
+
+    batch->stages = g_ptr_array_sized_new(TXN_PIPELINE_BATCH);
+    return batch;
+}
+
+static void
+txn_batch_free(txn_batch *batch)
+{
+    g_ptr_array_foreach(batch->stages, (GFunc)txn_stage_free, NULL);
+    g_ptr_array_free(batch->stages, TRUE);
+    g_free(batch);
+}
+
+static void
+txn_pipeline_worker(gpointer data, gpointer user_data)
+{
+    txn_batch *batch = data;
+    gnc_txn_pipeline *pipeline = user_data;
+
+    g_ptr_array_foreach(batch->stages, (GFunc)txn_stage_convert, NULL);
+    g_async_queue_push(pipeline->done, batch);
+}
+
+gint
+gnc_txn_pipeline_default_workers(void)
+{
+    const gchar *env = g_getenv("GNC_XML_LOAD_THREADS");
+    gint processors = 1;
+
+    if (env)
+        return MAX(atoi(env), 0);
+
+#ifdef HAVE_GLIB_2_36
+    processors = g_get_num_processors();
+#endif
+    /* The parsing thread and the decompressor are busy already. */
+    return MIN(processors - 1, 8);
+}
+
+gnc_txn_pipeline *
+gnc_txn_pipeline_new(gint n_workers)
+{
+    gnc_txn_pipeline *pipeline;
+    GError *error = NULL;
+
+    if (n_workers < 1)
+        return NULL;
+
+    pipeline = g_new0(gnc_txn_pipeline, 1);
+    pipeline->pool = g_thread_pool_new(txn_pipeline_worker, pipeline,
+                                       n_workers, FALSE, &error);
+    if (!pipeline->pool)
+    {
+        PWARN("Could not start the loader threads: %s",
+              error ? error->message : "(unknown)");
+        g_clear_error(&error);
+        g_free(pipeline);
+        return NULL;
+    }
+    pipeline->done = g_async_queue_new();
+    pipeline->ready = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pipeline->max_in_flight = 4 * n_workers;
+
+    return pipeline;
+}
+
+/* Apply the completed batches in sequence.  When block is TRUE, wait
+   until no more than 'keep' batches remain outstanding. */
+static void
+txn_pipeline_merge(gnc_txn_pipeline *pipeline, gxpf_data *gdata,
+                   gboolean block, guint keep)
+{
+    while (TRUE)
+    {
+        txn_batch *batch;
+
+        while ((batch = g_hash_table_lookup(pipeline->ready,
+                                            GUINT_TO_POINTER(pipeline->merge_seq))))
+        {
+            guint i;
+
+            g_hash_table_remove(pipeline->ready,
+                                GUINT_TO_POINTER(pipeline->merge_seq));
+            for (i = 0; i < batch->stages->len; i++)
+                txn_stage_deliver(g_ptr_array_index(batch->stages, i), gdata);
+            txn_batch_free(batch);
+            pipeline->merge_seq++;
+            pipeline->in_flight--;
+        }
+
+        if (block && pipeline->in_flight > keep)
+            batch = g_async_queue_pop(pipeline->done);
+        else
+            batch = g_async_queue_try_pop(pipeline->done);
+
+        if (!batch)
+            return;
+
+        g_hash_table_insert(pipeline->ready, GUINT_TO_POINTER(batch->seq),
+                            batch);
+    }
+}
+
+static void
+txn_pipeline_submit(gnc_txn_pipeline *pipeline)
+{
+    txn_batch *batch = pipeline->filling;
+
+    if (!batch)
+        return;
+
+    pipeline->filling = NULL;
+    batch->seq = pipeline->next_seq++;
+    pipeline->in_flight++;
+    g_thread_pool_push(pipeline->pool, batch, NULL);
+}
+
+static void
+txn_pipeline_add(gnc_txn_pipeline *pipeline, gxpf_data *gdata,
+                 txn_stage *stage)
+{
+    if (!pipeline->filling)
+        pipeline->filling = txn_batch_new();
+
+    g_ptr_array_add(pipeline->filling->stages, stage);
+    if (pipeline->filling->stages->len < TXN_PIPELINE_BATCH)
+        return;
+
+    txn_pipeline_submit(pipeline);
+    txn_pipeline_merge(pipeline, gdata,
+                       pipeline->in_flight >= pipeline->max_in_flight,
+                       pipeline->max_in_flight - 1);
+}
+
+void
+gnc_txn_pipeline_flush(gnc_txn_pipeline *pipeline, gxpf_data *gdata)
+{
+    g_return_if_fail(pipeline && gdata);
+
+    txn_pipeline_submit(pipeline);
+    txn_pipeline_merge(pipeline, gdata, TRUE, 0);
+}
+
+static void
+txn_pipeline_free_ready(gpointer key, gpointer value, gpointer user_data)
+{
+    txn_batch_free(value);
+}
+
+void
+gnc_txn_pipeline_destroy(gnc_txn_pipeline *pipeline)
+{
+    txn_batch *batch;
+
+    if (!pipeline)
+        return;
+
+    /* Waits for the queued batches. */
+    g_thread_pool_free(pipeline->pool, FALSE, TRUE);
+
+    if (pipeline->filling)
+        txn_batch_free(pipeline->filling);
+    while ((batch = g_async_queue_try_pop(pipeline->done)))
+        txn_batch_free(batch);
+    g_hash_table_foreach(pipeline->ready, txn_pipeline_free_ready, NULL);
+    g_hash_table_destroy(pipeline->ready);
+    g_async_queue_unref(pipeline->done);
+    g_free(pipeline);
+}
+
+/***********************************************************************/
+/* Recording */
+
+/* transaction > splits > split > reconcile-date > ts:date */
+#define TXN_SAX_MAX_DEPTH 8
+
+struct txn_sax_state
+{
+    txn_stage *stage;
+    txn_split_stage *split;
+
+    txn_sax_elem stack[TXN_SAX_MAX_DEPTH];
+    guint depth;
+    /* Nesting level inside an element whose content is skipped. */
+    guint ignore_depth;
+
+    /* Character data of the current leaf element. */
+    GString *text;
+    txn_stage_ts *ts;
+
+    /* DOM subtree for trn:slots or split:slots. */
+    xmlNodePtr slots_root;
+    xmlNodePtr slots_node;
+
+    guint trn_seen;
+    guint split_seen;
+    gboolean split_ok;
+    gboolean splits_done;
+};
+
+/* Shared by all the frames of a transaction which is skipped because
+   gxpf_data.skip_transactions is set. */
+static struct txn_sax_state txn_sax_skipped;
+
+static void
+txn_sax_state_free(struct txn_sax_state *state)
+{
+    if (state->split) txn_split_stage_free(state->split);
+    if (state->stage) txn_stage_free(state->stage);
+    g_string_free(state->text, TRUE);
+    g_free(state);
+}
+
+static gboolean
+txn_sax_lookup_child(const struct txn_sax_child *children, const gchar *tag,
+                     txn_sax_elem *elem, guint *seen)
+{
+    guint i;
+
+    for (i = 0; children[i].tag; i++)
+    {
+        if (g_strcmp0(tag, children[i].tag) == 0)
+        {
+            *elem = children[i].elem;
+            *seen |= 1 << i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static gboolean
+txn_sax_all_required_seen(const struct txn_sax_child *children, guint seen)
+{
+    guint i;
+
+    for (i = 0; children[i].tag; i++)
+    {
+        if (children[i].required && !(seen & (1 << i)))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Same rule as dom_tree_to_guid: the first attribute must be a guid
+   type declaration. */
+static gboolean
+txn_sax_guid_attrs_ok(gchar **attrs)
+{
+    if (!attrs || !attrs[0] || g_strcmp0(attrs[0], "type") != 0)
+        return FALSE;
+
+    return (g_strcmp0(attrs[1], "guid") == 0 ||
+            g_strcmp0(attrs[1], "new") == 0);
+}
+
+static txn_stage_guid *
+txn_sax_guid_field(struct txn_sax_state *state, txn_sax_elem elem)
+{
+    switch (elem)
+    {
+    case TXN_SAX_TRN_ID:
+        return &state->stage->id;
+    case TXN_SAX_SPL_ID:
+        return &state->split->id;
+    case TXN_SAX_SPL_ACCOUNT:
+        return &state->split->account;
+    case TXN_SAX_SPL_LOT:
+        return &state->split->lot;
+    default:
+        return NULL;
+    }
+}
+
+static gchar **
+txn_sax_string_field(struct txn_sax_state *state, txn_sax_elem elem)
+{
+    switch (elem)
+    {
+    case TXN_SAX_TRN_NUM:
+        return &state->stage->num;
+    case TXN_SAX_TRN_DESCRIPTION:
+        return &state->stage->description;
+    case TXN_SAX_SPL_MEMO:
+        return &state->split->memo;
+    case TXN_SAX_SPL_ACTION:
+        return &state->split->action;
+    case TXN_SAX_SPL_RECONCILED_STATE:
+        return &state->split->reconciled;
+    case TXN_SAX_SPL_VALUE:
+        return &state->split->value.text;
+    case TXN_SAX_SPL_QUANTITY:
+        return &state->split->quantity.text;
+    default:
+        return NULL;
+    }
+}
+
+static void
+txn_sax_start_slots(struct txn_sax_state *state, xmlNodePtr *field,
+                    const gchar *tag, gchar **attrs)
+{
+    gchar **atptr;
+
+    if (*field) xmlFreeNode(*field);
+
+    *field = xmlNewNode(NULL, BAD_CAST tag);
+    state->slots_root = *field;
+    state->slots_node = *field;
+
+    for (atptr = attrs; atptr && *atptr; atptr += 2)
+        xmlSetProp(*field, BAD_CAST atptr[0], BAD_CAST atptr[1]);
+}
+
+static void
+txn_sax_start_ts(struct txn_sax_state *state, txn_stage_ts *ts)
+{
+    txn_stage_ts_clear(ts);
+    ts->present = TRUE;
+    ts->ok = TRUE;
+    state->ts = ts;
+}
+
+static gboolean
+txn_sax_start_handler(GSList* sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer *data_for_children,
+                      gpointer *result, const gchar *tag, gchar **attrs)
+{
+    struct txn_sax_state *state = parent_data;
+    txn_stage_guid *id;
+    txn_sax_elem elem;
+
+    *result = NULL;
+
+    if (parent_data == NULL && ((gxpf_data*)global_data)->skip_transactions)
+    {
+        *data_for_children = &txn_sax_skipped;
+        return TRUE;
+    }
+
+    if (parent_data == NULL)
+    {
+        state = g_new0(struct txn_sax_state, 1);
+        state->stage = txn_stage_new(tag);
+        state->text = g_string_sized_new(64);
+        state->stack[state->depth++] = TXN_SAX_TRANSACTION;
+        *data_for_children = state;
+        return TRUE;
+    }
+
+    *data_for_children = state;
+
+    if (state == &txn_sax_skipped)
+        return TRUE;
+
+    if (state->slots_node)
+    {
+        gchar **atptr;
+
+        state->slots_node = xmlNewChild(state->slots_node, NULL,
+                                        BAD_CAST tag, NULL);
+        for (atptr = attrs; atptr && *atptr; atptr += 2)
+            xmlSetProp(state->slots_node, BAD_CAST atptr[0],
+                       BAD_CAST atptr[1]);
+        return TRUE;
+    }
+
+    if (state->ignore_depth)
+    {
+        state->ignore_depth++;
+        return TRUE;
+    }
+
+    switch (state->stack[state->depth - 1])
+    {
+    case TXN_SAX_TRANSACTION:
+        if (!txn_sax_lookup_child(txn_sax_trn_children, tag, &elem,
+                                  &state->trn_seen))
+        {
+            PERR("Unhandled tag: %s", tag ? tag : "(null)");
+            state->stage->ok = FALSE;
+            state->ignore_depth = 1;
+            return TRUE;
+        }
+        break;
+
+    case TXN_SAX_TRN_SPLITS:
+        if (state->splits_done || g_strcmp0(tag, "trn:split") != 0)
+        {
+            state->splits_done = TRUE;
+            state->ignore_depth = 1;
+            return TRUE;
+        }
+        elem = TXN_SAX_SPLIT;
+        break;
+
+    case TXN_SAX_SPLIT:
+        if (!txn_sax_lookup_child(txn_sax_split_children, tag, &elem,
+                                  &state->split_seen))
+        {
+            PERR("Unhandled tag: %s", tag ? tag : "(null)");
+            state->split_ok = FALSE;
+            state->ignore_depth = 1;
+            return TRUE;
+        }
+        break;
+
+    case TXN_SAX_TRN_DATE_POSTED:
+    case TXN_SAX_TRN_DATE_ENTERED:
+    case TXN_SAX_SPL_RECONCILE_DATE:
+        if (g_strcmp0(tag, "ts:date") == 0)
+            elem = TXN_SAX_TS_DATE;
+        else if (g_strcmp0(tag, "ts:ns") == 0)
+            elem = TXN_SAX_TS_NS;
+        else
+        {
+            state->ignore_depth = 1;
+            return TRUE;
+        }
+        break;
+
+    case TXN_SAX_TRN_CURRENCY:
+        if (g_strcmp0(tag, "cmdty:space") == 0)
+            elem = TXN_SAX_CMDTY_SPACE;
+        else if (g_strcmp0(tag, "cmdty:id") == 0)
+            elem = TXN_SAX_CMDTY_ID;
+        else
+        {
+            state->ignore_depth = 1;
+            return TRUE;
+        }
+        break;
+
+    default:
+        /* Leaf elements have no element content. */
+        state->ignore_depth = 1;
+        return TRUE;
+    }
+
+    g_return_val_if_fail(state->depth < TXN_SAX_MAX_DEPTH, FALSE);
+    state->stack[state->depth++] = elem;
+    g_string_truncate(state->text, 0);
+
+    if ((id = txn_sax_guid_field(state, elem)))
+    {
+        id->attrs_ok = txn_sax_guid_attrs_ok(attrs);
+        return TRUE;
+    }
+
+    switch (elem)
+    {
+    case TXN_SAX_TRN_DATE_POSTED:
+        txn_sax_start_ts(state, &state->stage->date_posted);
+        break;
+    case TXN_SAX_TRN_DATE_ENTERED:
+        txn_sax_start_ts(state, &state->stage->date_entered);
+        break;
+    case TXN_SAX_SPL_RECONCILE_DATE:
+        txn_sax_start_ts(state, &state->split->reconcile_date);
+        break;
+
+    case TXN_SAX_TRN_CURRENCY:
+        g_free(state->stage->cmdty_space);
+        g_free(state->stage->cmdty_id);
+        state->stage->cmdty_space = NULL;
+        state->stage->cmdty_id = NULL;
+        state->stage->has_currency = TRUE;
+        state->stage->cmdty_ok = TRUE;
+        break;
+
+    case TXN_SAX_TRN_SLOTS:
+        txn_sax_start_slots(state, &state->stage->slots, tag, attrs);
+        break;
+    case TXN_SAX_SPL_SLOTS:
+        txn_sax_start_slots(state, &state->split->slots, tag, attrs);
+        break;
+
+    case TXN_SAX_SPLIT:
+        state->split = g_new0(txn_split_stage, 1);
+        state->split_seen = 0;
+        state->split_ok = TRUE;
+        break;
+
+    default:
+        break;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+txn_sax_chars_handler(GSList *sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer *result,
+                      const char *text, int length)
+{
+    struct txn_sax_state *state = parent_data;
+
+    if (length <= 0 || state == &txn_sax_skipped)
+        return TRUE;
+
+    if (state->slots_node)
+    {
+        xmlNodeAddContentLen(state->slots_node, BAD_CAST text, length);
+        return TRUE;
+    }
+
+    if (state->ignore_depth)
+        return TRUE;
+
+    /* Only leaf text is kept; whitespace between elements is dropped. */
+    switch (state->stack[state->depth - 1])
+    {
+    case TXN_SAX_TRANSACTION:
+    case TXN_SAX_TRN_CURRENCY:
+    case TXN_SAX_TRN_DATE_POSTED:
+    case TXN_SAX_TRN_DATE_ENTERED:
+    case TXN_SAX_TRN_SPLITS:
+    case TXN_SAX_SPLIT:
+    case TXN_SAX_SPL_RECONCILE_DATE:
+        break;
+    default:
+        g_string_append_len(state->text, text, length);
+        break;
+    }
+
+    return TRUE;
+}
+
+static void
+txn_sax_end_split(struct txn_sax_state *state)
+{
+    txn_split_stage *split = state->split;
+
+    state->split = NULL;
+
+    if (!txn_sax_all_required_seen(txn_sax_split_children,
+                                   state->split_seen))
+    {
+        PERR("didn't find all of the expected tags in the input");
+        state->split_ok = FALSE;
+    }
+
+    if (state->split_ok)
+    {
+        g_ptr_array_add(state->stage->splits, split);
+    }
+    else
+    {
+        txn_split_stage_free(split);
+        state->splits_done = TRUE;
+    }
+}
+
+/* Store a copy of the collected text in *field, or mark a duplicate. */
+static gboolean
+txn_sax_store_once(struct txn_sax_state *state, gchar **field)
+{
+    if (*field)
+        return FALSE;
+
+    *field = g_strdup(state->text->str);
+    return TRUE;
+}
+
+static void
+txn_sax_end_element(struct txn_sax_state *state, txn_sax_elem elem)
+{
+    txn_stage_guid *id;
+    gchar **field;
+
+    if ((id = txn_sax_guid_field(state, elem)))
+    {
+        g_free(id->text);
+        id->text = g_strdup(state->text->str);
+        return;
+    }
+
+    if ((field = txn_sax_string_field(state, elem)))
+    {
+        g_free(*field);
+        *field = g_strdup(state->text->str);
+        return;
+    }
+
+    switch (elem)
+    {
+    case TXN_SAX_SPLIT:
+        txn_sax_end_split(state);
+        break;
+    case TXN_SAX_TRN_SLOTS:
+    case TXN_SAX_SPL_SLOTS:
+        state->slots_root = NULL;
+        state->slots_node = NULL;
+        break;
+    case TXN_SAX_TS_DATE:
+        if (!txn_sax_store_once(state, &state->ts->secs))
+            state->ts->ok = FALSE;
+        break;
+    case TXN_SAX_TS_NS:
+        if (!txn_sax_store_once(state, &state->ts->nsecs))
+            state->ts->ok = FALSE;
+        break;
+    case TXN_SAX_CMDTY_SPACE:
+        if (!txn_sax_store_once(state, &state->stage->cmdty_space))
+            state->stage->cmdty_ok = FALSE;
+        break;
+    case TXN_SAX_CMDTY_ID:
+        if (!txn_sax_store_once(state, &state->stage->cmdty_id))
+            state->stage->cmdty_ok = FALSE;
+        break;
+    default:
+        break;
+    }
+}
+
+static gboolean
+txn_sax_finish(struct txn_sax_state *state, gxpf_data *gdata)
+{
+    txn_stage *stage = state->stage;
+    gboolean ok;
+
+    state->stage = NULL;
+
+    if (!txn_sax_all_required_seen(txn_sax_trn_children, state->trn_seen))
+    {
+        PERR("didn't find all of the expected tags in the input");
+        stage->ok = FALSE;
+    }
+
+    ok = stage->ok;
+    if (!ok)
+    {
+        PERR("discarding transaction %s",
+             stage->id.text ? stage->id.text : "(no id)");
+        txn_stage_free(stage);
+    }
+    else if (gdata->txn_pipeline)
+    {
+        txn_pipeline_add(gdata->txn_pipeline, gdata, stage);
+    }
+    else
+    {
+        txn_stage_convert(stage);
+        txn_stage_deliver(stage, gdata);
+        txn_stage_free(stage);
+    }
+
+    return ok;
+}
+
+static gboolean
+txn_sax_end_handler(gpointer data_for_children,
+                    GSList* data_from_children, GSList* sibling_data,
+                    gpointer parent_data, gpointer global_data,
+                    gpointer *result, const gchar *tag)
+{
+    struct txn_sax_state *state = data_for_children;
+    gboolean successful;
+
+    /* See gnc_transaction_end_handler. */
+    if (!tag)
+    {
+        return TRUE;
+    }
+
+    g_return_val_if_fail(state, FALSE);
+
+    if (state == &txn_sax_skipped)
+        return TRUE;
+
+    if (parent_data == NULL)
+    {
+        successful = txn_sax_finish(state, global_data);
+        txn_sax_state_free(state);
+        return successful;
+    }
+
+    if (state->slots_node && state->slots_node != state->slots_root)
+    {
+        state->slots_node = state->slots_node->parent;
+        return TRUE;
+    }
+
+    if (state->ignore_depth)
+    {
+        state->ignore_depth--;
+        return TRUE;
+    }
+
+    txn_sax_end_element(state, state->stack[--state->depth]);
+    return TRUE;
+}
+
+static void
+txn_sax_fail_handler(gpointer data_for_children,
+                     GSList* data_from_children,
+                     GSList* sibling_data,
+                     gpointer parent_data,
+                     gpointer global_data,
+                     gpointer *result,
+                     const gchar *tag)
+{
+    struct txn_sax_state *state = data_for_children;
+
+    /* Nested frames share the state; only the transaction frame owns it. */
+    if (!state || state == &txn_sax_skipped || parent_data == state)
+        return;
+
+    txn_sax_state_free(state);
+}
+
+static sixtp*
+gnc_transaction_sax_parser_new(void)
+{
+    sixtp *top_level;
+
+    top_level = sixtp_set_any(sixtp_new(), FALSE,
+                              SIXTP_START_HANDLER_ID, txn_sax_start_handler,
+                              SIXTP_CHARACTERS_HANDLER_ID, txn_sax_chars_handler,
+                              SIXTP_END_HANDLER_ID, txn_sax_end_handler,
+                              SIXTP_FAIL_HANDLER_ID, txn_sax_fail_handler,
+                              SIXTP_NO_MORE_HANDLERS);
+    if (!top_level)
+        return NULL;
+
+    if (!sixtp_add_sub_parser(top_level, SIXTP_MAGIC_CATCHER, top_level))
+    {
+        sixtp_destroy(top_level);
+        return NULL;
+    }
+
+    return top_level;
+}
+
+sixtp*
+gnc_transaction_sixtp_parser_create(void)
+{
+    if (g_getenv("GNC_XML_DOM_TRANSACTIONS"))
+        return gnc_transaction_dom_sixtp_parser_create();
+
+    return gnc_transaction_sax_parser_new();
+}
+
+sixtp*
+gnc_transaction_dom_sixtp_parser_create(void)
 {
     return sixtp_dom_parser_new(gnc_transaction_end_handler, NULL, NULL);
 }
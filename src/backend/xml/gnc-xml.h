@@ -59,7 +59,14 @@ xmlNodePtr gnc_budget_dom_tree_create( GncBudget *bgt );
 sixtp* gnc_budget_sixtp_parser_create(void);
 
 xmlNodePtr gnc_transaction_dom_tree_create(Transaction *txn);
+/* Writes what xmlElemDump writes for gnc_transaction_dom_tree_create(),
+   without building the tree. */
+gboolean gnc_transaction_write_xml(xmlOutputBufferPtr out, Transaction *txn);
 sixtp* gnc_transaction_sixtp_parser_create(void);
+/* The former DOM-based transaction parser, kept so that the tests can
+   check the streaming one against it.  It is also used by gnc_transaction_sixtp_parser_create() when
+   GNC_XML_DOM_TRANSACTIONS is set in the environment. */
+sixtp* gnc_transaction_dom_sixtp_parser_create(void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create(void);
 
@@ -37,6 +37,8 @@ gnc_xml_parse_file(sixtp *top_parser, const char *filename,
     gpdata.cb = callback;
     gpdata.parsedata = parsedata;
     gpdata.bookdata = bookdata;
+    gpdata.txn_pipeline = NULL;
+    gpdata.skip_transactions = FALSE;
 
     return sixtp_parse_file(top_parser, filename,
                             NULL, &gpdata, &parse_result);
@@ -31,11 +31,19 @@
 typedef gboolean (*gxpf_callback)(const char *tag, gpointer parsedata,
                                   gpointer data);
 
+typedef struct gnc_txn_pipeline_struct gnc_txn_pipeline;
+
 struct gxpf_data_struct
 {
     gxpf_callback cb;
     gpointer parsedata;
     gpointer bookdata;
+    /* When set, transactions are converted on worker threads and only
+       delivered to cb by gnc_txn_pipeline_flush or later transactions. */
+    gnc_txn_pipeline *txn_pipeline;
+    /* When set, transactions are parsed but dropped, as they have been
+       loaded from somewhere else. */
+    gboolean skip_transactions;
 };
 
 typedef struct gxpf_data_struct gxpf_data;
@@ -45,4 +53,16 @@ gnc_xml_parse_file(sixtp *top_parser, const char *filename,
                    gxpf_callback callback, gpointer parsedata,
                    gpointer bookdata);
 
+/* Parallel transaction loading, see gnc-transaction-xml-v2.c.
+ *
+ * gnc_txn_pipeline_new returns NULL when n_workers is less than one.
+ * The transactions are handed to the callback in document order, from
+ * the parsing thread.  gnc_txn_pipeline_flush must be called before
+ * anything is parsed which may refer to the transactions, and once
+ * more at the end of the parse. */
+gint gnc_txn_pipeline_default_workers(void);
+gnc_txn_pipeline *gnc_txn_pipeline_new(gint n_workers);
+void gnc_txn_pipeline_flush(gnc_txn_pipeline *pipeline, gxpf_data *gdata);
+void gnc_txn_pipeline_destroy(gnc_txn_pipeline *pipeline);
+
 #endif /* IO_GNCXML_GEN_H */
@@ -0,0 +1,1143 @@
+/********************************************************************\
+ * io-gncxml-snapshot.c -- binary cache of an xml file's transactions *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/* The snapshot file is laid out as
+ *
+ *   snapshot_header
+ *   GncGUID        guids[n_guids]            index 0 is the null guid
+ *   snapshot_txn   transactions[n_transactions]
+ *   snapshot_split splits[n_splits]          grouped by transaction
+ *   gchar          heap[heap_size]
+ *
+ * All records are a multiple of 8 bytes long, so every table is aligned
+ * in the mapped file.  Transactions and splits refer to guids by index
+ * and to strings and kvp slots by offset into the heap; offset 0 means
+ * "not set".  Strings are nul-terminated and shared.  Slots are stored
+ * as a length followed by the frame, see heap_put_frame.  The checksum
+ * covers everything after the header.
+ *
+ * The header also holds the size and a SHA-256 digest of the data file
+ * the snapshot was taken from.  Times are not trusted: a file rewritten
+ * within the same second, or restored with its old time, keeps it. */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "gnc-engine.h"
+#include "gnc-commodity.h"
+#include "gnc-lot.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+#include "SplitP.h"
+#include "io-gncxml-snapshot.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+#define SNAPSHOT_MAGIC "GNCSNAP"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+/* zlib's crc32 takes a 32 bit length. */
+#define SNAPSHOT_CRC_CHUNK (1 << 30)
+#define SNAPSHOT_DIGEST_LEN 32
+#define SNAPSHOT_READ_CHUNK 65536
+
+typedef struct
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 byte_order;
+    gint64 source_size;
+    guint8 source_digest[SNAPSHOT_DIGEST_LEN];
+    guint32 n_guids;
+    guint32 n_transactions;
+    guint32 n_splits;
+    guint32 heap_size;
+    guint32 checksum;
+    guint32 unused;
+} snapshot_header;
+
+typedef struct
+{
+    gint64 date_posted_sec;
+    gint64 date_posted_nsec;
+    gint64 date_entered_sec;
+    gint64 date_entered_nsec;
+    guint32 guid;
+    guint32 currency_space;
+    guint32 currency_id;
+    guint32 num;
+    guint32 description;
+    guint32 slots;
+    guint32 first_split;
+    guint32 n_splits;
+} snapshot_txn;
+
+typedef struct
+{
+    gint64 value_num;
+    gint64 value_denom;
+    gint64 amount_num;
+    gint64 amount_denom;
+    gint64 reconcile_sec;
+    gint64 reconcile_nsec;
+    guint32 guid;
+    guint32 account;
+    guint32 lot;
+    guint32 memo;
+    guint32 action;
+    guint32 slots;
+    guint32 reconciled;
+    guint32 unused;
+} snapshot_split;
+
+struct gnc_xml_snapshot
+{
+    GMappedFile *file;
+    const snapshot_header *header;
+    const GncGUID *guids;
+    const snapshot_txn *txns;
+    const snapshot_split *splits;
+    const gchar *heap;
+
+    /* Filled in by gnc_xml_snapshot_check. */
+    gboolean checked;
+    Account **accounts;          /* by guid index */
+    GNCLot **lots;               /* by guid index */
+    gnc_commodity **currencies;  /* by transaction */
+};
+
+/* SHA-256 of the contents of datafile, as it is on disk, or NULL if it
+ * cannot be read. */
+static GChecksum *
+snapshot_source_checksum(const char *datafile)
+{
+    GChecksum *checksum;
+    FILE *in;
+    guchar *buf;
+    gsize n;
+    gboolean success;
+
+    in = g_fopen(datafile, "rb");
+    if (!in)
+        return NULL;
+
+    checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    buf = g_malloc(SNAPSHOT_READ_CHUNK);
+    while ((n = fread(buf, 1, SNAPSHOT_READ_CHUNK, in)) > 0)
+        g_checksum_update(checksum, buf, n);
+    success = !ferror(in);
+    fclose(in);
+    g_free(buf);
+
+    if (!success)
+    {
+        g_checksum_free(checksum);
+        return NULL;
+    }
+    return checksum;
+}
+
+static gboolean
+snapshot_source_digest(const char *datafile,
+                       guint8 digest[SNAPSHOT_DIGEST_LEN])
+{
+    GChecksum *checksum = snapshot_source_checksum(datafile);
+    gsize digest_len = SNAPSHOT_DIGEST_LEN;
+
+    if (!checksum)
+        return FALSE;
+    g_checksum_get_digest(checksum, digest, &digest_len);
+    g_checksum_free(checksum);
+    return digest_len == SNAPSHOT_DIGEST_LEN;
+}
+
+gchar *
+gnc_xml_file_digest(const char *filename)
+{
+    GChecksum *checksum = snapshot_source_checksum(filename);
+    gchar *digest;
+
+    if (!checksum)
+        return NULL;
+    digest = g_strdup(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+    return digest;
+}
+
+static uLong
+snapshot_crc(uLong crc, gconstpointer data, gsize length)
+{
+    const Bytef *bytes = data;
+
+    while (length > 0)
+    {
+        uInt chunk = (uInt) MIN(length, SNAPSHOT_CRC_CHUNK);
+
+        crc = crc32(crc, bytes, chunk);
+        bytes += chunk;
+        length -= chunk;
+    }
+
+    return crc;
+}
+
+/***********************************************************************/
+/* Kvp slots */
+
+static void
+heap_put_u32(GByteArray *heap, guint32 value)
+{
+    g_byte_array_append(heap, (const guint8*) &value, sizeof(value));
+}
+
+static void
+heap_put_i64(GByteArray *heap, gint64 value)
+{
+    g_byte_array_append(heap, (const guint8*) &value, sizeof(value));
+}
+
+static void
+heap_put_string(GByteArray *heap, const gchar *str)
+{
+    guint32 length = str ? strlen(str) : 0;
+
+    heap_put_u32(heap, length);
+    g_byte_array_append(heap, (const guint8*) (str ? str : ""), length + 1);
+}
+
+static void heap_put_frame(GByteArray *heap, KvpFrame *frame);
+
+static void
+heap_put_value(GByteArray *heap, const KvpValue *value)
+{
+    KvpValueType type = kvp_value_get_type(value);
+
+    heap_put_u32(heap, type);
+
+    switch (type)
+    {
+    case KVP_TYPE_GINT64:
+        heap_put_i64(heap, kvp_value_get_gint64(value));
+        break;
+    case KVP_TYPE_DOUBLE:
+    {
+        double d = kvp_value_get_double(value);
+        g_byte_array_append(heap, (const guint8*) &d, sizeof(d));
+        break;
+    }
+    case KVP_TYPE_NUMERIC:
+    {
+        gnc_numeric n = kvp_value_get_numeric(value);
+        heap_put_i64(heap, n.num);
+        heap_put_i64(heap, n.denom);
+        break;
+    }
+    case KVP_TYPE_STRING:
+        heap_put_string(heap, kvp_value_get_string(value));
+        break;
+    case KVP_TYPE_GUID:
+    {
+        const GncGUID *guid = kvp_value_get_guid(value);
+        g_byte_array_append(heap, (guid ? guid : guid_null())->data,
+                            GUID_DATA_SIZE);
+        break;
+    }
+    case KVP_TYPE_TIMESPEC:
+    {
+        Timespec ts = kvp_value_get_timespec(value);
+        heap_put_i64(heap, ts.tv_sec);
+        heap_put_i64(heap, ts.tv_nsec);
+        break;
+    }
+    case KVP_TYPE_BINARY:
+    {
+        guint64 size = 0;
+        void *data = kvp_value_get_binary(value, &size);
+        heap_put_i64(heap, size);
+        if (size > 0)
+            g_byte_array_append(heap, data, size);
+        break;
+    }
+    case KVP_TYPE_GLIST:
+    {
+        GList *node = kvp_value_get_glist(value);
+        heap_put_u32(heap, g_list_length(node));
+        for (; node; node = node->next)
+            heap_put_value(heap, node->data);
+        break;
+    }
+    case KVP_TYPE_FRAME:
+        heap_put_frame(heap, kvp_value_get_frame(value));
+        break;
+    case KVP_TYPE_GDATE:
+    {
+        GDate date = kvp_value_get_gdate(value);
+        heap_put_u32(heap, g_date_valid(&date) ? g_date_get_julian(&date) : 0);
+        break;
+    }
+    default:
+        PERR("unknown kvp value type %d", type);
+        break;
+    }
+}
+
+struct frame_writer
+{
+    GByteArray *heap;
+    guint32 count;
+};
+
+static void
+heap_put_slot(const gchar *key, KvpValue *value, gpointer data)
+{
+    struct frame_writer *writer = data;
+
+    writer->count++;
+    heap_put_string(writer->heap, key);
+    heap_put_value(writer->heap, value);
+}
+
+/* A frame is its number of slots followed by the key and the value of
+   each; values are their KvpValueType followed by the contents. */
+static void
+heap_put_frame(GByteArray *heap, KvpFrame *frame)
+{
+    struct frame_writer writer = { heap, 0 };
+    guint offset = heap->len;
+
+    heap_put_u32(heap, 0);
+    if (frame)
+        kvp_frame_for_each_slot(frame, heap_put_slot, &writer);
+    memcpy(heap->data + offset, &writer.count, sizeof(writer.count));
+}
+
+typedef struct
+{
+    const guchar *pos;
+    const guchar *end;
+    gboolean ok;
+} slot_reader;
+
+static gconstpointer
+reader_take(slot_reader *r, gsize length)
+{
+    const guchar *data = r->pos;
+
+    if (!r->ok || (gsize) (r->end - r->pos) < length)
+    {
+        r->ok = FALSE;
+        return NULL;
+    }
+
+    r->pos += length;
+    return data;
+}
+
+static guint32
+reader_u32(slot_reader *r)
+{
+    guint32 value = 0;
+    gconstpointer data = reader_take(r, sizeof(value));
+
+    if (data)
+        memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static gint64
+reader_i64(slot_reader *r)
+{
+    gint64 value = 0;
+    gconstpointer data = reader_take(r, sizeof(value));
+
+    if (data)
+        memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static const gchar *
+reader_string(slot_reader *r)
+{
+    guint32 length = reader_u32(r);
+    const gchar *str = reader_take(r, (gsize) length + 1);
+
+    if (str && str[length] != '\0')
+    {
+        r->ok = FALSE;
+        return NULL;
+    }
+    return str;
+}
+
+static void reader_frame(slot_reader *r, KvpFrame *frame);
+
+static KvpValue *
+reader_value(slot_reader *r)
+{
+    KvpValueType type = reader_u32(r);
+
+    if (!r->ok)
+        return NULL;
+
+    switch (type)
+    {
+    case KVP_TYPE_GINT64:
+    {
+        gint64 i = reader_i64(r);
+        return r->ok ? kvp_value_new_gint64(i) : NULL;
+    }
+    case KVP_TYPE_DOUBLE:
+    {
+        double d = 0;
+        gconstpointer data = reader_take(r, sizeof(d));
+        if (!data)
+            return NULL;
+        memcpy(&d, data, sizeof(d));
+        return kvp_value_new_double(d);
+    }
+    case KVP_TYPE_NUMERIC:
+    {
+        gint64 num = reader_i64(r);
+        gint64 denom = reader_i64(r);
+        return r->ok ? kvp_value_new_numeric(gnc_numeric_create(num, denom))
+               : NULL;
+    }
+    case KVP_TYPE_STRING:
+    {
+        const gchar *str = reader_string(r);
+        return str ? kvp_value_new_string(str) : NULL;
+    }
+    case KVP_TYPE_GUID:
+    {
+        GncGUID guid;
+        gconstpointer data = reader_take(r, GUID_DATA_SIZE);
+        if (!data)
+            return NULL;
+        memcpy(guid.data, data, GUID_DATA_SIZE);
+        return kvp_value_new_guid(&guid);
+    }
+    case KVP_TYPE_TIMESPEC:
+    {
+        Timespec ts;
+        ts.tv_sec = reader_i64(r);
+        ts.tv_nsec = reader_i64(r);
+        return r->ok ? kvp_value_new_timespec(ts) : NULL;
+    }
+    case KVP_TYPE_BINARY:
+    {
+        gint64 size = reader_i64(r);
+        gconstpointer data;
+        if (size < 0 || (guint64) size > G_MAXSIZE)
+            r->ok = FALSE;
+        data = reader_take(r, (gsize) size);
+        return r->ok ? kvp_value_new_binary(data, size) : NULL;
+    }
+    case KVP_TYPE_GLIST:
+    {
+        guint32 count = reader_u32(r);
+        GList *list = NULL;
+        guint32 i;
+
+        for (i = 0; i < count && r->ok; i++)
+        {
+            KvpValue *value = reader_value(r);
+            if (value)
+                list = g_list_prepend(list, value);
+        }
+        if (!r->ok)
+        {
+            kvp_glist_delete(list);
+            return NULL;
+        }
+        return kvp_value_new_glist_nc(g_list_reverse(list));
+    }
+    case KVP_TYPE_FRAME:
+    {
+        KvpFrame *frame = kvp_frame_new();
+
+        reader_frame(r, frame);
+        if (!r->ok)
+        {
+            kvp_frame_delete(frame);
+            return NULL;
+        }
+        return kvp_value_new_frame_nc(frame);
+    }
+    case KVP_TYPE_GDATE:
+    {
+        guint32 julian = reader_u32(r);
+        GDate date;
+
+        g_date_clear(&date, 1);
+        if (julian && g_date_valid_julian(julian))
+            g_date_set_julian(&date, julian);
+        return r->ok ? kvp_value_new_gdate(date) : NULL;
+    }
+    default:
+        r->ok = FALSE;
+        return NULL;
+    }
+}
+
+static void
+reader_frame(slot_reader *r, KvpFrame *frame)
+{
+    guint32 count = reader_u32(r);
+    guint32 i;
+
+    for (i = 0; i < count && r->ok; i++)
+    {
+        const gchar *key = reader_string(r);
+        KvpValue *value = reader_value(r);
+
+        if (!value)
+            continue;
+        if (key && *key)
+            kvp_frame_set_slot_nc(frame, key, value);
+        else
+            kvp_value_delete(value);
+    }
+}
+
+/***********************************************************************/
+/* Writing */
+
+typedef struct
+{
+    GArray *guids;
+    GHashTable *guid_index;      /* instance GncGUID -> index */
+    GArray *txns;
+    GArray *splits;
+    GByteArray *heap;
+    GHashTable *strings;         /* instance string -> heap offset */
+    gboolean ok;
+} snapshot_writer;
+
+static guint32
+writer_add_guid(snapshot_writer *w, const GncGUID *guid)
+{
+    guint32 index;
+
+    if (!guid || guid_equal(guid, guid_null()))
+        return 0;
+
+    index = GPOINTER_TO_UINT(g_hash_table_lookup(w->guid_index, guid));
+    if (index)
+        return index;
+
+    index = w->guids->len;
+    g_array_append_val(w->guids, *guid);
+    g_hash_table_insert(w->guid_index, (gpointer) guid,
+                        GUINT_TO_POINTER(index));
+    return index;
+}
+
+static guint32
+writer_add_string(snapshot_writer *w, const gchar *str)
+{
+    guint32 offset;
+    gsize length;
+
+    if (!str)
+        return 0;
+
+    offset = GPOINTER_TO_UINT(g_hash_table_lookup(w->strings, str));
+    if (offset)
+        return offset;
+
+    length = strlen(str) + 1;
+    if (length > G_MAXUINT32 - w->heap->len)
+    {
+        w->ok = FALSE;
+        return 0;
+    }
+
+    offset = w->heap->len;
+    g_byte_array_append(w->heap, (const guint8*) str, length);
+    g_hash_table_insert(w->strings, (gpointer) str, GUINT_TO_POINTER(offset));
+    return offset;
+}
+
+static guint32
+writer_add_slots(snapshot_writer *w, KvpFrame *frame)
+{
+    guint32 offset, length;
+
+    if (!frame || kvp_frame_is_empty(frame))
+        return 0;
+
+    offset = w->heap->len;
+    heap_put_u32(w->heap, 0);
+    heap_put_frame(w->heap, frame);
+    length = w->heap->len - offset - sizeof(length);
+    memcpy(w->heap->data + offset, &length, sizeof(length));
+    return offset;
+}
+
+/* Empty strings are left out, just as the xml writer leaves them out. */
+static guint32
+writer_add_text(snapshot_writer *w, const gchar *str)
+{
+    return (str && *str) ? writer_add_string(w, str) : 0;
+}
+
+static void
+writer_add_split(snapshot_writer *w, Split *split)
+{
+    Account *account = xaccSplitGetAccount(split);
+    GNCLot *lot = xaccSplitGetLot(split);
+    gnc_numeric value = xaccSplitGetValue(split);
+    gnc_numeric amount = xaccSplitGetAmount(split);
+    Timespec ts = xaccSplitRetDateReconciledTS(split);
+    snapshot_split rec;
+
+    memset(&rec, 0, sizeof(rec));
+
+    rec.guid = writer_add_guid(w, xaccSplitGetGUID(split));
+    rec.memo = writer_add_text(w, xaccSplitGetMemo(split));
+    rec.action = writer_add_text(w, xaccSplitGetAction(split));
+    rec.reconciled = (guchar) xaccSplitGetReconcile(split);
+    rec.reconcile_sec = ts.tv_sec;
+    rec.reconcile_nsec = ts.tv_nsec;
+    rec.value_num = value.num;
+    rec.value_denom = value.denom;
+    rec.amount_num = amount.num;
+    rec.amount_denom = amount.denom;
+    if (account)
+        rec.account = writer_add_guid(w, xaccAccountGetGUID(account));
+    if (lot)
+        rec.lot = writer_add_guid(w, gnc_lot_get_guid(lot));
+    rec.slots = writer_add_slots(w, xaccSplitGetSlots(split));
+
+    g_array_append_val(w->splits, rec);
+}
+
+static int
+writer_add_transaction(Transaction *trn, gpointer data)
+{
+    snapshot_writer *w = data;
+    gnc_commodity *currency = xaccTransGetCurrency(trn);
+    snapshot_txn rec;
+    Timespec ts;
+    GList *node;
+
+    memset(&rec, 0, sizeof(rec));
+
+    rec.guid = writer_add_guid(w, xaccTransGetGUID(trn));
+    if (currency)
+    {
+        rec.currency_space =
+            writer_add_string(w, gnc_commodity_get_namespace(currency));
+        rec.currency_id =
+            writer_add_string(w, gnc_commodity_get_mnemonic(currency));
+    }
+    rec.num = writer_add_text(w, xaccTransGetNum(trn));
+    rec.description = writer_add_string(w, xaccTransGetDescription(trn));
+    rec.slots = writer_add_slots(w, xaccTransGetSlots(trn));
+
+    ts = xaccTransRetDatePostedTS(trn);
+    rec.date_posted_sec = ts.tv_sec;
+    rec.date_posted_nsec = ts.tv_nsec;
+    ts = xaccTransRetDateEnteredTS(trn);
+    rec.date_entered_sec = ts.tv_sec;
+    rec.date_entered_nsec = ts.tv_nsec;
+
+    rec.first_split = w->splits->len;
+    for (node = xaccTransGetSplitList(trn); node; node = node->next)
+    {
+        writer_add_split(w, node->data);
+        rec.n_splits++;
+    }
+
+    g_array_append_val(w->txns, rec);
+
+    return w->ok ? 0 : -1;
+}
+
+static gboolean
+snapshot_fwrite(FILE *out, gconstpointer data, gsize length)
+{
+    return length == 0 || fwrite(data, 1, length, out) == length;
+}
+
+gboolean
+gnc_xml_snapshot_write(QofBook *book, const char *filename,
+                       const char *datafile)
+{
+    snapshot_writer w;
+    snapshot_header header;
+    struct stat data_stat;
+    gchar *tmpfile;
+    FILE *out = NULL;
+    gboolean success;
+    uLong crc;
+
+    g_return_val_if_fail(book && filename && datafile, FALSE);
+
+    ENTER("book=%p, filename=%s", book, filename);
+
+    memset(&header, 0, sizeof(header));
+    if (g_stat(datafile, &data_stat) != 0
+            || !snapshot_source_digest(datafile, header.source_digest))
+    {
+        LEAVE("no data file %s", datafile);
+        return FALSE;
+    }
+
+    w.guids = g_array_new(FALSE, FALSE, sizeof(GncGUID));
+    w.guid_index = g_hash_table_new(guid_hash_to_guint,
+                                    guid_g_hash_table_equal);
+    w.txns = g_array_new(FALSE, FALSE, sizeof(snapshot_txn));
+    w.splits = g_array_new(FALSE, FALSE, sizeof(snapshot_split));
+    w.heap = g_byte_array_new();
+    w.strings = g_hash_table_new(g_str_hash, g_str_equal);
+    w.ok = TRUE;
+
+    /* Index and offset 0 mean "not set". */
+    g_array_append_val(w.guids, *guid_null());
+    g_byte_array_append(w.heap, (const guint8*) "", 1);
+
+    xaccAccountTreeForEachTransaction(gnc_book_get_root_account(book),
+                                      writer_add_transaction, &w);
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.source_size = data_stat.st_size;
+    header.n_guids = w.guids->len;
+    header.n_transactions = w.txns->len;
+    header.n_splits = w.splits->len;
+    header.heap_size = w.heap->len;
+
+    crc = crc32(0L, Z_NULL, 0);
+    crc = snapshot_crc(crc, w.guids->data, (gsize) w.guids->len * sizeof(GncGUID));
+    crc = snapshot_crc(crc, w.txns->data, (gsize) w.txns->len * sizeof(snapshot_txn));
+    crc = snapshot_crc(crc, w.splits->data,
+                       (gsize) w.splits->len * sizeof(snapshot_split));
+    crc = snapshot_crc(crc, w.heap->data, w.heap->len);
+    header.checksum = crc;
+
+    /* Write a new file and move it into place, so that a reader never
+       sees half a snapshot. */
+    tmpfile = g_strconcat(filename, ".tmp", NULL);
+    if (w.ok)
+        out = g_fopen(tmpfile, "wb");
+
+    success = out
+              && snapshot_fwrite(out, &header, sizeof(header))
+              && snapshot_fwrite(out, w.guids->data,
+                                 (gsize) w.guids->len * sizeof(GncGUID))
+              && snapshot_fwrite(out, w.txns->data,
+                                 (gsize) w.txns->len * sizeof(snapshot_txn))
+              && snapshot_fwrite(out, w.splits->data,
+                                 (gsize) w.splits->len * sizeof(snapshot_split))
+              && snapshot_fwrite(out, w.heap->data, w.heap->len);
+
+    if (out && fclose(out) != 0)
+        success = FALSE;
+
+    if (success)
+    {
+#ifdef G_OS_WIN32
+        g_unlink(filename);
+#endif
+        success = (g_rename(tmpfile, filename) == 0);
+    }
+
+    if (!success)
+    {
+        PWARN("unable to write snapshot %s", filename);
+        g_unlink(tmpfile);
+    }
+
+    g_free(tmpfile);
+    g_array_free(w.guids, TRUE);
+    g_hash_table_destroy(w.guid_index);
+    g_array_free(w.txns, TRUE);
+    g_array_free(w.splits, TRUE);
+    g_byte_array_free(w.heap, TRUE);
+    g_hash_table_destroy(w.strings);
+
+    LEAVE("%u transactions, %u splits", header.n_transactions,
+          header.n_splits);
+    return success;
+}
+
+/***********************************************************************/
+/* Reading */
+
+static const gchar *
+snapshot_string(const gnc_xml_snapshot *snapshot, guint32 offset)
+{
+    return offset ? snapshot->heap + offset : NULL;
+}
+
+/* Every index and offset must lie within its table. */
+static gboolean
+snapshot_records_ok(const gnc_xml_snapshot *snapshot)
+{
+    const snapshot_header *header = snapshot->header;
+    guint32 i;
+
+    for (i = 0; i < header->n_transactions; i++)
+    {
+        const snapshot_txn *txn = &snapshot->txns[i];
+
+        if (txn->guid >= header->n_guids
+                || txn->currency_space >= header->heap_size
+                || txn->currency_id >= header->heap_size
+                || txn->num >= header->heap_size
+                || txn->description >= header->heap_size
+                || txn->slots >= header->heap_size
+                || txn->first_split > header->n_splits
+                || txn->n_splits > header->n_splits - txn->first_split)
+            return FALSE;
+    }
+
+    for (i = 0; i < header->n_splits; i++)
+    {
+        const snapshot_split *split = &snapshot->splits[i];
+
+        if (split->guid >= header->n_guids
+                || split->account >= header->n_guids
+                || split->lot >= header->n_guids
+                || split->memo >= header->heap_size
+                || split->action >= header->heap_size
+                || split->slots >= header->heap_size)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+gnc_xml_snapshot *
+gnc_xml_snapshot_open(const char *filename, const char *datafile)
+{
+    gnc_xml_snapshot *snapshot;
+    const snapshot_header *header;
+    GMappedFile *file;
+    GError *error = NULL;
+    struct stat data_stat;
+    guint8 digest[SNAPSHOT_DIGEST_LEN];
+    const gchar *contents;
+    gsize length;
+    guint64 expected;
+
+    g_return_val_if_fail(filename && datafile, NULL);
+
+    if (g_stat(datafile, &data_stat) != 0)
+        return NULL;
+
+    file = g_mapped_file_new(filename, FALSE, &error);
+    if (!file)
+    {
+        PINFO("no snapshot: %s", error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    contents = g_mapped_file_get_contents(file);
+    length = g_mapped_file_get_length(file);
+    header = (const snapshot_header*) contents;
+
+    if (length < sizeof(snapshot_header)
+            || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+            || header->version != SNAPSHOT_VERSION
+            || header->byte_order != SNAPSHOT_BYTE_ORDER)
+    {
+        PINFO("%s is not a snapshot this program can use", filename);
+        goto reject;
+    }
+
+    /* The size is a cheap first test; only the digest is conclusive. */
+    if (header->source_size != (gint64) data_stat.st_size
+            || !snapshot_source_digest(datafile, digest)
+            || memcmp(header->source_digest, digest, sizeof(digest)) != 0)
+    {
+        PINFO("snapshot %s is out of date", filename);
+        goto reject;
+    }
+
+    expected = sizeof(snapshot_header)
+               + (guint64) header->n_guids * sizeof(GncGUID)
+               + (guint64) header->n_transactions * sizeof(snapshot_txn)
+               + (guint64) header->n_splits * sizeof(snapshot_split)
+               + header->heap_size;
+
+    if (expected != length || header->n_guids == 0 || header->heap_size == 0
+            || contents[length - 1] != '\0'
+            || snapshot_crc(crc32(0L, Z_NULL, 0),
+                            contents + sizeof(snapshot_header),
+                            length - sizeof(snapshot_header))
+            != header->checksum)
+    {
+        PWARN("snapshot %s is damaged", filename);
+        goto reject;
+    }
+
+    snapshot = g_new0(gnc_xml_snapshot, 1);
+    snapshot->file = file;
+    snapshot->header = header;
+    snapshot->guids = (const GncGUID*) (contents + sizeof(snapshot_header));
+    snapshot->txns = (const snapshot_txn*) (snapshot->guids + header->n_guids);
+    snapshot->splits =
+        (const snapshot_split*) (snapshot->txns + header->n_transactions);
+    snapshot->heap = (const gchar*) (snapshot->splits + header->n_splits);
+
+    if (!snapshot_records_ok(snapshot))
+    {
+        PWARN("snapshot %s is damaged", filename);
+        gnc_xml_snapshot_close(snapshot);
+        return NULL;
+    }
+
+    return snapshot;
+
+reject:
+    g_mapped_file_unref(file);
+    return NULL;
+}
+
+guint
+gnc_xml_snapshot_count_transactions(const gnc_xml_snapshot *snapshot)
+{
+    g_return_val_if_fail(snapshot, 0);
+
+    return snapshot->header->n_transactions;
+}
+
+gboolean
+gnc_xml_snapshot_check(gnc_xml_snapshot *snapshot, QofBook *book)
+{
+    const snapshot_header *header;
+    gnc_commodity_table *table;
+    guint32 i, j;
+
+    g_return_val_if_fail(snapshot && book, FALSE);
+
+    header = snapshot->header;
+    table = gnc_commodity_table_get_table(book);
+
+    g_free(snapshot->accounts);
+    g_free(snapshot->lots);
+    g_free(snapshot->currencies);
+    snapshot->accounts = g_new0(Account*, header->n_guids);
+    snapshot->lots = g_new0(GNCLot*, header->n_guids);
+    snapshot->currencies = g_new0(gnc_commodity*, header->n_transactions);
+    snapshot->checked = FALSE;
+
+    for (i = 0; i < header->n_transactions; i++)
+    {
+        const snapshot_txn *txn = &snapshot->txns[i];
+
+        if (txn->currency_space || txn->currency_id)
+        {
+            const snapshot_txn *prev = i > 0 ? &snapshot->txns[i - 1] : NULL;
+            gnc_commodity *currency = NULL;
+
+            /* Strings are shared, so equal offsets mean equal names. */
+            if (prev && prev->currency_space == txn->currency_space
+                    && prev->currency_id == txn->currency_id)
+                currency = snapshot->currencies[i - 1];
+            else if (table && txn->currency_space && txn->currency_id)
+                currency = gnc_commodity_table_lookup(
+                               table,
+                               snapshot_string(snapshot, txn->currency_space),
+                               snapshot_string(snapshot, txn->currency_id));
+
+            if (!currency)
+            {
+                PINFO("snapshot currency not in book");
+                return FALSE;
+            }
+            snapshot->currencies[i] = currency;
+        }
+
+        for (j = txn->first_split; j < txn->first_split + txn->n_splits; j++)
+        {
+            const snapshot_split *split = &snapshot->splits[j];
+
+            if (split->account && !snapshot->accounts[split->account])
+            {
+                snapshot->accounts[split->account] =
+                    xaccAccountLookup(&snapshot->guids[split->account], book);
+            }
+            if (!snapshot->accounts[split->account])
+            {
+                PINFO("snapshot account not in book");
+                return FALSE;
+            }
+
+            if (split->lot && !snapshot->lots[split->lot])
+            {
+                snapshot->lots[split->lot] =
+                    gnc_lot_lookup(&snapshot->guids[split->lot], book);
+                if (!snapshot->lots[split->lot])
+                {
+                    PINFO("snapshot lot not in book");
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    snapshot->checked = TRUE;
+    return TRUE;
+}
+
+static void
+snapshot_load_slots(const gnc_xml_snapshot *snapshot, guint32 offset,
+                    KvpFrame *frame)
+{
+    const guchar *blob = (const guchar*) snapshot->heap + offset;
+    gsize available = snapshot->header->heap_size - offset;
+    guint32 length;
+    slot_reader r;
+
+    if (available < sizeof(length))
+    {
+        PERR("damaged slots in snapshot");
+        return;
+    }
+
+    memcpy(&length, blob, sizeof(length));
+    if (available - sizeof(length) < length)
+    {
+        PERR("damaged slots in snapshot");
+        return;
+    }
+
+    r.pos = blob + sizeof(length);
+    r.end = r.pos + length;
+    r.ok = TRUE;
+    reader_frame(&r, frame);
+
+    if (!r.ok || r.pos != r.end)
+        PERR("damaged slots in snapshot");
+}
+
+static Split *
+snapshot_load_split(const gnc_xml_snapshot *snapshot,
+                    const snapshot_split *rec, QofBook *book)
+{
+    Split *split = xaccMallocSplit(book);
+
+    if (rec->guid)
+        xaccSplitSetGUID(split, &snapshot->guids[rec->guid]);
+    if (rec->memo)
+        xaccSplitSetMemo(split, snapshot_string(snapshot, rec->memo));
+    if (rec->action)
+        xaccSplitSetAction(split, snapshot_string(snapshot, rec->action));
+    xaccSplitSetReconcile(split, (char) rec->reconciled);
+    if (rec->reconcile_sec || rec->reconcile_nsec)
+    {
+        Timespec ts;
+
+        ts.tv_sec = rec->reconcile_sec;
+        ts.tv_nsec = rec->reconcile_nsec;
+        xaccSplitSetDateReconciledTS(split, &ts);
+    }
+    xaccSplitSetValue(split, gnc_numeric_create(rec->value_num,
+                      rec->value_denom));
+    xaccSplitSetAmount(split, gnc_numeric_create(rec->amount_num,
+                       rec->amount_denom));
+    xaccAccountInsertSplit(snapshot->accounts[rec->account], split);
+    if (rec->lot)
+        gnc_lot_add_split(snapshot->lots[rec->lot], split);
+    if (rec->slots)
+        snapshot_load_slots(snapshot, rec->slots, xaccSplitGetSlots(split));
+
+    return split;
+}
+
+void
+gnc_xml_snapshot_load(gnc_xml_snapshot *snapshot, QofBook *book,
+                      gnc_xml_snapshot_cb cb, gpointer user_data)
+{
+    guint32 i, j;
+
+    g_return_if_fail(snapshot && book);
+    g_return_if_fail(snapshot->checked);
+
+    ENTER("snapshot=%p, book=%p", snapshot, book);
+
+    for (i = 0; i < snapshot->header->n_transactions; i++)
+    {
+        const snapshot_txn *rec = &snapshot->txns[i];
+        Transaction *trn = xaccMallocTransaction(book);
+        Timespec ts;
+
+        xaccTransBeginEdit(trn);
+
+        if (rec->guid)
+            xaccTransSetGUID(trn, &snapshot->guids[rec->guid]);
+        if (snapshot->currencies[i])
+            xaccTransSetCurrency(trn, snapshot->currencies[i]);
+        if (rec->num)
+            xaccTransSetNum(trn, snapshot_string(snapshot, rec->num));
+
+        ts.tv_sec = rec->date_posted_sec;
+        ts.tv_nsec = rec->date_posted_nsec;
+        xaccTransSetDatePostedTS(trn, &ts);
+        ts.tv_sec = rec->date_entered_sec;
+        ts.tv_nsec = rec->date_entered_nsec;
+        xaccTransSetDateEnteredTS(trn, &ts);
+
+        if (rec->description)
+            xaccTransSetDescription(trn,
+                                    snapshot_string(snapshot, rec->description));
+        if (rec->slots)
+            snapshot_load_slots(snapshot, rec->slots, xaccTransGetSlots(trn));
+
+        for (j = rec->first_split; j < rec->first_split + rec->n_splits; j++)
+            xaccTransAppendSplit(trn, snapshot_load_split(snapshot,
+                                 &snapshot->splits[j], book));
+
+        xaccTransCommitEdit(trn);
+
+        if (cb)
+            cb(trn, user_data);
+    }
+
+    LEAVE("%u transactions", snapshot->header->n_transactions);
+}
+
+void
+gnc_xml_snapshot_close(gnc_xml_snapshot *snapshot)
+{
+    if (!snapshot)
+        return;
+
+    g_mapped_file_unref(snapshot->file);
+    g_free(snapshot->accounts);
+    g_free(snapshot->lots);
+    g_free(snapshot->currencies);
+    g_free(snapshot);
+}
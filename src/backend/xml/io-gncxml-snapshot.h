@@ -0,0 +1,78 @@
+/********************************************************************\
+ * io-gncxml-snapshot.h -- binary cache of an xml file's transactions *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/** @file io-gncxml-snapshot.h
+ *  @brief Memory-mappable snapshot of the transactions of an xml file.
+ *
+ *  Converting the transactions is the bulk of the work of loading a
+ *  large xml file.  A snapshot holds the same transactions in a flat
+ *  binary form which is mapped into memory and turned into engine
+ *  objects without any parsing.  It records the size and a SHA-256
+ *  digest of the data file it was taken from, and is ignored as soon
+ *  as these no longer match.  Checking the digest reads the whole data
+ *  file once more, which costs far less than parsing it.
+ *
+ *  The snapshot is a cache: it uses the byte order and alignment of
+ *  the host which wrote it, and any snapshot that does not check out
+ *  is simply not used.
+ */
+
+#ifndef IO_GNCXML_SNAPSHOT_H
+#define IO_GNCXML_SNAPSHOT_H
+
+#include <glib.h>
+
+#include "qof.h"
+#include "Transaction.h"
+
+typedef struct gnc_xml_snapshot gnc_xml_snapshot;
+
+typedef void (*gnc_xml_snapshot_cb)(Transaction *trn, gpointer user_data);
+
+/** Write the transactions of the account tree of book to filename, as
+ *  taken from datafile.  datafile must already hold them. */
+gboolean gnc_xml_snapshot_write(QofBook *book, const char *filename,
+                                const char *datafile);
+
+/** Map the snapshot in filename.  Returns NULL if there is none, if it
+ *  is damaged, or if it was not taken from datafile as it is now. */
+gnc_xml_snapshot *gnc_xml_snapshot_open(const char *filename,
+                                        const char *datafile);
+
+guint gnc_xml_snapshot_count_transactions(const gnc_xml_snapshot *snapshot);
+
+/** Check that the accounts, lots and currencies the transactions refer
+ *  to are all in book.  Must succeed before gnc_xml_snapshot_load. */
+gboolean gnc_xml_snapshot_check(gnc_xml_snapshot *snapshot, QofBook *book);
+
+/** Create the transactions in book, handing each one to cb. */
+void gnc_xml_snapshot_load(gnc_xml_snapshot *snapshot, QofBook *book,
+                           gnc_xml_snapshot_cb cb, gpointer user_data);
+
+void gnc_xml_snapshot_close(gnc_xml_snapshot *snapshot);
+
+/** The SHA-256 digest of the contents of filename in hex, the same one
+ *  a snapshot records of its data file, or NULL if filename cannot be
+ *  read.  The caller frees it with g_free(). */
+gchar *gnc_xml_file_digest(const char *filename);
+
+#endif /* IO_GNCXML_SNAPSHOT_H */
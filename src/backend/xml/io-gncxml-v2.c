@@ -24,6 +24,7 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
@@ -42,6 +43,7 @@
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
+#include "io-gncxml-snapshot.h"
 
 #include "sixtp.h"
 #include "sixtp-parsers.h"
@@ -80,6 +82,8 @@ typedef struct
     gchar *filename;
     gchar *perms;
     gboolean compress;
+    gint level;    /* zlib compression level, or Z_DEFAULT_COMPRESSION */
+    gint workers;  /* more than one selects block-parallel compression */
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -91,6 +95,7 @@ struct file_backend
     const char    * tag;
     sixtp         * parser;
     FILE          * out;
+    xmlOutputBufferPtr xml_out;
     QofBook       * book;
 };
 
@@ -678,6 +683,106 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+static gboolean is_gzipped_file(const gchar *name);
+static void parse_gz_push_handler(xmlParserCtxtPtr xml_context,
+                                  const gchar *filename);
+
+static void
+snapshot_add_transaction(Transaction *trn, gpointer data)
+{
+    add_transaction_local(data, trn);
+}
+
+/* Take all the transactions from the snapshot and skip those in the
+   file, provided the snapshot fits what has been read so far. */
+static void
+load_snapshot_transactions(gxpf_data *gdata)
+{
+    sixtp_gdv2 *gd = gdata->parsedata;
+    gnc_xml_snapshot *snapshot = gd->snapshot;
+    int total = gd->counter.transactions_total;
+
+    gd->snapshot = NULL;
+
+    if ((total == 0
+            || total == (int) gnc_xml_snapshot_count_transactions(snapshot))
+            && gnc_xml_snapshot_check(snapshot, gd->book))
+    {
+        gnc_xml_snapshot_load(snapshot, gd->book, snapshot_add_transaction, gd);
+        gdata->skip_transactions = TRUE;
+    }
+    else
+    {
+        PINFO("snapshot does not fit the file, reading the transactions");
+    }
+
+    gnc_xml_snapshot_close(snapshot);
+}
+
+/* Count an element of the book.  The elements of each type come
+   together in the file, so the profile is charged once per run of like
+   elements, with the wall time of the whole run, rather than once per
+   element: with the transaction pipeline the conversion of one
+   transaction overlaps the parsing of the next, so only the run as a
+   whole, which ends with the pipeline flushed, has a meaningful time.
+   A NULL tag ends the last run. */
+static void
+profile_element(sixtp_gdv2 *gd, const gchar *tag)
+{
+    gint64 now;
+
+    if (!gd->profiling)
+        return;
+    if (tag && g_strcmp0(tag, gd->profile_tag) == 0)
+    {
+        gd->profile_count++;
+        return;
+    }
+
+    now = qof_profile_now();
+    if (gd->profile_tag)
+        qof_profile_add_objects(gd->profile_tag, gd->profile_count,
+                                now - gd->profile_start);
+    g_free(gd->profile_tag);
+    gd->profile_tag = g_strdup(tag);
+    gd->profile_count = 1;
+    gd->profile_start = now;
+}
+
+/* Before any element other than a transaction, deliver the
+   transactions still being converted, as it may refer to them.  Before
+   the first transaction, which comes after the accounts and lots it
+   refers to, load the snapshot if there is one. */
+static gboolean
+txn_before_child(gpointer data_for_children,
+                 GSList* data_from_children, GSList* sibling_data,
+                 gpointer parent_data, gpointer global_data,
+                 gpointer *result, const gchar *tag,
+                 const gchar *child_tag)
+{
+    gxpf_data *gdata = (gxpf_data*)global_data;
+    sixtp_gdv2 *gd = gdata->parsedata;
+
+    if (g_strcmp0(child_tag, TRANSACTION_TAG) != 0)
+    {
+        if (gdata->txn_pipeline)
+            gnc_txn_pipeline_flush(gdata->txn_pipeline, gdata);
+        profile_element(gd, child_tag);
+    }
+    else
+    {
+        profile_element(gd, child_tag);
+        if (gd->snapshot)
+        {
+            gint64 start = qof_profile_now();
+            load_snapshot_transactions(gdata);
+            qof_profile_end_phase("snapshot load", start);
+        }
+    }
+
+    return TRUE;
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full(
     FileBackend *fbe, QofBook *book,
@@ -693,6 +798,9 @@ qof_session_load_from_xml_file_v2_full(
     struct file_backend be_data;
     gboolean retval;
     char *v2type = NULL;
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+    gint64 phase_start;
 
     gd = gnc_sixtp_gdv2_new(book, FALSE, file_rw_feedback, be->percentage);
 
@@ -700,6 +808,9 @@ qof_session_load_from_xml_file_v2_full(
     main_parser = sixtp_new();
     book_parser = sixtp_new();
 
+    sixtp_set_before_child(main_parser, txn_before_child);
+    sixtp_set_before_child(book_parser, txn_before_child);
+
     if (type == GNC_BOOK_XML2_FILE)
         v2type = g_strdup(GNC_V2_STRING);
 
@@ -760,24 +871,48 @@ qof_session_load_from_xml_file_v2_full(
     xaccLogDisable ();
     xaccDisableDataScrubbing();
 
-    if (push_handler)
-    {
-        gpointer parse_result = NULL;
-        gxpf_data gpdata;
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+    gpdata.txn_pipeline =
+        gnc_txn_pipeline_new(gnc_txn_pipeline_default_workers());
+    gpdata.skip_transactions = FALSE;
 
-        gpdata.cb = generic_callback;
-        gpdata.parsedata = gd;
-        gpdata.bookdata = book;
+    if (!push_handler && fbe->snapshotfile)
+        gd->snapshot = gnc_xml_snapshot_open(fbe->snapshotfile, fbe->fullpath);
 
+    gd->profiling = qof_profile_enabled();
+    phase_start = qof_profile_now();
+    if (push_handler)
+    {
         retval = sixtp_parse_push(top_parser, push_handler, push_user_data,
                                   NULL, &gpdata, &parse_result);
     }
+    else if (gpdata.txn_pipeline && is_gzipped_file(fbe->fullpath))
+    {
+        /* Decompress on a thread of its own rather than in libxml2. */
+        retval = sixtp_parse_push(top_parser,
+                                  (sixtp_push_handler) parse_gz_push_handler,
+                                  fbe->fullpath, NULL, &gpdata, &parse_result);
+    }
     else
     {
-        retval = gnc_xml_parse_file(top_parser, fbe->fullpath,
-                                    generic_callback, gd, book);
+        retval = sixtp_parse_file(top_parser, fbe->fullpath,
+                                  NULL, &gpdata, &parse_result);
     }
 
+    if (gpdata.txn_pipeline)
+    {
+        gnc_txn_pipeline_flush(gpdata.txn_pipeline, &gpdata);
+        gnc_txn_pipeline_destroy(gpdata.txn_pipeline);
+    }
+    profile_element(gd, NULL);
+    qof_profile_end_phase("parse", phase_start);
+
+    /* Left over if the file has no transactions. */
+    gnc_xml_snapshot_close(gd->snapshot);
+    gd->snapshot = NULL;
+
     if (!retval)
     {
         sixtp_destroy(top_parser);
@@ -797,26 +932,43 @@ qof_session_load_from_xml_file_v2_full(
     qof_book_mark_session_saved (book);
 
     /* Call individual scrub functions */
+    phase_start = qof_profile_now();
     memset(&be_data, 0, sizeof(be_data));
     be_data.book = book;
     qof_object_foreach_backend (GNC_FILE_BACKEND, scrub_cb, &be_data);
 
-    /* fix price quote sources */
+    /* Fix price quote sources, account and transaction commodities and
+     * split amount/value, unless the book was saved clean. */
     root = gnc_book_get_root_account(book);
-    xaccAccountTreeScrubQuoteSources (root, gnc_commodity_table_get_table(book));
-
-    /* Fix account and transaction commodities */
-    xaccAccountTreeScrubCommodities (root);
-
-    /* Fix split amount/value */
-    xaccAccountTreeScrubSplits (root);
+    if (fbe->deferred_scrub && xaccBookIsScrubbed(book))
+    {
+        PINFO("book was saved clean, not scrubbing it");
+    }
+    else
+    {
+        xaccBookScrubAfterLoad(book, NULL);
+        if (fbe->deferred_scrub)
+            xaccBookMarkScrubbed(book);
+    }
+    qof_profile_end_phase("scrub", phase_start);
 
     /* commit all groups, this completes the BeginEdit started when the
-     * account_end_handler finished reading the account.
+     * account_end_handler finished reading the account.  This is where
+     * the splits are sorted and the balances computed.
      */
+    phase_start = qof_profile_now();
     gnc_account_foreach_descendant(root,
                                    (AccountCb) xaccAccountCommitEdit,
                                    NULL);
+    qof_profile_end_phase("sort and balance accounts", phase_start);
+
+    /* Take a snapshot for the next load, unless this one came from it. */
+    if (!push_handler && fbe->snapshotfile && !gpdata.skip_transactions)
+    {
+        phase_start = qof_profile_now();
+        gnc_xml_snapshot_write(book, fbe->snapshotfile, fbe->fullpath);
+        qof_profile_end_phase("snapshot write", phase_start);
+    }
 
     /* start logging again */
     xaccLogEnable ();
@@ -946,10 +1098,25 @@ write_data_cb (const char *type, gpointer data_p, gpointer be_data_p)
         (data->write)(be_data->out, be_data->book);
 }
 
+typedef gboolean (*write_part_fn)(FILE *out, QofBook *book, sixtp_gdv2 *gd);
+
+/* Write one part of the book, reporting how long it took per object. */
+static gboolean
+write_profiled(FILE *out, QofBook *book, sixtp_gdv2 *gd,
+               write_part_fn write_part, const gchar *type, gint64 count)
+{
+    gint64 start = qof_profile_now();
+    gboolean success = write_part(out, book, gd);
+
+    qof_profile_add_objects(type, count, qof_profile_now() - start);
+    return success;
+}
+
 static gboolean
 write_book(FILE *out, QofBook *book, sixtp_gdv2 *gd)
 {
     struct file_backend be_data;
+    gint64 start;
 
 #ifdef IMPLEMENT_BOOK_DOM_TREES_LATER
     /* We can't just blast out the dom tree, because the dom tree
@@ -1005,21 +1172,35 @@ write_book(FILE *out, QofBook *book, sixtp_gdv2 *gd)
     qof_object_foreach_backend (GNC_FILE_BACKEND, write_counts_cb, &be_data);
 
     if (ferror(out)
-            || !write_commodities(out, book, gd)
-            || !write_pricedb(out, book, gd)
-            || !write_accounts(out, book, gd)
-            || !write_transactions(out, book, gd)
-            || !write_template_transaction_data(out, book, gd)
-            || !write_schedXactions(out, book, gd))
+            || !write_profiled(out, book, gd, write_commodities, "commodity",
+                               gd->counter.commodities_total)
+            || !write_profiled(out, book, gd, write_pricedb, "price",
+                               gnc_pricedb_get_num_prices(
+                                   gnc_pricedb_get_db(book)))
+            || !write_profiled(out, book, gd, write_accounts, "account",
+                               gd->counter.accounts_total)
+            || !write_profiled(out, book, gd, write_transactions, "transaction",
+                               gd->counter.transactions_total)
+            || !write_profiled(out, book, gd, write_template_transaction_data,
+                               "template account",
+                               gnc_account_n_descendants(
+                                   gnc_book_get_template_root(book)))
+            || !write_profiled(out, book, gd, write_schedXactions,
+                               "schedxaction", gd->counter.schedXactions_total))
 
         return FALSE;
 
+    start = qof_profile_now();
     qof_collection_foreach(qof_book_get_collection(book, GNC_ID_BUDGET),
                            write_budget, &be_data);
+    qof_profile_add_objects("budget", gd->counter.budgets_total,
+                            qof_profile_now() - start);
     if (ferror(out))
         return FALSE;
 
+    start = qof_profile_now();
     qof_object_foreach_backend (GNC_FILE_BACKEND, write_data_cb, &be_data);
+    qof_profile_end_phase("write other objects", start);
     if (ferror(out))
         return FALSE;
 
@@ -1104,14 +1285,9 @@ static int
 xml_add_trn_data(Transaction *t, gpointer data)
 {
     struct file_backend *be_data = data;
-    xmlNodePtr node;
-
-    node = gnc_transaction_dom_tree_create(t);
-
-    xmlElemDump(be_data->out, NULL, node);
-    xmlFreeNode(node);
 
-    if (ferror(be_data->out) || fprintf(be_data->out, "\n") < 0)
+    if (!gnc_transaction_write_xml(be_data->xml_out, t) ||
+            xmlOutputBufferWrite(be_data->xml_out, 1, "\n") < 0)
         return -1;
 
     be_data->gd->counter.transactions_loaded++;
@@ -1119,34 +1295,49 @@ xml_add_trn_data(Transaction *t, gpointer data)
     return 0;
 }
 
+/* Write all the transactions of the account tree below root through
+   one buffered output stream. */
 static gboolean
-write_transactions(FILE *out, QofBook *book, sixtp_gdv2 *gd)
+write_account_tree_transactions(FILE *out, Account *root, sixtp_gdv2 *gd)
 {
     struct file_backend be_data;
+    gboolean success;
 
     be_data.out = out;
     be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction(gnc_book_get_root_account(book),
-                   xml_add_trn_data,
-                   (gpointer) &be_data);
+    be_data.xml_out = xmlOutputBufferCreateFile(out, NULL);
+    if (!be_data.xml_out)
+        return FALSE;
+
+    success = (0 == xaccAccountTreeForEachTransaction(root, xml_add_trn_data,
+               (gpointer) &be_data));
+
+    /* Flushes, but does not close, out. */
+    if (xmlOutputBufferClose(be_data.xml_out) < 0)
+        success = FALSE;
+
+    return success && !ferror(out);
+}
+
+static gboolean
+write_transactions(FILE *out, QofBook *book, sixtp_gdv2 *gd)
+{
+    return write_account_tree_transactions(out,
+                                           gnc_book_get_root_account(book),
+                                           gd);
 }
 
 static gboolean
 write_template_transaction_data( FILE *out, QofBook *book, sixtp_gdv2 *gd )
 {
     Account *ra;
-    struct file_backend be_data;
-
-    be_data.out = out;
-    be_data.gd = gd;
 
     ra = gnc_book_get_template_root(book);
     if ( gnc_account_n_descendants(ra) > 0 )
     {
         if (fprintf(out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
                 || !write_account_tree(out, ra, gd)
-                || xaccAccountTreeForEachTransaction(ra, xml_add_trn_data, (gpointer)&be_data)
+                || !write_account_tree_transactions(out, ra, gd)
                 || fprintf(out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
 
             return FALSE;
@@ -1225,11 +1416,14 @@ do_write_namespace_cb (const char *type, gpointer data_p, gpointer file_p)
         (data->ns)(out);
 }
 
+/* Write the xml declaration and the start tag of the root element,
+ * root_start being its name and any attributes, followed by all our
+ * namespace declarations. */
 static gboolean
-write_v2_header (FILE *out)
+write_root_header (FILE *out, const char *root_start)
 {
     if (fprintf(out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
-            || fprintf(out, "<" GNC_V2_STRING) < 0
+            || fprintf(out, "<%s", root_start) < 0
 
             || !gnc_xml2_write_namespace_decl (out, "gnc")
             || !gnc_xml2_write_namespace_decl (out, "act")
@@ -1267,7 +1461,7 @@ gnc_book_write_to_xml_filehandle_v2(QofBook *book, FILE *out)
 
     if (!out) return FALSE;
 
-    if (!write_v2_header(out)
+    if (!write_root_header(out, GNC_V2_STRING)
             || !write_counts(out, "book", 1, NULL))
         return FALSE;
 
@@ -1311,7 +1505,7 @@ gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *book, FILE
     table = gnc_commodity_table_get_table(book);
     ncom = gnc_commodity_table_get_size(table);
 
-    if (!write_v2_header(out)
+    if (!write_root_header(out, GNC_V2_STRING)
             || !write_counts(out, "commodity", ncom, "account", nacc, NULL))
         return FALSE;
 
@@ -1330,6 +1524,293 @@ gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *book, FILE
 
 #define BUFLEN 4096
 
+/* Parallel compression, in the manner of pigz: the input is cut into
+ * blocks of GZ_BLOCK_SIZE which are deflated concurrently, each primed
+ * with the last GZ_DICT_SIZE bytes of its predecessor and ended with a
+ * sync flush so that the raw deflate streams can simply be concatenated.
+ * The result is a single ordinary gzip member. */
+#define GZ_BLOCK_SIZE (128 * 1024)
+#define GZ_DICT_SIZE  (32 * 1024)
+
+typedef struct
+{
+    gint64 seq;
+    gint level;
+    Bytef *data;
+    gsize len;
+    Bytef *dict;
+    gsize dict_len;
+    Bytef *out;
+    gsize out_len;
+    gboolean ok;
+} gz_block_t;
+
+typedef struct
+{
+    GThreadPool *pool;
+    GAsyncQueue *done;
+    GHashTable *ready;      /* seq -> gz_block_t, arrived out of order */
+    gint64 next_seq;        /* next block to be written */
+    gint pending;           /* submitted but not yet written */
+    gboolean failed;
+} gz_compressor_t;
+
+static gint
+gz_default_level(void)
+{
+    const gchar *env = g_getenv("GNC_XML_COMPRESSION_LEVEL");
+
+    if (env && *env >= '0' && *env <= '9' && env[1] == '\0')
+        return *env - '0';
+    return Z_DEFAULT_COMPRESSION;
+}
+
+static gint
+gz_default_workers(void)
+{
+    const gchar *env = g_getenv("GNC_XML_SAVE_THREADS");
+    gint processors = 1;
+
+    if (env)
+        return CLAMP(atoi(env), 1, 64);
+
+#ifdef HAVE_GLIB_2_36
+    processors = g_get_num_processors();
+#endif
+    return CLAMP(processors, 1, 8);
+}
+
+static void
+gz_block_free(gz_block_t *block)
+{
+    g_free(block->data);
+    g_free(block->dict);
+    g_free(block->out);
+    g_free(block);
+}
+
+/* Thread pool function: deflate one block into block->out. */
+static void
+gz_block_deflate(gpointer data, gpointer user_data)
+{
+    gz_block_t *block = data;
+    GAsyncQueue *done = user_data;
+    z_stream strm;
+    gsize size;
+    gint zval;
+    gint64 start = qof_profile_now();
+
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, block->level, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        g_async_queue_push(done, block);
+        return;
+    }
+
+    if (block->dict_len)
+        deflateSetDictionary(&strm, block->dict, block->dict_len);
+
+    /* deflateBound covers Z_FINISH; leave room for the sync marker. */
+    size = deflateBound(&strm, block->len) + 16;
+    block->out = g_malloc(size);
+    strm.next_in = block->data;
+    strm.avail_in = block->len;
+    strm.next_out = block->out;
+    strm.avail_out = size;
+
+    do
+    {
+        if (strm.avail_out == 0)
+        {
+            block->out = g_realloc(block->out, size * 2);
+            strm.next_out = block->out + size;
+            strm.avail_out = size;
+            size *= 2;
+        }
+        zval = deflate(&strm, Z_SYNC_FLUSH);
+    }
+    while (zval == Z_OK && strm.avail_out == 0);
+
+    /* Z_BUF_ERROR just means the flush had already completed when the
+     * output buffer happened to fill up exactly. */
+    block->ok = ((zval == Z_OK || zval == Z_BUF_ERROR) && strm.avail_in == 0);
+    block->out_len = size - strm.avail_out;
+    deflateEnd(&strm);
+    qof_profile_end_phase("compress", start);
+
+    g_async_queue_push(done, block);
+}
+
+/* Write the finished blocks that are next in line.  Waits for the
+ * workers until no more than max_pending blocks are outstanding. */
+static gboolean
+gz_write_blocks(gz_compressor_t *gz, FILE *out, gint max_pending)
+{
+    gz_block_t *block;
+
+    while (gz->pending > 0)
+    {
+        if (gz->pending > max_pending)
+            block = g_async_queue_pop(gz->done);
+        else if ((block = g_async_queue_try_pop(gz->done)) == NULL)
+            break;
+
+        g_hash_table_insert(gz->ready, &block->seq, block);
+
+        while ((block = g_hash_table_lookup(gz->ready, &gz->next_seq)) != NULL)
+        {
+            g_hash_table_remove(gz->ready, &gz->next_seq);
+            gz->next_seq++;
+            gz->pending--;
+
+            if (!gz->failed
+                    && (!block->ok
+                        || fwrite(block->out, 1, block->out_len, out)
+                        != block->out_len))
+                gz->failed = TRUE;
+            gz_block_free(block);
+        }
+    }
+
+    return !gz->failed;
+}
+
+static gboolean
+gz_write_le32(FILE *out, guint32 value)
+{
+    guchar bytes[4];
+
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = (value >> 24) & 0xff;
+    return fwrite(bytes, 1, sizeof(bytes), out) == sizeof(bytes);
+}
+
+/* Compress everything read from params->fd into params->filename using
+ * params->workers threads.  Returns TRUE on success. */
+static gboolean
+gz_compress_parallel(gz_thread_params_t *params)
+{
+    /* gzip magic, deflate, no flags, no mtime, no extra flags, unknown OS */
+    static const guchar header[] =
+    { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff };
+    /* An empty final block with fixed Huffman codes. */
+    static const guchar trailer[] = { 0x03, 0x00 };
+    gz_compressor_t gz;
+    GError *error = NULL;
+    FILE *out;
+    Bytef *dict = NULL;
+    gsize dict_len = 0;
+    gint64 seq = 0;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    guint32 isize = 0;
+    gboolean eof = FALSE;
+    gboolean success = TRUE;
+
+    out = g_fopen(params->filename, "wb");
+    if (out == NULL)
+    {
+        g_warning("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                  params->filename, g_strerror(errno) ? g_strerror(errno) : "",
+                  errno);
+        return FALSE;
+    }
+
+    memset(&gz, 0, sizeof(gz));
+    gz.done = g_async_queue_new();
+    gz.ready = g_hash_table_new(g_int64_hash, g_int64_equal);
+    gz.pool = g_thread_pool_new(gz_block_deflate, gz.done, params->workers,
+                                FALSE, &error);
+    if (gz.pool == NULL)
+    {
+        g_warning("Could not create compression threads: %s", error->message);
+        g_error_free(error);
+        success = FALSE;
+    }
+    else if (fwrite(header, 1, sizeof(header), out) != sizeof(header))
+    {
+        success = FALSE;
+    }
+
+    while (success && !eof)
+    {
+        gz_block_t *block = g_new0(gz_block_t, 1);
+        gssize bytes = 1;
+
+        block->data = g_malloc(GZ_BLOCK_SIZE);
+        while (block->len < GZ_BLOCK_SIZE)
+        {
+            bytes = read(params->fd, block->data + block->len,
+                         GZ_BLOCK_SIZE - block->len);
+            if (bytes > 0)
+                block->len += bytes;
+            else if (bytes == 0 || errno != EINTR)
+                break;
+        }
+
+        if (bytes < 0)
+        {
+            g_warning("Could not read from pipe. The error is '%s' (errno %d)",
+                      g_strerror(errno) ? g_strerror(errno) : "", errno);
+            success = FALSE;
+        }
+        eof = (bytes <= 0);
+
+        if (!success || block->len == 0)
+        {
+            gz_block_free(block);
+            break;
+        }
+
+        crc = crc32(crc, block->data, block->len);
+        isize += block->len;
+
+        block->seq = seq++;
+        block->level = params->level;
+        block->dict = dict;
+        block->dict_len = dict_len;
+        dict_len = MIN(block->len, GZ_DICT_SIZE);
+        dict = g_malloc(dict_len);
+        memcpy(dict, block->data + block->len - dict_len, dict_len);
+
+        g_thread_pool_push(gz.pool, block, NULL);
+        gz.pending++;
+
+        /* Keep every worker busy without buffering the whole file. */
+        success = gz_write_blocks(&gz, out, 2 * params->workers);
+    }
+    g_free(dict);
+
+    if (!gz_write_blocks(&gz, out, 0))
+        success = FALSE;
+
+    if (success
+            && (fwrite(trailer, 1, sizeof(trailer), out) != sizeof(trailer)
+                || !gz_write_le32(out, crc)
+                || !gz_write_le32(out, isize)))
+        success = FALSE;
+
+    if (!success)
+        g_warning("Could not write the compressed file '%s'", params->filename);
+
+    if (fclose(out) != 0)
+    {
+        g_warning("Could not close the compressed file '%s'. The error is '%s' (errno %d)",
+                  params->filename, g_strerror(errno) ? g_strerror(errno) : "",
+                  errno);
+        success = FALSE;
+    }
+
+    if (gz.pool)
+        g_thread_pool_free(gz.pool, FALSE, TRUE);
+    g_hash_table_destroy(gz.ready);
+    g_async_queue_unref(gz.done);
+
+    return success;
+}
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
@@ -1340,6 +1821,14 @@ gz_thread_func(gz_thread_params_t *params)
     gint gzval;
     gzFile file;
     gint success = 1;
+    gint64 start;
+    gint64 usecs = 0;
+
+    if (params->compress && params->workers > 1)
+    {
+        success = gz_compress_parallel(params);
+        goto cleanup_gz_thread_func;
+    }
 
 #ifdef G_OS_WIN32
     {
@@ -1381,7 +1870,10 @@ gz_thread_func(gz_thread_params_t *params)
             bytes = read(params->fd, buffer, BUFLEN);
             if (bytes > 0)
             {
-                if (gzwrite(file, buffer, bytes) <= 0)
+                start = qof_profile_now();
+                gzval = gzwrite(file, buffer, bytes);
+                usecs += qof_profile_now() - start;
+                if (gzval <= 0)
                 {
                     gint errnum;
                     const gchar *error = gzerror(file, &errnum);
@@ -1406,7 +1898,9 @@ gz_thread_func(gz_thread_params_t *params)
     {
         while (success)
         {
+            start = qof_profile_now();
             gzval = gzread(file, buffer, BUFLEN);
+            usecs += qof_profile_now() - start;
             if (gzval > 0)
             {
                 if (
@@ -1443,6 +1937,8 @@ gz_thread_func(gz_thread_params_t *params)
                   params->filename, gzval);
         success = 0;
     }
+    qof_profile_add_phase_time(params->compress ? "compress" : "decompress",
+                               usecs);
 
 cleanup_gz_thread_func:
     close(params->fd);
@@ -1484,8 +1980,13 @@ try_gz_open (const char *filename, const char *perms, gboolean use_gzip,
         params = g_new(gz_thread_params_t, 1);
         params->fd = filedes[compress ? 0 : 1];
         params->filename = g_strdup(filename);
-        params->perms = g_strdup(perms);
         params->compress = compress;
+        params->level = compress ? gz_default_level() : Z_DEFAULT_COMPRESSION;
+        params->workers = compress ? gz_default_workers() : 1;
+        if (params->level == Z_DEFAULT_COMPRESSION)
+            params->perms = g_strdup(perms);
+        else
+            params->perms = g_strdup_printf("%s%d", perms, params->level);
 
 #ifndef HAVE_GLIB_2_32
         thread = g_thread_create((GThreadFunc) gz_thread_func, params,
@@ -1567,8 +2068,12 @@ gnc_book_write_to_xml_file_v2(
 
     /* Optionally wait for parallel compression threads */
     if (out && compress)
+    {
+        gint64 start = qof_profile_now();
         if (!wait_for_gzip(out))
             success = FALSE;
+        qof_profile_end_phase("wait for compression", start);
+    }
 
     return success;
 }
@@ -1610,6 +2115,277 @@ gnc_book_write_accounts_to_xml_file_v2(
     return success;
 }
 
+/***********************************************************************/
+/* The change journal.  It starts with the same xml declaration and
+ * namespaces as a data file, but its root element is never closed:
+ * every save appends one complete journal record holding the
+ * transactions committed since the previous save, and the deletion of
+ * those that no longer exist.  The root carries the SHA-256 digest of
+ * the data file the records apply to, so that a journal left behind by
+ * a crash or an older version is never replayed over a file it does not
+ * belong to. */
+
+#define JOURNAL_STRING "gnc-journal"
+#define JOURNAL_RECORD_TAG "gnc:journal-record"
+#define JOURNAL_DELETE_TAG "gnc:journal-delete"
+
+typedef struct
+{
+    sixtp_gdv2 *gd;
+    const gchar *base_digest;
+    gboolean stale;
+} journal_replay_data;
+
+gboolean
+gnc_xml_journal_write_header(FILE *out, const gchar *base_digest)
+{
+    gchar *root_start;
+    gboolean success;
+
+    g_return_val_if_fail(base_digest != NULL, FALSE);
+
+    root_start = g_strdup_printf(JOURNAL_STRING " base-digest=\"%s\"",
+                                 base_digest);
+    success = write_root_header(out, root_start);
+    g_free(root_start);
+
+    return success;
+}
+
+gboolean
+gnc_xml_journal_write_record(FILE *out, QofBook *book, GList *guids)
+{
+    xmlOutputBufferPtr xml_out;
+    gchar guid_str[GUID_ENCODING_LENGTH + 1];
+    GList *node;
+
+    xml_out = xmlOutputBufferCreateFile(out, NULL);
+    if (!xml_out)
+        return FALSE;
+
+    xmlOutputBufferWriteString(xml_out, "<" JOURNAL_RECORD_TAG ">\n");
+    for (node = guids; node; node = node->next)
+    {
+        const GncGUID *guid = node->data;
+        Transaction *trn = xaccTransLookup(guid, book);
+
+        if (trn)
+        {
+            gnc_transaction_write_xml(xml_out, trn);
+            xmlOutputBufferWriteString(xml_out, "\n");
+        }
+        else
+        {
+            guid_to_string_buff(guid, guid_str);
+            xmlOutputBufferWriteString(xml_out, "<" JOURNAL_DELETE_TAG
+                                       " type=\"guid\">");
+            xmlOutputBufferWriteString(xml_out, guid_str);
+            xmlOutputBufferWriteString(xml_out, "</" JOURNAL_DELETE_TAG ">\n");
+        }
+    }
+    xmlOutputBufferWriteString(xml_out, "</" JOURNAL_RECORD_TAG ">\n");
+
+    if (xmlOutputBufferClose(xml_out) < 0 || fflush(out) != 0 || ferror(out))
+        return FALSE;
+
+    return TRUE;
+}
+
+static gboolean
+journal_start_handler(GSList* sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer *data_for_children,
+                      gpointer *result, const gchar *tag, gchar **attrs)
+{
+    journal_replay_data *jdata = global_data;
+    gboolean digest_ok = FALSE;
+    gchar **attr;
+
+    for (attr = attrs; attr && attr[0] && attr[1]; attr += 2)
+    {
+        if (g_strcmp0(attr[0], "base-digest") == 0)
+            digest_ok = g_strcmp0(attr[1], jdata->base_digest) == 0;
+    }
+
+    jdata->stale = !digest_ok;
+    return !jdata->stale;
+}
+
+/* Replace a transaction by the version from the journal, so take the
+ * current one out of the book first. */
+static void
+journal_forget_transaction(QofBook *book, const GncGUID *guid)
+{
+    Transaction *trn = xaccTransLookup(guid, book);
+
+    if (!trn)
+        return;
+
+    xaccTransClearReadOnly(trn);
+    xaccTransDestroy(trn);
+}
+
+static gboolean
+journal_transaction_end_handler(gpointer data_for_children,
+                                GSList* data_from_children, GSList* sibling_data,
+                                gpointer parent_data, gpointer global_data,
+                                gpointer *result, const gchar *tag)
+{
+    journal_replay_data *jdata = global_data;
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    xmlNodePtr child;
+    Transaction *trn;
+
+    if (parent_data || !tag)
+        return TRUE;
+
+    g_return_val_if_fail(tree, FALSE);
+
+    /* The parser carries on after the root was rejected. */
+    if (jdata->stale)
+    {
+        xmlFreeNode(tree);
+        return FALSE;
+    }
+
+    for (child = tree->xmlChildrenNode; child; child = child->next)
+    {
+        if (g_strcmp0((const char*)child->name, "trn:id") == 0)
+        {
+            GncGUID *guid = dom_tree_to_guid(child);
+            if (guid)
+            {
+                journal_forget_transaction(jdata->gd->book, guid);
+                g_free(guid);
+            }
+            break;
+        }
+    }
+
+    trn = dom_tree_to_transaction(tree, jdata->gd->book);
+    if (trn)
+        add_transaction_local(jdata->gd, trn);
+
+    xmlFreeNode(tree);
+    return trn != NULL;
+}
+
+static gboolean
+journal_delete_end_handler(gpointer data_for_children,
+                           GSList* data_from_children, GSList* sibling_data,
+                           gpointer parent_data, gpointer global_data,
+                           gpointer *result, const gchar *tag)
+{
+    journal_replay_data *jdata = global_data;
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    GncGUID *guid;
+
+    if (parent_data || !tag)
+        return TRUE;
+
+    g_return_val_if_fail(tree, FALSE);
+
+    if (jdata->stale)
+    {
+        xmlFreeNode(tree);
+        return FALSE;
+    }
+
+    guid = dom_tree_to_guid(tree);
+    if (guid)
+    {
+        journal_forget_transaction(jdata->gd->book, guid);
+        g_free(guid);
+    }
+
+    xmlFreeNode(tree);
+    return guid != NULL;
+}
+
+gboolean
+gnc_xml_journal_replay(QofBook *book, const char *filename,
+                       const gchar *base_digest)
+{
+    journal_replay_data jdata;
+    sixtp *top_parser, *journal_parser, *record_parser;
+    gchar *contents, *root, *cut, *last, *buffer;
+    gsize length;
+    gpointer parse_result = NULL;
+    gboolean retval;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL))
+    {
+        PWARN("Unable to read journal %s", filename);
+        return FALSE;
+    }
+
+    /* Close the root element after the last complete record, dropping
+     * whatever a crash in the middle of a save left behind. */
+    root = g_strstr_len(contents, length, "<" JOURNAL_STRING);
+    cut = root ? strchr(root, '>') : NULL;
+    if (!cut)
+    {
+        PWARN("Journal %s has no header", filename);
+        g_free(contents);
+        return FALSE;
+    }
+    cut++;
+    last = g_strrstr_len(contents, length, "</" JOURNAL_RECORD_TAG ">");
+    if (last && last > cut)
+        cut = last + strlen("</" JOURNAL_RECORD_TAG ">");
+    *cut = '\0';
+    buffer = g_strconcat(contents, "\n</" JOURNAL_STRING ">\n", NULL);
+    g_free(contents);
+
+    top_parser = sixtp_new();
+    journal_parser = sixtp_new();
+    record_parser = sixtp_new();
+    sixtp_set_start(journal_parser, journal_start_handler);
+
+    if (!sixtp_add_some_sub_parsers(
+                top_parser, TRUE,
+                JOURNAL_STRING, journal_parser,
+                NULL, NULL)
+            || !sixtp_add_some_sub_parsers(
+                journal_parser, TRUE,
+                JOURNAL_RECORD_TAG, record_parser,
+                NULL, NULL)
+            || !sixtp_add_some_sub_parsers(
+                record_parser, TRUE,
+                TRANSACTION_TAG,
+                sixtp_dom_parser_new(journal_transaction_end_handler, NULL, NULL),
+                JOURNAL_DELETE_TAG,
+                sixtp_dom_parser_new(journal_delete_end_handler, NULL, NULL),
+                NULL, NULL))
+    {
+        sixtp_destroy(top_parser);
+        g_free(buffer);
+        return FALSE;
+    }
+
+    jdata.gd = gnc_sixtp_gdv2_new(book, FALSE, NULL, NULL);
+    jdata.base_digest = base_digest;
+    jdata.stale = FALSE;
+
+    xaccLogDisable();
+    retval = sixtp_parse_buffer(top_parser, buffer, strlen(buffer),
+                                NULL, &jdata, &parse_result);
+    xaccLogEnable();
+
+    if (jdata.stale)
+        PWARN("Journal %s does not belong to the current data file", filename);
+    else if (!retval)
+        PWARN("Error replaying journal %s", filename);
+    else
+        PINFO("Replayed %d transactions from %s",
+              jdata.gd->counter.transactions_loaded, filename);
+
+    sixtp_destroy(top_parser);
+    g_free(jdata.gd);
+    g_free(buffer);
+
+    return retval && !jdata.stale;
+}
+
 /***********************************************************************/
 static gboolean
 is_gzipped_file(const gchar *name)
@@ -2096,6 +2872,41 @@ cleanup_push_handler:
     }
 }
 
+#define GZ_PUSH_BUFLEN 65536
+
+static void
+parse_gz_push_handler (xmlParserCtxtPtr xml_context, const gchar *filename)
+{
+    FILE *file;
+    gchar *buffer;
+    size_t bytes;
+
+    file = try_gz_open(filename, "r", TRUE, FALSE);
+    if (file == NULL)
+    {
+        PWARN("Unable to open file %s", filename);
+        return;
+    }
+
+    buffer = g_malloc(GZ_PUSH_BUFLEN);
+    while ((bytes = fread(buffer, 1, GZ_PUSH_BUFLEN, file)) > 0)
+    {
+        if (xmlParseChunk(xml_context, buffer, bytes, 0) != 0)
+            goto cleanup_gz_push_handler;
+    }
+
+    if (ferror(file))
+        goto cleanup_gz_push_handler;
+
+    /* last chunk */
+    xmlParseChunk(xml_context, "", 0, 1);
+
+cleanup_gz_push_handler:
+    g_free(buffer);
+    fclose(file);
+    wait_for_gzip(file);
+}
+
 gboolean
 gnc_xml2_parse_with_subst (FileBackend *fbe, QofBook *book, GHashTable *subst)
 {
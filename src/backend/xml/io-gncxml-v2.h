@@ -71,6 +71,16 @@ struct sixtp_gdv2
     countCallbackFn countCallback;
     QofBePercentageFunc gui_display_fn;
     gboolean exporting;
+    /* Transactions to load instead of those in the file, see
+       io-gncxml-snapshot.h. */
+    struct gnc_xml_snapshot *snapshot;
+    /* Whether the load is being profiled, and the run of like elements
+       of the book being read: their tag, how many and when the run
+       started, for qof_profile_add_objects. */
+    gboolean profiling;
+    gchar *profile_tag;
+    gint64 profile_count;
+    gint64 profile_start;
 };
 
 /**
@@ -139,6 +149,21 @@ gboolean gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *b
 gboolean gnc_book_write_accounts_to_xml_file_v2(QofBackend * be, QofBook *book,
         const char *filename);
 
+/** Start a change journal for the data file with the given digest, as
+ * computed by gnc_xml_file_digest(). */
+gboolean gnc_xml_journal_write_header(FILE *out, const gchar *base_digest);
+
+/** Append one journal record to @a out: the current state of each
+ * transaction in @a guids (a list of GncGUID*), or its deletion if it is
+ * no longer in the book. */
+gboolean gnc_xml_journal_write_record(FILE *out, QofBook *book, GList *guids);
+
+/** Apply the records of a change journal to a freshly loaded book.
+ * Returns FALSE if the journal could not be read or does not belong to
+ * the data file with the given digest. */
+gboolean gnc_xml_journal_replay(QofBook *book, const char *filename,
+                                const gchar *base_digest);
+
 /** The is_gncxml_file() routine checks to see if the first few
  * chars of the file look like gnc-xml data.
  */
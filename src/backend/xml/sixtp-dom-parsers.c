@@ -61,7 +61,7 @@ dom_tree_to_guid(xmlNodePtr node)
             char *guid_str;
 
             guid_str = (char*)xmlNodeGetContent (node->xmlChildrenNode);
-            string_to_guid(guid_str, gid);
+            xml_string_to_guid(guid_str, gid);
             xmlFree (guid_str);
             xmlFree (type);
             return gid;
@@ -545,7 +545,7 @@ dom_tree_to_gnc_numeric(xmlNodePtr node)
 
     ret = g_new(gnc_numeric, 1);
 
-    if (string_to_gnc_numeric(content, ret))
+    if (xml_string_to_gnc_numeric(content, ret))
     {
         g_free(content);
         return ret;
@@ -157,13 +157,87 @@ string_to_double(const char *str, double *result)
     return(TRUE);
 }
 
+/*********/
+/* fast paths
+ */
+
+/* Read the decimal digits at the start of str into v.  Returns how
+   many there were, or 0 if there were none or more than max_digits. */
+static int
+scan_decimal(const gchar *str, int max_digits, gint64 *v)
+{
+    gint64 val = 0;
+    int n;
+
+    for (n = 0; str[n] >= '0' && str[n] <= '9'; n++)
+    {
+        if (n == max_digits)
+            return 0;
+        val = val * 10 + (str[n] - '0');
+    }
+    *v = val;
+    return n;
+}
+
+/* Read exactly width decimal digits from the start of str into v. */
+static gboolean
+scan_fixed_digits(const gchar *str, int width, int *v)
+{
+    int val = 0;
+    int i;
+
+    for (i = 0; i < width; i++)
+    {
+        if (str[i] < '0' || str[i] > '9')
+            return FALSE;
+        val = val * 10 + (str[i] - '0');
+    }
+    *v = val;
+    return TRUE;
+}
+
+static int
+hex_digit_value(gchar c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
 /*********/
 /* gint64
  */
+
+gboolean
+string_to_gint64(const gchar *str, gint64 *v)
+{
+    gboolean negative;
+    gint64 val;
+    int n;
+
+    g_return_val_if_fail(str, FALSE);
+
+    /* 18 digits cannot overflow. */
+    negative = (*str == '-');
+    n = scan_decimal(str + negative, 18, &val);
+    if (n > 0 && str[negative + n] == '\0')
+    {
+        if (v)
+            *v = negative ? -val : val;
+        return(TRUE);
+    }
+
+    return string_to_gint64_general(str, v);
+}
+
 /* Maybe there should be a comment here explaining why this function
    doesn't call g_ascii_strtoull, because it's not so obvious. -CAS */
 gboolean
-string_to_gint64(const gchar *str, gint64 *v)
+string_to_gint64_general(const gchar *str, gint64 *v)
 {
     /* convert a string to a gint64. only whitespace allowed before and after. */
     long long int v_in;
@@ -286,6 +360,83 @@ hex_string_to_binary(const gchar *str,  void **v, guint64 *data_len)
     return(TRUE);
 }
 
+/************/
+/* GncGUID
+ */
+
+gboolean
+xml_string_to_guid(const gchar *str, GncGUID *guid)
+{
+    int i;
+
+    if (str && guid)
+    {
+        for (i = 0; i < GUID_DATA_SIZE; i++)
+        {
+            int high = hex_digit_value(str[2 * i]);
+            int low;
+
+            if (high < 0)
+                break;
+            low = hex_digit_value(str[2 * i + 1]);
+            if (low < 0)
+                break;
+            guid->data[i] = (high << 4) | low;
+        }
+        if (i == GUID_DATA_SIZE)
+            return(TRUE);
+    }
+
+    /* Let string_to_guid deal with what is left, clearing guid. */
+    return string_to_guid(str, guid);
+}
+
+/************/
+/* gnc_numeric
+ */
+
+/* One half of "num/denom", as g_ascii_strtoll reads it in base 0: an
+   optional minus sign and at most 18 digits, with no leading zero
+   that would make it octal.  Returns the length read, 0 if the text
+   is anything else. */
+static int
+scan_numeric_part(const gchar *str, gint64 *v)
+{
+    gboolean negative = (*str == '-');
+    gint64 val;
+    int n;
+
+    n = scan_decimal(str + negative, 18, &val);
+    if (n == 0 || (n > 1 && str[negative] == '0'))
+        return 0;
+
+    *v = negative ? -val : val;
+    return negative + n;
+}
+
+gboolean
+xml_string_to_gnc_numeric(const gchar *str, gnc_numeric *n)
+{
+    gint64 num;
+    gint64 denom;
+    int len;
+
+    if (str && n && (len = scan_numeric_part(str, &num)) > 0 && str[len] == '/')
+    {
+        const gchar *denom_str = str + len + 1;
+
+        len = scan_numeric_part(denom_str, &denom);
+        if (len > 0 && denom_str[len] == '\0')
+        {
+            n->num = num;
+            n->denom = denom;
+            return(TRUE);
+        }
+    }
+
+    return string_to_gnc_numeric(str, n);
+}
+
 /***************************************************************************/
 /* simple chars only parser - just grabs all it's contained chars and
    does what you specify in the end handler - if you pass NULL as the
@@ -358,8 +509,73 @@ simple_chars_only_parser_new(sixtp_end_handler end_handler)
    all goes well, returns the Timespec* as the result.
 */
 
+/* Seconds since the epoch of "YYYY-MM-DD HH:MM:SS +ZZZZ", exactly as
+   timespec_sec_to_string writes it.  Anything else, and any date
+   gnc_timegm would have to normalize, is left to the general parser. */
+static gboolean
+timespec_secs_fast(const gchar *str, time64 *secs)
+{
+    static const int days_in_month[] =
+    {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    int year, month, day, hour, min, sec, zone;
+    int last_day;
+    gint64 y, era, yoe, doy, doe;
+    time64 gmtoff;
+
+    if (!scan_fixed_digits(str, 4, &year) || str[4] != '-'
+            || !scan_fixed_digits(str + 5, 2, &month) || str[7] != '-'
+            || !scan_fixed_digits(str + 8, 2, &day) || str[10] != ' '
+            || !scan_fixed_digits(str + 11, 2, &hour) || str[13] != ':'
+            || !scan_fixed_digits(str + 14, 2, &min) || str[16] != ':'
+            || !scan_fixed_digits(str + 17, 2, &sec) || str[19] != ' '
+            || (str[20] != '+' && str[20] != '-')
+            || !scan_fixed_digits(str + 21, 4, &zone) || str[25] != '\0')
+        return FALSE;
+
+    if (year < 1 || month < 1 || month > 12)
+        return FALSE;
+    last_day = days_in_month[month - 1];
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0))
+        last_day = 29;
+    if (day < 1 || day > last_day || hour > 23 || min > 59 || sec > 59)
+        return FALSE;
+
+    /* Days from 1970-01-01 in the proleptic Gregorian calendar, counting
+       years from March so that leap days fall at the end. */
+    y = year - (month <= 2);
+    era = y / 400;
+    yoe = y - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    gmtoff = (zone / 100) * 60 * 60 + (zone % 100) * 60;
+    if (str[20] == '-') gmtoff = - gmtoff;
+
+    *secs = ((era * 146097 + doe - 719468) * 24 * 60 * 60
+             + hour * 60 * 60 + min * 60 + sec) - gmtoff;
+    return TRUE;
+}
+
 gboolean
 string_to_timespec_secs(const gchar *str, Timespec *ts)
+{
+    time64 secs;
+
+    if (!str || !ts) return FALSE;
+
+    if (timespec_secs_fast(str, &secs))
+    {
+        ts->tv_sec = secs;
+        return(TRUE);
+    }
+
+    return string_to_timespec_secs_general(str, ts);
+}
+
+gboolean
+string_to_timespec_secs_general(const gchar *str, Timespec *ts)
 {
 
     struct tm parsed_time;
@@ -652,7 +868,7 @@ generic_guid_end_handler(gpointer data_for_children,
         return(FALSE);
     }
 
-    ok = string_to_guid(txt, gid);
+    ok = xml_string_to_guid(txt, gid);
     g_free(txt);
 
     if (!ok)
@@ -718,7 +934,7 @@ generic_gnc_numeric_end_handler(gpointer data_for_children,
         num = g_new(gnc_numeric, 1);
         if (num)
         {
-            if (string_to_gnc_numeric(txt, num))
+            if (xml_string_to_gnc_numeric(txt, num))
             {
                 ok = TRUE;
                 *result = num;
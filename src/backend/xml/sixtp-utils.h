@@ -68,12 +68,25 @@ gchar * concatenate_child_result_chars(GSList *data_from_children);
 
 gboolean string_to_double(const char *str, double *result);
 
+/* string_to_gint64, string_to_timespec_secs, xml_string_to_guid and
+   xml_string_to_gnc_numeric first try a quick, locale-independent
+   parse of the exact form gnucash writes and fall back to the general
+   parser for anything else, so they accept the same strings and give
+   the same results.  The general parsers are kept public so the tests
+   can check that. */
 gboolean string_to_gint64(const gchar *str, gint64 *v);
+gboolean string_to_gint64_general(const gchar *str, gint64 *v);
 
 gboolean string_to_gint32(const gchar *str, gint32 *v);
 
 gboolean hex_string_to_binary(const gchar *str,  void **v, guint64 *data_len);
 
+/** Same as string_to_guid. */
+gboolean xml_string_to_guid(const gchar *str, GncGUID *guid);
+
+/** Same as string_to_gnc_numeric. */
+gboolean xml_string_to_gnc_numeric(const gchar *str, gnc_numeric *n);
+
 gboolean generic_return_chars_end_handler(gpointer data_for_children,
         GSList* data_from_children,
         GSList* sibling_data,
@@ -85,6 +98,7 @@ gboolean generic_return_chars_end_handler(gpointer data_for_children,
 sixtp* simple_chars_only_parser_new(sixtp_end_handler end_handler);
 
 gboolean string_to_timespec_secs(const gchar *str, Timespec *ts);
+gboolean string_to_timespec_secs_general(const gchar *str, Timespec *ts);
 gboolean string_to_timespec_nsecs(const gchar *str, Timespec *ts);
 
 gboolean generic_timespec_start_handler(GSList* sibling_data,
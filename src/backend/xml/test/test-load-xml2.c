@@ -27,10 +27,12 @@
  */
 
 #include "config.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <utime.h>
 #include <dirent.h>
 #include <string.h>
 #include <glib.h>
@@ -40,6 +42,9 @@
 #include <cashobjects.h>
 #include <TransLog.h>
 #include <gnc-engine.h>
+#include <Account.h>
+#include <Transaction.h>
+#include <Scrub.h>
 #include "../gnc-backend-xml.h"
 #include "../io-gncxml-v2.h"
 
@@ -109,6 +114,432 @@ test_load_file(const char *filename)
     qof_session_end(session);
 }
 
+static QofSession *
+load_file_with_threads(const char *filename, const char *threads)
+{
+    QofSession *session;
+
+    g_setenv("GNC_XML_LOAD_THREADS", threads, TRUE);
+
+    session = qof_session_new();
+    remove_locks(filename);
+    qof_session_begin(session, filename, TRUE, FALSE, FALSE);
+    qof_session_load(session, NULL);
+
+    g_unsetenv("GNC_XML_LOAD_THREADS");
+
+    return session;
+}
+
+/* The pipelined loader must produce the same book as the serial one. */
+static void
+test_parallel_load_file(const char *filename)
+{
+    QofSession *serial, *parallel;
+    Account *serial_root, *parallel_root;
+
+    serial = load_file_with_threads(filename, "0");
+    parallel = load_file_with_threads(filename, "3");
+
+    do_test_args(qof_session_get_error(parallel) == ERR_BACKEND_NO_ERR,
+                 "parallel load xml2", __FILE__, __LINE__,
+                 "qof error=%d for file [%s]",
+                 qof_session_get_error(parallel), filename);
+
+    serial_root = gnc_book_get_root_account(qof_session_get_book(serial));
+    parallel_root = gnc_book_get_root_account(qof_session_get_book(parallel));
+
+    do_test_args(xaccAccountEqual(serial_root, parallel_root, TRUE),
+                 "parallel load xml2", __FILE__, __LINE__,
+                 "serial and parallel loads differ for file [%s]", filename);
+
+    qof_session_end(parallel);
+    qof_session_destroy(parallel);
+    qof_session_end(serial);
+    qof_session_destroy(serial);
+}
+
+/* The streaming transaction parser must produce the same book as the
+   DOM one. */
+static void
+test_sax_load_file(const char *filename)
+{
+    QofSession *dom, *sax;
+    Account *dom_root, *sax_root;
+
+    g_setenv("GNC_XML_DOM_TRANSACTIONS", "1", TRUE);
+    dom = load_file_with_threads(filename, "0");
+    g_unsetenv("GNC_XML_DOM_TRANSACTIONS");
+
+    sax = load_file_with_threads(filename, "0");
+
+    do_test_args(qof_session_get_error(sax) == ERR_BACKEND_NO_ERR,
+                 "sax load xml2", __FILE__, __LINE__,
+                 "qof error=%d for file [%s]",
+                 qof_session_get_error(sax), filename);
+
+    dom_root = gnc_book_get_root_account(qof_session_get_book(dom));
+    sax_root = gnc_book_get_root_account(qof_session_get_book(sax));
+
+    do_test_args(xaccAccountEqual(dom_root, sax_root, TRUE),
+                 "sax load xml2", __FILE__, __LINE__,
+                 "DOM and SAX loads differ for file [%s]", filename);
+
+    qof_session_end(sax);
+    qof_session_destroy(sax);
+    qof_session_end(dom);
+    qof_session_destroy(dom);
+}
+
+static int
+collect_transaction(Transaction *trn, void *data)
+{
+    GList **list = data;
+
+    *list = g_list_prepend(*list, trn);
+    return g_list_length(*list) >= 2;
+}
+
+/* Remove the copy of a test file and everything saved next to it. */
+static void
+remove_file_copy(const char *copy)
+{
+    GDir *dir = g_dir_open(".", 0, NULL);
+    const gchar *entry;
+
+    if (!dir)
+        return;
+    while ((entry = g_dir_read_name(dir)) != NULL)
+        if (g_str_has_prefix(entry, copy))
+            g_unlink(entry);
+    g_dir_close(dir);
+}
+
+/* Turn the newline after the xml declaration of filename into a space
+   and put the old time back; the book is the same but the file is not. */
+static gboolean
+rewrite_keeping_time(const char *filename)
+{
+    gchar *contents = NULL;
+    gsize length;
+    struct stat before;
+    struct utimbuf times;
+    gboolean success = FALSE;
+
+    if (g_file_get_contents(filename, &contents, &length, NULL)
+            && g_str_has_prefix(contents, "<?xml")
+            && strchr(contents, '\n') != NULL
+            && g_stat(filename, &before) == 0)
+    {
+        *strchr(contents, '\n') = ' ';
+        times.actime = before.st_atime;
+        times.modtime = before.st_mtime;
+        success = (g_file_set_contents(filename, contents, length, NULL)
+                   && g_utime(filename, &times) == 0);
+    }
+    g_free(contents);
+    return success;
+}
+
+/* Whether a journal of filename was moved aside. */
+static gboolean
+journal_orphaned(const char *filename)
+{
+    gchar *prefix = g_strconcat(filename, ".journal.orphan-", NULL);
+    const gchar *entry;
+    gboolean found = FALSE;
+    GDir *dir;
+
+    dir = g_dir_open(".", 0, NULL);
+    while (dir && !found && (entry = g_dir_read_name(dir)) != NULL)
+        found = g_str_has_prefix(entry, prefix);
+    if (dir)
+        g_dir_close(dir);
+    g_free(prefix);
+    return found;
+}
+
+/* A journaled save must leave the data file alone, and loading must
+   replay the journal to give the book that was saved.  A journal of a
+   data file which has changed since, even keeping its size and time,
+   must not be replayed, and must be kept rather than deleted. */
+static void
+test_journal_file(const char *filename)
+{
+    const char *copy = "test-load-xml2-journal.gml2";
+    gchar *journal = g_strconcat(copy, ".journal", NULL);
+    gchar *contents;
+    gsize length;
+    QofSession *writer, *reader;
+    Account *writer_root, *reader_root;
+    GList *trans = NULL;
+    struct stat before, after;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL)
+            || !g_file_set_contents(copy, contents, length, NULL))
+    {
+        failure_args("journal", __FILE__, __LINE__,
+                     "unable to copy file [%s]", filename);
+        g_free(journal);
+        return;
+    }
+    g_free(contents);
+
+    g_setenv("GNC_XML_JOURNAL", "1", TRUE);
+    writer = load_file_with_threads(copy, "0");
+    writer_root = gnc_book_get_root_account(qof_session_get_book(writer));
+    xaccAccountTreeForEachTransaction(writer_root, collect_transaction, &trans);
+
+    if (g_list_length(trans) == 2)
+    {
+        Transaction *changed = trans->data;
+        Transaction *deleted = trans->next->data;
+
+        g_stat(copy, &before);
+
+        xaccTransBeginEdit(changed);
+        xaccTransSetDescription(changed, "changed through the journal");
+        xaccTransCommitEdit(changed);
+        xaccTransClearReadOnly(deleted);
+        xaccTransDestroy(deleted);
+
+        qof_session_save(writer, NULL);
+        g_stat(copy, &after);
+
+        do_test_args(g_file_test(journal, G_FILE_TEST_EXISTS),
+                     "journaled save", __FILE__, __LINE__,
+                     "no journal written for file [%s]", filename);
+        do_test_args(before.st_size == after.st_size
+                     && before.st_mtime == after.st_mtime,
+                     "journaled save", __FILE__, __LINE__,
+                     "data file rewritten for file [%s]", filename);
+
+        reader = load_file_with_threads(copy, "0");
+        reader_root = gnc_book_get_root_account(qof_session_get_book(reader));
+        do_test_args(qof_session_get_error(reader) == ERR_BACKEND_NO_ERR
+                     && xaccAccountEqual(writer_root, reader_root, TRUE),
+                     "journal replay", __FILE__, __LINE__,
+                     "replayed book differs for file [%s]", filename);
+
+        qof_session_end(reader);
+        do_test_args(!g_file_test(journal, G_FILE_TEST_EXISTS),
+                     "journal compaction", __FILE__, __LINE__,
+                     "journal left behind for file [%s]", filename);
+        qof_session_destroy(reader);
+
+        /* The first save goes to the whole file, which the reader has
+           replaced; the second one is journaled again. */
+        xaccTransBeginEdit(changed);
+        xaccTransSetDescription(changed, "changed through the file");
+        xaccTransCommitEdit(changed);
+        qof_session_save(writer, NULL);
+        xaccTransBeginEdit(changed);
+        xaccTransSetDescription(changed, "changed through a stale journal");
+        xaccTransCommitEdit(changed);
+        qof_session_save(writer, NULL);
+
+        if (do_test_args(g_file_test(journal, G_FILE_TEST_EXISTS)
+                         && rewrite_keeping_time(copy),
+                         "stale journal", __FILE__, __LINE__,
+                         "unable to set up a stale journal for file [%s]",
+                         filename))
+        {
+            reader = load_file_with_threads(copy, "0");
+            do_test_args(qof_session_get_error(reader)
+                         == ERR_FILEIO_FILE_BAD_READ
+                         && !g_file_test(journal, G_FILE_TEST_EXISTS)
+                         && journal_orphaned(copy),
+                         "stale journal", __FILE__, __LINE__,
+                         "stale journal not set aside for file [%s]",
+                         filename);
+            qof_session_end(reader);
+            qof_session_destroy(reader);
+        }
+    }
+    g_list_free(trans);
+
+    qof_session_end(writer);
+    qof_session_destroy(writer);
+    g_unsetenv("GNC_XML_JOURNAL");
+
+    remove_file_copy(copy);
+    g_free(journal);
+}
+
+/* A load from the snapshot must give the same book as the load from
+   the xml file which wrote it, and must not write it again.  An edit
+   which keeps the size and time of the file must still be noticed. */
+static void
+test_snapshot_file(const char *filename)
+{
+    const char *copy = "test-load-xml2-snapshot.gml2";
+    gchar *snapshot = g_strconcat(copy, ".snapshot", NULL);
+    gchar *contents;
+    gsize length;
+    QofSession *cold, *warm;
+    Account *cold_root, *warm_root;
+    struct stat before, after;
+    GTimer *timer;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL)
+            || !g_file_set_contents(copy, contents, length, NULL))
+    {
+        failure_args("snapshot", __FILE__, __LINE__,
+                     "unable to copy file [%s]", filename);
+        g_free(snapshot);
+        return;
+    }
+    g_free(contents);
+
+    g_setenv("GNC_XML_SNAPSHOT", "1", TRUE);
+    timer = g_timer_new();
+
+    cold = load_file_with_threads(copy, "0");
+    if (g_getenv("VERBOSE"))
+        printf("load of %s without snapshot: %.3f s\n", filename,
+               g_timer_elapsed(timer, NULL));
+
+    if (do_test_args(g_stat(snapshot, &before) == 0,
+                     "snapshot written", __FILE__, __LINE__,
+                     "no snapshot for file [%s]", filename))
+    {
+        g_timer_start(timer);
+        warm = load_file_with_threads(copy, "0");
+        if (g_getenv("VERBOSE"))
+            printf("load of %s from snapshot: %.3f s\n", filename,
+                   g_timer_elapsed(timer, NULL));
+
+        cold_root = gnc_book_get_root_account(qof_session_get_book(cold));
+        warm_root = gnc_book_get_root_account(qof_session_get_book(warm));
+        do_test_args(qof_session_get_error(warm) == ERR_BACKEND_NO_ERR
+                     && xaccAccountEqual(cold_root, warm_root, TRUE),
+                     "snapshot load", __FILE__, __LINE__,
+                     "snapshot book differs for file [%s]", filename);
+
+        /* Writing it again would replace the file. */
+        do_test_args(g_stat(snapshot, &after) == 0
+                     && before.st_ino == after.st_ino,
+                     "snapshot used", __FILE__, __LINE__,
+                     "snapshot rewritten for file [%s]", filename);
+
+        qof_session_end(warm);
+        qof_session_destroy(warm);
+    }
+
+    g_stat(snapshot, &before);
+    if (rewrite_keeping_time(copy))
+    {
+        warm = load_file_with_threads(copy, "0");
+        do_test_args(g_stat(snapshot, &after) == 0
+                     && before.st_ino != after.st_ino,
+                     "snapshot out of date", __FILE__, __LINE__,
+                     "stale snapshot used for file [%s]", filename);
+        qof_session_end(warm);
+        qof_session_destroy(warm);
+    }
+
+    g_timer_destroy(timer);
+    qof_session_end(cold);
+    qof_session_destroy(cold);
+    g_unsetenv("GNC_XML_SNAPSHOT");
+
+    remove_file_copy(copy);
+    g_free(snapshot);
+}
+
+/* A book scrubbed with the deferred scrub is marked clean, and loading
+   it back without scrubbing must give the same book. */
+static void
+test_deferred_scrub_file(const char *filename)
+{
+    const char *copy = "test-load-xml2-scrub.gml2";
+    gchar *contents;
+    gsize length;
+    QofSession *scrubbed, *unscrubbed;
+    QofBook *book;
+    Account *scrubbed_root, *unscrubbed_root;
+    GList *accounts, *node;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL)
+            || !g_file_set_contents(copy, contents, length, NULL))
+    {
+        failure_args("deferred scrub", __FILE__, __LINE__,
+                     "unable to copy file [%s]", filename);
+        return;
+    }
+    g_free(contents);
+
+    g_setenv("GNC_XML_DEFERRED_SCRUB", "1", TRUE);
+    scrubbed = load_file_with_threads(copy, "0");
+    book = qof_session_get_book(scrubbed);
+    do_test_args(qof_session_get_error(scrubbed) == ERR_BACKEND_NO_ERR,
+                 "deferred scrub", __FILE__, __LINE__,
+                 "load failed for file [%s]", filename);
+
+    qof_book_mark_session_dirty(book);
+    qof_session_save(scrubbed, NULL);
+    do_test_args(xaccBookIsScrubbed(book),
+                 "deferred scrub mark", __FILE__, __LINE__,
+                 "book not marked clean for file [%s]", filename);
+
+    unscrubbed = load_file_with_threads(copy, "0");
+    book = qof_session_get_book(unscrubbed);
+    do_test_args(xaccBookIsScrubbed(book),
+                 "deferred scrub skipped", __FILE__, __LINE__,
+                 "saved book not clean for file [%s]", filename);
+
+    scrubbed_root = gnc_book_get_root_account(qof_session_get_book(scrubbed));
+    unscrubbed_root = gnc_book_get_root_account(book);
+    do_test_args(xaccAccountEqual(scrubbed_root, unscrubbed_root, TRUE),
+                 "deferred scrub load", __FILE__, __LINE__,
+                 "unscrubbed book differs for file [%s]", filename);
+
+    /* Changing a split behind the marker's back must be noticed. */
+    accounts = gnc_account_get_descendants(unscrubbed_root);
+    for (node = accounts; node; node = node->next)
+    {
+        GList *splits = xaccAccountGetSplitList(node->data);
+        Split *split;
+
+        if (!splits)
+            continue;
+        split = splits->data;
+        xaccTransBeginEdit(xaccSplitGetParent(split));
+        xaccSplitSetAmount(split, gnc_numeric_add(xaccSplitGetAmount(split),
+                                                  gnc_numeric_create(1, 1),
+                                                  GNC_DENOM_AUTO,
+                                                  GNC_HOW_DENOM_EXACT));
+        xaccTransCommitEdit(xaccSplitGetParent(split));
+        do_test_args(!xaccBookIsScrubbed(book),
+                     "deferred scrub checksum", __FILE__, __LINE__,
+                     "changed book still clean for file [%s]", filename);
+
+        /* Saving must not vouch for the change either. */
+        qof_book_mark_session_dirty(book);
+        qof_session_save(unscrubbed, NULL);
+        do_test_args(!xaccBookIsScrubbed(book),
+                     "deferred scrub save", __FILE__, __LINE__,
+                     "change marked clean by save for file [%s]", filename);
+        break;
+    }
+    g_list_free(accounts);
+
+    /* A book that was never scrubbed must not be marked clean. */
+    book = qof_book_new();
+    do_test_args(!xaccBookMarkScrubbed(book) && !xaccBookIsScrubbed(book),
+                 "deferred scrub unscrubbed", __FILE__, __LINE__,
+                 "new book marked clean for file [%s]", filename);
+    qof_book_destroy(book);
+
+    qof_session_end(unscrubbed);
+    qof_session_destroy(unscrubbed);
+    qof_session_end(scrubbed);
+    qof_session_destroy(scrubbed);
+    g_unsetenv("GNC_XML_DEFERRED_SCRUB");
+
+    remove_file_copy(copy);
+}
+
 int
 main (int argc, char ** argv)
 {
@@ -142,6 +573,11 @@ main (int argc, char ** argv)
                 gchar *to_open = g_build_filename(location, entry, (gchar*)NULL);
                 if (!g_file_test(to_open, G_FILE_TEST_IS_DIR))
                 {
+                    test_parallel_load_file(to_open);
+                    test_sax_load_file(to_open);
+                    test_journal_file(to_open);
+                    test_snapshot_file(to_open);
+                    test_deferred_scrub_file(to_open);
                     test_load_file(to_open);
                 }
                 g_free(to_open);
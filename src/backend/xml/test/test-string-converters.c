@@ -1,7 +1,10 @@
 #include "config.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
 
@@ -103,6 +106,233 @@ test_string_converters(void)
     }
 }
 
+/* The fast scalar parsers must agree with the general ones on
+   everything, not just on what gnucash writes. */
+
+#define FUZZ_ROUNDS 2000
+#define BENCHMARK_SAMPLES 1000
+#define BENCHMARK_ROUNDS 500000
+
+/* Parse str with the fast or the general parser, storing what was read
+   in result so that the two can be compared. */
+typedef gboolean (*parse_fn)(const gchar *str, gboolean general,
+                             gint64 result[2]);
+typedef gchar *(*random_string_fn)(void);
+
+static gboolean
+parse_timespec_secs(const gchar *str, gboolean general, gint64 result[2])
+{
+    Timespec ts = { 0, 0 };
+    gboolean ok;
+
+    ok = general ? string_to_timespec_secs_general(str, &ts)
+         : string_to_timespec_secs(str, &ts);
+    result[0] = ts.tv_sec;
+    return ok;
+}
+
+static gboolean
+parse_gint64(const gchar *str, gboolean general, gint64 result[2])
+{
+    return general ? string_to_gint64_general(str, &result[0])
+           : string_to_gint64(str, &result[0]);
+}
+
+static gboolean
+parse_guid(const gchar *str, gboolean general, gint64 result[2])
+{
+    GncGUID guid;
+    gboolean ok;
+
+    ok = general ? string_to_guid(str, &guid) : xml_string_to_guid(str, &guid);
+    memcpy(result, guid.data, GUID_DATA_SIZE);
+    return ok;
+}
+
+static gboolean
+parse_gnc_numeric(const gchar *str, gboolean general, gint64 result[2])
+{
+    gnc_numeric n = { 0, 1 };
+    gboolean ok;
+
+    ok = general ? string_to_gnc_numeric(str, &n)
+         : xml_string_to_gnc_numeric(str, &n);
+    result[0] = n.num;
+    result[1] = n.denom;
+    return ok;
+}
+
+static gchar *
+random_timespec_string(void)
+{
+    /* From the first century to the ninth millennium */
+    Timespec ts = { (gint64)rand() * 128 - G_GINT64_CONSTANT(62000000000), 0 };
+
+    return timespec_sec_to_string(&ts);
+}
+
+static gchar *
+random_gint64_string(void)
+{
+    gint64 v = ((gint64)rand() << 32 | rand()) >> get_random_int_in_range(0, 62);
+
+    return g_strdup_printf("%" G_GINT64_FORMAT, get_random_boolean() ? -v : v);
+}
+
+static gchar *
+random_guid_string(void)
+{
+    static const gchar hex_digits[] = "0123456789abcdef";
+    gchar *ret = g_new(gchar, GUID_ENCODING_LENGTH + 1);
+    int i;
+
+    for (i = 0; i < GUID_ENCODING_LENGTH; i++)
+        ret[i] = hex_digits[get_random_int_in_range(0, 15)];
+    ret[GUID_ENCODING_LENGTH] = '\0';
+    return ret;
+}
+
+static gchar *
+random_gnc_numeric_string(void)
+{
+    return gnc_numeric_to_string(get_random_gnc_numeric());
+}
+
+/* Copy str with one random edit at or after position keep: a character
+   replaced, the string cut short or a character appended. */
+static gchar *
+mutate_string(const gchar *str, int keep)
+{
+    static const gchar edit_chars[] = "0123456789abcdefABCDEFxX+-/: \t";
+    int len = strlen(str);
+    int pos = get_random_int_in_range(MIN(keep, len), len);
+    gchar c = edit_chars[get_random_int_in_range(0, sizeof(edit_chars) - 2)];
+    gchar *ret;
+
+    switch (get_random_int_in_range(0, 2))
+    {
+    case 0:
+        ret = g_strdup(str);
+        if (pos < len)
+            ret[pos] = c;
+        break;
+    case 1:
+        ret = g_strndup(str, pos);
+        break;
+    default:
+        ret = g_strdup_printf("%s%c", str, c);
+        break;
+    }
+    return ret;
+}
+
+static void
+check_same_result(const char *title, parse_fn parse, const gchar *str)
+{
+    gint64 fast[2] = { 0, 0 };
+    gint64 general[2] = { 0, 0 };
+    gboolean fast_ok = parse(str, FALSE, fast);
+    gboolean general_ok = parse(str, TRUE, general);
+
+    do_test_args(fast_ok == general_ok
+                 && fast[0] == general[0] && fast[1] == general[1],
+                 title, __FILE__, __LINE__, "with string \"%s\"", str);
+}
+
+static void
+benchmark_parser(const char *title, parse_fn parse,
+                 random_string_fn random_string)
+{
+    gchar *samples[BENCHMARK_SAMPLES];
+    gint64 result[2];
+    GTimer *timer = g_timer_new();
+    double elapsed[2];
+    int general;
+    int i;
+
+    for (i = 0; i < BENCHMARK_SAMPLES; i++)
+        samples[i] = random_string();
+
+    for (general = 0; general < 2; general++)
+    {
+        g_timer_start(timer);
+        for (i = 0; i < BENCHMARK_ROUNDS; i++)
+            parse(samples[i % BENCHMARK_SAMPLES], general, result);
+        elapsed[general] = g_timer_elapsed(timer, NULL);
+    }
+    printf("%s: %.1f ns fast, %.1f ns general\n", title,
+           elapsed[0] * 1e9 / BENCHMARK_ROUNDS,
+           elapsed[1] * 1e9 / BENCHMARK_ROUNDS);
+
+    for (i = 0; i < BENCHMARK_SAMPLES; i++)
+        g_free(samples[i]);
+    g_timer_destroy(timer);
+}
+
+static void
+test_fast_parser(const char *title, parse_fn parse,
+                 random_string_fn random_string, int keep,
+                 const gchar **edge_cases)
+{
+    int i;
+
+    for (i = 0; edge_cases[i]; i++)
+        check_same_result(title, parse, edge_cases[i]);
+
+    for (i = 0; i < FUZZ_ROUNDS; i++)
+    {
+        gchar *str = random_string();
+        gchar *mutated = mutate_string(str, keep);
+
+        check_same_result(title, parse, str);
+        check_same_result(title, parse, mutated);
+        g_free(str);
+        g_free(mutated);
+    }
+
+    if (g_getenv("VERBOSE"))
+        benchmark_parser(title, parse, random_string);
+}
+
+static const gchar *timespec_edge_cases[] =
+{
+    "2000-02-29 12:00:00 +0000",
+    "1900-02-29 12:00:00 +0000",
+    "2001-02-30 12:00:00 -0500",
+    "2001-12-31 23:59:60 +0000",
+    "9999-12-31 23:59:59 -1400",
+    "2001-01-01 00:00:00 +0530 ",
+    "2001-01-01 00:00:00 0530",
+    "2001-01-01  0:00:00 +0000",
+    NULL
+};
+
+static const gchar *gint64_edge_cases[] =
+{
+    "0", "-0", "+7", " 7", "7 ", "007", "--7", "7x", "",
+    "999999999999999999", "-999999999999999999",
+    "9223372036854775807", "-9223372036854775808", "99999999999999999999",
+    NULL
+};
+
+static const gchar *guid_edge_cases[] =
+{
+    "0123456789abcdef0123456789ABCDEF",
+    "0123456789abcdef0123456789abcdef trailing",
+    "0123456789abcdef0123456789abcde",
+    "0123456789abcdef0123456789abcdeg",
+    "",
+    NULL
+};
+
+static const gchar *gnc_numeric_edge_cases[] =
+{
+    "0/1", "-0/1", "1/0", "-5/-100", "010/8", "0x10/1", " 5/1", "5/1 ",
+    "5/ 1", "+5/1", "5", "5/", "/5", "5/1/2",
+    "123456789012345678/1", "9223372036854775807/1",
+    NULL
+};
+
 int
 main(int argc, char **argv)
 {
@@ -111,6 +341,16 @@ main(int argc, char **argv)
     fflush(stdout);
     test_string_converters();
     fflush(stdout);
+    /* Leave the year alone: the general parser cannot handle year 0. */
+    test_fast_parser("timespec secs", parse_timespec_secs,
+                     random_timespec_string, 4, timespec_edge_cases);
+    test_fast_parser("gint64", parse_gint64, random_gint64_string, 0,
+                     gint64_edge_cases);
+    test_fast_parser("guid", parse_guid, random_guid_string, 0,
+                     guid_edge_cases);
+    test_fast_parser("gnc_numeric", parse_gnc_numeric,
+                     random_gnc_numeric_string, 0, gnc_numeric_edge_cases);
+    fflush(stdout);
     print_test_results();
     exit(get_rv());
 }
@@ -27,6 +27,7 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/types.h>
@@ -367,6 +368,62 @@ test_add_transaction(const char *tag, gpointer globaldata, gpointer data)
     return retval;
 }
 
+/* Like gnc_xml_parse_file, but converting the transactions on worker
+   threads. */
+static gboolean
+parse_file_pipelined(sixtp *parser, const char *filename,
+                     gxpf_callback callback, gpointer parsedata,
+                     QofBook *bookdata)
+{
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+    gboolean retval;
+
+    gpdata.cb = callback;
+    gpdata.parsedata = parsedata;
+    gpdata.bookdata = bookdata;
+    gpdata.txn_pipeline = gnc_txn_pipeline_new(2);
+    gpdata.skip_transactions = FALSE;
+
+    retval = sixtp_parse_file(parser, filename, NULL, &gpdata, &parse_result);
+
+    gnc_txn_pipeline_flush(gpdata.txn_pipeline, &gpdata);
+    gnc_txn_pipeline_destroy(gpdata.txn_pipeline);
+
+    return retval;
+}
+
+/* Check that the streaming writer produces exactly the bytes the DOM
+   tree would have been dumped as. */
+static char *
+streamed_and_dom_equal(Transaction *trn)
+{
+    xmlNodePtr node;
+    xmlBufferPtr dom_buf, stream_buf;
+    xmlOutputBufferPtr out;
+    char *msg = NULL;
+    gboolean written;
+
+    node = gnc_transaction_dom_tree_create(trn);
+    dom_buf = xmlBufferCreate();
+    xmlNodeDump(dom_buf, NULL, node, 0, 1);
+    xmlFreeNode(node);
+
+    stream_buf = xmlBufferCreate();
+    out = xmlOutputBufferCreateBuffer(stream_buf, NULL);
+    written = gnc_transaction_write_xml(out, trn);
+    if (xmlOutputBufferClose(out) < 0 || !written)
+        msg = "gnc_transaction_write_xml failed";
+    else if (xmlBufferLength(dom_buf) != xmlBufferLength(stream_buf)
+             || memcmp(xmlBufferContent(dom_buf), xmlBufferContent(stream_buf),
+                       xmlBufferLength(dom_buf)) != 0)
+        msg = "streamed output differs from the dom tree";
+
+    xmlBufferFree(dom_buf);
+    xmlBufferFree(stream_buf);
+    return msg;
+}
+
 static void
 test_transaction(void)
 {
@@ -440,6 +497,16 @@ test_transaction(void)
             success_args("transaction_xml", __FILE__, __LINE__, "%d", i );
         }
 
+        if ((compare_msg = streamed_and_dom_equal(ran_trn)) != NULL)
+        {
+            failure_args("transaction_xml", __FILE__, __LINE__,
+                         "%s", compare_msg);
+        }
+        else
+        {
+            success_args("transaction_write_xml", __FILE__, __LINE__, "%d", i);
+        }
+
         filename1 = g_strdup_printf("test_file_XXXXXX");
 
         fd = g_mkstemp(filename1);
@@ -466,6 +533,7 @@ test_transaction(void)
         {
             sixtp *parser;
             tran_data data;
+            int j;
 
             gchar *msg = "[xaccAccountScrubCommodity()] Account \"\" does not have a commodity!";
             gchar *logdomain = "gnc.engine.scrub";
@@ -476,16 +544,33 @@ test_transaction(void)
             data.trn = ran_trn;
             data.com = com;
             data.value = i;
-            parser = gnc_transaction_sixtp_parser_create();
 
-            if (!gnc_xml_parse_file(parser, filename1, test_add_transaction,
-                                    (gpointer)&data, book))
+            /* Load with the streaming parser, serially and pipelined,
+               and with the DOM parser; each must reproduce the original
+               transaction. */
+            for (j = 0; j < 3; j++)
             {
-                failure_args("gnc_xml_parse_file returned FALSE",
-                             __FILE__, __LINE__, "%d", i);
+                gboolean parsed;
+
+                parser = j == 2 ? gnc_transaction_dom_sixtp_parser_create()
+                         : gnc_transaction_sixtp_parser_create();
+
+                if (j == 1)
+                    parsed = parse_file_pipelined(parser, filename1,
+                                                  test_add_transaction,
+                                                  (gpointer)&data, book);
+                else
+                    parsed = gnc_xml_parse_file(parser, filename1,
+                                                test_add_transaction,
+                                                (gpointer)&data, book);
+                if (!parsed)
+                {
+                    failure_args("gnc_xml_parse_file returned FALSE",
+                                 __FILE__, __LINE__, "%d", i);
+                }
+                else
+                    really_get_rid_of_transaction (data.new_trn);
             }
-            else
-                really_get_rid_of_transaction (data.new_trn);
 
             /* no handling of circular data structures.  We'll do that later */
             /* sixtp_destroy(parser); */
@@ -507,6 +592,9 @@ test_real_transaction(const char *tag, gpointer global_data, gpointer data)
                                      (Transaction*)data);
     do_test_args(msg == NULL, "test_real_transaction",
                  __FILE__, __LINE__, msg);
+    msg = streamed_and_dom_equal((Transaction*)data);
+    do_test_args(msg == NULL, "test_real_transaction_write_xml",
+                 __FILE__, __LINE__, msg);
     really_get_rid_of_transaction((Transaction*)data);
     return TRUE;
 }
@@ -0,0 +1,149 @@
+/***************************************************************************
+ *            test-xml2-compress.c
+ *
+ *  Checks that compressed saves decompress to exactly the uncompressed
+ *  file, whatever the number of compression threads.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <gnc-engine.h>
+#include <cashobjects.h>
+#include <TransLog.h>
+#include "../io-gncxml-v2.h"
+
+#include <test-stuff.h>
+#include <test-engine-stuff.h>
+
+#define PLAIN_FILE "test-xml2-compress.xml"
+#define COMPRESSED_FILE "test-xml2-compress.xml.gz"
+
+/* Read a file, decompressing it if it is gzipped. */
+static GString *
+read_file(const char *filename)
+{
+    GString *contents = g_string_new(NULL);
+    gchar buffer[4096];
+    gzFile file;
+    gint bytes;
+
+    file = gzopen(filename, "rb");
+    if (file == NULL)
+    {
+        g_string_free(contents, TRUE);
+        return NULL;
+    }
+
+    while ((bytes = gzread(file, buffer, sizeof(buffer))) > 0)
+        g_string_append_len(contents, buffer, bytes);
+
+    if (gzclose(file) != Z_OK || bytes < 0)
+    {
+        g_string_free(contents, TRUE);
+        return NULL;
+    }
+
+    return contents;
+}
+
+static void
+test_compressed_save(QofBook *book, const GString *plain, const char *threads,
+                     const char *level)
+{
+    GString *unzipped;
+    GTimer *timer;
+    gboolean written;
+
+    g_setenv("GNC_XML_SAVE_THREADS", threads, TRUE);
+    if (level)
+        g_setenv("GNC_XML_COMPRESSION_LEVEL", level, TRUE);
+    else
+        g_unsetenv("GNC_XML_COMPRESSION_LEVEL");
+
+    timer = g_timer_new();
+    written = gnc_book_write_to_xml_file_v2(book, COMPRESSED_FILE, TRUE);
+    g_timer_stop(timer);
+
+    if (!do_test_args(written, "compressed save", __FILE__, __LINE__,
+                      "threads %s", threads))
+    {
+        g_timer_destroy(timer);
+        return;
+    }
+
+    if (g_getenv("VERBOSE"))
+        printf("compressed save with %s thread(s), level %s: %.3f s\n",
+               threads, level ? level : "default",
+               g_timer_elapsed(timer, NULL));
+    g_timer_destroy(timer);
+
+    unzipped = read_file(COMPRESSED_FILE);
+    do_test_args(unzipped != NULL
+                 && unzipped->len == plain->len
+                 && memcmp(unzipped->str, plain->str, plain->len) == 0,
+                 "compressed save round trip", __FILE__, __LINE__,
+                 "threads %s", threads);
+    if (unzipped)
+        g_string_free(unzipped, TRUE);
+
+    g_unlink(COMPRESSED_FILE);
+}
+
+int
+main (int argc, char ** argv)
+{
+    QofBook *book;
+    GString *plain;
+
+    qof_init();
+    cashobjects_register();
+    xaccLogDisable();
+
+    book = get_random_book();
+    /* Make sure the file spans several compression blocks. */
+    add_random_transactions_to_book(book, 500);
+
+    if (!gnc_book_write_to_xml_file_v2(book, PLAIN_FILE, FALSE)
+            || (plain = read_file(PLAIN_FILE)) == NULL)
+    {
+        failure("uncompressed save");
+    }
+    else
+    {
+        test_compressed_save(book, plain, "1", NULL);
+        test_compressed_save(book, plain, "2", NULL);
+        test_compressed_save(book, plain, "4", NULL);
+        test_compressed_save(book, plain, "8", NULL);
+        test_compressed_save(book, plain, "4", "1");
+        test_compressed_save(book, plain, "4", "9");
+        g_string_free(plain, TRUE);
+    }
+    g_unlink(PLAIN_FILE);
+
+    print_test_results();
+    qof_close();
+    exit(get_rv());
+}
@@ -79,6 +79,7 @@ static int          debugging        = 0;
 static int          extra            = 0;
 static gchar      **log_flags        = NULL;
 static gchar       *log_to_filename  = NULL;
+static gchar       *profile_filename = NULL;
 static int          nofile           = 0;
 static const gchar *gconf_path       = NULL;
 static const char  *add_quotes_file  = NULL;
@@ -115,6 +116,14 @@ static GOptionEntry options[] =
         NULL
     },
 
+    {
+        "profile-load", '\0', 0, G_OPTION_ARG_STRING, &profile_filename,
+        N_("Append the time taken by each phase of loading and saving files to FILE, one line of JSON per load or save"),
+        /* Translators: Argument description for autohelp; see
+           http://developer.gnome.org/doc/API/2.0/glib/glib-Commandline-option-parser.html */
+        N_("FILE")
+    },
+
     {
         "nofile", '\0', 0, G_OPTION_ARG_NONE, &nofile,
         N_("Do not load the last file opened"), NULL
@@ -860,6 +869,8 @@ main(int argc, char ** argv)
     gnc_print_unstable_message();
 
     gnc_log_init();
+    if (profile_filename)
+        qof_profile_set_output_file(profile_filename);
 
     /* If asked via a command line parameter, fetch quotes only */
     if (add_quotes_file)
@@ -45,6 +45,9 @@ static QofLogModule log_module = GNC_MOD_ACCOUNT;
 static gchar account_separator[8] = ".";
 static gunichar account_uc_separator = ':';
 
+/* Bumped each time the balances of an account are recomputed. */
+static guint balance_generation = 0;
+
 enum
 {
     LAST_SIGNAL
@@ -254,6 +257,7 @@ gnc_account_init(Account* acc)
 
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->unreconciled_splits = NULL;
 }
 
 static void
@@ -1107,6 +1111,8 @@ xaccFreeAccount (Account *acc)
 
     priv->balance_dirty = FALSE;
     priv->sort_dirty = FALSE;
+    g_list_free (priv->unreconciled_splits);
+    priv->unreconciled_splits = NULL;
 
     /* qof_instance_release (&acc->inst); */
     g_object_unref(acc);
@@ -1881,7 +1887,7 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
+    GList *lp, *unreconciled = NULL;
 
     if (NULL == acc) return;
 
@@ -1915,6 +1921,11 @@ xaccAccountRecomputeBalance (Account * acc)
             reconciled_balance =
                 gnc_numeric_add_fixed(reconciled_balance, amt);
         }
+        else if (NREC == split->reconciled ||
+                 CREC == split->reconciled)
+        {
+            unreconciled = g_list_prepend (unreconciled, split);
+        }
 
         split->balance = balance;
         split->cleared_balance = cleared_balance;
@@ -1925,7 +1936,16 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->balance = balance;
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
+    g_list_free (priv->unreconciled_splits);
+    priv->unreconciled_splits = g_list_reverse (unreconciled);
     priv->balance_dirty = FALSE;
+    balance_generation++;
+}
+
+guint
+gnc_account_get_balance_generation (void)
+{
+    return balance_generation;
 }
 
 /********************************************************************\
@@ -3541,6 +3561,31 @@ xaccAccountGetSplitList (const Account *acc)
     return GET_PRIVATE(acc)->splits;
 }
 
+SplitList *
+xaccAccountGetUnreconciledSplitList (const Account *acc)
+{
+    AccountPrivate *priv;
+    GList *lp, *result = NULL;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+
+    xaccAccountBringUpToDate ((Account*)acc);
+    priv = GET_PRIVATE(acc);
+    if (!priv->balance_dirty)
+        return g_list_copy (priv->unreconciled_splits);
+
+    /* The account is being edited; the index is stale, so look at
+     * every split instead. */
+    for (lp = priv->splits; lp; lp = lp->next)
+    {
+        Split *split = lp->data;
+
+        if (NREC == split->reconciled || CREC == split->reconciled)
+            result = g_list_prepend (result, split);
+    }
+    return g_list_reverse (result);
+}
+
 LotList *
 xaccAccountGetLotList (const Account *acc)
 {
@@ -396,6 +396,12 @@ GNCPolicy *gnc_account_get_policy (Account *account);
  */
 void xaccAccountRecomputeBalance (Account *);
 
+/** A number that changes whenever the balances of any account are
+ *  recomputed, whether or not events were suspended at the time.
+ *  Something that caches balances can compare it to the value it saw
+ *  when it filled the cache. */
+guint gnc_account_get_balance_generation (void);
+
 /** The xaccAccountSortSplits() routine will resort the account's
  *  splits if the sort is dirty. If 'force' is true, the account
  *  is sorted even if the editlevel is not zero.
@@ -964,6 +970,15 @@ guint32 xaccAccountTypesValid(void);
  */
 SplitList* xaccAccountGetSplitList (const Account *account);
 
+/** The xaccAccountGetUnreconciledSplitList() routine returns the
+ *    splits of the account that are either not reconciled or only
+ *    cleared, in the same order as xaccAccountGetSplitList().  The
+ *    list is kept up to date with the account balances, so this does
+ *    not walk the splits that are already reconciled.
+ * @note The caller must free the returned list with g_list_free().
+ */
+SplitList* xaccAccountGetUnreconciledSplitList (const Account *account);
+
 /** The xaccAccountMoveAllSplits() routine reassigns each of the splits
  *  in accfrom to accto. */
 void xaccAccountMoveAllSplits (Account *accfrom, Account *accto);
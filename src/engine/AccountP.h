@@ -113,6 +113,11 @@ typedef struct AccountPrivate
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
+    /* The splits that are neither reconciled nor frozen nor voided, in
+     * the order of splits.  Rebuilt with the balances, so only valid
+     * while balance_dirty is FALSE. */
+    GList *unreconciled_splits;
+
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
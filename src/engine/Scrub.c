@@ -55,6 +55,7 @@
 #define G_LOG_DOMAIN "gnc.engine.scrub"
 
 static QofLogModule log_module = G_LOG_DOMAIN;
+static gint scrub_depth = 0;
 
 /* ================================================================ */
 
@@ -1344,6 +1345,267 @@ xaccAccountScrubKvp (Account *account)
 
 /* ================================================================ */
 
+/* Bump this whenever the scrubs run by xaccBookScrubAfterLoad change,
+ * so that books marked clean by older code are scrubbed again. */
+#define SCRUB_VERSION 1
+#define SCRUB_VERSION_PATH "scrubbed/version"
+#define SCRUB_CHECKSUM_PATH "scrubbed/checksum"
+/* Book data set once the book is known to be clean in this session */
+#define SCRUB_DONE_KEY "gnc-scrub-after-load-done"
+
+static gboolean
+account_has_old_data (const Account *account)
+{
+    return (kvp_frame_get_slot (account->inst.kvp_data, "old-currency") ||
+            kvp_frame_get_slot (account->inst.kvp_data, "old-security") ||
+            kvp_frame_get_slot (account->inst.kvp_data, "old-currency-scu") ||
+            kvp_frame_get_slot (account->inst.kvp_data, "old-security-scu"));
+}
+
+static gboolean
+account_has_old_price_source (const Account *account)
+{
+    return (dxaccAccountGetPriceSrc (account) != NULL ||
+            kvp_frame_get_slot (account->inst.kvp_data, "old-quote-tz"));
+}
+
+static void
+scrub_after_load_account (Account *account, gpointer data)
+{
+    ScrubReport *report = data;
+    gboolean changed = FALSE;
+    GList *node;
+
+    if (!xaccAccountGetCommodity (account) &&
+            xaccAccountGetType (account) != ACCT_TYPE_ROOT)
+    {
+        xaccAccountScrubCommodity (account);
+        changed = TRUE;
+    }
+    if (account_has_old_data (account))
+    {
+        xaccAccountDeleteOldData (account);
+        changed = TRUE;
+    }
+    if (changed)
+        report->accounts++;
+
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    {
+        Split *split = node->data;
+        gnc_numeric amount = split->amount;
+        gnc_numeric value = split->value;
+
+        xaccSplitScrub (split);
+        if (!gnc_numeric_equal (split->amount, amount) ||
+                !gnc_numeric_equal (split->value, value))
+            report->splits++;
+    }
+}
+
+typedef struct
+{
+    ScrubReport *report;
+    gboolean new_style;
+} QuoteSourceData;
+
+static void
+scrub_after_load_quote_source (Account *account, gpointer data)
+{
+    QuoteSourceData *qsd = data;
+
+    if (!account_has_old_price_source (account))
+        return;
+    qsd->report->accounts++;
+    move_quote_source (account, GINT_TO_POINTER(qsd->new_style));
+}
+
+static int
+scrub_after_load_trans (Transaction *trans, gpointer data)
+{
+    ScrubReport *report = data;
+    gboolean had_currency = (xaccTransGetCurrency (trans) != NULL);
+
+    xaccTransScrubCurrency (trans);
+    if (!had_currency && xaccTransGetCurrency (trans))
+        report->transactions++;
+    return 0;
+}
+
+void
+xaccBookScrubAfterLoad (QofBook *book, ScrubReport *report)
+{
+    ScrubReport counts = { 0, 0, 0 };
+    QuoteSourceData qsd = { &counts, FALSE };
+    Account *root;
+
+    g_return_if_fail (book);
+
+    ENTER ("(book=%p)", book);
+    root = gnc_book_get_root_account (book);
+    scrub_depth++;
+    qof_event_suspend ();
+
+    /* Quote sources move from the accounts to their commodities unless
+     * a commodity already has one. */
+    gnc_commodity_table_foreach_commodity (gnc_commodity_table_get_table (book),
+                                           check_quote_source, &qsd.new_style);
+    scrub_after_load_quote_source (root, &qsd);
+    gnc_account_foreach_descendant (root, scrub_after_load_quote_source, &qsd);
+
+    /* The transaction currencies come first, as they may be found from
+     * the old account currencies that the account scrub removes. */
+    xaccAccountTreeForEachTransaction (root, scrub_after_load_trans, &counts);
+
+    scrub_after_load_account (root, &counts);
+    gnc_account_foreach_descendant (root, scrub_after_load_account, &counts);
+
+    qof_event_resume ();
+    scrub_depth--;
+    qof_book_set_data (book, SCRUB_DONE_KEY, GINT_TO_POINTER (TRUE));
+
+    if (counts.accounts || counts.transactions || counts.splits)
+        PWARN ("Scrubbing fixed %u accounts, %u transactions and %u splits",
+               counts.accounts, counts.transactions, counts.splits);
+    else
+        PINFO ("Scrubbing changed nothing");
+    if (report)
+        *report = counts;
+    LEAVE ("(book=%p)", book);
+}
+
+/* Order-independent checksum of the data the scrubs look at: every
+ * account's commodity and old data, and every split's account,
+ * transaction currency, amount and value.  Each object is hashed with
+ * FNV-1a and the hashes are summed. */
+
+#define CHECKSUM_SEED G_GUINT64_CONSTANT(14695981039346656037)
+#define CHECKSUM_PRIME G_GUINT64_CONSTANT(1099511628211)
+
+static guint64
+checksum_bytes (guint64 hash, gconstpointer data, gsize len)
+{
+    const guchar *p = data;
+
+    while (len--)
+    {
+        hash ^= *p++;
+        hash *= CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+static guint64
+checksum_string (guint64 hash, const gchar *str)
+{
+    return checksum_bytes (hash, str ? str : "", str ? strlen (str) + 1 : 1);
+}
+
+static guint64
+checksum_guid (guint64 hash, gconstpointer inst)
+{
+    return checksum_bytes (hash, qof_entity_get_guid (inst), sizeof (GncGUID));
+}
+
+static guint64
+checksum_numeric (guint64 hash, gnc_numeric n)
+{
+    hash = checksum_bytes (hash, &n.num, sizeof (n.num));
+    return checksum_bytes (hash, &n.denom, sizeof (n.denom));
+}
+
+static void
+checksum_account (Account *account, gpointer data)
+{
+    guint64 *sum = data;
+    guint64 hash = checksum_guid (CHECKSUM_SEED, account);
+    gnc_commodity *commodity = xaccAccountGetCommodity (account);
+    guchar old_data = (account_has_old_data (account) << 1) |
+                      account_has_old_price_source (account);
+    GList *node;
+
+    hash = checksum_string (hash, gnc_commodity_get_unique_name (commodity));
+    hash = checksum_bytes (hash, &old_data, sizeof (old_data));
+    *sum += hash;
+
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    {
+        Split *split = node->data;
+        Transaction *trans = split->parent;
+
+        hash = checksum_guid (CHECKSUM_SEED, split);
+        hash = checksum_guid (hash, account);
+        hash = checksum_string (hash, trans ? gnc_commodity_get_unique_name
+                                (xaccTransGetCurrency (trans)) : NULL);
+        hash = checksum_numeric (hash, split->amount);
+        hash = checksum_numeric (hash, split->value);
+        *sum += hash;
+    }
+}
+
+static gint64
+book_scrub_checksum (QofBook *book)
+{
+    Account *root = gnc_book_get_root_account (book);
+    guint64 sum = 0;
+
+    checksum_account (root, &sum);
+    gnc_account_foreach_descendant (root, checksum_account, &sum);
+    return (gint64) sum;
+}
+
+gboolean
+xaccBookMarkScrubbed (QofBook *book)
+{
+    KvpFrame *slots;
+
+    g_return_val_if_fail (book, FALSE);
+
+    if (!qof_book_get_data (book, SCRUB_DONE_KEY))
+    {
+        PINFO ("(book=%p) was never scrubbed, not marking it", book);
+        return FALSE;
+    }
+
+    /* The marker describes the data as it was loaded, so writing it is
+     * part of the scrub and not an edit of the book. */
+    scrub_depth++;
+    qof_book_begin_edit (book);
+    slots = qof_book_get_slots (book);
+    kvp_frame_set_gint64 (slots, SCRUB_VERSION_PATH, SCRUB_VERSION);
+    kvp_frame_set_gint64 (slots, SCRUB_CHECKSUM_PATH, book_scrub_checksum (book));
+    qof_book_commit_edit (book);
+    scrub_depth--;
+    return TRUE;
+}
+
+gboolean
+xaccBookIsScrubbed (QofBook *book)
+{
+    KvpFrame *slots;
+
+    g_return_val_if_fail (book, FALSE);
+
+    slots = qof_book_get_slots (book);
+    if (kvp_frame_get_gint64 (slots, SCRUB_VERSION_PATH) != SCRUB_VERSION)
+        return FALSE;
+    if (kvp_frame_get_gint64 (slots, SCRUB_CHECKSUM_PATH) !=
+            book_scrub_checksum (book))
+        return FALSE;
+
+    /* Verified clean, so it is as good as scrubbed */
+    qof_book_set_data (book, SCRUB_DONE_KEY, GINT_TO_POINTER (TRUE));
+    return TRUE;
+}
+
+gboolean
+gnc_get_ongoing_scrub (void)
+{
+    return scrub_depth > 0;
+}
+
+/* ================================================================ */
+
 Account *
 xaccScrubUtilityGetOrMakeAccount (Account *root, gnc_commodity * currency,
                                   const char *accname, GNCAccountType acctype,
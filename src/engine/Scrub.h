@@ -151,6 +151,55 @@ void xaccAccountTreeScrubQuoteSources (Account *root, gnc_commodity_table *table
 
 void xaccAccountScrubKvp (Account *account);
 
+/** @name Scrubbing After Load
+    A file backend scrubs every account, transaction and split of a
+    book it has just loaded, although a book saved by this version of
+    GnuCash is already clean.  Right after the scrub, xaccBookMarkScrubbed
+    records in the book that it is clean, together with a checksum of
+    the data the scrubs look at.  The marker is saved with the book, so
+    that the next load can check with xaccBookIsScrubbed whether
+    scrubbing can be skipped; edits made after the scrub change the
+    data and so void the marker.
+    @{ */
+
+/** Counts of the objects changed by xaccBookScrubAfterLoad. */
+typedef struct
+{
+    guint accounts;
+    guint transactions;
+    guint splits;
+} ScrubReport;
+
+/** Run the quote source, commodity and split scrubs over all the
+ *  accounts of the book in one batch, with events suspended, and log
+ *  what was changed.
+ *
+ *  @param report If not NULL, filled with the number of objects
+ *  changed.
+ */
+void xaccBookScrubAfterLoad (QofBook *book, ScrubReport *report);
+
+/** Record in the book that it is clean, with the checksum of its data
+ *  as it is now.  Call this right after xaccBookScrubAfterLoad, before
+ *  anything else edits the book.  Only a book that
+ *  xaccBookScrubAfterLoad ran over, or that xaccBookIsScrubbed found
+ *  clean, in this session is marked.  Writing the marker doesn't dirty
+ *  the book.
+ *
+ *  @return TRUE if the book was marked. */
+gboolean xaccBookMarkScrubbed (QofBook *book);
+
+/** Whether the book was marked clean by this version of the scrub
+ *  code and its data hasn't changed since.  Walks all the splits.
+ *  A book found clean may be marked again by xaccBookMarkScrubbed. */
+gboolean xaccBookIsScrubbed (QofBook *book);
+
+/** Whether xaccBookScrubAfterLoad is running, so that the edits it
+ *  makes can be told from the user's. */
+gboolean gnc_get_ongoing_scrub (void);
+
+/** @} */
+
 #endif /* XACC_SCRUB_H */
 /** @} */
 /** @} */
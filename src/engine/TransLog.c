@@ -148,6 +148,12 @@ xaccFileIsCurrentLog (const gchar *name)
     return result;
 }
 
+const gchar *
+xaccLogGetCurrentName (void)
+{
+    return trans_log_name;
+}
+
 /********************************************************************\
 \********************************************************************/
 
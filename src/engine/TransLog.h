@@ -81,6 +81,10 @@ void    xaccLogSetBaseName (const char *);
 /** Test a filename to see if it is the name of the current logfile */
 gboolean xaccFileIsCurrentLog (const gchar *name);
 
+/** The name, without its directory, of the current log file, or NULL
+ *  if no log file has been opened. */
+const gchar *xaccLogGetCurrentName (void);
+
 #endif /* XACC_TRANS_LOG_H */
 /** @} */
 /** @} */
@@ -1282,7 +1282,9 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
                 clr_bal = gnc_numeric_zero ();
     SetupData *sdata = (SetupData*)pData;
     TxnParms* t_arr;
-    int ind;
+    GList *unrec, *node;
+    int ind, num_unrec = 0;
+    guint generation = gnc_account_get_balance_generation ();
     g_assert (sdata != NULL);
     t_arr = (TxnParms*)sdata->txns;
     for (ind = 0; ind < sdata->num_txns; ind++)
@@ -1293,6 +1295,8 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
             clr_bal = gnc_numeric_add_fixed (clr_bal, p.amount);
         if (p.reconciled == YREC || p.reconciled == FREC)
             rec_bal = gnc_numeric_add_fixed (rec_bal, p.amount);
+        if (p.reconciled == NREC || p.reconciled == CREC)
+            ++num_unrec;
     }
     g_assert (gnc_numeric_zero_p (priv->starting_balance));
     g_assert (gnc_numeric_zero_p (priv->balance));
@@ -1303,6 +1307,20 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
     g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
     g_assert (!priv->balance_dirty);
+    g_assert_cmpuint (gnc_account_get_balance_generation (), !=, generation);
+    /* Nothing to recompute, so nothing changes */
+    generation = gnc_account_get_balance_generation ();
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert_cmpuint (gnc_account_get_balance_generation (), ==, generation);
+
+    unrec = xaccAccountGetUnreconciledSplitList (fixture->acct);
+    g_assert_cmpint (g_list_length (unrec), ==, num_unrec);
+    for (node = unrec; node; node = node->next)
+    {
+        char recn = xaccSplitGetReconcile (node->data);
+        g_assert (recn == NREC || recn == CREC);
+    }
+    g_list_free (unrec);
 }
 
 /* xaccAccountOrder
@@ -52,6 +52,9 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define DIALOG_SEARCH_CM_CLASS "dialog-search"
 #define KEY_ACTIVE_ONLY "search_for_active_only"
 
+/* Number of results added to the result view per idle call */
+#define SEARCH_RESULT_PAGE_SIZE 250
+
 typedef enum
 {
     GNC_SEARCH_MATCH_ALL = 0,
@@ -75,6 +78,8 @@ struct _GNCSearchWindow
 
     /* The "results" sub-window widgets */
     GtkWidget               *result_view;
+    GtkWidget               *result_count_label;
+    GtkWidget               *stop_button;
     gpointer	             selected_item;
     GList                   *selected_item_list;
 
@@ -288,12 +293,57 @@ gnc_search_dialog_double_click_cb (GNCQueryView *qview,
 }
 
 
+/* Show the number of results so far, and once they are all in apply
+ * the 'new search' limit.  A stopped fill only shows part of the
+ * results, so its count says nothing about that limit. */
+static void
+gnc_search_dialog_update_count (GNCSearchWindow *sw)
+{
+    GNCQueryView *qview = GNC_QUERY_VIEW(sw->result_view);
+    gint num_entries = gnc_query_view_get_num_entries (qview);
+    gboolean filling = gnc_query_view_is_filling (qview);
+    gchar *text;
+
+    text = g_strdup_printf (ngettext ("%d item found", "%d items found",
+                                      num_entries), num_entries);
+    gtk_label_set_text (GTK_LABEL (sw->result_count_label), text);
+    g_free (text);
+
+    gtk_widget_set_sensitive (sw->stop_button, filling);
+    if (filling || gnc_query_view_fill_cancelled (qview))
+        return;
+
+    /* set 'new search' if fewer than max_count items is returned. */
+    if (num_entries < gnc_gconf_get_float ("dialogs/search", "new_search_limit", NULL))
+        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (sw->new_rb), TRUE);
+}
+
+
+static void
+gnc_search_dialog_entries_loaded_cb (GNCQueryView *qview, gpointer count,
+                                     GNCSearchWindow *sw)
+{
+    gnc_search_dialog_update_count (sw);
+}
+
+
+static void
+gnc_search_dialog_stop_cb (GtkButton *button, GNCSearchWindow *sw)
+{
+    gnc_query_view_cancel_fill (GNC_QUERY_VIEW(sw->result_view));
+}
+
+
 static void
 gnc_search_dialog_init_result_view (GNCSearchWindow *sw)
 {
     GtkTreeSelection *selection;
 
-    sw->result_view = gnc_query_view_new(sw->display_list, sw->q);
+    /* Large results go into the view a page at a time from the idle
+     * loop, so adding the rows does not block the dialog and can be
+     * stopped.  The query itself still runs before the first page. */
+    sw->result_view = gnc_query_view_new_paged (sw->display_list, sw->q,
+                      SEARCH_RESULT_PAGE_SIZE);
 
     // We want the multi-selection mode of the tree view.
     selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(sw->result_view));
@@ -308,21 +358,22 @@ gnc_search_dialog_init_result_view (GNCSearchWindow *sw)
 
     g_signal_connect (GNC_QUERY_VIEW(sw->result_view), "double_click_entry",
                       G_CALLBACK(gnc_search_dialog_double_click_cb), sw);
+
+    g_signal_connect (GNC_QUERY_VIEW(sw->result_view), "entries_loaded",
+                      G_CALLBACK(gnc_search_dialog_entries_loaded_cb), sw);
 }
 
 
 static void
 gnc_search_dialog_display_results (GNCSearchWindow *sw)
 {
-    gdouble max_count;
-
     /* Check if this is the first time this is called for this window.
      * If so, then build the results sub-window, the scrolled treeview,
      * and the active buttons.
      */
     if (sw->result_view == NULL)
     {
-        GtkWidget *scroller, *frame, *button_box, *button;
+        GtkWidget *scroller, *frame, *button_box, *button, *vbox, *hbox;
 
         /* Create the view */
         gnc_search_dialog_init_result_view (sw);
@@ -336,7 +387,21 @@ gnc_search_dialog_display_results (GNCSearchWindow *sw)
                                         GTK_POLICY_AUTOMATIC);
         gtk_widget_set_size_request(GTK_WIDGET(scroller), 300, 100);
         gtk_container_add (GTK_CONTAINER (scroller), sw->result_view);
-        gtk_container_add(GTK_CONTAINER(frame), scroller);
+
+        /* Create the result count and the stop button below it */
+        hbox = gtk_hbox_new (FALSE, 3);
+        sw->result_count_label = gtk_label_new (NULL);
+        gtk_misc_set_alignment (GTK_MISC (sw->result_count_label), 0.0, 0.5);
+        gtk_box_pack_start (GTK_BOX (hbox), sw->result_count_label, TRUE, TRUE, 3);
+        sw->stop_button = gtk_button_new_from_stock (GTK_STOCK_STOP);
+        g_signal_connect (G_OBJECT (sw->stop_button), "clicked",
+                          G_CALLBACK (gnc_search_dialog_stop_cb), sw);
+        gtk_box_pack_end (GTK_BOX (hbox), sw->stop_button, FALSE, FALSE, 3);
+
+        vbox = gtk_vbox_new (FALSE, 3);
+        gtk_box_pack_start (GTK_BOX (vbox), scroller, TRUE, TRUE, 0);
+        gtk_box_pack_start (GTK_BOX (vbox), hbox, FALSE, FALSE, 0);
+        gtk_container_add(GTK_CONTAINER(frame), vbox);
 
         /* Create the button_box */
         button_box = gtk_vbox_new (FALSE, 3);
@@ -389,10 +454,8 @@ gnc_search_dialog_display_results (GNCSearchWindow *sw)
     gnc_search_dialog_select_buttons_enable (sw, 0);
     gnc_query_view_unselect_all (GNC_QUERY_VIEW(sw->result_view));
 
-    /* set 'new search' if fewer than max_count items is returned. */
-    max_count = gnc_gconf_get_float("dialogs/search", "new_search_limit", NULL);
-    if (gnc_query_view_get_num_entries(GNC_QUERY_VIEW(sw->result_view)) < max_count)
-        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON (sw->new_rb), TRUE);
+    /* The first page may have been all there was */
+    gnc_search_dialog_update_count (sw);
 }
 
 
@@ -140,10 +140,10 @@ static void month_coords(GncDenseCal *dcal, int monthOfCal, GList **outList);
 static void doc_coords(GncDenseCal *dcal, int dayOfCal,
                        int *x1, int *y1, int *x2, int *y2);
 
-static void gdc_mark_add(GncDenseCal *dcal, guint tag, gchar *name, gchar *info, guint size, GDate **dateArray);
+static void gdc_mark_add(GncDenseCal *dcal, guint tag, gchar *name, gchar *info, guint size, GDate **dateArray, gboolean redraw);
 static void gdc_mark_remove(GncDenseCal *dcal, guint mark_to_remove, gboolean redraw);
 
-static void gdc_add_tag_markings(GncDenseCal *cal, guint tag);
+static void gdc_add_tag_markings(GncDenseCal *cal, guint tag, gboolean redraw);
 static void gdc_add_markings(GncDenseCal *cal);
 static void gdc_remove_markings(GncDenseCal *cal);
 
@@ -1714,7 +1714,7 @@ gdc_get_doc_offset(GncDenseCal *dcal, GDate *d)
 }
 
 static void
-gdc_add_tag_markings(GncDenseCal *cal, guint tag)
+gdc_add_tag_markings(GncDenseCal *cal, guint tag, gboolean redraw)
 {
     gchar *name, *info;
     gint num_marks, idx;
@@ -1744,7 +1744,7 @@ gdc_add_tag_markings(GncDenseCal *cal, guint tag)
         _gnc_dense_cal_set_year(cal, g_date_get_year(dates[0]), FALSE);
     }
 
-    gdc_mark_add(cal, tag, name, info, num_marks, dates);
+    gdc_mark_add(cal, tag, name, info, num_marks, dates, redraw);
 
     for (idx = 0; idx < num_marks; idx++)
     {
@@ -1760,12 +1760,18 @@ cleanup:
 static void
 gdc_add_markings(GncDenseCal *cal)
 {
-    GList *tags;
+    GList *tags, *iter;
     tags = gnc_dense_cal_model_get_contained(cal->model);
-    for (; tags != NULL; tags = tags->next)
+    for (iter = tags; iter != NULL; iter = iter->next)
     {
-        guint tag = GPOINTER_TO_UINT(tags->data);
-        gdc_add_tag_markings(cal, tag);
+        guint tag = GPOINTER_TO_UINT(iter->data);
+        gdc_add_tag_markings(cal, tag, FALSE);
+    }
+    /* Draw once for all of them rather than once per tag. */
+    if (tags != NULL)
+    {
+        gnc_dense_cal_draw_to_buffer(cal);
+        gtk_widget_queue_draw(GTK_WIDGET(cal->cal_drawing_area));
     }
     g_list_free(tags);
 }
@@ -1788,7 +1794,7 @@ gdc_model_added_cb(GncDenseCalModel *model, guint added_tag, gpointer user_data)
 {
     GncDenseCal *cal = GNC_DENSE_CAL(user_data);
     g_debug("gdc_model_added_cb update\n");
-    gdc_add_tag_markings(cal, added_tag);
+    gdc_add_tag_markings(cal, added_tag, TRUE);
 }
 
 static void
@@ -1797,7 +1803,7 @@ gdc_model_update_cb(GncDenseCalModel *model, guint update_tag, gpointer user_dat
     GncDenseCal *cal = GNC_DENSE_CAL(user_data);
     g_debug("gdc_model_update_cb update for tag [%d]\n", update_tag);
     gdc_mark_remove(cal, update_tag, FALSE);
-    gdc_add_tag_markings(cal, update_tag);
+    gdc_add_tag_markings(cal, update_tag, TRUE);
 
 }
 
@@ -1836,7 +1842,8 @@ gdc_mark_add(GncDenseCal *dcal,
              gchar *name,
              gchar *info,
              guint size,
-             GDate **dateArray)
+             GDate **dateArray,
+             gboolean redraw)
 {
     guint i;
     gint doc;
@@ -1873,12 +1880,15 @@ gdc_mark_add(GncDenseCal *dcal,
             break;
         }
         dcal->marks[doc] = g_list_append(dcal->marks[doc], newMark);
-        newMark->ourMarks = g_list_append(newMark->ourMarks,
-                                          GINT_TO_POINTER(doc));
+        newMark->ourMarks = g_list_prepend(newMark->ourMarks,
+                                           GINT_TO_POINTER(doc));
     }
     dcal->markData = g_list_append(dcal->markData, (gpointer)newMark);
-    gnc_dense_cal_draw_to_buffer(dcal);
-    gtk_widget_queue_draw(GTK_WIDGET(dcal->cal_drawing_area));
+    if (redraw)
+    {
+        gnc_dense_cal_draw_to_buffer(dcal);
+        gtk_widget_queue_draw(GTK_WIDGET(dcal->cal_drawing_area));
+    }
 }
 
 static void
@@ -32,12 +32,16 @@
 #include "gnc-query-view.h"
 #include "search-param.h"
 
+/* This static indicates the debugging module that this .o belongs to.  */
+static QofLogModule log_module = GNC_MOD_GUI;
+
 /* Signal codes */
 enum
 {
     COLUMN_TOGGLED,
     ROW_SELECTED,
     DOUBLE_CLICK_ENTRY,
+    ENTRIES_LOADED,
     LAST_SIGNAL
 };
 
@@ -47,6 +51,20 @@ struct _GNCQueryViewPriv
 {
     const QofParam *get_guid;
     gint	    component_id;
+
+    /* Paged filling of the list store */
+    gint            page_size;      /* rows added per idle call, 0 for all */
+    GArray         *fill_guids;     /* GUIDs of the entries still to add */
+    guint           fill_pos;
+    QofCollection  *fill_col;
+    GList          *fill_selected;  /* selection to restore when done */
+    guint           fill_idle_id;
+    gboolean        fill_cancelled; /* the last fill was stopped early */
+    gint64          fill_time;      /* microseconds spent adding rows */
+
+    /* Where the query looks for entries, if not the whole book */
+    GNCQueryViewCandidatesFn get_candidates;
+    gpointer        candidates_data;
 };
 
 #define GNC_QUERY_VIEW_GET_PRIVATE(o)  \
@@ -70,6 +88,8 @@ static void gnc_query_view_double_click_cb (GtkTreeView *tree_view,
 
 static void gnc_query_view_destroy (GtkObject *object);
 static void gnc_query_view_fill (GNCQueryView *qview);
+static void gnc_query_view_fill_stop (GNCQueryView *qview);
+static void gnc_query_view_refresh_selected (GNCQueryView *qview, GList *old_entry);
 static void gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column);
 
 
@@ -137,6 +157,12 @@ gnc_query_view_construct (GNCQueryView *qview, GList *param_list, Query *query)
 
 GtkWidget *
 gnc_query_view_new (GList *param_list, Query *query)
+{
+    return gnc_query_view_new_paged (param_list, query, 0);
+}
+
+GtkWidget *
+gnc_query_view_new_paged (GList *param_list, Query *query, gint page_size)
 {
     GNCQueryView  *qview;
     GtkListStore  *liststore;
@@ -177,6 +203,7 @@ gnc_query_view_new (GList *param_list, Query *query)
     /* Free array */
     g_slice_free1( array_size, types );
 
+    gnc_query_view_set_page_size (qview, page_size);
     gnc_query_view_construct (qview, param_list, query);
 
     return GTK_WIDGET (qview);
@@ -189,6 +216,7 @@ void gnc_query_view_reset_query (GNCQueryView *qview, Query *query)
     g_return_if_fail (query);
     g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
 
+    gnc_query_view_fill_stop (qview);
     qof_query_destroy (qview->query);
     qview->query = qof_query_copy (query);
 
@@ -450,11 +478,23 @@ gnc_query_view_class_init (GNCQueryViewClass *klass)
                      1,
                      G_TYPE_POINTER);
 
+    query_view_signals[ENTRIES_LOADED] =
+        g_signal_new("entries_loaded",
+                     G_TYPE_FROM_CLASS (object_class),
+                     G_SIGNAL_RUN_FIRST,
+                     G_STRUCT_OFFSET (GNCQueryViewClass, entries_loaded),
+                     NULL, NULL,
+                     g_cclosure_marshal_VOID__POINTER,
+                     G_TYPE_NONE,
+                     1,
+                     G_TYPE_POINTER);
+
     object_class->destroy = gnc_query_view_destroy;
 
     klass->column_toggled = NULL;
     klass->row_selected = NULL;
     klass->double_click_entry = NULL;
+    klass->entries_loaded = NULL;
 }
 
 
@@ -572,6 +612,7 @@ gnc_query_view_destroy (GtkObject *object)
     GNCQueryViewPriv *priv;
 
     priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    gnc_query_view_fill_stop (qview);
     if (priv->component_id > 0)
     {
         gnc_unregister_gui_component (priv->component_id);
@@ -675,15 +716,25 @@ gnc_query_view_refresh_selected (GNCQueryView *qview, GList *old_entry)
 void
 gnc_query_view_refresh (GNCQueryView *qview)
 {
+    GNCQueryViewPriv *priv;
     GtkTreeModel     *model;
-    GtkTreeIter       iter;
-    GtkTreeSelection *selection;
     GList            *old_entry;
 
     g_return_if_fail (qview != NULL);
     g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
 
+    /* A fill still in progress is abandoned; its selection is the one
+     * to restore. */
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
     old_entry = qview->selected_entry_list;
+    if (priv->fill_guids)
+    {
+        g_list_free (old_entry);
+        old_entry = priv->fill_selected;
+        priv->fill_selected = NULL;
+    }
+    gnc_query_view_fill_stop (qview);
+
     model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
     gtk_list_store_clear (GTK_LIST_STORE (model));
 
@@ -691,6 +742,14 @@ gnc_query_view_refresh (GNCQueryView *qview)
     qview->selected_entry = NULL;
     qview->selected_entry_list = NULL;
 
+    if (priv->page_size > 0)
+    {
+        /* The selection is restored once the last page is added */
+        priv->fill_selected = old_entry;
+        gnc_query_view_fill (qview);
+        return;
+    }
+
     gnc_query_view_fill (qview);
 
     gnc_query_view_refresh_selected (qview, old_entry);
@@ -750,97 +809,246 @@ gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column)
 
 
 /********************************************************************\
- * gnc_query_view_fill                                              *
- *   Add all items to the list store                                *
+ * gnc_query_view_append_entry                                      *
+ *   Add one item to the list store                                 *
  *                                                                  *
  * Args: qview - view to add item to                                *
+ *       model - the list store of the view                         *
+ *       entry - the item to add                                    *
  * Returns: nothing                                                 *
 \********************************************************************/
 static void
-gnc_query_view_fill (GNCQueryView *qview)
+gnc_query_view_append_entry (GNCQueryView *qview, GtkTreeModel *model,
+                             gpointer entry)
 {
     GNCQueryViewPriv *priv;
-    GtkTreeModel     *model;
     GtkTreeIter       iter;
-    GList            *entries, *item;
+    GList            *node;
     const             GncGUID *guid;
+    const QofParam   *gup;
+    QofParam         *qp = NULL;
     gint i;
 
-    /* Clear all watches */
     priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
-    gnc_gui_component_clear_watches (priv->component_id);
 
-    entries = qof_query_run (qview->query);
+    /* Add a row to the list store */
+    gtk_list_store_append (GTK_LIST_STORE (model), &iter);
+    /* Add a pointer to the data in the first column of the list store */
+    gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, entry, -1);
+
+    for (i = 0, node = qview->column_params; node; node = node->next)
+    {
+        gboolean result;
+        GNCSearchParam *param = node->data;
+        GSList *converters = gnc_search_param_get_converters (param);
+        const char *type = gnc_search_param_get_param_type (param);
+        gpointer res = entry;
+        gchar *qofstring;
+
+        /* Test for boolean type */
+        if (g_strcmp0 (type, QOF_TYPE_BOOLEAN) == 0)
+        {
+            result = (gboolean) GPOINTER_TO_INT (gnc_search_param_compute_value (param, res));
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, result, -1);
+            i++;
+            continue;
+        }
+
+        /* Do all the object conversions */
+        for (; converters; converters = converters->next)
+        {
+            qp = converters->data;
+            if (converters->next)
+                res = (qp->param_getfcn)(res, qp);
+        }
+
+        /* Now convert this to a text value for the row */
+        if ( g_strcmp0(type, QOF_TYPE_DEBCRED) == 0 || g_strcmp0(type, QOF_TYPE_NUMERIC) == 0 )
+        {
+
+            gnc_numeric (*nfcn)(gpointer, QofParam *) =
+                (gnc_numeric(*)(gpointer, QofParam *))(qp->param_getfcn);
+            gnc_numeric value = nfcn(res, qp);
+
+            if (qview->numeric_abs)
+                value = gnc_numeric_abs (value);
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, xaccPrintAmount (value, gnc_default_print_info (FALSE)), -1);
+        }
+        else
+        {
+            qofstring = qof_query_core_to_string (type, res, qp);
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, qofstring , -1);
+            g_free(qofstring);
+        }
+        i++;
+    }
+    /* and set a watcher on this item */
+    gup = priv->get_guid;
+    guid = (const GncGUID*)((gup->param_getfcn)(entry, gup));
+    gnc_gui_component_watch_entity (priv->component_id, guid,
+                                    QOF_EVENT_MODIFY | QOF_EVENT_DESTROY);
+
+    qview->num_entries++;
+}
+
+
+/* Stop a paged fill, leaving the rows added so far in the view. */
+static void
+gnc_query_view_fill_stop (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+
+    if (priv->fill_idle_id)
+    {
+        g_source_remove (priv->fill_idle_id);
+        priv->fill_idle_id = 0;
+    }
+    if (priv->fill_guids)
+    {
+        g_array_free (priv->fill_guids, TRUE);
+        priv->fill_guids = NULL;
+    }
+    g_list_free (priv->fill_selected);
+    priv->fill_selected = NULL;
+    priv->fill_col = NULL;
+    priv->fill_pos = 0;
+}
+
+
+/* Add the next page of a paged fill.  Returns TRUE while there are
+ * entries left to add. */
+static gboolean
+gnc_query_view_fill_page (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    GtkTreeModel     *model;
+    GList            *old_entry;
+    guint             end;
+    gint64            start = g_get_monotonic_time ();
 
     model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
+    end = MIN (priv->fill_pos + priv->page_size, priv->fill_guids->len);
 
-    for (item = entries; item; item = item->next)
+    /* Entries destroyed since the query ran are skipped. */
+    for (; priv->fill_pos < end; priv->fill_pos++)
     {
-        GList *node;
-        gint row;
-        const QofParam *gup;
-        QofParam *qp = NULL;
+        GncGUID *guid = &g_array_index (priv->fill_guids, GncGUID, priv->fill_pos);
+        QofInstance *inst = qof_collection_lookup_entity (priv->fill_col, guid);
 
-        /* Add a row to the list store */
-        gtk_list_store_append (GTK_LIST_STORE (model), &iter);
-        /* Add a pointer to the data in the first column of the list store */
-        gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, item->data, -1);
+        if (inst)
+            gnc_query_view_append_entry (qview, model, inst);
+    }
+    priv->fill_time += g_get_monotonic_time () - start;
 
-        for (i = 0, node = qview->column_params; node; node = node->next)
-        {
-            gboolean result;
-            GNCSearchParam *param = node->data;
-            GSList *converters = gnc_search_param_get_converters (param);
-            const char *type = gnc_search_param_get_param_type (param);
-            gpointer res = item->data;
-            gchar *qofstring;
-
-            /* Test for boolean type */
-            if (g_strcmp0 (type, QOF_TYPE_BOOLEAN) == 0)
-            {
-                result = (gboolean) GPOINTER_TO_INT (gnc_search_param_compute_value (param, res));
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, result, -1);
-                i++;
-                continue;
-            }
+    if (priv->fill_pos < priv->fill_guids->len)
+    {
+        g_signal_emit (qview, query_view_signals[ENTRIES_LOADED], 0,
+                       GINT_TO_POINTER (qview->num_entries));
+        return TRUE;
+    }
 
-            /* Do all the object conversions */
-            for (; converters; converters = converters->next)
-            {
-                qp = converters->data;
-                if (converters->next)
-                    res = (qp->param_getfcn)(res, qp);
-            }
+    PINFO("qview=%p added %u rows in %.3f ms", qview, priv->fill_guids->len,
+          priv->fill_time / 1000.0);
+    g_array_free (priv->fill_guids, TRUE);
+    priv->fill_guids = NULL;
+    priv->fill_col = NULL;
+    priv->fill_pos = 0;
 
-            /* Now convert this to a text value for the row */
-            if ( g_strcmp0(type, QOF_TYPE_DEBCRED) == 0 || g_strcmp0(type, QOF_TYPE_NUMERIC) == 0 )
-            {
+    old_entry = priv->fill_selected;
+    priv->fill_selected = NULL;
+    gnc_query_view_refresh_selected (qview, old_entry);
+    g_list_free (old_entry);
 
-                gnc_numeric (*nfcn)(gpointer, QofParam *) =
-                    (gnc_numeric(*)(gpointer, QofParam *))(qp->param_getfcn);
-                gnc_numeric value = nfcn(res, qp);
+    g_signal_emit (qview, query_view_signals[ENTRIES_LOADED], 0,
+                   GINT_TO_POINTER (qview->num_entries));
+    return FALSE;
+}
 
-                if (qview->numeric_abs)
-                    value = gnc_numeric_abs (value);
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, xaccPrintAmount (value, gnc_default_print_info (FALSE)), -1);
-            }
-            else
-            {
-                qofstring = qof_query_core_to_string (type, res, qp);
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, qofstring , -1);
-                g_free(qofstring);
-            }
-            i++;
+
+static gboolean
+gnc_query_view_fill_idle (gpointer user_data)
+{
+    GNCQueryView     *qview = user_data;
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+
+    if (gnc_query_view_fill_page (qview))
+        return TRUE;
+
+    priv->fill_idle_id = 0;
+    return FALSE;
+}
+
+
+/********************************************************************\
+ * gnc_query_view_fill                                              *
+ *   Add all items to the list store                                *
+ *                                                                  *
+ * Args: qview - view to add item to                                *
+ * Returns: nothing                                                 *
+\********************************************************************/
+static void
+gnc_query_view_fill (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv;
+    GtkTreeModel     *model;
+    GList            *entries, *item;
+    const QofParam   *gup;
+    gint64            start;
+
+    /* Clear all watches */
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    gnc_gui_component_clear_watches (priv->component_id);
+    priv->fill_cancelled = FALSE;
+
+    /* The query itself still runs here on the main loop; log its time
+     * next to the time spent adding the rows. */
+    start = g_get_monotonic_time ();
+    if (priv->get_candidates)
+        entries = qof_query_run_list (qview->query, priv->get_candidates,
+                                      priv->candidates_data);
+    else
+        entries = qof_query_run (qview->query);
+    PINFO("qview=%p query %.3f ms, %u results", qview,
+          (g_get_monotonic_time () - start) / 1000.0, g_list_length (entries));
+
+    model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
+
+    if (priv->page_size <= 0 || !entries)
+    {
+        start = g_get_monotonic_time ();
+        for (item = entries; item; item = item->next)
+            gnc_query_view_append_entry (qview, model, item->data);
+        PINFO("qview=%p added %d rows in %.3f ms", qview, qview->num_entries,
+              (g_get_monotonic_time () - start) / 1000.0);
+
+        if (priv->page_size > 0)
+        {
+            gnc_query_view_refresh_selected (qview, priv->fill_selected);
+            g_list_free (priv->fill_selected);
+            priv->fill_selected = NULL;
+            g_signal_emit (qview, query_view_signals[ENTRIES_LOADED], 0,
+                           GINT_TO_POINTER (qview->num_entries));
         }
-        row++;
-        /* and set a watcher on this item */
-        gup = priv->get_guid;
-        guid = (const GncGUID*)((gup->param_getfcn)(item->data, gup));
-        gnc_gui_component_watch_entity (priv->component_id, guid,
-                                        QOF_EVENT_MODIFY | QOF_EVENT_DESTROY);
-
-        qview->num_entries++;
+        return;
     }
+
+    /* Keep the GUIDs rather than the results, which belong to the
+     * query and whose entries may be destroyed before their page is
+     * added.  The first page goes in at once. */
+    gup = priv->get_guid;
+    priv->fill_col = qof_book_get_collection (qof_instance_get_book (entries->data),
+                                              qof_query_get_search_for (qview->query));
+    priv->fill_guids = g_array_sized_new (FALSE, FALSE, sizeof (GncGUID),
+                                          g_list_length (entries));
+    for (item = entries; item; item = item->next)
+        g_array_append_val (priv->fill_guids,
+                            *(const GncGUID*)((gup->param_getfcn)(item->data, gup)));
+    priv->fill_pos = 0;
+    priv->fill_time = 0;
+
+    /* A handler of the first entries_loaded may have cancelled the fill */
+    if (gnc_query_view_fill_page (qview) && priv->fill_guids)
+        priv->fill_idle_id = g_idle_add (gnc_query_view_fill_idle, qview);
 }
 
 
@@ -904,3 +1112,79 @@ gnc_query_view_set_numerics (GNCQueryView *qview, gboolean abs, gboolean inv_sor
     qview->numeric_abs = abs;
     qview->numeric_inv_sort = inv_sort;
 }
+
+
+void
+gnc_query_view_set_page_size (GNCQueryView *qview, gint page_size)
+{
+    GNCQueryViewPriv *priv;
+
+    g_return_if_fail (qview);
+    g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
+
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    priv->page_size = MAX (page_size, 0);
+}
+
+
+void
+gnc_query_view_set_candidates (GNCQueryView *qview,
+                               GNCQueryViewCandidatesFn get_candidates,
+                               gpointer user_data)
+{
+    GNCQueryViewPriv *priv;
+
+    g_return_if_fail (qview);
+    g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
+
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    priv->get_candidates = get_candidates;
+    priv->candidates_data = user_data;
+}
+
+
+gboolean
+gnc_query_view_is_filling (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv;
+
+    g_return_val_if_fail (qview, FALSE);
+    g_return_val_if_fail (GNC_IS_QUERY_VIEW (qview), FALSE);
+
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    return (priv->fill_guids != NULL);
+}
+
+
+gboolean
+gnc_query_view_fill_cancelled (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv;
+
+    g_return_val_if_fail (qview, FALSE);
+    g_return_val_if_fail (GNC_IS_QUERY_VIEW (qview), FALSE);
+
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    return priv->fill_cancelled;
+}
+
+
+void
+gnc_query_view_cancel_fill (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv;
+
+    g_return_if_fail (qview);
+    g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
+
+    if (!gnc_query_view_is_filling (qview))
+        return;
+
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    PINFO("qview=%p stopped after %u of %u rows, %.3f ms", qview,
+          priv->fill_pos, priv->fill_guids->len, priv->fill_time / 1000.0);
+    gnc_query_view_fill_stop (qview);
+    priv->fill_cancelled = TRUE;
+    g_signal_emit (qview, query_view_signals[ENTRIES_LOADED], 0,
+                   GINT_TO_POINTER (qview->num_entries));
+}
@@ -41,6 +41,11 @@ extern "C" {
     typedef struct _GNCQueryView      GNCQueryView;
     typedef struct _GNCQueryViewClass GNCQueryViewClass;
 
+    /* Returns a newly allocated list of the objects to run the query
+     * over; the view frees the list, but not the objects.  It is called
+     * after the query has run in the backend, see qof_query_run_list(). */
+    typedef QofQueryCandidatesCB GNCQueryViewCandidatesFn;
+
     struct _GNCQueryView
     {
         GtkTreeView qview;
@@ -83,6 +88,11 @@ extern "C" {
         /* This signal is emitted when a row is double clicked, the pointer has
            a pointer to the entry */
         void (*double_click_entry) (GNCQueryView *qview, gpointer entry);
+
+        /* This signal is emitted after each page of a paged fill, and
+           when the fill finishes or is cancelled, the pointer has an
+           integer value for the number of rows in the view */
+        void (*entries_loaded) (GNCQueryView *qview, gpointer count);
     };
 
     /***********************************************************
@@ -98,6 +108,11 @@ extern "C" {
      */
     GtkWidget * gnc_query_view_new (GList *param_list, Query *query);
 
+    /* As gnc_query_view_new(), with the page size of
+     * gnc_query_view_set_page_size() set before the first fill. */
+    GtkWidget * gnc_query_view_new_paged (GList *param_list, Query *query,
+                                          gint page_size);
+
     void gnc_query_view_construct (GNCQueryView *qview, GList *param_list, Query *query);
 
     void gnc_query_view_reset_query (GNCQueryView *view, Query *query);
@@ -112,6 +127,30 @@ extern "C" {
 
     void gnc_query_view_refresh (GNCQueryView *qview);
 
+    /* With a page size greater than zero the view adds the query
+     * results that many rows at a time from the idle loop, emitting
+     * "entries_loaded" after each page, instead of all at once.  The
+     * default of zero fills the view before returning.
+     */
+    void gnc_query_view_set_page_size (GNCQueryView *qview, gint page_size);
+
+    gboolean gnc_query_view_is_filling (GNCQueryView *qview);
+
+    /* Run the query over the objects returned by get_candidates
+     * instead of over every object in the book.  Set this before
+     * gnc_query_view_construct() so the first fill uses it too.
+     */
+    void gnc_query_view_set_candidates (GNCQueryView *qview,
+                                        GNCQueryViewCandidatesFn get_candidates,
+                                        gpointer user_data);
+
+    /* Stop a paged fill, keeping the rows already in the view. */
+    void gnc_query_view_cancel_fill (GNCQueryView *qview);
+
+    /* TRUE if the last fill was stopped with gnc_query_view_cancel_fill()
+     * and so the view does not hold all the results. */
+    gboolean gnc_query_view_fill_cancelled (GNCQueryView *qview);
+
     void gnc_query_view_unselect_all (GNCQueryView *qview);
 
     gboolean gnc_query_view_item_in_view (GNCQueryView *qview, gpointer item);
@@ -59,6 +59,13 @@ struct _GncSxInstanceDenseCalAdapter
     GObject parent;
     gboolean disposed;
     GncSxInstanceModel *instances;
+
+    /* The calendar asks for the name, info, count and then each
+     * instance of one tag in turn, so remember where the last answer
+     * came from. */
+    GncSxInstances *last_instances;
+    GList *last_node;
+    gint last_index;
 };
 
 static void
@@ -90,11 +97,21 @@ gnc_sx_instance_dense_cal_adapter_interface_init(gpointer g_iface, gpointer ifac
     iface->get_instance = gsidca_get_instance;
 }
 
+/* Forget the remembered lookup; the instance lists are about to change */
+static void
+gsidca_forget_lookup(GncSxInstanceDenseCalAdapter *adapter)
+{
+    adapter->last_instances = NULL;
+    adapter->last_node = NULL;
+    adapter->last_index = -1;
+}
+
 static void
 gsidca_instances_added_cb(GncSxInstanceModel *model, SchedXaction *sx_added, gpointer user_data)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(user_data);
     g_debug("instance added\n");
+    gsidca_forget_lookup(adapter);
     if (xaccSchedXactionGetEnabled(sx_added))
     {
         g_signal_emit_by_name(adapter, "added", GPOINTER_TO_UINT(sx_added));
@@ -105,6 +122,7 @@ static void
 gsidca_instances_updated_cb(GncSxInstanceModel *model, SchedXaction *sx_updated, gpointer user_data)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(user_data);
+    gsidca_forget_lookup(adapter);
     gnc_sx_instance_model_update_sx_instances(model, sx_updated);
     g_debug("instances updated\n");
     if (xaccSchedXactionGetEnabled(sx_updated))
@@ -123,6 +141,7 @@ gsidca_instances_removing_cb(GncSxInstanceModel *model, SchedXaction *sx_to_be_r
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(user_data);
     g_debug("removing instance...\n");
     g_signal_emit_by_name(adapter, "removing", GPOINTER_TO_UINT(sx_to_be_removed));
+    gsidca_forget_lookup(adapter);
     gnc_sx_instance_model_remove_sx_instances(model, sx_to_be_removed);
 }
 
@@ -131,6 +150,7 @@ gnc_sx_instance_dense_cal_adapter_new(GncSxInstanceModel *instances)
 {
     GncSxInstanceDenseCalAdapter *adapter = g_object_new(GNC_TYPE_SX_INSTANCE_DENSE_CAL_ADAPTER, NULL);
     adapter->instances = instances;
+    gsidca_forget_lookup(adapter);
     g_object_ref(G_OBJECT(adapter->instances));
 
     g_signal_connect(instances, "added", (GCallback)gsidca_instances_added_cb, adapter);
@@ -182,6 +202,25 @@ gsidca_find_sx_with_tag(gconstpointer list_data,
     return (GUINT_TO_POINTER(GPOINTER_TO_UINT(sx_instances->sx)) == find_data ? 0 : 1);
 }
 
+static GncSxInstances*
+gsidca_find_instances(GncSxInstanceDenseCalAdapter *adapter, guint tag)
+{
+    GList *found;
+
+    if (adapter->last_instances != NULL
+            && GPOINTER_TO_UINT(adapter->last_instances->sx) == tag)
+        return adapter->last_instances;
+
+    found = g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag);
+    if (found == NULL)
+        return NULL;
+
+    adapter->last_instances = (GncSxInstances*)found->data;
+    adapter->last_node = NULL;
+    adapter->last_index = -1;
+    return adapter->last_instances;
+}
+
 static GList*
 gsidca_get_contained(GncDenseCalModel *model)
 {
@@ -203,8 +242,7 @@ static gchar*
 gsidca_get_name(GncDenseCalModel *model, guint tag)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return NULL;
     return xaccSchedXactionGetName(insts->sx);
@@ -217,8 +255,7 @@ gsidca_get_info(GncDenseCalModel *model, guint tag)
     // g_list_find(instances->sxes, {sx_to_tag, tag}).get_freq_spec().get_freq_str();
     GList *schedule;
     gchar *schedule_str;
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return NULL;
     schedule = gnc_sx_get_schedule(insts->sx);
@@ -231,8 +268,7 @@ gsidca_get_instance_count(GncDenseCalModel *model, guint tag)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
     // g_list_find(instances->sxes, {sx_to_tag, tag}).length();
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return 0;
     return g_list_length(insts->instance_list);
@@ -243,11 +279,18 @@ gsidca_get_instance(GncDenseCalModel *model, guint tag, gint instance_index, GDa
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
     GncSxInstance *inst;
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return;
-    inst = (GncSxInstance*)g_list_nth_data(insts->instance_list, instance_index);
+    /* Instances are asked for in order; step on from the last one. */
+    if (adapter->last_node != NULL && instance_index == adapter->last_index + 1)
+        adapter->last_node = adapter->last_node->next;
+    else
+        adapter->last_node = g_list_nth(insts->instance_list, instance_index);
+    adapter->last_index = instance_index;
+    if (adapter->last_node == NULL)
+        return;
+    inst = (GncSxInstance*)adapter->last_node->data;
     g_date_valid(&inst->date);
     *date = inst->date;
     g_date_valid(date);
@@ -34,6 +34,7 @@
 #include "Account.h"
 #include "gnc-accounting-period.h"
 #include "gnc-commodity.h"
+#include "gnc-pricedb.h"
 #include "gnc-gconf-utils.h"
 #include "gnc-engine.h"
 #include "gnc-event.h"
@@ -90,6 +91,34 @@ static void gnc_tree_model_account_event_handler (QofInstance *entity,
         GncTreeModelAccount *model,
         GncEventData *ed);
 
+/** The balances shown by the model.  Computing one walks the
+ *  account's subtree and converts through the price database, so the
+ *  model keeps them until something they depend upon changes. */
+typedef enum
+{
+    BALANCE_PRESENT,
+    BALANCE_PRESENT_REPORT,
+    BALANCE_BALANCE,
+    BALANCE_BALANCE_REPORT,
+    BALANCE_CLEARED,
+    BALANCE_CLEARED_REPORT,
+    BALANCE_RECONCILED,
+    BALANCE_RECONCILED_REPORT,
+    BALANCE_FUTURE_MIN,
+    BALANCE_FUTURE_MIN_REPORT,
+    BALANCE_PERIOD,
+    BALANCE_TOTAL_PERIOD,
+    NUM_BALANCES
+} AccountBalance;
+
+/** The cached balances of one account.  A NULL string hasn't been
+ *  computed yet. */
+typedef struct
+{
+    gchar *string[NUM_BALANCES];
+    gboolean negative[NUM_BALANCES];
+} AccountBalances;
+
 /** The instance private data for an account tree model. */
 typedef struct GncTreeModelAccountPrivate
 {
@@ -97,6 +126,15 @@ typedef struct GncTreeModelAccountPrivate
     Account *root;
     gint event_handler_id;
     const gchar *negative_color;
+
+    /* Account -> AccountBalances.  An entry covers the account's
+     * subtree, so it is dropped along with those of all its ancestors
+     * whenever the account changes. */
+    GHashTable *balances;
+    guint balances_generation;  /* see gnc_account_get_balance_generation */
+    time64 balances_day;        /* the present balances change daily */
+    time64 period_start;        /* the period of the period balances */
+    time64 period_end;
 } GncTreeModelAccountPrivate;
 
 #define GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(o)  \
@@ -128,6 +166,47 @@ gnc_tree_model_account_update_color (GConfEntry *entry, gpointer user_data)
     use_red = gconf_value_get_bool(value);
     priv->negative_color = use_red ? "red" : "black";
 }
+
+static void
+account_balances_free (AccountBalances *balances)
+{
+    gint i;
+
+    for (i = 0; i < NUM_BALANCES; i++)
+        g_free (balances->string[i]);
+    g_free (balances);
+}
+
+/** Forget all the cached balances, as after a change of preferences or
+ *  prices.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_clear_balances (GncTreeModelAccount *model)
+{
+    GncTreeModelAccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_TREE_MODEL_ACCOUNT(model));
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    g_hash_table_remove_all (priv->balances);
+}
+
+/** Forget the cached balances of an account and of all its ancestors,
+ *  whose totals include it.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_clear_account_balances (GncTreeModelAccount *model,
+        Account *account)
+{
+    GncTreeModelAccountPrivate *priv;
+
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    for ( ; account; account = gnc_account_get_parent (account))
+        g_hash_table_remove (priv->balances, account);
+}
 /************************************************************/
 /*               g_object required functions                */
 /************************************************************/
@@ -208,10 +287,17 @@ gnc_tree_model_account_init (GncTreeModelAccount *model)
     priv->book = NULL;
     priv->root = NULL;
     priv->negative_color = red ? "red" : "black";
+    priv->balances = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                            (GDestroyNotify) account_balances_free);
 
     gnc_gconf_general_register_cb(KEY_NEGATIVE_IN_RED,
                                   gnc_tree_model_account_update_color,
                                   model);
+    /* The formatting of the balances and the report currency are
+     * general preferences. */
+    gnc_gconf_general_register_any_cb((GncGconfGeneralAnyCb)
+                                      gnc_tree_model_account_clear_balances,
+                                      model);
 
     LEAVE(" ");
 }
@@ -233,7 +319,12 @@ gnc_tree_model_account_finalize (GObject *object)
     gnc_gconf_general_remove_cb(KEY_NEGATIVE_IN_RED,
                                 gnc_tree_model_account_update_color,
                                 model);
+    gnc_gconf_general_remove_any_cb((GncGconfGeneralAnyCb)
+                                    gnc_tree_model_account_clear_balances,
+                                    model);
 
+    g_hash_table_destroy (priv->balances);
+    priv->balances = NULL;
     priv->book = NULL;
 
     if (G_OBJECT_CLASS (parent_class)->finalize)
@@ -264,6 +355,9 @@ gnc_tree_model_account_dispose (GObject *object)
     gnc_gconf_general_remove_cb(KEY_NEGATIVE_IN_RED,
                                 gnc_tree_model_account_update_color,
                                 model);
+    gnc_gconf_general_remove_any_cb((GncGconfGeneralAnyCb)
+                                    gnc_tree_model_account_clear_balances,
+                                    model);
 
     if (G_OBJECT_CLASS (parent_class)->dispose)
         G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -588,8 +682,8 @@ gnc_tree_model_account_compute_period_balance(GncTreeModelAccount *model,
     if (acct == priv->root)
         return g_strdup("");
 
-    t1 = gnc_accounting_period_fiscal_start();
-    t2 = gnc_accounting_period_fiscal_end();
+    t1 = priv->period_start;
+    t2 = priv->period_end;
 
     if (t1 > t2)
         return g_strdup("");
@@ -604,6 +698,123 @@ gnc_tree_model_account_compute_period_balance(GncTreeModelAccount *model,
     return g_strdup(xaccPrintAmount(b3, gnc_account_print_info(acct, TRUE)));
 }
 
+/** The functions computing the balances other than the period ones,
+ *  indexed by AccountBalance. */
+static const struct
+{
+    xaccGetBalanceInCurrencyFn fn;
+    gboolean report;
+} balance_fns[BALANCE_PERIOD] =
+{
+    { xaccAccountGetPresentBalanceInCurrency, FALSE },
+    { xaccAccountGetPresentBalanceInCurrency, TRUE },
+    { xaccAccountGetBalanceInCurrency, FALSE },
+    { xaccAccountGetBalanceInCurrency, TRUE },
+    { xaccAccountGetClearedBalanceInCurrency, FALSE },
+    { xaccAccountGetClearedBalanceInCurrency, TRUE },
+    { xaccAccountGetReconciledBalanceInCurrency, FALSE },
+    { xaccAccountGetReconciledBalanceInCurrency, TRUE },
+    { xaccAccountGetProjectedMinimumBalanceInCurrency, FALSE },
+    { xaccAccountGetProjectedMinimumBalanceInCurrency, TRUE },
+};
+
+/** Drop the cached balances that are stale: all of them once any
+ *  account's balances have been recomputed since they were cached,
+ *  which catches changes made while events were suspended, or on a
+ *  new day, and the period ones when the accounting period moves.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_check_balances (GncTreeModelAccount *model,
+                                       AccountBalance which)
+{
+    GncTreeModelAccountPrivate *priv;
+    GHashTableIter iter;
+    gpointer value;
+    time64 today, t1, t2;
+
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    today = gnc_time64_get_today_start ();
+    if (today != priv->balances_day
+            || gnc_account_get_balance_generation () != priv->balances_generation)
+    {
+        g_hash_table_remove_all (priv->balances);
+        priv->balances_day = today;
+        priv->balances_generation = gnc_account_get_balance_generation ();
+    }
+
+    if (which < BALANCE_PERIOD)
+        return;
+    t1 = gnc_accounting_period_fiscal_start();
+    t2 = gnc_accounting_period_fiscal_end();
+    if (t1 == priv->period_start && t2 == priv->period_end)
+        return;
+
+    g_hash_table_iter_init (&iter, priv->balances);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        AccountBalances *balances = value;
+        gint i;
+
+        for (i = BALANCE_PERIOD; i < NUM_BALANCES; i++)
+        {
+            g_free (balances->string[i]);
+            balances->string[i] = NULL;
+        }
+    }
+    priv->period_start = t1;
+    priv->period_end = t2;
+}
+
+/** Return one of the balances of an account, computing it if it isn't
+ *  cached.  The string belongs to the model.
+ *
+ *  @internal
+ */
+static const gchar *
+gnc_tree_model_account_get_balance (GncTreeModelAccount *model,
+                                    Account *account,
+                                    AccountBalance which,
+                                    gboolean *negative)
+{
+    GncTreeModelAccountPrivate *priv;
+    AccountBalances *balances;
+
+    gnc_tree_model_account_check_balances (model, which);
+
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    balances = g_hash_table_lookup (priv->balances, account);
+    if (!balances)
+    {
+        balances = g_new0 (AccountBalances, 1);
+        g_hash_table_insert (priv->balances, account, balances);
+    }
+
+    if (!balances->string[which])
+    {
+        if (which >= BALANCE_PERIOD)
+            balances->string[which] =
+                gnc_tree_model_account_compute_period_balance
+                (model, account, which == BALANCE_TOTAL_PERIOD,
+                 &balances->negative[which]);
+        else if (balance_fns[which].report)
+            balances->string[which] =
+                gnc_ui_account_get_print_report_balance
+                (balance_fns[which].fn, account, TRUE,
+                 &balances->negative[which]);
+        else
+            balances->string[which] =
+                gnc_ui_account_get_print_balance
+                (balance_fns[which].fn, account, TRUE,
+                 &balances->negative[which]);
+    }
+
+    if (negative)
+        *negative = balances->negative[which];
+    return balances->string[which];
+}
+
 static void
 gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
                                   GtkTreeIter *iter,
@@ -614,7 +825,6 @@ gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
     GncTreeModelAccountPrivate *priv;
     Account *account;
     gboolean negative; /* used to set "deficit style" also known as red numbers */
-    gchar *string;
     time64 last_date;
 
     g_return_if_fail (GNC_IS_TREE_MODEL_ACCOUNT (model));
@@ -658,86 +868,80 @@ gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
 
     case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_PRESENT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_PRESENT_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_PRESENT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_PRESENT, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_BALANCE, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_BALANCE_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_BALANCE, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_PERIOD:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, FALSE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_PERIOD, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE_PERIOD:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, FALSE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_PERIOD, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_CLEARED, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_CLEARED_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_CLEARED:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_CLEARED, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_RECONCILED, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_RECONCILED_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_DATE:
         g_value_init (value, G_TYPE_STRING);
@@ -749,61 +953,55 @@ gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
 
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_RECONCILED:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_RECONCILED, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_FUTURE_MIN, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_FUTURE_MIN_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_FUTURE_MIN:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_FUTURE_MIN, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_BALANCE, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_REPORT:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_BALANCE_REPORT, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_TOTAL:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_BALANCE, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, TRUE, &negative);
-        g_value_take_string (value, string);
+        g_value_set_string (value,
+                            gnc_tree_model_account_get_balance(model, account,
+                                    BALANCE_TOTAL_PERIOD, NULL));
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_TOTAL_PERIOD:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, TRUE, &negative);
+        gnc_tree_model_account_get_balance(model, account, BALANCE_TOTAL_PERIOD, &negative);
         gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_ACCOUNT:
@@ -1286,8 +1484,9 @@ propagate_change(GtkTreeModel *model, GtkTreePath *path, gint toggle_if_num)
  *
  *  @param entity The guid of the affected item.
  *
- *  @param type The type of the affected item.  This function only
- *  cares about items of type "account".
+ *  @param type The type of the affected item.  This function cares
+ *  about accounts, and about prices and commodities only to drop the
+ *  cached balances they affect.
  *
  *  @param event type The type of the event. This function only cares
  *  about items of type ADD, REMOVE, MODIFY, and DESTROY.
@@ -1307,6 +1506,14 @@ gnc_tree_model_account_event_handler (QofInstance *entity,
     Account *account, *parent;
 
     g_return_if_fail(model);	/* Required */
+
+    /* Prices and commodities feed into the conversions of every
+     * balance. */
+    if (GNC_IS_PRICE(entity) || GNC_IS_COMMODITY(entity))
+    {
+        gnc_tree_model_account_clear_balances(model);
+        return;
+    }
     if (!GNC_IS_ACCOUNT(entity))
         return;
 
@@ -1314,7 +1521,15 @@ gnc_tree_model_account_event_handler (QofInstance *entity,
           entity, event_type, model, ed);
     priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
 
+    /* Whatever happened to the account, its balances and those of its
+     * ancestors may have changed.  This includes the splits added,
+     * removed and changed in it. */
     account = GNC_ACCOUNT(entity);
+    gnc_tree_model_account_clear_account_balances(model, account);
+    if (event_type == QOF_EVENT_REMOVE && ed && ed->node)
+        gnc_tree_model_account_clear_account_balances(model,
+                GNC_ACCOUNT(ed->node));
+
     if (gnc_account_get_book(account) != priv->book)
     {
         LEAVE("not in this book");
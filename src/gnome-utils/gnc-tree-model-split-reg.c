@@ -103,9 +103,13 @@ struct GncTreeModelSplitRegPrivate
     QofBook *book;                   // GNC Book
     Account *anchor;                 // Account of register
 
-    GList *full_tlist;               // List of unique transactions derived from the query slist in same order
+    GPtrArray  *full_tlist;          // Array of unique transactions derived from the query slist in same order
+    GHashTable *full_tlist_pos;      // Position of each transaction in full_tlist
     GList *tlist;                    // List of unique transactions derived from the full_tlist to display in same order
     gint   tlist_start;              // The position of the first transaction in tlist in the full_tlist
+    GHashTable *tlist_keys;          // Key of the row of each transaction in tlist
+    GHashTable *tlist_rows;          // Node in tlist of each row key
+    gint   tlist_first_key;          // The key of the first row in tlist
 
     Transaction *btrans;             // The Blank transaction
 
@@ -377,6 +381,10 @@ gnc_tree_model_split_reg_init (GncTreeModelSplitReg *model)
     }
 
     model->priv = g_new0 (GncTreeModelSplitRegPrivate, 1);
+    model->priv->full_tlist = g_ptr_array_new ();
+    model->priv->full_tlist_pos = g_hash_table_new (g_direct_hash, g_direct_equal);
+    model->priv->tlist_keys = g_hash_table_new (g_direct_hash, g_direct_equal);
+    model->priv->tlist_rows = g_hash_table_new (g_direct_hash, g_direct_equal);
 
     gnc_gconf_general_register_cb (KEY_ACCOUNTING_LABELS,
                                   gnc_tree_model_split_reg_gconf_changed,
@@ -429,10 +437,13 @@ gnc_tree_model_split_reg_dispose (GObject *object)
     /* Free the tlist */
     g_list_free (priv->tlist);
     priv->tlist = NULL;
+    g_hash_table_destroy (priv->tlist_keys);
+    g_hash_table_destroy (priv->tlist_rows);
 
     /* Free the full_tlist */
-    g_list_free (priv->full_tlist);
+    g_ptr_array_free (priv->full_tlist, TRUE);
     priv->full_tlist = NULL;
+    g_hash_table_destroy (priv->full_tlist_pos);
 
     /* Free the blank split */
     priv->bsplit = NULL;
@@ -552,62 +563,219 @@ gtm_sr_remove_all_rows (GncTreeModelSplitReg *model)
     g_list_free (rr_list);
 }
 
+/************************************************************/
+/*                 Transaction List Indexes                 */
+/************************************************************/
+/* Return the transaction at position in full_tlist, or NULL. */
+static Transaction *
+gtm_sr_full_tlist_nth (GncTreeModelSplitRegPrivate *priv, gint position)
+{
+    if (position < 0 || position >= (gint) priv->full_tlist->len)
+        return NULL;
+    return g_ptr_array_index (priv->full_tlist, position);
+}
+
+/* Return the position of trans in full_tlist, or -1. */
+static gint
+gtm_sr_full_tlist_index (GncTreeModelSplitRegPrivate *priv, Transaction *trans)
+{
+    gpointer position;
+
+    if (!g_hash_table_lookup_extended (priv->full_tlist_pos, trans, NULL, &position))
+        return -1;
+    return GPOINTER_TO_INT (position);
+}
+
+/* The rows of tlist are numbered by keys running on from tlist_first_key
+   without gaps, so the row of a transaction and the node of a row are
+   hash lookups.  Transactions are only added at either end of tlist,
+   which extends the keys; removing one from the middle renumbers them. */
 static void
-gtm_sr_reg_load (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update, gint num_of_rows)
+gtm_sr_tlist_index_rebuild (GncTreeModelSplitRegPrivate *priv)
 {
-    GncTreeModelSplitRegPrivate *priv;
-    GList *node;
-    gint rows = 0;
+    GList *tnode;
+    gint key = 0;
 
-    priv = model->priv;
+    g_hash_table_remove_all (priv->tlist_keys);
+    g_hash_table_remove_all (priv->tlist_rows);
+    priv->tlist_first_key = 0;
 
-    if (model_update == VIEW_HOME)
+    for (tnode = priv->tlist; tnode; tnode = tnode->next, key++)
     {
-        priv->tlist_start = 0;
+        g_hash_table_insert (priv->tlist_keys, tnode->data, GINT_TO_POINTER (key));
+        g_hash_table_insert (priv->tlist_rows, GINT_TO_POINTER (key), tnode);
+    }
+}
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+/* Replace tlist with a new list of transactions. */
+static void
+gtm_sr_tlist_set (GncTreeModelSplitRegPrivate *priv, GList *tlist)
+{
+    g_list_free (priv->tlist);
+    priv->tlist = tlist;
+    gtm_sr_tlist_index_rebuild (priv);
+}
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+static gint
+gtm_sr_tlist_length (GncTreeModelSplitRegPrivate *priv)
+{
+    return g_hash_table_size (priv->tlist_rows);
+}
+
+static gboolean
+gtm_sr_tlist_get_key (GncTreeModelSplitRegPrivate *priv, Transaction *trans, gint *key)
+{
+    gpointer value;
+
+    if (!g_hash_table_lookup_extended (priv->tlist_keys, trans, NULL, &value))
+        return FALSE;
+    *key = GPOINTER_TO_INT (value);
+    return TRUE;
+}
+
+/* Return the node at row n of tlist, or NULL. */
+static GList *
+gtm_sr_tlist_nth (GncTreeModelSplitRegPrivate *priv, gint n)
+{
+    if (n < 0 || n >= gtm_sr_tlist_length (priv))
+        return NULL;
+    return g_hash_table_lookup (priv->tlist_rows, GINT_TO_POINTER (priv->tlist_first_key + n));
+}
 
-            if (rows == num_of_rows)
-                break;
-        } 
+/* Return the row of trans in tlist, or -1. */
+static gint
+gtm_sr_tlist_index (GncTreeModelSplitRegPrivate *priv, Transaction *trans)
+{
+    gint key;
+
+    if (!gtm_sr_tlist_get_key (priv, trans, &key))
+        return -1;
+    return key - priv->tlist_first_key;
+}
+
+/* Return the node of trans in tlist, or NULL. */
+static GList *
+gtm_sr_tlist_find (GncTreeModelSplitRegPrivate *priv, Transaction *trans)
+{
+    return gtm_sr_tlist_nth (priv, gtm_sr_tlist_index (priv, trans));
+}
+
+/* Return the row of tnode in tlist, or -1. */
+static gint
+gtm_sr_tlist_position (GncTreeModelSplitRegPrivate *priv, GList *tnode)
+{
+    gint pos;
+
+    if (tnode == NULL)
+        return -1;
+
+    pos = gtm_sr_tlist_index (priv, tnode->data);
+    if (gtm_sr_tlist_nth (priv, pos) != tnode)
+        return -1;
+    return pos;
+}
+
+/* Add trans at the front or the back of tlist and return its node. */
+static GList *
+gtm_sr_tlist_add (GncTreeModelSplitRegPrivate *priv, Transaction *trans, gboolean before)
+{
+    gint length = gtm_sr_tlist_length (priv);
+    GList *tnode;
+    gint key;
+
+    if (before || length == 0)
+    {
+        priv->tlist = g_list_prepend (priv->tlist, trans);
+        tnode = priv->tlist;
+        key = --priv->tlist_first_key;
     }
-    
-    if (model_update == VIEW_END)
+    else
     {
-        priv->tlist_start = g_list_length (priv->full_tlist) - num_of_rows;
+        /* Appending to the last node does not walk the list. */
+        GList *last = gtm_sr_tlist_nth (priv, length - 1);
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+        last = g_list_append (last, trans);
+        tnode = last->next;
+        key = priv->tlist_first_key + length;
+    }
+    g_hash_table_insert (priv->tlist_keys, trans, GINT_TO_POINTER (key));
+    g_hash_table_insert (priv->tlist_rows, GINT_TO_POINTER (key), tnode);
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+    return tnode;
+}
+
+/* Remove tnode from tlist. */
+static void
+gtm_sr_tlist_remove (GncTreeModelSplitRegPrivate *priv, GList *tnode)
+{
+    gint last_key = priv->tlist_first_key + gtm_sr_tlist_length (priv) - 1;
+    Transaction *trans;
+    gint key;
 
-            if (rows == num_of_rows)
-                break;
-        } 
+    if (tnode == NULL)
+        return;
+
+    trans = tnode->data;
+    if (!gtm_sr_tlist_get_key (priv, trans, &key))
+        return;
+
+    priv->tlist = g_list_delete_link (priv->tlist, tnode);
+
+    if (key == priv->tlist_first_key || key == last_key)
+    {
+        g_hash_table_remove (priv->tlist_keys, trans);
+        g_hash_table_remove (priv->tlist_rows, GINT_TO_POINTER (key));
+        if (key == priv->tlist_first_key)
+            priv->tlist_first_key++;
     }
+    else
+        gtm_sr_tlist_index_rebuild (priv);
+}
+
+/* Make tnode in tlist hold trans instead. */
+static void
+gtm_sr_tlist_replace (GncTreeModelSplitRegPrivate *priv, GList *tnode, Transaction *trans)
+{
+    gint key;
+
+    if (!gtm_sr_tlist_get_key (priv, tnode->data, &key))
+        return;
+
+    g_hash_table_remove (priv->tlist_keys, tnode->data);
+    tnode->data = trans;
+    g_hash_table_insert (priv->tlist_keys, trans, GINT_TO_POINTER (key));
+}
+
+
+static void
+gtm_sr_reg_load (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update, gint num_of_rows)
+{
+    GncTreeModelSplitRegPrivate *priv;
+    GList *tlist = NULL;
+    gint full_len, pos, end;
+
+    priv = model->priv;
+    full_len = priv->full_tlist->len;
+
+    if (model_update == VIEW_HOME)
+        priv->tlist_start = 0;
+
+    if (model_update == VIEW_END)
+        priv->tlist_start = full_len - num_of_rows;
 
     if (model_update == VIEW_GOTO)
     {
         priv->tlist_start = num_of_rows - NUM_OF_TRANS*1.5;
+        num_of_rows = NUM_OF_TRANS*3;
+    }
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+    end = MIN (priv->tlist_start + num_of_rows, full_len);
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+    /* Build the list from the back so that each step is a prepend. */
+    for (pos = end - 1; pos >= priv->tlist_start && pos >= 0; pos--)
+        tlist = g_list_prepend (tlist, g_ptr_array_index (priv->full_tlist, pos));
 
-            if (rows == (NUM_OF_TRANS*3))
-                break;
-        } 
-    }
+    gtm_sr_tlist_set (priv, tlist);
 }
 
 
@@ -616,8 +784,8 @@ void
 gnc_tree_model_split_reg_load (GncTreeModelSplitReg *model, GList *slist, Account *default_account)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *node;
-    gint rows = 0;
+    GList *tlist, *node;
+    gint full_len;
 
     ENTER("#### Load ModelSplitReg = %p and slist length is %d ####", model, g_list_length (slist));
 
@@ -625,54 +793,56 @@ gnc_tree_model_split_reg_load (GncTreeModelSplitReg *model, GList *slist, Accoun
 
     /* Clear the treeview */
     gtm_sr_remove_all_rows (model);
-    priv->full_tlist = NULL;
-    priv->tlist = NULL;
+    gtm_sr_tlist_set (priv, NULL);
+    g_ptr_array_set_size (priv->full_tlist, 0);
+    g_hash_table_remove_all (priv->full_tlist_pos);
 
     if (model->current_trans == NULL)
         model->current_trans = priv->btrans;
 
-    if (model->sort_direction == 1) // ascending
-    {
-        /* Get a list of Unique Transactions from an slist */
-        priv->full_tlist = xaccSplitListGetUniqueTransactions (slist);
-
-        /* Add the blank transaction to the full_tlist */
-        priv->full_tlist = g_list_append (priv->full_tlist, priv->btrans);
-    }
-    else
-    {
-        /* Get a list of Unique Transactions from an slist */
-        priv->full_tlist = xaccSplitListGetUniqueTransactions (slist);
+    /* Get a list of Unique Transactions from an slist */
+    tlist = xaccSplitListGetUniqueTransactions (slist);
 
-        /* Add the blank transaction to the full_tlist */
-        priv->full_tlist = g_list_append (priv->full_tlist, priv->btrans);
+    /* Add the blank transaction to the full_tlist */
+    tlist = g_list_append (tlist, priv->btrans);
 
+    if (model->sort_direction != 1) // descending
+    {
         /* Reverse the full_tlist */
-        priv->full_tlist = g_list_reverse (priv->full_tlist);
+        tlist = g_list_reverse (tlist);
+    }
+
+    for (node = tlist; node; node = node->next)
+    {
+        g_hash_table_insert (priv->full_tlist_pos, node->data,
+                             GINT_TO_POINTER (priv->full_tlist->len));
+        g_ptr_array_add (priv->full_tlist, node->data);
     }
+    g_list_free (tlist);
 
     // Update the scrollbar
     gnc_tree_model_split_reg_sync_scrollbar (model);
 
-    model->number_of_trans_in_full_tlist = g_list_length (priv->full_tlist);
+    full_len = priv->full_tlist->len;
+    model->number_of_trans_in_full_tlist = full_len;
 
-    if (g_list_length (priv->full_tlist) < NUM_OF_TRANS*3)
+    if (full_len < NUM_OF_TRANS*3)
     {
         // Copy the full_tlist to tlist
-        priv->tlist = g_list_copy (priv->full_tlist);
+        gtm_sr_reg_load (model, VIEW_HOME, full_len);
     }
     else
     {
         if (model->position_of_trans_in_full_tlist < (NUM_OF_TRANS*3))
             gtm_sr_reg_load (model, VIEW_HOME, NUM_OF_TRANS*3);
-        else if (model->position_of_trans_in_full_tlist > g_list_length (priv->full_tlist) - (NUM_OF_TRANS*3))
+        else if (model->position_of_trans_in_full_tlist > full_len - (NUM_OF_TRANS*3))
             gtm_sr_reg_load (model, VIEW_END, NUM_OF_TRANS*3);
         else
             gtm_sr_reg_load (model, VIEW_GOTO, model->position_of_trans_in_full_tlist);
     }
 
     PINFO("#### Register for Account '%s' has %d transactions and %d splits and tlist is %d ####",
-          default_account ? xaccAccountGetName (default_account) : "NULL", g_list_length (priv->full_tlist), g_list_length (slist), g_list_length (priv->tlist));
+          default_account ? xaccAccountGetName (default_account) : "NULL", full_len, g_list_length (slist), gtm_sr_tlist_length (priv));
 
     /* Update the completion model liststores */
     g_idle_add ((GSourceFunc) gnc_tree_model_split_reg_update_completion, model);
@@ -688,15 +858,16 @@ void
 gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *inode, *dnode;
-    gint rows = 0;
+    gint full_len;
     gint icount = 0;
     gint dcount = 0;
+    gint pos;
 
     priv = model->priv;
+    full_len = priv->full_tlist->len;
 
     // if list is not long enougth, return
-    if (g_list_length (priv->full_tlist) < NUM_OF_TRANS*3)
+    if (full_len < NUM_OF_TRANS*3)
         return;
 
     if ((model_update == VIEW_UP) && (model->current_row < NUM_OF_TRANS) && (priv->tlist_start > 0))
@@ -717,34 +888,17 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         priv->tlist_start = iblock_start;
 
         // Insert at the front end
-        for (inode = g_list_nth (priv->full_tlist, iblock_end); inode; inode = inode->prev)
-        {
-            Transaction *trans = inode->data;
-
-            gtm_sr_insert_trans (model, trans, TRUE);
+        for (pos = iblock_end; pos >= iblock_start; pos--)
+            gtm_sr_insert_trans (model, gtm_sr_full_tlist_nth (priv, pos), TRUE);
 
-            rows++;
-
-            if (rows == icount)
-                break;
-        }
-        rows = 0;
         // Delete at the back end
-        for (dnode = g_list_nth (priv->full_tlist, dblock_end); dnode; dnode = dnode->prev)
-        {
-            Transaction *trans = dnode->data;
-
-            gtm_sr_delete_trans (model, trans);
+        for (pos = MIN (dblock_end, full_len - 1); pos >= dblock_start; pos--)
+            gtm_sr_delete_trans (model, gtm_sr_full_tlist_nth (priv, pos));
 
-            rows++;
-
-            if (rows == dcount)
-                break;
-        }
         g_signal_emit_by_name (model, "refresh_view");
     }
 
-    if ((model_update == VIEW_DOWN) && (model->current_row > NUM_OF_TRANS*2) && (priv->tlist_start < (g_list_length (priv->full_tlist) - NUM_OF_TRANS*3 )))
+    if ((model_update == VIEW_DOWN) && (model->current_row > NUM_OF_TRANS*2) && (priv->tlist_start < (full_len - NUM_OF_TRANS*3 )))
     {
         gint dblock_end = 0;
         gint iblock_start = priv->tlist_start + NUM_OF_TRANS*3;
@@ -754,8 +908,8 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         if (iblock_start < 0)
             iblock_start = 0;
 
-        if (iblock_end > g_list_length (priv->full_tlist))
-            iblock_end = g_list_length (priv->full_tlist) - 1;
+        if (iblock_end >= full_len)
+            iblock_end = full_len - 1;
 
         icount = iblock_end - iblock_start + 1;
 
@@ -765,30 +919,13 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         priv->tlist_start = dblock_end;
 
         // Insert at the back end
-        for (inode = g_list_nth (priv->full_tlist, iblock_start); inode; inode = inode->next)
-        {
-            Transaction *trans = inode->data;
-
-            gtm_sr_insert_trans (model, trans, FALSE);
+        for (pos = iblock_start; pos <= iblock_end; pos++)
+            gtm_sr_insert_trans (model, gtm_sr_full_tlist_nth (priv, pos), FALSE);
 
-            rows++;
-
-            if (rows == icount)
-                break;
-        }
-        rows = 0;
         // Delete at the front end
-        for (dnode = g_list_nth (priv->full_tlist, dblock_start); dnode; dnode = dnode->next)
-        {
-            Transaction *trans = dnode->data;
-
-            gtm_sr_delete_trans (model, trans);
+        for (pos = dblock_start; pos < dblock_end; pos++)
+            gtm_sr_delete_trans (model, gtm_sr_full_tlist_nth (priv, pos));
 
-            rows++;
-
-            if (rows == dcount)
-                break;
-        }
         g_signal_emit_by_name (model, "refresh_view");
     }
 }
@@ -799,20 +936,15 @@ Transaction *
 gnc_tree_model_split_reg_get_first_trans (GncTreeModelSplitReg *model)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *node;
     Transaction *trans;
 
     priv = model->priv;
 
-    node = g_list_first (priv->full_tlist);
-
-    trans = node->data;
+    trans = gtm_sr_full_tlist_nth (priv, 0);
 
     if (trans == priv->btrans)
-    {
-        node = g_list_last (priv->full_tlist);
-        trans = node->data;
-    }
+        trans = gtm_sr_full_tlist_nth (priv, priv->full_tlist->len - 1);
+
     return trans;
 }
 
@@ -825,7 +957,7 @@ gnc_tree_model_split_reg_trans_is_in_view (GncTreeModelSplitReg *model, Transact
 
     priv = model->priv;
 
-    if (g_list_index (priv->tlist, trans) == -1)
+    if (gtm_sr_tlist_index (priv, trans) == -1)
         return FALSE;
     else
         return TRUE;
@@ -841,28 +973,21 @@ gnc_tree_model_split_reg_get_tooltip (GncTreeModelSplitReg *model, gint position
     const gchar *date_text;
     const gchar *desc_text;
     Timespec ts = {0,0};
-    GList *node;
 
     priv = model->priv;
 
-    node = g_list_nth (priv->full_tlist, position);
-    if (node == NULL)
+    trans = gtm_sr_full_tlist_nth (priv, position);
+    if (trans == NULL)
        return g_strconcat ("Error", NULL);
+    else if (trans == priv->btrans)
+       return g_strconcat ("Blank Transaction", NULL);
     else
     {
-        trans = node->data;
-        if (trans == NULL)
-           return g_strconcat ("Error", NULL);
-        else if (trans == priv->btrans)
-           return g_strconcat ("Blank Transaction", NULL);
-        else
-        {
-            xaccTransGetDatePostedTS (trans, &ts);
-            date_text = gnc_print_date (ts);
-            desc_text = xaccTransGetDescription (trans);
-            model->current_trans = trans;
-            return g_strconcat (date_text, "\n", desc_text, NULL);
-        }
+        xaccTransGetDatePostedTS (trans, &ts);
+        date_text = gnc_print_date (ts);
+        desc_text = xaccTransGetDescription (trans);
+        model->current_trans = trans;
+        return g_strconcat (date_text, "\n", desc_text, NULL);
     }
 }
 
@@ -872,15 +997,15 @@ void
 gnc_tree_model_split_reg_set_current_trans_by_position (GncTreeModelSplitReg *model, gint position)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *node;
+    Transaction *trans;
 
     priv = model->priv;
 
-    node = g_list_nth (priv->full_tlist, position);
-    if (node == NULL)
-        node = g_list_last (priv->full_tlist);
+    trans = gtm_sr_full_tlist_nth (priv, position);
+    if (trans == NULL)
+        trans = gtm_sr_full_tlist_nth (priv, priv->full_tlist->len - 1);
 
-    model->current_trans = node->data;
+    model->current_trans = trans;
 }
 
 
@@ -892,7 +1017,7 @@ gnc_tree_model_split_reg_sync_scrollbar (GncTreeModelSplitReg *model)
 
     priv = model->priv;
 
-    model->position_of_trans_in_full_tlist = g_list_index (priv->full_tlist, model->current_trans);
+    model->position_of_trans_in_full_tlist = gtm_sr_full_tlist_index (priv, model->current_trans);
 
     g_signal_emit_by_name (model, "scroll_sync");
 }
@@ -1297,7 +1422,7 @@ gnc_tree_model_split_reg_get_iter (GtkTreeModel *tree_model,
 
     indices = gtk_tree_path_get_indices (path);
 
-    tnode = g_list_nth (model->priv->tlist, indices[0]);
+    tnode = gtm_sr_tlist_nth (model->priv, indices[0]);
 
     if (!tnode) {
         DEBUG("path index off end of tlist");
@@ -1416,7 +1541,7 @@ gnc_tree_model_split_reg_get_path (GtkTreeModel *tree_model, GtkTreeIter *iter)
     snode = iter->user_data3;
 
     /* Level 1 */
-    tpos = g_list_position (model->priv->tlist, tnode);
+    tpos = gtm_sr_tlist_position (model->priv, tnode);
 
     if (tpos == -1)
         goto fail;
@@ -1926,7 +2051,7 @@ gnc_tree_model_split_reg_iter_n_children (GtkTreeModel *tree_model, GtkTreeIter
     ENTER("model %p, iter %s", tree_model, iter_to_string (iter));
 
     if (iter == NULL) {
-        i = g_list_length (model->priv->tlist);
+        i = gtm_sr_tlist_length (model->priv);
         LEAVE ("toplevel count is %d", i);
         return i;
     }
@@ -1968,7 +2093,7 @@ gnc_tree_model_split_reg_iter_nth_child (GtkTreeModel *tree_model,
 
     if (parent_iter == NULL) {  /* Top-level */
         flags = TROW1;
-        tnode = g_list_nth (model->priv->tlist, n);
+        tnode = gtm_sr_tlist_nth (model->priv, n);
 
         if (!tnode) {
             PERR("Index greater than trans list.");
@@ -2186,7 +2311,7 @@ gnc_tree_model_split_reg_get_path_to_split_and_trans (GncTreeModelSplitReg *mode
         gchar *path_string;
 
         /* Level 1 */
-        tpos = g_list_index (model->priv->tlist, model->priv->btrans);
+        tpos = gtm_sr_tlist_index (model->priv, model->priv->btrans);
         if (tpos == -1)
             tpos = number;
         gtk_tree_path_append_index (path, tpos);
@@ -2208,7 +2333,7 @@ gnc_tree_model_split_reg_get_path_to_split_and_trans (GncTreeModelSplitReg *mode
     if (trans != NULL)
     {
         /* Level 1 */
-        tpos = g_list_index (model->priv->tlist, trans);
+        tpos = gtm_sr_tlist_index (model->priv, trans);
         if (tpos == -1)
             tpos = number;
         gtk_tree_path_append_index (path, tpos);
@@ -2264,7 +2389,7 @@ gnc_tree_model_split_reg_get_iter_from_trans_and_split (
     if (split && priv->book != xaccSplitGetBook (split)) return FALSE;    
     if (split && !xaccTransStillHasSplit (trans, split)) return FALSE;
 
-    tnode = g_list_find (priv->tlist, trans);
+    tnode = gtm_sr_tlist_find (priv, trans);
     if (!tnode) return FALSE;
 
     if (trans == priv->btrans)
@@ -2477,11 +2602,7 @@ gtm_sr_insert_trans (GncTreeModelSplitReg *model, Transaction *trans, gboolean b
     GList *tnode = NULL, *snode = NULL;
 
     ENTER("insert transaction %p into model %p", trans, model);
-    if (before == TRUE)
-        model->priv->tlist = g_list_prepend (model->priv->tlist, trans);
-    else
-        model->priv->tlist = g_list_append (model->priv->tlist, trans);
-    tnode = g_list_find (model->priv->tlist, trans);
+    tnode = gtm_sr_tlist_add (model->priv, trans, before);
 
     iter = gtm_sr_make_iter (model, TROW1, tnode, NULL);
     gtm_sr_insert_row_at (model, &iter);
@@ -2521,9 +2642,9 @@ gtm_sr_delete_trans (GncTreeModelSplitReg *model, Transaction *trans)
     GList *tnode = NULL, *snode = NULL;
 
     ENTER("delete trans %p", trans);
-    tnode = g_list_find (model->priv->tlist, trans);
+    tnode = gtm_sr_tlist_find (model->priv, trans);
 
-    DEBUG("tlist length is %d and no of splits is %d", g_list_length (model->priv->tlist), xaccTransCountSplits (trans));
+    DEBUG("tlist length is %d and no of splits is %d", gtm_sr_tlist_length (model->priv), xaccTransCountSplits (trans));
 
     if (tnode == model->priv->bsplit_parent_node)
     {
@@ -2548,7 +2669,7 @@ gtm_sr_delete_trans (GncTreeModelSplitReg *model, Transaction *trans)
     iter = gtm_sr_make_iter (model, TROW1, tnode, NULL);
     gtm_sr_delete_row_at (model, &iter);
 
-    model->priv->tlist = g_list_delete_link (model->priv->tlist, tnode);
+    gtm_sr_tlist_remove (model->priv, tnode);
     LEAVE(" ");
 }
 
@@ -2565,9 +2686,9 @@ gnc_tree_model_split_reg_set_blank_split_parent (GncTreeModelSplitReg *model, Tr
     priv = model->priv;
 
     if (trans == NULL)
-        tnode = g_list_last (priv->tlist);
+        tnode = gtm_sr_tlist_nth (priv, gtm_sr_tlist_length (priv) - 1);
     else
-        tnode = g_list_find (priv->tlist, trans);
+        tnode = gtm_sr_tlist_find (priv, trans);
 
     ENTER("set blank split %p parent to trans %p and remove_only is %d", priv->bsplit, trans, remove_only);
 
@@ -2719,7 +2840,7 @@ gtm_sr_get_removal_path (GncTreeModelSplitReg *model, Transaction *trans,
     if (priv->book != xaccTransGetBook (trans))
         return FALSE;
 
-    tnode = g_list_find (priv->tlist, trans);
+    tnode = gtm_sr_tlist_find (priv, trans);
     if (!tnode)
         return FALSE;
 
@@ -3280,9 +3401,7 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
             if (priv->btrans == trans)
             {
                 priv->btrans = xaccMallocTransaction (priv->book);
-                priv->tlist = g_list_append (priv->tlist, priv->btrans);
-
-                tnode = g_list_find (priv->tlist, priv->btrans);
+                tnode = gtm_sr_tlist_add (priv, priv->btrans, FALSE);
                 /* Insert a new blank trans */
                 iter1 = gtm_sr_make_iter (model, TROW1 | BLANK, tnode, NULL);
                 gtm_sr_insert_row_at (model, &iter1);
@@ -3302,9 +3421,9 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
         case QOF_EVENT_DESTROY:
             if (priv->btrans == trans)
             {
-                tnode = g_list_find (priv->tlist, priv->btrans);
+                tnode = gtm_sr_tlist_find (priv, priv->btrans);
                 priv->btrans = xaccMallocTransaction (priv->book);
-                tnode->data = priv->btrans;
+                gtm_sr_tlist_replace (priv, tnode, priv->btrans);
                 iter1 = gtm_sr_make_iter (model, TROW1 | BLANK, tnode, NULL);
                 gtm_sr_changed_row_at (model, &iter1);
                 iter2 = gtm_sr_make_iter (model, TROW2 | BLANK, tnode, NULL);
@@ -3332,7 +3451,7 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
             acc = xaccSplitGetAccount (split);
             trans = xaccSplitGetParent (split);
 
-            if (!g_list_find (priv->tlist, trans) && priv->display_gl)
+            if (!gtm_sr_tlist_find (priv, trans) && priv->display_gl)
             {
                 gnc_commodity *split_com;
                 split_com = xaccAccountGetCommodity (acc);
@@ -3343,7 +3462,7 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
                     g_signal_emit_by_name (model, "refresh_trans", trans);
                 }
             }
-            else if (!g_list_find (priv->tlist, trans) && ((xaccAccountHasAncestor (acc, priv->anchor) && priv->display_subacc) || acc == priv->anchor ))
+            else if (!gtm_sr_tlist_find (priv, trans) && ((xaccAccountHasAncestor (acc, priv->anchor) && priv->display_subacc) || acc == priv->anchor ))
             {
                 DEBUG("Insert trans %p (%s)", trans, name);
                 gtm_sr_insert_trans (model, trans, TRUE);
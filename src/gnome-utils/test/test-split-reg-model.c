@@ -0,0 +1,195 @@
+/********************************************************************
+ * test-split-reg-model.c: timing of the split register tree model. *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/* test-split-reg-model.c:
+ *
+ *     Loads a register with a large number of transactions (200000
+ * unless given on the command line), scrolls it from one end to the
+ * other and back and prints the time taken per operation.  This is a
+ * timing aid, so it is not run by make check.
+ */
+
+#include "config.h"
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "TransLog.h"
+#include "gnc-ui-util.h"
+#include "gnc-tree-model-split-reg.h"
+
+static void
+report (const gchar *operation, gint64 usecs, gint count)
+{
+    printf ("%-28s %8d ops %10.3f ms %10.3f us/op\n", operation, count,
+            usecs / 1000.0, count > 0 ? (gdouble) usecs / count : 0.0);
+}
+
+static Account *
+make_account (QofBook *book, gnc_commodity *currency, const gchar *name)
+{
+    Account *acc = xaccMallocAccount (book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (acc, currency);
+    gnc_account_append_child (gnc_book_get_root_account (book), acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static void
+make_transactions (QofBook *book, Account *acc, Account *other, gint count)
+{
+    gnc_commodity *currency = xaccAccountGetCommodity (acc);
+    time64 date = gnc_time (NULL) - (time64) count * 60;
+    gint i;
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountBeginEdit (other);
+    for (i = 0; i < count; i++)
+    {
+        Transaction *trans = xaccMallocTransaction (book);
+        Split *split1 = xaccMallocSplit (book);
+        Split *split2 = xaccMallocSplit (book);
+        gnc_numeric amount = gnc_numeric_create (i % 10000 + 1, 100);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetCurrency (trans, currency);
+        xaccTransSetDatePostedSecs (trans, date + (time64) i * 60);
+        xaccTransSetDescription (trans, "Scroll test");
+
+        xaccSplitSetParent (split1, trans);
+        xaccSplitSetAccount (split1, acc);
+        xaccSplitSetAmount (split1, amount);
+        xaccSplitSetValue (split1, amount);
+
+        xaccSplitSetParent (split2, trans);
+        xaccSplitSetAccount (split2, other);
+        xaccSplitSetAmount (split2, gnc_numeric_neg (amount));
+        xaccSplitSetValue (split2, gnc_numeric_neg (amount));
+        xaccTransCommitEdit (trans);
+    }
+    xaccAccountCommitEdit (other);
+    xaccAccountCommitEdit (acc);
+}
+
+/* Walk every top level row the way a tree view does when it draws. */
+static void
+time_rows (GncTreeModelSplitReg *model)
+{
+    GtkTreeModel *tree_model = GTK_TREE_MODEL (model);
+    GtkTreeIter iter;
+    GtkTreePath *path;
+    gint64 start;
+    gint rows, n;
+
+    rows = gtk_tree_model_iter_n_children (tree_model, NULL);
+
+    start = g_get_monotonic_time ();
+    for (n = 0; n < rows; n++)
+    {
+        gtk_tree_model_iter_nth_child (tree_model, &iter, NULL, n);
+        path = gtk_tree_model_get_path (tree_model, &iter);
+        gtk_tree_model_get_iter (tree_model, &iter, path);
+        gtk_tree_path_free (path);
+    }
+    report ("row nth/path/iter", g_get_monotonic_time () - start, rows);
+}
+
+int
+main (int argc, char **argv)
+{
+    GncTreeModelSplitReg *model;
+    QofBook *book;
+    gnc_commodity *currency;
+    Account *acc, *other;
+    GList *slist;
+    gint64 start;
+    gint count = 200000;
+    gint moves, position;
+
+    gtk_init (&argc, &argv);
+    if (argc > 1)
+        count = atoi (argv[1]);
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+    xaccLogDisable ();
+
+    book = gnc_get_current_book ();
+    currency = gnc_commodity_new (book, "US Dollar", "ISO4217", "USD", NULL, 100);
+    acc = make_account (book, currency, "Checking");
+    other = make_account (book, currency, "Expenses");
+
+    start = g_get_monotonic_time ();
+    make_transactions (book, acc, other, count);
+    report ("create transactions", g_get_monotonic_time () - start, count);
+
+    model = gnc_tree_model_split_reg_new (BANK_REGISTER2, REG2_STYLE_LEDGER, FALSE, FALSE);
+    slist = xaccAccountGetSplitList (acc);
+
+    /* The model opens at the blank transaction, at the end. */
+    start = g_get_monotonic_time ();
+    gnc_tree_model_split_reg_load (model, slist, acc);
+    report ("load", g_get_monotonic_time () - start, 1);
+    time_rows (model);
+
+    /* Scroll to the top a block at a time. */
+    start = g_get_monotonic_time ();
+    for (moves = 0; moves <= count / NUM_OF_TRANS; moves++)
+    {
+        model->current_row = 0;
+        gnc_tree_model_split_reg_move (model, VIEW_UP);
+    }
+    report ("scroll up one block", g_get_monotonic_time () - start, moves);
+    time_rows (model);
+
+    /* And back down to the bottom. */
+    start = g_get_monotonic_time ();
+    for (moves = 0; moves <= count / NUM_OF_TRANS; moves++)
+    {
+        model->current_row = NUM_OF_TRANS * 3 - 1;
+        gnc_tree_model_split_reg_move (model, VIEW_DOWN);
+    }
+    report ("scroll down one block", g_get_monotonic_time () - start, moves);
+
+    /* Drag the scrollbar over the whole register. */
+    start = g_get_monotonic_time ();
+    for (position = 0; position < count; position += count / 1000 + 1)
+    {
+        gnc_tree_model_split_reg_set_current_trans_by_position (model, position);
+        gnc_tree_model_split_reg_sync_scrollbar (model);
+    }
+    report ("scrollbar position", g_get_monotonic_time () - start,
+            count / (count / 1000 + 1));
+
+    g_object_unref (model);
+    qof_close ();
+    return 0;
+}
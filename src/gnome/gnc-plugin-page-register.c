@@ -105,6 +105,8 @@ static gchar *gnc_plugin_page_register_get_tab_color (GncPluginPage *plugin_page
 static gchar *gnc_plugin_page_register_get_long_name (GncPluginPage *plugin_page);
 
 static void gnc_plugin_page_register_summarybar_position_changed(GConfEntry *entry, gpointer user_data);
+static void gnc_plugin_page_register_selected (GObject *object, gpointer user_data);
+static void gnc_plugin_page_register_unselected (GObject *object, gpointer user_data);
 
 /* Callbacks for the "Sort By" dialog */
 void gnc_plugin_page_register_sort_button_cb(GtkToggleButton *button, GncPluginPageRegister *page);
@@ -623,10 +625,41 @@ gnc_plugin_page_register_new_common (GNCLedgerDisplay *ledger)
         gnc_plugin_page_add_book (plugin_page, (QofBook *)item->data);
     // Do not free the list. It is owned by the query.
 
+    /* Registers not in view are refreshed from the idle loop */
+    g_signal_connect (G_OBJECT (plugin_page), "selected",
+                      G_CALLBACK (gnc_plugin_page_register_selected), NULL);
+    g_signal_connect (G_OBJECT (plugin_page), "unselected",
+                      G_CALLBACK (gnc_plugin_page_register_unselected), NULL);
+
     priv->component_manager_id = 0;
     return plugin_page;
 }
 
+static void
+gnc_plugin_page_register_set_background_refresh (GObject *object,
+        gboolean background)
+{
+    GncPluginPageRegisterPrivate *priv;
+
+    g_return_if_fail (GNC_IS_PLUGIN_PAGE_REGISTER (object));
+
+    priv = GNC_PLUGIN_PAGE_REGISTER_GET_PRIVATE(object);
+    if (priv->ledger)
+        gnc_ledger_display_set_background_refresh (priv->ledger, background);
+}
+
+static void
+gnc_plugin_page_register_selected (GObject *object, gpointer user_data)
+{
+    gnc_plugin_page_register_set_background_refresh (object, FALSE);
+}
+
+static void
+gnc_plugin_page_register_unselected (GObject *object, gpointer user_data)
+{
+    gnc_plugin_page_register_set_background_refresh (object, TRUE);
+}
+
 GncPluginPage *
 gnc_plugin_page_register_new (Account *account, gboolean subaccounts)
 {
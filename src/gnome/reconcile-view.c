@@ -100,6 +100,32 @@ gnc_reconcile_view_get_type (void)
  *       statement_date - date of statement                                 *
  * Returns: the account tree widget, or NULL if there was a problem.        *
 \****************************************************************************/
+/* The splits the query of the view is run over: only the ones not yet
+ * reconciled, of the account and of its descendants if they are
+ * reconciled together.  qof_query_run_list() calls this after the
+ * backend has loaded any older splits the query can match. */
+static GList *
+gnc_reconcile_view_get_candidates (gpointer user_data)
+{
+    GNCReconcileView *view = user_data;
+    GList            *accounts = NULL;
+    GList            *splits = NULL;
+    GList            *node;
+
+    if (xaccAccountGetReconcileChildrenStatus (view->account))
+        accounts = gnc_account_get_descendants (view->account);
+
+    accounts = g_list_prepend (accounts, view->account);
+
+    for (node = g_list_last (accounts); node; node = node->prev)
+        splits = g_list_concat (xaccAccountGetUnreconciledSplitList (node->data),
+                                splits);
+
+    g_list_free (accounts);
+    return splits;
+}
+
+
 static void
 gnc_reconcile_view_construct (GNCReconcileView *view, Query *query)
 {
@@ -111,7 +137,8 @@ gnc_reconcile_view_construct (GNCReconcileView *view, Query *query)
     if (view->view_type == RECLIST_CREDIT)
         inv_sort = TRUE;
 
-    /* Construct the view */
+    /* Construct the view, looking only at the unreconciled splits */
+    gnc_query_view_set_candidates (qview, gnc_reconcile_view_get_candidates, view);
     gnc_query_view_construct (qview, view->column_list, query);
     gnc_query_view_set_numerics (qview, TRUE, inv_sort);
 
@@ -199,7 +226,9 @@ gnc_reconcile_view_new (Account *account, GNCReconcileViewType type,
 
     if (auto_check)
     {
-        for (splits = qof_query_run (query); splits; splits = splits->next)
+        splits = qof_query_run_list (query, gnc_reconcile_view_get_candidates,
+                                     view);
+        for (; splits; splits = splits->next)
         {
             Split *split = splits->data;
             char recn = xaccSplitGetReconcile (split);
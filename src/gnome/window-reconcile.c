@@ -1520,32 +1520,21 @@ recn_set_watches_one_account (gpointer data, gpointer user_data)
 {
     Account *account = (Account *)data;
     RecnWindow *recnData = (RecnWindow *)user_data;
-    GList *node;
+    GList *splits, *node;
 
-    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    /* Only the splits that are not yet reconciled are of interest */
+    splits = xaccAccountGetUnreconciledSplitList (account);
+    for (node = splits; node; node = node->next)
     {
-        Split *split = node->data;
-        Transaction *trans;
-        char recn;
+        Transaction *trans = xaccSplitGetParent (node->data);
 
-        recn = xaccSplitGetReconcile (split);
-        switch (recn)
-        {
-        case NREC:
-        case CREC:
-            trans = xaccSplitGetParent (split);
-
-            gnc_gui_component_watch_entity (recnData->component_id,
-                                            xaccTransGetGUID (trans),
-                                            QOF_EVENT_MODIFY
-                                            | QOF_EVENT_DESTROY
-                                            | GNC_EVENT_ITEM_CHANGED);
-            break;
-
-        default:
-            break;
-        }
+        gnc_gui_component_watch_entity (recnData->component_id,
+                                        xaccTransGetGUID (trans),
+                                        QOF_EVENT_MODIFY
+                                        | QOF_EVENT_DESTROY
+                                        | GNC_EVENT_ITEM_CHANGED);
     }
+    g_list_free (splits);
 }
 
 
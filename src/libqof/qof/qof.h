@@ -93,6 +93,7 @@
 #include "qofquerycore.h"
 #include "qofsession.h"
 #include "qofchoice.h"
+#include "qofprofile.h"
 #include "qofreference.h"
 #include "qof-string-cache.h"
 
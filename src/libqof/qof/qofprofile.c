@@ -0,0 +1,350 @@
+/********************************************************************\
+ * qofprofile.c -- timing of book loads and saves                   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "qof.h"
+#include "qofprofile.h"
+
+static QofLogModule log_module = QOF_MOD_PROFILE;
+
+typedef struct
+{
+    gchar *name;
+    gint64 count;       /* objects only */
+    gint64 usecs;
+} profile_entry;
+
+/* Phases may be added from other threads, so everything is guarded by
+ * the lock. */
+G_LOCK_DEFINE_STATIC(profile);
+static gint profile_depth = 0;
+static gboolean profile_finished = FALSE;
+static gboolean profile_success = FALSE;
+static gchar *profile_operation = NULL;
+static gchar *profile_backend = NULL;
+static gint64 profile_start = 0;
+static gint64 profile_usecs = 0;
+static GList *profile_phases = NULL;    /* in the order first seen */
+static GList *profile_objects = NULL;
+static gchar *profile_output_file = NULL;
+static gboolean profile_output_checked = FALSE;
+
+static void
+profile_entry_free(gpointer data)
+{
+    profile_entry *entry = data;
+
+    g_free(entry->name);
+    g_free(entry);
+}
+
+static void
+profile_clear(void)
+{
+    g_list_free_full(profile_phases, profile_entry_free);
+    g_list_free_full(profile_objects, profile_entry_free);
+    profile_phases = NULL;
+    profile_objects = NULL;
+    g_free(profile_operation);
+    g_free(profile_backend);
+    profile_operation = NULL;
+    profile_backend = NULL;
+    profile_usecs = 0;
+    profile_finished = FALSE;
+}
+
+static profile_entry *
+profile_lookup(GList **list, const gchar *name)
+{
+    profile_entry *entry;
+    GList *node;
+
+    for (node = *list; node; node = node->next)
+    {
+        entry = node->data;
+        if (g_strcmp0(entry->name, name) == 0)
+            return entry;
+    }
+
+    entry = g_new0(profile_entry, 1);
+    entry->name = g_strdup(name);
+    *list = g_list_append(*list, entry);
+    return entry;
+}
+
+gint64
+qof_profile_now (void)
+{
+    return g_get_monotonic_time();
+}
+
+void
+qof_profile_begin (const gchar *operation, const gchar *backend)
+{
+    G_LOCK(profile);
+    if (profile_depth++ == 0)
+    {
+        profile_clear();
+        profile_operation = g_strdup(operation);
+        profile_backend = g_strdup(backend);
+        profile_start = qof_profile_now();
+    }
+    G_UNLOCK(profile);
+}
+
+void
+qof_profile_add_phase_time (const gchar *phase, gint64 usecs)
+{
+    g_return_if_fail(phase);
+
+    G_LOCK(profile);
+    if (profile_depth > 0)
+        profile_lookup(&profile_phases, phase)->usecs += usecs;
+    G_UNLOCK(profile);
+}
+
+void
+qof_profile_end_phase (const gchar *phase, gint64 start)
+{
+    qof_profile_add_phase_time(phase, qof_profile_now() - start);
+}
+
+void
+qof_profile_add_objects (const gchar *type, gint64 count, gint64 usecs)
+{
+    profile_entry *entry;
+
+    g_return_if_fail(type);
+
+    G_LOCK(profile);
+    if (profile_depth > 0)
+    {
+        entry = profile_lookup(&profile_objects, type);
+        entry->count += count;
+        entry->usecs += usecs;
+    }
+    G_UNLOCK(profile);
+}
+
+gboolean
+qof_profile_enabled (void)
+{
+    gboolean enabled;
+
+    G_LOCK(profile);
+    enabled = profile_depth > 0
+              && (profile_get_output_file()
+                  || qof_log_check(log_module, QOF_LOG_INFO));
+    G_UNLOCK(profile);
+
+    return enabled;
+}
+
+/********************************************************************\
+ * Reporting
+\********************************************************************/
+
+static gdouble
+usecs_to_ms(gint64 usecs)
+{
+    return usecs / 1000.0;
+}
+
+static void
+json_append_string(GString *json, const gchar *str)
+{
+    const gchar *p;
+
+    g_string_append_c(json, '"');
+    for (p = str ? str : ""; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+            g_string_append_printf(json, "\\%c", *p);
+        else if ((guchar) *p < 0x20)
+            g_string_append_printf(json, "\\u%04x", (guchar) *p);
+        else
+            g_string_append_c(json, *p);
+    }
+    g_string_append_c(json, '"');
+}
+
+/* Numbers are written with a '.' whatever the locale. */
+static void
+json_append_double(GString *json, gdouble value)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_string_append(json, g_ascii_formatd(buf, sizeof(buf), "%.3f", value));
+}
+
+/* Called with the lock held. */
+static gchar *
+profile_to_json(void)
+{
+    GString *json = g_string_new("{\"operation\": ");
+    GList *node;
+
+    json_append_string(json, profile_operation);
+    g_string_append(json, ", \"backend\": ");
+    json_append_string(json, profile_backend);
+    g_string_append_printf(json, ", \"success\": %s, \"total_ms\": ",
+                           profile_success ? "true" : "false");
+    json_append_double(json, usecs_to_ms(profile_usecs));
+
+    g_string_append(json, ", \"phases\": [");
+    for (node = profile_phases; node; node = node->next)
+    {
+        profile_entry *entry = node->data;
+
+        g_string_append(json, "{\"name\": ");
+        json_append_string(json, entry->name);
+        g_string_append(json, ", \"ms\": ");
+        json_append_double(json, usecs_to_ms(entry->usecs));
+        g_string_append(json, node->next ? "}, " : "}");
+    }
+
+    g_string_append(json, "], \"objects\": [");
+    for (node = profile_objects; node; node = node->next)
+    {
+        profile_entry *entry = node->data;
+
+        g_string_append(json, "{\"type\": ");
+        json_append_string(json, entry->name);
+        g_string_append_printf(json, ", \"count\": %" G_GINT64_FORMAT
+                               ", \"ms\": ", entry->count);
+        json_append_double(json, usecs_to_ms(entry->usecs));
+        g_string_append(json, ", \"per_second\": ");
+        json_append_double(json, entry->usecs > 0
+                           ? entry->count * 1e6 / entry->usecs : 0.0);
+        g_string_append(json, node->next ? "}, " : "}");
+    }
+    g_string_append(json, "]}");
+
+    return g_string_free(json, FALSE);
+}
+
+/* Called with the lock held. */
+static void
+profile_log(void)
+{
+    GList *node;
+
+    PINFO("%s through %s backend %s in %.3f s", profile_operation,
+          profile_backend, profile_success ? "succeeded" : "failed",
+          profile_usecs / 1e6);
+    for (node = profile_phases; node; node = node->next)
+    {
+        profile_entry *entry = node->data;
+        PINFO("phase %s: %.3f s", entry->name, entry->usecs / 1e6);
+    }
+    for (node = profile_objects; node; node = node->next)
+    {
+        profile_entry *entry = node->data;
+        PINFO("%s: %" G_GINT64_FORMAT " in %.3f s (%.0f/s)",
+              entry->name, entry->count, entry->usecs / 1e6,
+              entry->usecs > 0 ? entry->count * 1e6 / entry->usecs : 0.0);
+    }
+}
+
+/* Called with the lock held. */
+static const gchar *
+profile_get_output_file(void)
+{
+    if (!profile_output_checked)
+    {
+        const gchar *filename = g_getenv("GNC_PROFILE_FILE");
+
+        profile_output_checked = TRUE;
+        if (!profile_output_file && filename && *filename)
+            profile_output_file = g_strdup(filename);
+    }
+    return profile_output_file;
+}
+
+/* Called with the lock held. */
+static void
+profile_write_output(void)
+{
+    gchar *json;
+    FILE *out;
+
+    if (!profile_get_output_file())
+        return;
+
+    out = g_fopen(profile_output_file, "a");
+    if (!out)
+    {
+        PWARN("cannot open profile file %s: %s", profile_output_file,
+              g_strerror(errno));
+        return;
+    }
+
+    json = profile_to_json();
+    fprintf(out, "%s\n", json);
+    fclose(out);
+    g_free(json);
+}
+
+void
+qof_profile_end (gboolean success)
+{
+    G_LOCK(profile);
+    if (profile_depth > 0 && --profile_depth == 0)
+    {
+        profile_usecs = qof_profile_now() - profile_start;
+        profile_success = success;
+        profile_finished = TRUE;
+        profile_log();
+        profile_write_output();
+    }
+    G_UNLOCK(profile);
+}
+
+gchar *
+qof_profile_to_json (void)
+{
+    gchar *json = NULL;
+
+    G_LOCK(profile);
+    if (profile_finished)
+        json = profile_to_json();
+    G_UNLOCK(profile);
+
+    return json;
+}
+
+void
+qof_profile_set_output_file (const gchar *filename)
+{
+    G_LOCK(profile);
+    g_free(profile_output_file);
+    profile_output_file = g_strdup(filename);
+    profile_output_checked = TRUE;
+    G_UNLOCK(profile);
+}
@@ -0,0 +1,88 @@
+/********************************************************************\
+ * qofprofile.h -- timing of book loads and saves                   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/** @addtogroup Profile
+    Timing of the phases of loading and saving a book.
+
+    qof_session_load and qof_session_save time every load and save as
+    a whole.  While one runs, the backend adds the time it spends in
+    each phase of the work (decompressing, parsing, scrubbing, ...)
+    and in each type of object, together with the number of objects.
+
+    When the load or save is over the result is logged at the info
+    level under QOF_MOD_PROFILE and, if an output file has been set
+    with qof_profile_set_output_file or the GNC_PROFILE_FILE
+    environment variable, appended to that file as one line of JSON.
+    The result of the last load or save can also be fetched with
+    qof_profile_to_json.
+
+    Phases are not exclusive: a phase running on a thread of its own,
+    such as decompression, overlaps the others, and a phase may
+    include the time of the objects built during it.
+    @{ */
+/** @file qofprofile.h
+    @brief Timing of book loads and saves.
+*/
+
+#ifndef QOF_PROFILE_H
+#define QOF_PROFILE_H
+
+#include <glib.h>
+
+#define QOF_MOD_PROFILE "qof.profile"
+
+/** Start timing operation ("load" or "save") through backend, and
+ *  forget the previous result.  Calls nest: only the outermost pair of
+ *  qof_profile_begin and qof_profile_end is timed. */
+void qof_profile_begin (const gchar *operation, const gchar *backend);
+
+/** Finish timing the current operation and report it. */
+void qof_profile_end (gboolean success);
+
+/** The clock the profile uses, in microseconds. */
+gint64 qof_profile_now (void);
+
+/** Add the time since start, as returned by qof_profile_now, to phase. */
+void qof_profile_end_phase (const gchar *phase, gint64 start);
+
+/** Add usecs microseconds to phase.  May be called from any thread. */
+void qof_profile_add_phase_time (const gchar *phase, gint64 usecs);
+
+/** Add count objects of type, which took usecs microseconds. */
+void qof_profile_add_objects (const gchar *type, gint64 count, gint64 usecs);
+
+/** TRUE if an operation is being timed and its report will go
+ *  somewhere, either to the output file or to the qof.profile log at
+ *  INFO level.  Callers that count objects on a hot path can check it
+ *  once rather than paying for the counting when nobody is looking. */
+gboolean qof_profile_enabled (void);
+
+/** The last finished operation as a JSON object, or NULL if there has
+ *  been none.  g_free the result. */
+gchar *qof_profile_to_json (void);
+
+/** Append the JSON of each finished operation to filename, or stop if
+ *  filename is NULL. */
+void qof_profile_set_output_file (const gchar *filename);
+
+/** @} */
+#endif /* QOF_PROFILE_H */
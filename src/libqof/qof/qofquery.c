@@ -800,6 +800,22 @@ static GList * qof_query_run_internal (QofQuery *q,
     return matching_objects;
 }
 
+/* Run the compiled query in the backend of the book, if it has one */
+static void qof_query_run_backend(QofQuery *q, QofBook *book)
+{
+    QofBackend *be = book->backend;
+
+    if (be)
+    {
+        gpointer compiled_query = g_hash_table_lookup (q->be_compiled, book);
+
+        if (compiled_query && be->run_query)
+        {
+            (be->run_query) (be, compiled_query);
+        }
+    }
+}
+
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
@@ -810,19 +826,9 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
     for (node = qcb->query->books; node; node = node->next)
     {
         QofBook *book = node->data;
-        QofBackend *be = book->backend;
 
         /* run the query in the backend */
-        if (be)
-        {
-            gpointer compiled_query = g_hash_table_lookup (qcb->query->be_compiled,
-                                      book);
-
-            if (compiled_query && be->run_query)
-            {
-                (be->run_query) (be, compiled_query);
-            }
-        }
+        qof_query_run_backend (qcb->query, book);
 
         /* And then iterate over all the objects */
         qof_object_foreach (qcb->query->search_for, book,
@@ -836,6 +842,43 @@ GList * qof_query_run (QofQuery *q)
     return qof_query_run_internal(q, qof_query_run_cb, NULL);
 }
 
+typedef struct
+{
+    QofQueryCandidatesCB get_candidates;
+    gpointer user_data;
+} QofQueryCandidates;
+
+static void qof_query_run_list_cb(QofQueryCB* qcb, gpointer cb_arg)
+{
+    QofQueryCandidates *cand = cb_arg;
+    GList *node, *objects;
+
+    g_return_if_fail(qcb);
+
+    /* Let the backends load what the query can match before the
+     * candidates are collected */
+    for (node = qcb->query->books; node; node = node->next)
+        qof_query_run_backend (qcb->query, node->data);
+
+    objects = (cand->get_candidates) (cand->user_data);
+    g_list_foreach(objects, check_item_cb, qcb);
+    g_list_free(objects);
+}
+
+GList *
+qof_query_run_list (QofQuery *q, QofQueryCandidatesCB get_candidates,
+                    gpointer user_data)
+{
+    QofQueryCandidates cand;
+
+    if (!q) return NULL;
+    g_return_val_if_fail (get_candidates, NULL);
+
+    cand.get_candidates = get_candidates;
+    cand.user_data = user_data;
+    return qof_query_run_internal(q, qof_query_run_list_cb, &cand);
+}
+
 static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     QofQuery* pq = cb_arg;
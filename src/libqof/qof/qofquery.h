@@ -222,6 +222,29 @@ GList * qof_query_run (QofQuery *query);
  */
 GList * qof_query_last_run (QofQuery *query);
 
+/** Returns a newly allocated list of candidate objects for
+ *  qof_query_run_list().  */
+typedef GList * (*QofQueryCandidatesCB) (gpointer user_data);
+
+/** Run the query over a list of candidate objects instead of over
+ *  the books of the query.  The objects must be of the type the query
+ *  searches for.  This lets a caller that already holds a much smaller
+ *  set of candidates, such as an index kept by the engine, avoid
+ *  walking every object in the book.
+ *
+ *  The query is first run in the backend of each book, just as
+ *  qof_query_run() does, so that a backend which loads objects on
+ *  demand brings in the ones the query can match.  Only then is
+ *  get_candidates called, so the candidates include them.  The
+ *  candidate list is freed before this returns.
+ *
+ *  Do NOT free the resulting list.  This list is managed internally
+ *  by QofQuery.
+ */
+GList * qof_query_run_list (QofQuery *query,
+                            QofQueryCandidatesCB get_candidates,
+                            gpointer user_data);
+
 /** Perform a subquery, return the results.
  *  Instead of running over a book, the subquery runs over the results
  *  of the primary query.
@@ -1253,8 +1253,12 @@ qof_session_load (QofSession *session,
 
         if (be->load)
         {
+            qof_profile_begin ("load", be->provider
+                               ? be->provider->access_method : NULL);
             be->load (be, newbook, LOAD_TYPE_INITIAL_LOAD);
             qof_session_push_error (session, qof_backend_get_error(be), NULL);
+            qof_profile_end (qof_session_get_error (session)
+                             == ERR_BACKEND_NO_ERR);
         }
     }
 
@@ -1265,6 +1269,7 @@ qof_session_load (QofSession *session,
     */
     err = qof_session_get_error(session);
     if ((err != ERR_BACKEND_NO_ERR) &&
+            (err != ERR_FILEIO_FILE_BAD_READ) &&
             (err != ERR_FILEIO_FILE_TOO_OLD) &&
             (err != ERR_FILEIO_NO_ENCODING) &&
             (err != ERR_FILEIO_FILE_UPGRADE) &&
@@ -1430,8 +1435,14 @@ qof_session_save (QofSession *session,
         be->percentage = percentage_func;
         if (be->sync)
         {
+            gboolean failed;
+
+            qof_profile_begin ("save", be->provider
+                               ? be->provider->access_method : NULL);
             (be->sync)(be, session->book);
-            if (save_error_handler(be, session))
+            failed = save_error_handler(be, session);
+            qof_profile_end (!failed);
+            if (failed)
                 goto leave;
         }
 
@@ -0,0 +1,125 @@
+/********************************************************************
+ * test-qofprofile.c: GLib g_test test suite for qofprofile.c.      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofprofile";
+void test_suite_qofprofile ( void );
+
+static void
+test_qof_profile_phases_and_objects( void )
+{
+    gchar *json;
+
+    qof_profile_begin( "load", "file" );
+    qof_profile_add_phase_time( "parse", 2000 );
+    qof_profile_add_phase_time( "scrub", 1000 );
+    qof_profile_add_phase_time( "parse", 500 );
+    qof_profile_add_objects( "Trans", 10, 4000 );
+    qof_profile_add_objects( "Trans", 10, 4000 );
+    qof_profile_end( TRUE );
+
+    json = qof_profile_to_json();
+    g_assert( json != NULL );
+    g_assert( g_str_has_prefix( json, "{\"operation\": \"load\", \"backend\": \"file\", \"success\": true" ) );
+    /* Phases keep the order they were first seen in and add up. */
+    g_assert( strstr( json, "\"phases\": [{\"name\": \"parse\", \"ms\": 2.500}, "
+                      "{\"name\": \"scrub\", \"ms\": 1.000}]" ) != NULL );
+    g_assert( strstr( json, "{\"type\": \"Trans\", \"count\": 20, \"ms\": 8.000, "
+                      "\"per_second\": 2500.000}" ) != NULL );
+    g_free( json );
+}
+
+static void
+test_qof_profile_nesting( void )
+{
+    gchar *json;
+
+    qof_profile_begin( "save", "sqlite3" );
+    qof_profile_add_phase_time( "outer", 1000 );
+    qof_profile_begin( "load", "file" );
+    qof_profile_add_phase_time( "inner", 1000 );
+    qof_profile_end( FALSE );
+    /* Only the outermost pair reports. */
+    qof_profile_add_phase_time( "outer", 1000 );
+    qof_profile_end( TRUE );
+
+    json = qof_profile_to_json();
+    g_assert( g_str_has_prefix( json, "{\"operation\": \"save\", \"backend\": \"sqlite3\", \"success\": true" ) );
+    g_assert( strstr( json, "{\"name\": \"outer\", \"ms\": 2.000}" ) != NULL );
+    g_assert( strstr( json, "{\"name\": \"inner\", \"ms\": 1.000}" ) != NULL );
+    g_free( json );
+
+    /* Outside of an operation nothing is recorded, and the last result
+     * stays. */
+    qof_profile_end( FALSE );
+    qof_profile_add_phase_time( "stray", 1000 );
+    json = qof_profile_to_json();
+    g_assert( strstr( json, "stray" ) == NULL );
+    g_assert( strstr( json, "\"success\": true" ) != NULL );
+    g_free( json );
+}
+
+static void
+test_qof_profile_output_file( void )
+{
+    gchar *filename = g_build_filename( g_get_tmp_dir(), "test-qofprofile.json", NULL );
+    gchar *contents = NULL;
+    gchar **lines;
+
+    g_unlink( filename );
+    qof_profile_set_output_file( filename );
+    g_assert( !qof_profile_enabled() );
+    qof_profile_begin( "load", "xml" );
+    g_assert( qof_profile_enabled() );
+    qof_profile_end( TRUE );
+    g_assert( !qof_profile_enabled() );
+    qof_profile_begin( "save", "xml" );
+    qof_profile_add_phase_time( "quoted \"name\"", 1 );
+    qof_profile_end( FALSE );
+    qof_profile_set_output_file( NULL );
+
+    g_assert( g_file_get_contents( filename, &contents, NULL, NULL ) );
+    lines = g_strsplit( contents, "\n", 0 );
+    g_assert_cmpint( g_strv_length( lines ), ==, 3 );
+    g_assert( g_str_has_prefix( lines[0], "{\"operation\": \"load\"" ) );
+    g_assert( g_str_has_prefix( lines[1], "{\"operation\": \"save\"" ) );
+    g_assert( strstr( lines[1], "\"quoted \\\"name\\\"\"" ) != NULL );
+    g_assert_cmpstr( lines[2], ==, "" );
+
+    g_strfreev( lines );
+    g_free( contents );
+    g_unlink( filename );
+    g_free( filename );
+}
+
+void
+test_suite_qofprofile ( void )
+{
+    GNC_TEST_ADD_FUNC( suitename, "phases and objects", test_qof_profile_phases_and_objects );
+    GNC_TEST_ADD_FUNC( suitename, "nesting", test_qof_profile_nesting );
+    GNC_TEST_ADD_FUNC( suitename, "output file", test_qof_profile_output_file );
+}
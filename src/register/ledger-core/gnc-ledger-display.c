@@ -60,6 +60,16 @@ struct gnc_ledger_display
     gboolean loading;
     gboolean use_double_line_default;
 
+    /* A refresh was skipped, so its changes were never loaded */
+    gboolean refresh_skipped;
+
+    /* Refreshes done from the idle loop */
+    gboolean background_refresh;
+    gboolean refresh_pending;
+    GHashTable *pending_changes;    /* merged changes, NULL for all */
+    GArray *pending_guids;          /* splits found by the query step */
+    guint refresh_idle_id;
+
     GNCLedgerDisplayDestroy destroy;
     GNCLedgerDisplayGetParent get_parent;
 
@@ -82,7 +92,7 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
                              gboolean use_double_line,
                              gboolean is_template);
 static void gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld,
-        GList *splits);
+        GList *splits, GHashTable *changes);
 
 
 /** Implementations *************************************************/
@@ -519,11 +529,12 @@ gnc_ledger_display_parent (void *user_data)
     return gnc_ledger_display_get_parent( ld );
 }
 
+/* A transaction commit sends a modify event for the transaction and an
+ * item changed event for the accounts of its splits, so watching both
+ * types covers every transaction shown without a watch per split. */
 static void
-gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
+gnc_ledger_display_set_watches (GNCLedgerDisplay *ld)
 {
-    GList *node;
-
     gnc_gui_component_clear_watches (ld->component_id);
 
     gnc_gui_component_watch_entity_type (ld->component_id,
@@ -531,15 +542,168 @@ gnc_ledger_display_set_watches (GNCLedgerDisplay *ld, GList *splits)
                                          QOF_EVENT_MODIFY | QOF_EVENT_DESTROY
                                          | GNC_EVENT_ITEM_CHANGED);
 
-    for (node = splits; node; node = node->next)
+    gnc_gui_component_watch_entity_type (ld->component_id,
+                                         GNC_ID_TRANS,
+                                         QOF_EVENT_MODIFY);
+}
+
+static void
+merge_changes_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    GHashTable *pending = user_data;
+    const EventInfo *info = value;
+    EventInfo *pending_info;
+
+    pending_info = g_hash_table_lookup (pending, key);
+    if (!pending_info)
     {
-        Split *split = node->data;
-        Transaction *trans = xaccSplitGetParent (split);
+        GncGUID *guid = g_new (GncGUID, 1);
 
-        gnc_gui_component_watch_entity (ld->component_id,
-                                        xaccTransGetGUID (trans),
-                                        QOF_EVENT_MODIFY);
+        *guid = *(const GncGUID *) key;
+        pending_info = g_new0 (EventInfo, 1);
+        g_hash_table_insert (pending, guid, pending_info);
     }
+    pending_info->event_mask |= info->event_mask;
+}
+
+/* The query step: remember which splits the query finds, by GUID, so
+ * that nothing is kept that could be destroyed before the load step. */
+static void
+gnc_ledger_display_run_pending_query (GNCLedgerDisplay *ld)
+{
+    GList *node;
+    gint64 start;
+
+    start = g_get_monotonic_time ();
+    node = qof_query_run (ld->query);
+
+    ld->pending_guids = g_array_sized_new (FALSE, FALSE, sizeof (GncGUID),
+                                           g_list_length (node));
+    for (; node; node = node->next)
+        g_array_append_val (ld->pending_guids,
+                            *qof_instance_get_guid (node->data));
+
+    PINFO("ld=%p query %.3f ms, %u splits", ld,
+          (g_get_monotonic_time () - start) / 1000.0, ld->pending_guids->len);
+}
+
+/* The load step: patch the register with the splits the query found
+ * that still exist. */
+static void
+gnc_ledger_display_load_pending (GNCLedgerDisplay *ld)
+{
+    QofCollection *col;
+    GList *splits = NULL;
+    gint64 start;
+    guint i;
+
+    start = g_get_monotonic_time ();
+    col = qof_book_get_collection (gnc_get_current_book (), GNC_ID_SPLIT);
+    for (i = ld->pending_guids->len; i > 0; i--)
+    {
+        GncGUID *guid = &g_array_index (ld->pending_guids, GncGUID, i - 1);
+        QofInstance *split = qof_collection_lookup_entity (col, guid);
+
+        if (split)
+            splits = g_list_prepend (splits, split);
+    }
+
+    gnc_ledger_display_refresh_internal (ld, splits, ld->pending_changes);
+    g_list_free (splits);
+
+    PINFO("ld=%p load %.3f ms", ld, (g_get_monotonic_time () - start) / 1000.0);
+}
+
+static void
+gnc_ledger_display_cancel_pending_refresh (GNCLedgerDisplay *ld)
+{
+    if (ld->refresh_idle_id)
+    {
+        g_source_remove (ld->refresh_idle_id);
+        ld->refresh_idle_id = 0;
+    }
+    if (ld->pending_guids)
+    {
+        g_array_free (ld->pending_guids, TRUE);
+        ld->pending_guids = NULL;
+    }
+    if (ld->pending_changes)
+    {
+        g_hash_table_destroy (ld->pending_changes);
+        ld->pending_changes = NULL;
+    }
+    ld->refresh_pending = FALSE;
+}
+
+/* Do each step of a pending refresh in its own idle call, so that
+ * newer events can supersede the query before it is loaded. */
+static gboolean
+gnc_ledger_display_refresh_idle (gpointer user_data)
+{
+    GNCLedgerDisplay *ld = user_data;
+
+    if (!ld->pending_guids)
+    {
+        gnc_ledger_display_run_pending_query (ld);
+        return TRUE;
+    }
+
+    ld->refresh_idle_id = 0;
+    gnc_ledger_display_load_pending (ld);
+    gnc_ledger_display_cancel_pending_refresh (ld);
+    return FALSE;
+}
+
+static void
+gnc_ledger_display_queue_refresh (GNCLedgerDisplay *ld, GHashTable *changes)
+{
+    /* A refresh of everything absorbs any other. */
+    if (!changes)
+    {
+        if (ld->pending_changes)
+            g_hash_table_destroy (ld->pending_changes);
+        ld->pending_changes = NULL;
+    }
+    else if (!ld->refresh_pending || ld->pending_changes)
+    {
+        if (!ld->pending_changes)
+            ld->pending_changes = g_hash_table_new_full (guid_hash_to_guint,
+                                  guid_g_hash_table_equal,
+                                  g_free, g_free);
+        g_hash_table_foreach (changes, merge_changes_helper,
+                              ld->pending_changes);
+    }
+    ld->refresh_pending = TRUE;
+
+    /* The splits found by a query that ran before these events are
+     * superseded. */
+    if (ld->pending_guids)
+    {
+        DEBUG("ld=%p dropping superseded query", ld);
+        g_array_free (ld->pending_guids, TRUE);
+        ld->pending_guids = NULL;
+    }
+
+    if (!ld->refresh_idle_id)
+        ld->refresh_idle_id = g_idle_add (gnc_ledger_display_refresh_idle, ld);
+}
+
+void
+gnc_ledger_display_set_background_refresh (GNCLedgerDisplay *ld,
+        gboolean background)
+{
+    if (!ld)
+        return;
+
+    ld->background_refresh = background;
+    if (background || !ld->refresh_pending)
+        return;
+
+    /* Bring the register up to date now that it is in view */
+    if (!ld->pending_guids)
+        gnc_ledger_display_run_pending_query (ld);
+    gnc_ledger_display_load_pending (ld);
+    gnc_ledger_display_cancel_pending_refresh (ld);
 }
 
 static void
@@ -549,11 +713,13 @@ refresh_handler (GHashTable *changes, gpointer user_data)
     const EventInfo *info;
     gboolean has_leader;
     GList *splits;
+    gint64 start;
 
     ENTER("changes=%p, user_data=%p", changes, user_data);
 
     if (ld->loading)
     {
+        ld->refresh_skipped = TRUE;
         LEAVE("already loading");
         return;
     }
@@ -582,16 +748,27 @@ refresh_handler (GHashTable *changes, gpointer user_data)
         }
     }
 
+    if (ld->background_refresh)
+    {
+        gnc_ledger_display_queue_refresh (ld, changes);
+        LEAVE("queued");
+        return;
+    }
+
     /* Its not clear if we should re-run the query, or if we should
      * just use qof_query_last_run().  Its possible that the dates
      * changed, requiring a full new query.  Similar considerations
      * needed for multi-user mode.
      */
+    start = g_get_monotonic_time ();
     splits = qof_query_run (ld->query);
+    PINFO("ld=%p query %.3f ms", ld, (g_get_monotonic_time () - start) / 1000.0);
 
-    gnc_ledger_display_set_watches (ld, splits);
-
-    gnc_ledger_display_refresh_internal (ld, splits);
+    /* Only the rows of the transactions in changes need to be set up
+     * again, as the query and so the order of the splits is the same. */
+    start = g_get_monotonic_time ();
+    gnc_ledger_display_refresh_internal (ld, splits, changes);
+    PINFO("ld=%p load %.3f ms", ld, (g_get_monotonic_time () - start) / 1000.0);
     LEAVE(" ");
 }
 
@@ -604,6 +781,7 @@ close_handler (gpointer user_data)
         return;
 
     gnc_unregister_gui_component (ld->component_id);
+    gnc_ledger_display_cancel_pending_refresh (ld);
 
     if (ld->destroy)
         ld->destroy (ld);
@@ -769,6 +947,7 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
     ld->query = NULL;
     ld->ld_type = ld_type;
     ld->loading = FALSE;
+    ld->refresh_skipped = FALSE;
     ld->destroy = NULL;
     ld->get_parent = NULL;
     ld->user_data = NULL;
@@ -795,11 +974,11 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
 
     gnc_split_register_set_data (ld->reg, ld, gnc_ledger_display_parent);
 
-    splits = qof_query_run (ld->query);
+    gnc_ledger_display_set_watches (ld);
 
-    gnc_ledger_display_set_watches (ld, splits);
+    splits = qof_query_run (ld->query);
 
-    gnc_ledger_display_refresh_internal (ld, splits);
+    gnc_ledger_display_refresh_internal (ld, splits, NULL);
 
     return ld;
 }
@@ -830,18 +1009,30 @@ gnc_ledger_display_find_by_query (Query *q)
 \********************************************************************/
 
 static void
-gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld, GList *splits)
+gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld, GList *splits,
+                                     GHashTable *changes)
 {
-    if (!ld || ld->loading)
+    if (!ld)
         return;
 
-    if (!gnc_split_register_full_refresh_ok (ld->reg))
+    if (ld->loading || !gnc_split_register_full_refresh_ok (ld->reg))
+    {
+        ld->refresh_skipped = TRUE;
         return;
+    }
+
+    /* The changes of a skipped refresh are not in the ones given now. */
+    if (ld->refresh_skipped)
+    {
+        changes = NULL;
+        ld->refresh_skipped = FALSE;
+    }
 
     ld->loading = TRUE;
 
-    gnc_split_register_load (ld->reg, splits,
-                             gnc_ledger_display_leader (ld));
+    gnc_split_register_load_changes (ld->reg, splits,
+                                     gnc_ledger_display_leader (ld),
+                                     changes);
 
     ld->loading = FALSE;
 }
@@ -863,7 +1054,10 @@ gnc_ledger_display_refresh (GNCLedgerDisplay *ld)
         return;
     }
 
-    gnc_ledger_display_refresh_internal (ld, qof_query_run (ld->query));
+    /* Everything is loaded now, so a pending refresh is not needed */
+    gnc_ledger_display_cancel_pending_refresh (ld);
+
+    gnc_ledger_display_refresh_internal (ld, qof_query_run (ld->query), NULL);
     LEAVE(" ");
 }
 
@@ -117,6 +117,16 @@ GNCLedgerDisplay * gnc_ledger_display_find_by_query (Query *q);
 void gnc_ledger_display_refresh (GNCLedgerDisplay * ledger_display);
 void gnc_ledger_display_refresh_by_split_register (SplitRegister *reg);
 
+/* With background refresh on, the refreshes asked for by the component
+ * manager are done from the idle loop in two steps: the query is run
+ * and the GUIDs of its splits remembered, then the register is loaded
+ * from them.  Refreshes that arrive before a pending one is loaded are
+ * merged into it and its query is run again.  Turning background
+ * refresh off loads a pending refresh at once.  Meant for registers
+ * that are not in view. */
+void gnc_ledger_display_set_background_refresh (GNCLedgerDisplay *ld,
+        gboolean background);
+
 /* close the window */
 void gnc_ledger_display_close (GNCLedgerDisplay * ledger_display);
 
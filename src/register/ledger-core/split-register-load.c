@@ -32,6 +32,7 @@
 #include "qof.h"
 #include "gnc-ui-util.h"
 #include "gnc-gui-query.h"
+#include "gnc-trans-quickfill.h"
 #include "numcell.h"
 #include "quickfillcell.h"
 #include "recncell.h"
@@ -46,6 +47,8 @@ static QofLogModule log_module = GNC_MOD_LEDGER;
 
 static void gnc_split_register_load_xfer_cells (SplitRegister *reg,
         Account *base_account);
+static void gnc_split_register_load_text_cells (SplitRegister *reg,
+        Account *account);
 
 static void
 gnc_split_register_load_recn_cells (SplitRegister *reg)
@@ -202,6 +205,67 @@ gnc_split_register_add_transaction (SplitRegister *reg,
     }
 }
 
+/** The rows a load set up for one transaction. */
+typedef struct
+{
+    Split *split;                 /**< The anchoring split */
+    int first_row;                /**< The row of the leading cell */
+    int num_rows;                 /**< Including the empty split row */
+    gboolean start_primary_color;
+} SRLoadedTrans;
+
+/** Whether the rows set up for @a loaded by an earlier load are what
+ *  gnc_split_register_add_transaction would set up for @a split at
+ *  @a vcell_loc now, so that they can be kept.  The virtual cells are
+ *  checked as well, because moving the cursor changes their cursors
+ *  and visibility. */
+static gboolean
+gnc_split_register_trans_loaded (Table *table, const SRLoadedTrans *loaded,
+                                 Split *split, CellBlock *lead_cursor,
+                                 CellBlock *split_cursor,
+                                 gboolean visible_splits,
+                                 gboolean start_primary_color,
+                                 VirtualCellLocation vcell_loc,
+                                 GHashTable *changes)
+{
+    VirtualCell *vcell;
+    int i;
+
+    if (loaded->split != split ||
+            loaded->first_row != vcell_loc.virt_row ||
+            loaded->start_primary_color != start_primary_color)
+        return FALSE;
+
+    /* Editing the transaction can add or remove split rows. */
+    if (gnc_gui_get_entity_events (changes,
+                                   xaccTransGetGUID (xaccSplitGetParent (split))))
+        return FALSE;
+
+    for (i = 0; i < loaded->num_rows; i++, vcell_loc.virt_row++)
+    {
+        gboolean lead = (i == 0);
+        gboolean empty = (i == loaded->num_rows - 1);
+
+        vcell = gnc_table_get_virtual_cell (table, vcell_loc);
+        if (vcell == NULL)
+            return FALSE;
+
+        if (vcell->cellblock != (lead ? lead_cursor : split_cursor))
+            return FALSE;
+
+        if (vcell->visible != ((lead || (visible_splits && !empty)) ? 1 : 0))
+            return FALSE;
+
+        if (vcell->start_primary_color != ((!lead || start_primary_color) ? 1 : 0))
+            return FALSE;
+
+        if (lead && !guid_equal (vcell->vcell_data, xaccSplitGetGUID (split)))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 static gint
 _find_split_with_parent_txn(gconstpointer a, gconstpointer b)
 {
@@ -212,11 +276,22 @@ _find_split_with_parent_txn(gconstpointer a, gconstpointer b)
 }
 
 static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
-                                      Split *split, gboolean has_last_num)
+                                      Split *split, gboolean has_last_num,
+                                      gboolean shared_text)
 {
     Split *s;
     int i = 0;
 
+    if (!has_last_num)
+        gnc_num_cell_set_last_num(
+            (NumCell *) gnc_table_layout_get_cell(layout, NUM_CELL),
+            gnc_get_num_action(trans, split));
+
+    /* Account registers share the account's quickfills (see
+     * gnc_split_register_load_text_cells). */
+    if (shared_text)
+        return;
+
     gnc_quickfill_cell_add_completion(
         (QuickFillCell *) gnc_table_layout_get_cell(layout, DESC_CELL),
         xaccTransGetDescription(trans));
@@ -225,11 +300,6 @@ static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
         (QuickFillCell *) gnc_table_layout_get_cell(layout, NOTES_CELL),
         xaccTransGetNotes(trans));
 
-    if (!has_last_num)
-        gnc_num_cell_set_last_num(
-            (NumCell *) gnc_table_layout_get_cell(layout, NUM_CELL),
-            gnc_get_num_action(trans, split));
-
     while ((s = xaccTransGetSplit(trans, i)) != NULL)
     {
         gnc_quickfill_cell_add_completion(
@@ -239,14 +309,16 @@ static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
     }
 }
 
-void
-gnc_split_register_load (SplitRegister *reg, GList * slist,
-                         Account *default_account)
+static void
+gnc_split_register_load_internal (SplitRegister *reg, GList * slist,
+                                  Account *default_account,
+                                  GHashTable *changes)
 {
     SRInfo *info;
     Transaction *pending_trans;
     CursorBuffer *cursor_buffer;
     GHashTable *trans_table = NULL;
+    GArray *loaded_trans;
     CellBlock *cursor_header;
     CellBlock *lead_cursor;
     CellBlock *split_cursor;
@@ -270,6 +342,7 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     gboolean multi_line;
     gboolean dynamic;
     gboolean we_own_slist = FALSE;
+    gboolean keep_rows;
     gboolean use_autoreadonly = qof_book_uses_autoreadonly(gnc_get_current_book());
 
     VirtualCellLocation vcell_loc;
@@ -278,6 +351,7 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     int new_trans_split_row = -1;
     int new_trans_row = -1;
     int new_split_row = -1;
+    int rows_kept = 0;
     time64 present, autoreadonly_time = 0;
 
     g_return_if_fail(reg);
@@ -286,7 +360,8 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     info = gnc_split_register_get_info (reg);
     g_return_if_fail(info);
 
-    ENTER("reg=%p, slist=%p, default_account=%p", reg, slist, default_account);
+    ENTER("reg=%p, slist=%p, default_account=%p, changes=%p",
+          reg, slist, default_account, changes);
 
     blank_split = xaccSplitLookup (&info->blank_split_guid,
                                    gnc_get_current_book ());
@@ -432,6 +507,10 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
             }
         }
 
+        /* attach the account's description, notes and memo quickfills */
+        if (default_account)
+            gnc_split_register_load_text_cells (reg, default_account);
+
         /* load up account names into the transfer combobox menus */
         gnc_split_register_load_xfer_cells (reg, default_account);
         gnc_split_register_load_recn_cells (reg);
@@ -488,6 +567,11 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     if (multi_line)
         trans_table = g_hash_table_new (g_direct_hash, g_direct_equal);
 
+    /* Without a record of the changes every row is set up again. */
+    keep_rows = (changes != NULL && !info->first_pass &&
+                 info->loaded_trans != NULL);
+    loaded_trans = g_array_new (FALSE, FALSE, sizeof (SRLoadedTrans));
+
     /* populate the table */
     for (node = slist; node; node = node->next)
     {
@@ -539,7 +623,8 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
         /* If this is the first load of the register,
          * fill up the quickfill cells. */
         if (info->first_pass)
-            add_quickfill_completions(reg->table->layout, trans, split, has_last_num);
+            add_quickfill_completions(reg->table->layout, trans, split, has_last_num,
+                                      default_account != NULL);
 
         if (trans == find_trans)
             new_trans_row = vcell_loc.virt_row;
@@ -547,12 +632,43 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
         if (split == find_trans_split)
             new_trans_split_row = vcell_loc.virt_row;
 
-        gnc_split_register_add_transaction (reg, trans, split,
-                                            lead_cursor, split_cursor,
-                                            multi_line, start_primary_color,
-                                            TRUE,
-                                            find_trans, find_split, find_class,
-                                            &new_split_row, &vcell_loc);
+        {
+            SRLoadedTrans entry;
+            SRLoadedTrans *loaded = NULL;
+
+            if (keep_rows && loaded_trans->len < info->loaded_trans->len)
+                loaded = &g_array_index (info->loaded_trans, SRLoadedTrans,
+                                         loaded_trans->len);
+
+            entry.split = split;
+            entry.first_row = vcell_loc.virt_row;
+            entry.start_primary_color = start_primary_color;
+
+            /* Keep the rows of a transaction that neither changed nor
+             * moved.  The one the cursor goes to is always set up again
+             * so that its row can be found. */
+            if (loaded && trans != find_trans && split != find_trans_split &&
+                    (find_split == NULL ||
+                     xaccSplitGetParent (find_split) != trans) &&
+                    gnc_split_register_trans_loaded (table, loaded, split,
+                            lead_cursor, split_cursor,
+                            multi_line, start_primary_color,
+                            vcell_loc, changes))
+            {
+                vcell_loc.virt_row += loaded->num_rows;
+                rows_kept += loaded->num_rows;
+            }
+            else
+                gnc_split_register_add_transaction (reg, trans, split,
+                                                    lead_cursor, split_cursor,
+                                                    multi_line, start_primary_color,
+                                                    TRUE,
+                                                    find_trans, find_split, find_class,
+                                                    &new_split_row, &vcell_loc);
+
+            entry.num_rows = vcell_loc.virt_row - entry.first_row;
+            g_array_append_val (loaded_trans, entry);
+        }
 
         if (!multi_line)
             start_primary_color = !start_primary_color;
@@ -561,6 +677,12 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     if (multi_line)
         g_hash_table_destroy (trans_table);
 
+    if (info->loaded_trans)
+        g_array_free (info->loaded_trans, TRUE);
+    info->loaded_trans = loaded_trans;
+
+    DEBUG("kept %d of %d rows", rows_kept, vcell_loc.virt_row);
+
     /* add the blank split at the end. */
     if (pending_trans == blank_trans)
         found_pending = TRUE;
@@ -690,6 +812,21 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     LEAVE(" ");
 }
 
+void
+gnc_split_register_load (SplitRegister *reg, GList * slist,
+                         Account *default_account)
+{
+    gnc_split_register_load_internal (reg, slist, default_account, NULL);
+}
+
+void
+gnc_split_register_load_changes (SplitRegister *reg, GList * slist,
+                                 Account *default_account,
+                                 GHashTable *changes)
+{
+    gnc_split_register_load_internal (reg, slist, default_account, changes);
+}
+
 /* ===================================================================== */
 
 #define QKEY  "split_reg_shared_quickfill"
@@ -733,4 +870,30 @@ gnc_split_register_load_xfer_cells (SplitRegister *reg, Account *base_account)
     gnc_combo_cell_use_list_store_cache (cell, store);
 }
 
+#define TKEY  "split_reg_shared_trans_quickfill"
+
+static void
+use_shared_quickfill (SplitRegister *reg, const char *cell_name, QuickFill *qf)
+{
+    QuickFillCell *cell;
+
+    cell = (QuickFillCell *) gnc_table_layout_get_cell (reg->table->layout,
+            cell_name);
+    if (cell)
+        gnc_quickfill_cell_use_quickfill_cache (cell, qf);
+}
+
+/* Description auto-fill looks in the default account, so only offer
+ * the strings of that account's transactions. */
+static void
+gnc_split_register_load_text_cells (SplitRegister *reg, Account *account)
+{
+    use_shared_quickfill (reg, DESC_CELL,
+                          gnc_get_shared_trans_desc_quickfill (account, TKEY));
+    use_shared_quickfill (reg, NOTES_CELL,
+                          gnc_get_shared_trans_notes_quickfill (account, TKEY));
+    use_shared_quickfill (reg, MEMO_CELL,
+                          gnc_get_shared_split_memo_quickfill (account, TKEY));
+}
+
 /* ====================== END OF FILE ================================== */
@@ -130,6 +130,10 @@ struct sr_info
 
     /* true if the account separator has changed */
     gboolean separator_changed;
+
+    /* The rows the last load set up for each transaction, in order, so
+     * that a reload can keep those that did not change */
+    GArray *loaded_trans;
 };
 
 
@@ -2754,6 +2754,10 @@ gnc_split_register_destroy_info (SplitRegister *reg)
     info->credit_str = NULL;
     info->tcredit_str = NULL;
 
+    if (info->loaded_trans)
+        g_array_free (info->loaded_trans, TRUE);
+    info->loaded_trans = NULL;
+
     g_free (reg->sr_info);
 
     reg->sr_info = NULL;
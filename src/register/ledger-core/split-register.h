@@ -517,6 +517,28 @@ void gnc_split_register_cancel_cursor_trans_changes (SplitRegister *reg);
 void gnc_split_register_load (SplitRegister *reg, GList * slist,
                               Account *default_account);
 
+/** Reload the register like gnc_split_register_load, after the changes
+ *  gathered by the component manager since the last load.
+ *
+ *  The virtual rows of a transaction are kept when it has no events in
+ *  @a changes and its rows neither moved nor were changed by moving the
+ *  cursor.  All other rows are set up again.  Rows below an inserted or
+ *  removed transaction move, so they are set up again as well.
+ *
+ *  @param reg a ::SplitRegister
+ *
+ *  @param slist a list of splits, in the same order and from the same
+ *  query as the last load
+ *
+ *  @param default_account an account to provide defaults for the blank split
+ *
+ *  @param changes the entity events passed to the refresh handler, or
+ *  NULL to set up every row again
+ */
+void gnc_split_register_load_changes (SplitRegister *reg, GList * slist,
+                                      Account *default_account,
+                                      GHashTable *changes);
+
 /** Copy the contents of the current cursor to a split. The split and
  *    transaction that are updated are the ones associated with the
  *    current cursor (register entry) position. If the do_commit flag
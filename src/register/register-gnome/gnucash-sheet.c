@@ -358,22 +358,44 @@ gnucash_sheet_cursor_move (GnucashSheet *sheet, VirtualLocation virt_loc)
 }
 
 
-static gint
+/* Return the first visible block below row 0 that ends below pixel y,
+ * or num_virt_rows if there is none.  The end of each block is the
+ * origin of the next one, so the ends never decrease down the sheet
+ * and the block can be found by bisection instead of walking every
+ * row above the visible window. */
+gint
 gnucash_sheet_y_pixel_to_block (GnucashSheet *sheet, int y)
 {
     VirtualCellLocation vcell_loc = { 1, 0 };
+    gint lo = 1;
+    gint hi = sheet->num_virt_rows;
+
+    while (lo < hi)
+    {
+        SheetBlock *block;
+        gint end;
+
+        vcell_loc.virt_row = lo + (hi - lo) / 2;
+        block = gnucash_sheet_get_block (sheet, vcell_loc);
+
+        end = block->origin_y;
+        if (block->visible)
+            end += block->style->dimensions->height;
+
+        if (end > y)
+            hi = vcell_loc.virt_row;
+        else
+            lo = vcell_loc.virt_row + 1;
+    }
 
-    for (;
+    for (vcell_loc.virt_row = lo;
             vcell_loc.virt_row < sheet->num_virt_rows;
             vcell_loc.virt_row++)
     {
         SheetBlock *block;
 
         block = gnucash_sheet_get_block (sheet, vcell_loc);
-        if (!block || !block->visible)
-            continue;
-
-        if (block->origin_y + block->style->dimensions->height > y)
+        if (block && block->visible)
             break;
     }
 
@@ -2517,6 +2539,52 @@ gnucash_sheet_recompute_block_offsets (GnucashSheet *sheet)
     sheet->height = height;
 }
 
+/* Update the offsets of the blocks below virt_row after the style or
+ * visibility of that block changed.  The blocks above it keep their
+ * offsets, and the blocks below it only move if its height changed. */
+void
+gnucash_sheet_recompute_block_offsets_from (GnucashSheet *sheet, gint virt_row)
+{
+    VirtualCellLocation vcell_loc = { virt_row, 0 };
+    SheetBlock *block;
+    gint old_end;
+    gint new_end;
+    gint delta;
+
+    g_return_if_fail (sheet != NULL);
+    g_return_if_fail (GNUCASH_IS_SHEET(sheet));
+    g_return_if_fail (sheet->table != NULL);
+
+    if (virt_row < 1 || virt_row >= sheet->num_virt_rows ||
+            sheet->num_virt_cols != 1)
+    {
+        gnucash_sheet_recompute_block_offsets (sheet);
+        return;
+    }
+
+    block = gnucash_sheet_get_block (sheet, vcell_loc);
+
+    new_end = block->origin_y;
+    if (block->visible)
+        new_end += block->style->dimensions->height;
+
+    vcell_loc.virt_row++;
+    block = gnucash_sheet_get_block (sheet, vcell_loc);
+    old_end = block ? block->origin_y : sheet->height;
+
+    delta = new_end - old_end;
+    if (delta == 0)
+        return;
+
+    for (; vcell_loc.virt_row < sheet->num_virt_rows; vcell_loc.virt_row++)
+    {
+        block = gnucash_sheet_get_block (sheet, vcell_loc);
+        block->origin_y += delta;
+    }
+
+    sheet->height += delta;
+}
+
 void
 gnucash_sheet_table_load (GnucashSheet *sheet, gboolean do_scroll)
 {
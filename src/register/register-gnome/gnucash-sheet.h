@@ -67,6 +67,10 @@ GtkWidget *gnucash_sheet_new (Table *table);
 void gnucash_sheet_table_load (GnucashSheet *sheet, gboolean do_scroll);
 
 void gnucash_sheet_recompute_block_offsets (GnucashSheet *sheet);
+void gnucash_sheet_recompute_block_offsets_from (GnucashSheet *sheet,
+        gint virt_row);
+
+gint gnucash_sheet_y_pixel_to_block (GnucashSheet *sheet, int y);
 
 GType gnucash_register_get_type (void);
 